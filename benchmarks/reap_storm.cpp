@@ -0,0 +1,126 @@
+/// @file reap_storm.cpp
+/// @brief Benchmarks reaping many short-lived child processes at once.
+/// @details Usage: <code>reap_storm [children [rounds]]</code>. Every
+///   round spawns the given number of <code>/bin/cat</code> processes that
+///   all block reading the same pipe. It then closes the pipe, so they all
+///   exit at once, and times how long it takes until all of them have been
+///   waited on. Which stresses how the exits of many children are
+///   delivered to their owners.
+/// @note Set the <code>FLOW_NO_PIDFDS</code> environment variable to have
+///   the exits delivered by waiting on any child, instead of via process
+///   descriptors.
+
+#include <algorithm> // for std::max
+#include <chrono>
+#include <cstdlib> // for std::strtoul
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h> // for O_CLOEXEC
+#include <spawn.h> // for posix_spawn_file_actions_*
+#include <unistd.h> // for ::pipe2, ::close
+
+#include <sys/resource.h> // for getrlimit, setrlimit
+
+#include "flow/owning_process_id.hpp"
+
+namespace {
+
+constexpr auto default_children = 10000u;
+constexpr auto default_rounds = 3u;
+
+/// @brief Descriptors to leave for everything but the children.
+constexpr auto reserved_descriptors = 64u;
+
+/// @brief Raises the soft limit on open descriptors as far as allowed.
+/// @note Each child may have a process descriptor open until waited on.
+/// @return The resulting limit.
+auto raise_descriptor_limit() -> rlim_t
+{
+    auto limit = rlimit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+        return 0u;
+    }
+    limit.rlim_cur = limit.rlim_max;
+    (void) ::setrlimit(RLIMIT_NOFILE, &limit);
+    (void) ::getrlimit(RLIMIT_NOFILE, &limit);
+    return limit.rlim_cur;
+}
+
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+    auto children = (argc > 1)
+        ? unsigned(std::strtoul(argv[1], nullptr, 10)) // NOLINT
+        : default_children;
+    const auto rounds = (argc > 2)
+        ? unsigned(std::strtoul(argv[2], nullptr, 10)) // NOLINT
+        : default_rounds;
+    const auto limit = raise_descriptor_limit();
+    if ((limit != RLIM_INFINITY) && (limit < children + reserved_descriptors)) {
+        children = unsigned(std::max(limit, rlim_t{reserved_descriptors}) -
+                            reserved_descriptors);
+        std::cerr << "descriptor limit only allows " << children;
+        std::cerr << " children\n";
+    }
+    auto path = std::string{"/bin/cat"};
+    auto arg0 = std::string{"cat"};
+    char *args[] = {arg0.data(), nullptr};
+    char *envp[] = {nullptr};
+    std::cout << std::setw(10) << "children";
+    std::cout << std::setw(12) << "spawn-msec";
+    std::cout << std::setw(12) << "reap-msec";
+    std::cout << std::setw(16) << "reap-usec/child" << "\n";
+    using clock = std::chrono::steady_clock;
+    for (auto round = 0u; round < rounds; ++round) {
+        // Both ends are close-on-exec, so only the children's standard
+        // inputs keep the read end open & nothing but this the write end.
+        int fds[2] = {-1, -1};
+        if (::pipe2(fds, O_CLOEXEC) == -1) {
+            std::cerr << "can't make pipe\n";
+            return 1;
+        }
+        auto file_actions = posix_spawn_file_actions_t{};
+        ::posix_spawn_file_actions_init(&file_actions);
+        ::posix_spawn_file_actions_adddup2(&file_actions, fds[0], 0);
+        auto processes = std::vector<flow::owning_process_id>{};
+        processes.reserve(children);
+        const auto start = clock::now();
+        for (auto i = 0u; i < children; ++i) {
+            const auto pid = flow::owning_process_id::spawn(path.c_str(),
+                                                            &file_actions,
+                                                            nullptr,
+                                                            args, envp);
+            if (pid == flow::invalid_process_id) {
+                std::cerr << "spawn failed after " << i << " children\n";
+                break;
+            }
+            processes.emplace_back(pid);
+        }
+        ::posix_spawn_file_actions_destroy(&file_actions);
+        ::close(fds[0]);
+        const auto spawned = clock::now();
+        // Releases all the children at once.
+        ::close(fds[1]);
+        for (auto&& process: processes) {
+            (void) process.wait();
+        }
+        const auto reaped = clock::now();
+        const auto to_msec = [](clock::duration d){
+            return double(std::chrono::duration_cast<
+                          std::chrono::microseconds>(d).count()) / 1000.0;
+        };
+        std::cout << std::setw(10) << size(processes);
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::setw(12) << to_msec(spawned - start);
+        std::cout << std::setw(12) << to_msec(reaped - spawned);
+        std::cout << std::setw(16) << std::setprecision(2);
+        std::cout << (to_msec(reaped - spawned) * 1000.0 /
+                      double(std::max<std::size_t>(size(processes), 1u)));
+        std::cout << "\n";
+    }
+    return 0;
+}
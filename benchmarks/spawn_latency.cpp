@@ -0,0 +1,100 @@
+/// @file spawn_latency.cpp
+/// @brief Benchmarks instantiation latency of an executable node as a
+///   function of the instantiating process's resident set size.
+/// @details Usage: <code>spawn_latency [iterations [rss-MiB...]]</code>.
+///   For every given resident set size, this allocates & touches that much
+///   memory and then times instantiating <code>/bin/true</code> with every
+///   <code>process_creation</code> method.
+
+#include <chrono>
+#include <cstddef> // for std::size_t
+#include <cstdlib> // for std::strtoul
+#include <iomanip> // for std::setw
+#include <iostream>
+#include <sstream> // for std::ostringstream
+#include <vector>
+
+#include "flow/instantiate.hpp"
+#include "flow/utility.hpp"
+
+namespace {
+
+constexpr auto default_iterations = 200u;
+constexpr auto mebibyte = std::size_t{1024u * 1024u};
+constexpr auto page_size = std::size_t{4096u};
+
+auto to_string(flow::process_creation value) -> const char*
+{
+    switch (value) {
+    case flow::process_creation::spawn: return "spawn";
+    case flow::process_creation::fork: return "fork";
+    case flow::process_creation::zygote: return "zygote";
+    }
+    return "unknown";
+}
+
+/// @brief Makes a buffer of the given size whose pages are all resident.
+auto make_resident(std::size_t size) -> std::vector<char>
+{
+    auto result = std::vector<char>(size);
+    for (auto i = std::size_t{}; i < size; i += page_size) {
+        result[i] = 1;
+    }
+    return result;
+}
+
+/// @brief Times instantiating the given node the given number of times.
+/// @return Mean duration of the <code>instantiate</code> calls.
+auto time_instantiate(const flow::node& node,
+                      flow::process_creation creation,
+                      unsigned iterations) -> std::chrono::nanoseconds
+{
+    using clock = std::chrono::steady_clock;
+    const auto opts = flow::instantiate_options{.creation = creation};
+    auto total = clock::duration{};
+    for (auto i = 0u; i < iterations; ++i) {
+        std::ostringstream diags;
+        const auto start = clock::now();
+        auto object = flow::instantiate(node, diags, opts);
+        total += clock::now() - start;
+        flow::wait(object);
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(total) /
+           std::max(iterations, 1u);
+}
+
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+    const auto iterations = (argc > 1)
+        ? unsigned(std::strtoul(argv[1], nullptr, 10)) // NOLINT
+        : default_iterations;
+    auto sizes = std::vector<std::size_t>{};
+    for (auto i = 2; i < argc; ++i) {
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10)); // NOLINT
+    }
+    if (sizes.empty()) {
+        sizes = {0u, 256u, 1024u};
+    }
+    const auto node = flow::node{
+        flow::executable{.file = "/bin/true", .arguments = {"true"}},
+        flow::port_map{}
+    };
+    std::cout << std::setw(8) << "rss-MiB";
+    std::cout << std::setw(8) << "method";
+    std::cout << std::setw(12) << "mean-usec" << "\n";
+    for (auto&& size: sizes) {
+        const auto resident = make_resident(size * mebibyte);
+        for (auto&& creation: {flow::process_creation::spawn,
+                               flow::process_creation::fork,
+                               flow::process_creation::zygote}) {
+            const auto mean = time_instantiate(node, creation, iterations);
+            std::cout << std::setw(8) << size;
+            std::cout << std::setw(8) << to_string(creation);
+            std::cout << std::setw(12) << std::fixed << std::setprecision(1);
+            std::cout << (double(mean.count()) / 1000.0) << "\n";
+        }
+    }
+    return 0;
+}
@@ -58,6 +58,11 @@ struct filebuf: public std::streambuf {
     auto operator=(filebuf&& other) noexcept -> filebuf&;
     auto swap(filebuf& rhs) -> void;
     [[nodiscard]] auto is_open() const noexcept -> bool;
+
+    /// @brief Underlying file descriptor, or -1 if not open.
+    /// @note This is like C++26's <code>std::basic_filebuf::native_handle</code>.
+    [[nodiscard]] auto native_handle() const noexcept -> int;
+
     auto unique(char* path) -> filebuf*;
     auto unique(std::filesystem::path& path) -> filebuf*;
     auto unique(std::string& path) -> filebuf*;
@@ -403,6 +408,11 @@ inline auto filebuf::is_open() const noexcept -> bool
     return fp != nullptr;
 }
 
+inline auto filebuf::native_handle() const noexcept -> int
+{
+    return fp? ::fileno(fp.get()): -1;
+}
+
 inline auto filebuf::unique(char* path) -> filebuf*
 {
     auto tmp = std::filesystem::path{path};
@@ -722,6 +732,7 @@ struct fstream: public std::iostream
     auto operator=(fstream&& other) noexcept -> fstream&;
 
     auto is_open() const -> bool;
+    [[nodiscard]] auto native_handle() const noexcept -> int;
     auto close() -> void;
     auto unique(char* path) -> void;
     auto unique(std::filesystem::path& path) -> void;
@@ -762,6 +773,11 @@ inline auto fstream::is_open() const -> bool
     return fb.is_open();
 }
 
+inline auto fstream::native_handle() const noexcept -> int
+{
+    return fb.native_handle();
+}
+
 inline auto fstream::close() -> void
 {
     if (!fb.close()) {
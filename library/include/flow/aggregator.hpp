@@ -0,0 +1,96 @@
+#ifndef aggregator_hpp
+#define aggregator_hpp
+
+#include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+#include "flow/reference_descriptor.hpp"
+
+namespace flow {
+
+/// @brief Function computed over each group of records.
+enum class aggregate_function: unsigned {
+    count,
+    sum,
+    min,
+    max,
+};
+
+auto operator<<(std::ostream& os, aggregate_function value) -> std::ostream&;
+
+/// @brief Aggregate to compute for each group.
+struct aggregate
+{
+    aggregate_function function{aggregate_function::count};
+
+    /// @brief One-based index of the field whose values are aggregated.
+    /// @note Zero means the whole record. This is ignored for
+    ///   <code>aggregate_function::count</code>.
+    std::size_t field{};
+
+    auto operator==(const aggregate&) const -> bool = default;
+};
+
+static_assert(std::regular<aggregate>);
+
+auto operator<<(std::ostream& os, const aggregate& value) -> std::ostream&;
+
+/// @brief Built-in hash aggregation - i.e. a "group by".
+/// @details Groups the delimited records read from its standard input port
+///   by their key fields, and for each group writes out a record of the key
+///   fields followed by the group's aggregates, to its standard output port.
+///   Groups are hash partitioned over threads which each aggregate into
+///   their own open addressing hash table. Partitions that outgrow their
+///   share of the memory budget spill their partial aggregates to temporary
+///   files that get re-aggregated once the input's been consumed.
+/// @note Output records are in no particular order.
+/// @note Field values that aren't numbers are treated as zero.
+/// @note This is a <code>builtin</code> implementation type.
+/// @see builtin.
+struct aggregator
+{
+    static constexpr auto default_memory_budget =
+        std::size_t{64u * 1024u * 1024u};
+
+    /// @brief One-based indices of the fields to group by.
+    /// @note Empty means to group by the whole record.
+    std::vector<std::size_t> key_fields;
+
+    /// @brief Aggregates to compute for each group.
+    std::vector<aggregate> aggregates{aggregate{}};
+
+    char field_delimiter{'\t'};
+
+    char record_delimiter{'\n'};
+
+    /// @brief Approximate limit on the memory to use for hash tables.
+    std::size_t memory_budget{default_memory_budget};
+
+    /// @brief Maximum number of threads to aggregate with.
+    /// @note Zero means to use as many as the hardware supports.
+    std::size_t threads{};
+
+    /// @brief Directory to spill partial aggregates to.
+    /// @note Empty means the system's temporary directory.
+    std::filesystem::path temporary_directory;
+
+    auto operator==(const aggregator&) const -> bool = default;
+};
+
+static_assert(std::regular<aggregator>);
+
+auto operator<<(std::ostream& os, const aggregator& value) -> std::ostream&;
+
+/// @brief Aggregates records from the input descriptor to the output
+///   descriptor.
+/// @throws std::system_error if reading, writing, or spilling fails.
+/// @see aggregator.
+auto group_by(const aggregator& spec, reference_descriptor in,
+              reference_descriptor out) -> void;
+
+}
+
+#endif /* aggregator_hpp */
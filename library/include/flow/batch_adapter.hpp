@@ -0,0 +1,79 @@
+#ifndef batch_adapter_hpp
+#define batch_adapter_hpp
+
+#include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <vector>
+
+#include "flow/batch_channel.hpp"
+#include "flow/port_map.hpp"
+#include "flow/record_schema.hpp"
+#include "flow/reference_descriptor.hpp"
+
+namespace flow {
+
+/// @brief Direction of conversion of a <code>batch_adapter</code>.
+enum class batch_conversion: unsigned {
+    /// @brief Delimited text records in, record batches out.
+    from_text,
+
+    /// @brief Record batches in, delimited text records out.
+    to_text,
+};
+
+auto operator<<(std::ostream& os, batch_conversion value) -> std::ostream&;
+
+/// @brief Built-in adapter between delimited text records and record
+///   batches.
+/// @details This is the stage to put at process boundaries of flows whose
+///   built-ins exchange record batches: between an executable's output and
+///   a built-in's columnar input, or vice versa.
+/// @note Empty fields, and fields that aren't valid values of their type,
+///   become nulls. Nulls become empty fields.
+/// @note This is a <code>builtin</code> implementation type.
+/// @see builtin, make_port_map(const batch_adapter&).
+struct batch_adapter
+{
+    static constexpr auto default_batch_size = std::size_t{4096u};
+
+    /// @brief Fields of the records.
+    std::vector<record_field> fields;
+
+    batch_conversion conversion{batch_conversion::from_text};
+
+    char field_delimiter{'\t'};
+
+    char record_delimiter{'\n'};
+
+    /// @brief Maximum number of records per batch.
+    std::size_t batch_size{default_batch_size};
+
+    auto operator==(const batch_adapter&) const -> bool = default;
+};
+
+static_assert(std::regular<batch_adapter>);
+
+auto operator<<(std::ostream& os, const batch_adapter& value)
+    -> std::ostream&;
+
+/// @brief Makes the port map for the given adapter.
+/// @details The port map has a standard input and output port with schemas
+///   for the adapter's text & batch sides.
+auto make_port_map(const batch_adapter& adapter) -> port_map;
+
+/// @brief Reads delimited text records from the given descriptor and sends
+///   them as record batches via the given handle.
+/// @throws std::system_error if reading fails.
+auto adapt(const batch_adapter& spec, reference_descriptor in,
+           const batch_channel::handle& out) -> void;
+
+/// @brief Receives record batches via the given handle and writes them as
+///   delimited text records to the given descriptor.
+/// @throws std::system_error if writing fails.
+auto adapt(const batch_adapter& spec, const batch_channel::handle& in,
+           reference_descriptor out) -> void;
+
+}
+
+#endif /* batch_adapter_hpp */
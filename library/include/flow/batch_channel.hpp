@@ -0,0 +1,99 @@
+#ifndef batch_channel_hpp
+#define batch_channel_hpp
+
+#include <cstddef> // for std::size_t
+#include <memory> // for std::shared_ptr
+#include <optional>
+#include <ostream>
+#include <type_traits> // for std::is_default_constructible_v
+
+#include "flow/record_batch.hpp"
+
+namespace flow {
+
+/// @brief Bounded in-process queue of record batches.
+/// @details This is the channel made for links between built-ins' ports
+///   whose schemas have <code>record_encoding::columnar</code> encoding.
+///   Batches are moved through it rather than serialized.
+/// @note This class is movable but not copyable. Destroying it closes both
+///   of its sides, waking up any of its handles' users.
+/// @note Instances of this type are made for <code>link</code> instances.
+/// @see link, record_batch.
+struct batch_channel
+{
+    enum class io: unsigned {read = 0u, write = 1u};
+
+    struct impl;
+
+    /// @brief Shared handle to one side of a batch channel.
+    /// @note Handles keep the channel's queue alive, so they can be used
+    ///   from other threads even after the channel's been destroyed.
+    struct handle
+    {
+        handle() noexcept;
+        handle(std::shared_ptr<impl> pimpl_, io side_) noexcept;
+
+        /// @brief Sends the given batch, waiting while the queue's full.
+        /// @return Whether the batch was sent. It's not if either side's
+        ///   been closed.
+        auto send(record_batch batch) const -> bool;
+
+        /// @brief Receives the next batch, waiting while the queue's empty.
+        /// @return Batch received, or empty optional once the write side's
+        ///   been closed and all of the sent batches have been received.
+        auto receive() const -> std::optional<record_batch>;
+
+        /// @brief Closes this handle's side of the channel.
+        auto close() const -> void;
+
+        [[nodiscard]] auto get_side() const noexcept -> io;
+
+    private:
+        std::shared_ptr<impl> pimpl;
+        io side{io::read};
+    };
+
+    static constexpr auto default_capacity = std::size_t{4u};
+
+    /// @param[in] capacity Maximum number of batches to queue. Senders
+    ///   wait while this many batches are queued.
+    explicit batch_channel(std::size_t capacity = default_capacity);
+
+    batch_channel(batch_channel&& other) noexcept;
+
+    ~batch_channel() noexcept;
+
+    auto operator=(batch_channel&& other) noexcept -> batch_channel&;
+
+    // This class is not meant to be copied!
+    batch_channel(const batch_channel& other) = delete;
+    auto operator=(const batch_channel& other) -> batch_channel& = delete;
+
+    [[nodiscard]] auto get(io side) const noexcept -> handle;
+
+    /// @brief Gets the number of batches that have been sent.
+    [[nodiscard]] auto get_sent() const -> std::size_t;
+
+    friend auto operator==(const batch_channel& lhs,
+                           const batch_channel& rhs) noexcept -> bool
+    {
+        return lhs.pimpl == rhs.pimpl;
+    }
+
+private:
+    std::shared_ptr<impl> pimpl;
+};
+
+static_assert(std::is_default_constructible_v<batch_channel>);
+static_assert(std::is_nothrow_move_constructible_v<batch_channel>);
+static_assert(!std::is_copy_constructible_v<batch_channel>);
+
+auto operator<<(std::ostream& os, batch_channel::io value)
+    -> std::ostream&;
+
+auto operator<<(std::ostream& os, const batch_channel& value)
+    -> std::ostream&;
+
+}
+
+#endif /* batch_channel_hpp */
@@ -0,0 +1,65 @@
+#ifndef builtin_hpp
+#define builtin_hpp
+
+#include <concepts> // for std::regular.
+#include <map>
+#include <ostream>
+
+#include "flow/aggregator.hpp"
+#include "flow/batch_adapter.hpp"
+#include "flow/batch_channel.hpp"
+#include "flow/owning_descriptor.hpp"
+#include "flow/projector.hpp"
+#include "flow/reference_descriptor.hpp"
+#include "flow/sorter.hpp"
+#include "flow/variant.hpp" // for <variant>, flow::variant, + ostream support
+#include "flow/wait_status.hpp"
+
+namespace flow {
+
+/// @brief Built-in implementation.
+/// @details Built-ins are run on threads of the instantiating process
+///   instead of being forked & exec'd. That avoids the cost of spawning
+///   processes and of data having to cross another process boundary.
+/// @note This is a <code>node</code> implementation type.
+/// @see node.
+using builtin = variant<
+    sorter,
+    aggregator,
+    projector,
+    batch_adapter
+>;
+
+// Ensure regularity...
+static_assert(std::regular<builtin>);
+
+/// @brief Descriptors that a running <code>builtin</code> uses for each of
+///   its byte stream ports.
+using builtin_descriptors = std::map<reference_descriptor, owning_descriptor>;
+
+/// @brief Batch channel sides that a running <code>builtin</code> uses for
+///   each of its columnar ports.
+using builtin_batches = std::map<reference_descriptor, batch_channel::handle>;
+
+/// @brief What a running <code>builtin</code> uses for each of its ports.
+struct builtin_ports
+{
+    builtin_descriptors descriptors;
+    builtin_batches batches;
+};
+
+/// @brief Runs the given built-in to completion.
+/// @note All the given ports are closed by the time this returns, so
+///   readers of the built-in's output see end-of-file.
+/// @param[in] implementation Built-in to run.
+/// @param[in,out] ports Descriptors & batch channels for the built-in's
+///   ports.
+/// @param[out] diags Diagnostics about why the built-in failed.
+/// @return Status akin to that of a process which ran the built-in.
+auto run(const builtin& implementation,
+         builtin_ports& ports,
+         std::ostream& diags) -> wait_status;
+
+}
+
+#endif /* builtin_hpp */
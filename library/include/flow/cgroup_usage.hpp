@@ -0,0 +1,52 @@
+#ifndef cgroup_usage_hpp
+#define cgroup_usage_hpp
+
+#include <chrono>
+#include <cstdint> // for std::uint64_t
+#include <optional>
+#include <ostream>
+
+namespace flow {
+
+/// @brief Resource usage accounted to a control group.
+/// @details This is what's read from the <code>cpu.stat</code>,
+///   <code>memory.current</code> & <code>memory.peak</code> files of the
+///   cgroup v2 control group made for an instance. Unlike
+///   <code>process_usage</code>, it's available while the processes in
+///   the group are still running, & includes all of their descendants.
+/// @see get_cgroup_usage, resource_limits.
+struct cgroup_usage
+{
+    /// @brief CPU time spent by the processes.
+    std::chrono::microseconds cpu_time{};
+
+    /// @brief CPU time spent executing in user mode.
+    std::chrono::microseconds user_time{};
+
+    /// @brief CPU time spent executing in kernel mode.
+    std::chrono::microseconds system_time{};
+
+    /// @brief Number of periods the processes were throttled in for
+    ///   having used up their CPU quota.
+    std::uint64_t throttled_periods{};
+
+    /// @brief Time the processes were throttled for.
+    std::chrono::microseconds throttled_time{};
+
+    /// @brief Memory in use, in bytes, if the memory controller's enabled
+    ///   for the group.
+    std::optional<std::uint64_t> memory_current;
+
+    /// @brief Most memory that's been in use, in bytes, if the memory
+    ///   controller's enabled for the group & it keeps track of this.
+    std::optional<std::uint64_t> memory_peak;
+
+    auto operator==(const cgroup_usage& other) const -> bool = default;
+};
+
+auto operator<<(std::ostream& os, const cgroup_usage& value)
+    -> std::ostream&;
+
+}
+
+#endif /* cgroup_usage_hpp */
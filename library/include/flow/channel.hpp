@@ -5,6 +5,7 @@
 #include <span>
 #include <type_traits> // for std::is_default_constructible_v
 
+#include "flow/batch_channel.hpp"
 #include "flow/link.hpp"
 #include "flow/file_channel.hpp"
 #include "flow/forwarding_channel.hpp"
@@ -25,7 +26,8 @@ struct reference_channel
         file_channel,
         pipe_channel,
         signal_channel,
-        forwarding_channel
+        forwarding_channel,
+        batch_channel
     >;
 
     /// @brief Non-owning pointer to referenced channel.
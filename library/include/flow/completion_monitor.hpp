@@ -0,0 +1,89 @@
+#ifndef completion_monitor_hpp
+#define completion_monitor_hpp
+
+#include <cstddef> // for std::size_t
+#include <experimental/propagate_const>
+#include <functional>
+#include <future>
+#include <memory> // for std::unique_ptr
+#include <type_traits> // for std::is_move_constructible_v
+#include <vector>
+
+#include "flow/instance.hpp"
+#include "flow/reference_descriptor.hpp"
+#include "flow/wait_result.hpp"
+
+namespace flow {
+
+/// @brief Monitor of the completion of instances, without blocking on them.
+/// @details This is for driving instances from an event loop, rather than
+///   from threads that each block waiting on an instance. Its descriptor
+///   becomes readable whenever a process or built-in of a tracked instance
+///   changes state. Polling then collects the results of what changed,
+///   & completes the instances that have entirely finished. A completed
+///   instance's callback is called & its future made ready, with all of
+///   its results, & it stops being tracked.
+/// @note Tracked instances must not be moved nor destroyed until they're
+///   completed or untracked.
+/// @note Only the descriptor is made ready from other threads. Tracking,
+///   untracking, & polling aren't thread-safe, so are meant to be done
+///   from the thread running the event loop.
+/// @see wait(instance&).
+struct completion_monitor
+{
+    struct impl;
+
+    /// @brief Function called for an instance when it's completed.
+    using callback = std::function<void(instance& object,
+                                        const std::vector<wait_result>& results)>;
+
+    /// @brief Makes a monitor.
+    /// @throws std::system_error if the monitor's descriptor can't be made.
+    completion_monitor();
+
+    completion_monitor(completion_monitor&& other) noexcept;
+
+    /// @brief Destroys the monitor, untracking whatever's still tracked.
+    ~completion_monitor();
+
+    auto operator=(completion_monitor&& other) noexcept -> completion_monitor&;
+
+    /// @brief Tracks the given instance until it completes.
+    /// @note An instance that's already finished completes on the next
+    ///   poll.
+    /// @param[in,out] object Instance to track.
+    /// @param[in] on_complete Function to call from <code>poll</code> when
+    ///   the instance completes.
+    /// @return Future of the results of the instance, made ready when the
+    ///   instance completes. Untracking first breaks its promise instead.
+    /// @throws std::invalid_argument if the instance is already tracked.
+    auto track(instance& object, callback on_complete = {})
+        -> std::future<std::vector<wait_result>>;
+
+    /// @brief Stops tracking the given instance.
+    /// @return Whether the instance had been tracked.
+    auto untrack(instance& object) -> bool;
+
+    /// @brief Collects the results of the tracked instances that have
+    ///   changed state, without blocking.
+    /// @return Number of instances completed by this call.
+    auto poll() -> std::size_t;
+
+    /// @brief Descriptor that's readable while there's something to poll.
+    /// @note Pass this to <code>epoll_ctl</code>, <code>poll</code>, or the
+    ///   like, to find out when to poll.
+    [[nodiscard]] auto descriptor() const noexcept -> reference_descriptor;
+
+    /// @brief Gets the number of instances being tracked.
+    [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+private:
+    std::experimental::propagate_const<std::unique_ptr<impl>> pimpl;
+};
+
+static_assert(std::is_move_constructible_v<completion_monitor>);
+static_assert(!std::is_copy_constructible_v<completion_monitor>);
+
+}
+
+#endif /* completion_monitor_hpp */
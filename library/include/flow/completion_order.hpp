@@ -0,0 +1,119 @@
+#ifndef completion_order_hpp
+#define completion_order_hpp
+
+#include <cstddef> // for std::ptrdiff_t
+#include <iterator> // for std::default_sentinel_t, std::input_iterator_tag
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "flow/instance.hpp"
+#include "flow/node_name.hpp"
+#include "flow/wait_result.hpp"
+
+namespace flow {
+
+/// @brief Result of waiting for a process or built-in of an instance.
+/// @see wait_any.
+struct descendant_wait_result
+{
+    /// @brief Names of the descendant, from the instance's child on down.
+    /// @note Empty for the instance itself.
+    std::vector<node_name> names;
+
+    /// @brief Result of waiting for the descendant, with the status it
+    ///   finished with.
+    wait_result result;
+};
+
+auto operator<<(std::ostream& os, const descendant_wait_result& value)
+    -> std::ostream&;
+
+/// @brief Waits for whichever process or built-in of the given instance
+///   finishes first, out of those that haven't been waited for.
+/// @details Unlike <code>wait(instance&)</code>, which waits for the
+///   children of a system instance in the order of their names, this
+///   returns as soon as any of its descendants has finished.
+/// @note The descendant gets waited for. So calling this again waits for
+///   another one.
+/// @note This replaces any function set via
+///   <code>owning_process_id::on_change</code> for the processes it waits
+///   for. So don't use it on instances a <code>completion_monitor</code>
+///   is tracking.
+/// @return Result for the descendant that finished, else nothing if
+///   there's nothing left to wait for.
+/// @see completion_order.
+auto wait_any(instance& object) -> std::optional<descendant_wait_result>;
+
+/// @brief Range of the results of waiting for the processes & built-ins of
+///   an instance, in the order they finish.
+/// @details Iterating this calls <code>wait_any</code> for each element.
+///   So it ends once everything in the instance has been waited for.
+/// @note The instance must outlive this & its iterators.
+/// @see wait_any.
+struct completion_order
+{
+    struct iterator
+    {
+        using iterator_category = std::input_iterator_tag;
+        using value_type = descendant_wait_result;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        iterator() noexcept = default;
+
+        /// @brief Waits for the first result of the given instance.
+        explicit iterator(instance& object);
+
+        auto operator*() const -> reference
+        {
+            return *current;
+        }
+
+        auto operator->() const -> pointer
+        {
+            return &(*current);
+        }
+
+        /// @brief Waits for the next result.
+        auto operator++() -> iterator&;
+
+        auto operator++(int) -> void
+        {
+            ++*this;
+        }
+
+        auto operator==(std::default_sentinel_t) const noexcept -> bool
+        {
+            return !current;
+        }
+
+    private:
+        instance *object{};
+        std::optional<descendant_wait_result> current;
+    };
+
+    explicit completion_order(instance& object) noexcept: object{&object}
+    {
+        // Intentionally empty.
+    }
+
+    /// @brief Waits for the first result.
+    [[nodiscard]] auto begin() const -> iterator
+    {
+        return iterator{*object};
+    }
+
+    [[nodiscard]] auto end() const noexcept -> std::default_sentinel_t
+    {
+        return std::default_sentinel;
+    }
+
+private:
+    instance *object{};
+};
+
+}
+
+#endif /* completion_order_hpp */
@@ -1,14 +1,102 @@
 #ifndef executable_hpp
 #define executable_hpp
 
+#include <chrono>
 #include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
 #include <filesystem>
 #include <ostream>
 #include <string>
 #include <vector>
 
+#include "flow/placement_policy.hpp"
+#include "flow/resource_limits.hpp"
+#include "flow/scheduling_policy.hpp"
+
 namespace flow {
 
+/// @brief When to create the process of an executable.
+/// @see executable.
+enum class start_policy: unsigned {
+    /// @brief Create it when the executable's instantiated.
+    eager,
+
+    /// @brief Create it once data is first available to read from any of
+    ///   the pipes linked to its input ports.
+    /// @details Until then, the process costs only the watching of those
+    ///   pipes. If they're all closed without any data having been written
+    ///   to them, the process is never created & it's waited for as if it
+    ///   exited successfully. Executables without linked input pipes are
+    ///   created eagerly regardless.
+    /// @note Only use this for executables that needn't run for no input.
+    on_data,
+};
+
+constexpr auto to_cstring(start_policy value) noexcept -> const char*
+{
+    switch (value) {
+    case start_policy::eager: return "eager";
+    case start_policy::on_data: return "on_data";
+    }
+    return "unknown";
+}
+
+auto operator<<(std::ostream& os, start_policy value) -> std::ostream&;
+
+/// @brief When to restart the process of an executable once it terminates.
+/// @see executable, restart_limits.
+enum class restart_policy: unsigned {
+    /// @brief Never restart it.
+    never,
+
+    /// @brief Restart it if it exits unsuccessfully or is killed by a
+    ///   signal.
+    on_failure,
+
+    /// @brief Restart it however it terminates.
+    always,
+};
+
+constexpr auto to_cstring(restart_policy value) noexcept -> const char*
+{
+    switch (value) {
+    case restart_policy::never: return "never";
+    case restart_policy::on_failure: return "on_failure";
+    case restart_policy::always: return "always";
+    }
+    return "unknown";
+}
+
+auto operator<<(std::ostream& os, restart_policy value) -> std::ostream&;
+
+/// @brief Limits on restarting the process of an executable.
+/// @details Each restart is delayed by a backoff that starts out at
+///   <code>initial_backoff</code> & doubles with every restart, up to
+///   <code>max_backoff</code>. It's reset once a restarted process has run
+///   for <code>max_backoff</code>. Restarting gives up, letting the
+///   process's termination be waited for, once it's been restarted
+///   <code>max_restarts</code> times within <code>window</code>.
+/// @see restart_policy.
+struct restart_limits
+{
+    std::chrono::milliseconds initial_backoff{100};
+    std::chrono::milliseconds max_backoff{10'000};
+
+    /// @brief Maximum number of restarts within the window.
+    /// @note Zero is for no maximum.
+    std::size_t max_restarts{5u};
+
+    /// @brief Window of time to count restarts within.
+    /// @note Zero is for counting all restarts.
+    std::chrono::milliseconds window{60'000};
+
+    auto operator==(const restart_limits& other) const noexcept -> bool =
+        default;
+};
+
+auto operator<<(std::ostream& os, const restart_limits& value)
+    -> std::ostream&;
+
 /// @brief Executable.
 /// @note This is a <code>node</code> implementation type.
 /// @see node.
@@ -24,6 +112,35 @@ struct executable
     /// @todo Consider what sense this member makes & removing it if
     ///   there isn't enough reason to keep it around.
     std::filesystem::path working_directory;
+
+    /// @brief When to create the process of this executable.
+    start_policy start{start_policy::eager};
+
+    /// @brief When to restart the process of this executable.
+    /// @details A restarted process is created onto the same channels as
+    ///   the process it replaces. So the nodes it's linked to carry on.
+    ///   Waiting for it only sees its termination once it's not to be
+    ///   restarted anymore.
+    /// @note Its pipes are kept open for as long as it may be restarted.
+    ///   So their readers don't see end-of-file until then.
+    restart_policy restart{restart_policy::never};
+
+    /// @brief Limits on restarting the process of this executable.
+    restart_limits limits;
+
+    /// @brief Limits on the resources the process of this executable may
+    ///   use.
+    /// @details If these are any different from the default, the process
+    ///   is created into a control group of its own that enforces them.
+    /// @see instantiate_options::cgroup.
+    resource_limits resources;
+
+    /// @brief Placement of the process of this executable onto CPUs &
+    ///   NUMA nodes.
+    placement_policy placement;
+
+    /// @brief Scheduling attributes of the process of this executable.
+    scheduling_policy scheduling;
 };
 
 inline auto operator==(const executable& lhs,
@@ -31,7 +148,13 @@ inline auto operator==(const executable& lhs,
 {
     return (lhs.file == rhs.file)
         && (lhs.arguments == rhs.arguments)
-        && (lhs.working_directory == rhs.working_directory);
+        && (lhs.working_directory == rhs.working_directory)
+        && (lhs.start == rhs.start)
+        && (lhs.restart == rhs.restart)
+        && (lhs.limits == rhs.limits)
+        && (lhs.resources == rhs.resources)
+        && (lhs.placement == rhs.placement)
+        && (lhs.scheduling == rhs.scheduling);
 }
 
 static_assert(std::regular<executable>);
@@ -1,17 +1,25 @@
 #ifndef instance_hpp
 #define instance_hpp
 
+#include <chrono>
+#include <cstddef> // for std::size_t
+#include <filesystem>
+#include <future>
 #include <map>
+#include <memory> // for std::unique_ptr, std::shared_ptr
+#include <optional>
 #include <ostream>
 #include <type_traits> // for std::is_default_constructible_v
 #include <vector>
 
 #include "ext/fstream.hpp"
 
+#include "flow/cgroup_usage.hpp"
 #include "flow/channel.hpp"
 #include "flow/link.hpp"
 #include "flow/environment_map.hpp"
 #include "flow/owning_process_id.hpp"
+#include "flow/process_usage.hpp"
 #include "flow/reference_process_id.hpp"
 #include "flow/node_name.hpp"
 #include "flow/variant.hpp"
@@ -19,6 +27,11 @@
 
 namespace flow {
 
+namespace detail {
+struct control_group;
+struct notifier;
+}
+
 /// @brief Instance of a <code>node</code>.
 /// @note This type is intended to be moveable, but not copyable.
 ///   Relatedly, it's not intended to support any kind of comparison.
@@ -45,6 +58,11 @@ struct instance
         std::vector<channel> channels;
 
         reference_process_id pgrp{default_pgrp};
+
+        /// @brief Control group made for the processes of this instance, if
+        ///   any.
+        /// @see flow::system::resources, get_cgroup_usage.
+        std::shared_ptr<detail::control_group> cgroup;
     };
 
     /// @brief Information specific to "forked" instances.
@@ -58,9 +76,46 @@ struct instance
         ext::fstream diags;
 
         variant<owning_process_id, wait_status> state;
+
+        /// @brief Resource usage of the process once it's been waited for.
+        /// @note Includes that of the processes it was restarted from.
+        process_usage usage;
+
+        /// @brief Number of times the process had been restarted, as of it
+        ///   last being waited for.
+        /// @see executable::restart, owning_process_id::restarts.
+        std::size_t restarts{};
+
+        /// @brief Control group the process was created into, if any.
+        /// @note Restarted processes are created into it too.
+        /// @see executable::resources, get_cgroup_usage.
+        std::shared_ptr<detail::control_group> cgroup;
     };
 
-    variant<system, forked> info;
+    /// @brief Information specific to "builtin" instances.
+    /// @note Instantiating a builtin node, results in a builtin instance.
+    /// @see flow::builtin.
+    struct builtin
+    {
+        /// @brief Diagnostics stream.
+        /// @note This is heap allocated so the thread running the built-in
+        ///   can keep writing to it while this instance gets moved around.
+        ///   Only read it after the built-in has been waited for.
+        std::unique_ptr<ext::fstream> diags;
+
+        /// @brief Future result of the running built-in until waited for,
+        ///   then the status it finished with.
+        variant<std::future<wait_status>, wait_status> state;
+
+        /// @brief Notifier the thread running the built-in notifies just
+        ///   before it finishes, if it's been started.
+        /// @note This is shared with that thread, so it stays put while
+        ///   this instance gets moved around.
+        /// @see completion_monitor.
+        std::shared_ptr<detail::notifier> finishing;
+    };
+
+    variant<system, forked, builtin> info;
 };
 
 static_assert(std::is_default_constructible_v<instance::system>);
@@ -69,6 +124,9 @@ static_assert(std::is_move_assignable_v<instance::system>);
 
 static_assert(std::is_default_constructible_v<instance::forked>);
 
+static_assert(std::is_default_constructible_v<instance::builtin>);
+static_assert(std::is_move_constructible_v<instance::builtin>);
+
 static_assert(std::is_default_constructible_v<instance>);
 static_assert(std::is_move_constructible_v<instance>);
 static_assert(std::is_move_assignable_v<instance>);
@@ -86,6 +144,35 @@ auto total_descendants(const instance& object) -> std::size_t;
 auto total_channels(const instance& object) -> std::size_t;
 auto get_wait_status(const instance& object) -> wait_status;
 
+/// @brief Totals the resource usage of the processes of the given
+///   instance & of its descendants.
+/// @note Only processes that have been waited for have usage to total.
+///   Built-ins run within this process, so have none of their own.
+auto total_usage(const instance& object) -> process_usage;
+
+/// @brief Sets the given deadline for all the processes of the given
+///   instance.
+/// @note Built-ins run within this process, so aren't limited by this.
+/// @see owning_process_id::set_deadline, instantiate_options::deadline.
+auto set_deadline(instance& object,
+                  std::chrono::steady_clock::time_point deadline,
+                  std::chrono::nanoseconds grace) -> void;
+
+/// @brief Gets the path of the control group made for the given instance.
+/// @return Path of the group's directory, else an empty path if no group
+///   was made for it.
+/// @see resource_limits.
+auto get_cgroup_path(const instance& object) -> std::filesystem::path;
+
+/// @brief Reads the resource usage accounted to the control group made for
+///   the given instance.
+/// @details That of a system instance's group includes that of all its
+///   descendants' groups.
+/// @return Usage, else nothing if no group was made for the instance or
+///   its usage couldn't be read.
+/// @see resource_limits.
+auto get_cgroup_usage(const instance& object) -> std::optional<cgroup_usage>;
+
 }
 
 #endif /* instance_hpp */
@@ -0,0 +1,101 @@
+#ifndef instance_pool_hpp
+#define instance_pool_hpp
+
+#include <chrono>
+#include <cstddef> // for std::size_t
+#include <experimental/propagate_const>
+#include <memory> // for std::unique_ptr
+#include <type_traits> // for std::is_move_constructible_v
+
+#include "flow/instance.hpp"
+#include "flow/instantiate.hpp"
+#include "flow/node.hpp"
+
+namespace flow {
+
+/// @brief Metrics of an <code>instance_pool</code>.
+/// @see instance_pool.
+struct instance_pool_metrics
+{
+    /// @brief Number of checkouts given an already running instance.
+    std::size_t hits{};
+
+    /// @brief Number of checkouts that had to instantiate.
+    std::size_t misses{};
+
+    /// @brief Number of pooled instances that had exited by the time they
+    ///   would've been checked out, so were replaced instead.
+    std::size_t expired{};
+
+    /// @brief Number of instantiations made.
+    std::size_t spawns{};
+
+    /// @brief Number of instantiations that failed.
+    std::size_t failures{};
+
+    /// @brief Total time the instantiations took.
+    std::chrono::nanoseconds total_spawn_time{};
+
+    /// @brief Longest time any instantiation took.
+    std::chrono::nanoseconds max_spawn_time{};
+};
+
+/// @brief Pool of running instances of a node, for taking the cost of
+///   instantiating it off the path of whatever needs an instance.
+/// @details The node is compiled into a <code>plan</code> once. A thread
+///   then keeps the pool filled with instances of it, instantiated ahead
+///   of time & left running. Until checked out, their processes are
+///   typically blocked reading their inputs. Checking out gives the
+///   caller an instance to use like any other. Its
+///   <code>user_endpoint</code> links' pipes are among its channels.
+/// @note Any <code>instantiate_options::deadline</code> starts counting
+///   down when an instance is checked out, not while it's pooled.
+/// @note Instances are used once. Give them back via <code>recycle</code>
+///   to have the pool wait for them instead of the caller.
+/// @note This is thread-safe.
+/// @see plan, instance_pool_metrics.
+struct instance_pool
+{
+    struct impl;
+
+    /// @brief Makes a pool of the given number of instances of the given
+    ///   node, instantiated with the given options.
+    /// @throws Whatever <code>compile</code> throws for @p node.
+    instance_pool(const node& node, std::size_t capacity,
+                  const instantiate_options& opts = {});
+
+    instance_pool(instance_pool&& other) noexcept;
+
+    /// @brief Destroys the pool & its pooled & recycled instances.
+    /// @note Destroying an instance closes its channels & waits for its
+    ///   processes, which typically exit once their inputs are closed.
+    ~instance_pool();
+
+    auto operator=(instance_pool&& other) noexcept -> instance_pool&;
+
+    /// @brief Checks out a running instance, instantiating one if none is.
+    /// @throws Whatever <code>instantiate</code> throws if it has to.
+    auto checkout() -> instance;
+
+    /// @brief Has the pool wait for & destroy the given instance.
+    auto recycle(instance object) -> void;
+
+    /// @brief Gets the number of instances the pool tries to keep ready.
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    /// @brief Gets the number of instances ready to be checked out.
+    [[nodiscard]] auto ready() const -> std::size_t;
+
+    /// @brief Gets the pool's metrics so far.
+    [[nodiscard]] auto metrics() const -> instance_pool_metrics;
+
+private:
+    std::experimental::propagate_const<std::unique_ptr<impl>> pimpl;
+};
+
+static_assert(std::is_move_constructible_v<instance_pool>);
+static_assert(!std::is_copy_constructible_v<instance_pool>);
+
+}
+
+#endif /* instance_pool_hpp */
@@ -1,6 +1,9 @@
 #ifndef instantiate_hpp
 #define instantiate_hpp
 
+#include <chrono>
+#include <filesystem>
+#include <memory> // for std::shared_ptr
 #include <ostream>
 #include <stdexcept> // for std::invalid_argument
 
@@ -9,6 +12,34 @@
 
 namespace flow {
 
+/// @brief How to create the processes of executables.
+/// @see instantiate_options.
+enum class process_creation: unsigned {
+    /// @brief Spawn processes where possible, else fork them.
+    /// @details Spawning uses <code>posix_spawn</code>, whose cost unlike
+    ///   forking's doesn't grow with the parent's resident set size. Forking
+    ///   is still used for children that must do more for themselves than
+    ///   spawning can express, like substituting their process ID into
+    ///   their arguments, or joining a control group.
+    spawn,
+
+    /// @brief Always fork processes and set them up from the forked child.
+    fork,
+
+    /// @brief Have a zygote process create processes where possible, else
+    ///   fork them.
+    /// @details The zygote is a small helper process started once, on first
+    ///   use, that forks children from its own small address space instead
+    ///   of this process's. The children are still children of this process.
+    ///   There's one zygote per host process, not one per instance: every
+    ///   instance using this option shares it, & requests to it are handled
+    ///   one at a time. The zygote's executable is <code>flow-zygote</code>.
+    ///   It's found from the <code>FLOW_ZYGOTE</code> environment variable
+    ///   if set, else beside this library or the executable using it. If
+    ///   it can't be started, that's reported once to the diagnostics.
+    zygote,
+};
+
 /// @brief Options for <code>instantiate</code>.
 /// @see instantiate.
 struct instantiate_options
@@ -19,6 +50,38 @@ struct instantiate_options
 
     /// @brief Base environment settings.
     environment_map environment;
+
+    /// @brief How to create the processes of executables.
+    process_creation creation{process_creation::spawn};
+
+    /// @brief How long after being instantiated processes may run, else
+    ///   zero for no limit.
+    /// @details Processes still running by then are sent
+    ///   <code>SIGTERM</code>, & then <code>SIGKILL</code> if still running
+    ///   <code>kill_grace</code> after that.
+    /// @note Built-ins run within this process, so aren't limited by this.
+    /// @see owning_process_id::set_deadline.
+    std::chrono::nanoseconds deadline{};
+
+    /// @brief How long after being sent <code>SIGTERM</code> for passing
+    ///   their deadline processes have to terminate.
+    std::chrono::nanoseconds kill_grace{std::chrono::seconds{5}};
+
+    /// @brief Directory of the cgroup v2 control group to make the control
+    ///   groups of instances within, else empty for this process's own.
+    /// @details Control groups are only made for instances of nodes that
+    ///   have resource limits, or that are within systems that do. The
+    ///   controllers the limits need are enabled for this group, so it
+    ///   should be one delegated to this process that it's not itself in.
+    ///   The kernel doesn't allow enabling them for a group with processes
+    ///   in it, other than the root group. So unless this process is in
+    ///   the root group, limits are only enforced with this set. Without
+    ///   it, the groups made are still good for accounting.
+    ///   If control groups can't be made, or limits can't be applied,
+    ///   why not is written to the diagnostics & instantiating carries on
+    ///   without them.
+    /// @see resource_limits.
+    std::filesystem::path cgroup;
 };
 
 struct invalid_executable: std::invalid_argument
@@ -49,6 +112,46 @@ auto instantiate(const node& node, std::ostream& diags,
                  const instantiate_options& opts = {})
     -> instance;
 
+/// @brief Compiled, reusable plan for instantiating a node.
+/// @details Compiling a node does all the work of instantiating it that
+///   doesn't depend on the particular instantiation. That's validating its
+///   links & port maps, flattening its tree of nodes, working out the
+///   channel each link needs & the descriptor actions of each executable,
+///   finding the executables' files, and making their argument &
+///   environment blocks. Instantiating the plan is then just making the
+///   channels & creating the processes.
+/// @note Copies share the same immutable compiled state, so a plan can be
+///   instantiated any number of times, from any number of threads at once.
+/// @note Executables' files are found when compiled. Later changes to the
+///   directories of <code>PATH</code> don't change what a plan executes.
+/// @see compile, instantiate(const plan&, std::ostream&).
+struct plan
+{
+    struct impl;
+
+    /// @brief Compiled state, or null if not compiled.
+    std::shared_ptr<const impl> pimpl;
+};
+
+/// @brief Compiles the given node into a plan for instantiating it.
+/// @throws invalid_link, invalid_executable, or invalid_port_map like
+///   <code>instantiate</code> does for @p node.
+/// @see plan, instantiate(const node&, std::ostream&,
+///   const instantiate_options&).
+auto compile(const node& node, const instantiate_options& opts = {})
+    -> plan;
+
+/// @brief Instantiates the given plan.
+/// @details This is equivalent to instantiating the node the plan was
+///   compiled from with the options it was compiled with.
+/// @param[in] plan Plan to instantiate.
+/// @param[out] diags Diagnostic information and warnings that don't by
+///   themselves prevent instantiation.
+/// @throws invalid_link if a file a link forwards between can't be opened.
+/// @throws std::invalid_argument if @p plan wasn't compiled.
+/// @see compile.
+auto instantiate(const plan& plan, std::ostream& diags) -> instance;
+
 }
 
 #endif /* instantiate_hpp */
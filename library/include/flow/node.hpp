@@ -5,6 +5,7 @@
 #include <ostream>
 #include <set>
 
+#include "flow/builtin.hpp"
 #include "flow/executable.hpp"
 #include "flow/io_type.hpp"
 #include "flow/link.hpp"
@@ -41,13 +42,20 @@ struct node
         // Intentionally empty.
     }
 
+    node(builtin type_info, port_map des_map = std_ports)
+        : interface{std::move(des_map)},
+          implementation{std::move(type_info)}
+    {
+        // Intentionally empty.
+    }
+
     /// @brief Ports of the <code>node</code>.
     /// @note This is considered an _interface_ component of this type.
     port_map interface;
 
     /// @brief Implementation specific information.
     /// @note This is considered an _internal_ component of this type.
-    variant<system, executable> implementation;
+    variant<system, executable, builtin> implementation;
 };
 
 inline auto operator==(const node& lhs,
@@ -1,17 +1,33 @@
 #ifndef owning_process_id_hpp
 #define owning_process_id_hpp
 
+#include <chrono>
+#include <cstddef> // for std::size_t
 #include <experimental/propagate_const>
+#include <functional>
 #include <memory> // for std::unique_ptr
+#include <optional>
 #include <type_traits> // for std::is_default_constructible_v
 
+#include <spawn.h> // for posix_spawn_file_actions_t, posix_spawnattr_t
+
+#include "flow/owning_descriptor.hpp"
+#include "flow/process_usage.hpp"
 #include "flow/reference_process_id.hpp"
 #include "flow/wait_result.hpp"
 
 namespace flow {
 
+namespace detail {
+struct deferred_process;
+struct process_supervisor;
+}
+
 /// @brief Owning process identifier.
 /// @note Provides some RAII-styled ownership handling for spawning processes.
+/// @note Processes are waited on via process descriptors where possible,
+///   else by a thread waiting on any child process. Setting the
+///   <code>FLOW_NO_PIDFDS</code> environment variable forces the latter.
 /// @note Implementation of this was based on POSIX process handling.
 ///   There has been at least one proposal for bring process handling into the
 ///   the C++ standard which may provide ideas for improving this code.
@@ -26,8 +42,34 @@ struct owning_process_id
 
     static auto fork() -> reference_process_id;
 
+    /// @brief Forks this process into the cgroup v2 control group of the
+    ///   given directory descriptor.
+    /// @details This uses <code>clone3</code>'s
+    ///   <code>CLONE_INTO_CGROUP</code>, so the child's in the group from
+    ///   the start. Where that's not supported or permitted, this forks
+    ///   like <code>fork()</code> instead, leaving the child in this
+    ///   process's group for it to move itself.
+    /// @note The child of this can only call async-signal-safe functions
+    ///   like that of <code>fork()</code>.
+    static auto fork(reference_descriptor cgroup) -> reference_process_id;
+
+    /// @brief Spawns a process via <code>posix_spawn</code>.
+    /// @return Identifier of the new process, else
+    ///   <code>invalid_process_id</code> with <code>errno</code> set to the
+    ///   reason.
+    static auto spawn(const char *path,
+                      const posix_spawn_file_actions_t *file_actions,
+                      const posix_spawnattr_t *attrs,
+                      char * const *argv,
+                      char * const *envp) -> reference_process_id;
+
     owning_process_id();
     owning_process_id(reference_process_id id);
+
+    /// @brief Takes ownership of the identified process and of the given
+    ///   process file descriptor referring to it.
+    owning_process_id(reference_process_id id, owning_descriptor pidfd);
+
     owning_process_id(const owning_process_id& other) = delete;
     owning_process_id(owning_process_id&& other) noexcept;
     ~owning_process_id();
@@ -42,10 +84,58 @@ struct owning_process_id
         return std::int32_t(reference_process_id(*this));
     }
 
+    /// @brief Waits for the process to terminate.
+    /// @details With <code>wait_options::untraced()</code>, this also
+    ///   returns once the process stops, with its
+    ///   <code>wait_stopped_status</code>. Each stop is returned once. The
+    ///   process continuing isn't reported.
+    /// @param[in] flags Options like <code>wait_options::nohang()</code>.
+    /// @return New status of the process, else its last status if there's
+    ///   no new one yet with <code>nohang</code> or it's been waited on.
     auto wait(wait_option flags = {}) noexcept -> wait_status;
 
+    /// @brief Waits like <code>wait</code>, but only until the given
+    ///   deadline.
+    /// @return Status like <code>wait</code> returns, else nothing if the
+    ///   deadline passed first.
+    auto wait_until(std::chrono::steady_clock::time_point deadline,
+                    wait_option flags = {}) noexcept
+        -> std::optional<wait_status>;
+
+    /// @brief Waits like <code>wait</code>, but only for up to the given
+    ///   time.
+    /// @see wait_until.
+    auto wait_for(std::chrono::nanoseconds timeout,
+                  wait_option flags = {}) noexcept
+        -> std::optional<wait_status>;
+
+    /// @brief Sets the deadline by which the process is to have terminated.
+    /// @details If it hasn't by then, it's sent <code>SIGTERM</code>. If it
+    ///   still hasn't @p grace after that, it's sent <code>SIGKILL</code>.
+    ///   Setting the deadline again moves it.
+    /// @note A process whose creation is deferred & that's yet to be created
+    ///   at the deadline is sent <code>SIGTERM</code> once it's created.
+    /// @throws std::system_error if the deadline can't be set.
+    auto set_deadline(std::chrono::steady_clock::time_point deadline,
+                      std::chrono::nanoseconds grace) -> void;
+
+    /// @brief Sets the function to call whenever the process changes state.
+    /// @details That's whenever there's a new status to wait for. Including
+    ///   when a process whose creation is deferred gets created or
+    ///   cancelled. If there's been any change already, the function's
+    ///   called right away. Setting an empty function stops the calls.
+    /// @note The function's called from whichever thread observes the
+    ///   change. So it must not block, nor use this.
+    /// @see completion_monitor.
+    auto on_change(std::function<void()> callback) -> void;
+
     auto operator<=>(const owning_process_id& other) const noexcept;
 
+    /// @brief Process file descriptor for the process, if there is one.
+    /// @note Unlike the process identifier, this can't come to refer to
+    ///   another process after the process is waited on.
+    [[nodiscard]] auto pidfd() const noexcept -> reference_descriptor;
+
     /// @brief Status of the process.
     /// @note This is an observer function.
     /// @return <code>wait_unknown_status{}</code> if the associated process
@@ -53,7 +143,35 @@ struct owning_process_id
     ///   process).
     [[nodiscard]] auto status() const noexcept -> wait_status;
 
+    /// @brief Resource usage of the process.
+    /// @return Usage of the process once it's terminated & been waited
+    ///   for, else zero usage.
+    [[nodiscard]] auto usage() const noexcept -> process_usage;
+
+    /// @brief Number of times the process has been restarted.
+    /// @see restart_policy.
+    [[nodiscard]] auto restarts() const noexcept -> std::size_t;
+
+    /// @brief Waits for the process to be created if its creation has been
+    ///   deferred.
+    /// @note Until a deferred process is created, this converts to
+    ///   <code>no_process_id</code>.
+    /// @return Identifier of the process, else <code>no_process_id</code>
+    ///   if it was deferred & then never created, else
+    ///   <code>invalid_process_id</code> if this owns no process.
+    auto await_start() noexcept -> reference_process_id;
+
+    /// @brief Waits like <code>await_start()</code>, but only until the
+    ///   given deadline.
+    /// @return What <code>await_start()</code> returns, else nothing if the
+    ///   deadline passed first.
+    auto await_start(std::chrono::steady_clock::time_point deadline) noexcept
+        -> std::optional<reference_process_id>;
+
 private:
+    friend struct detail::deferred_process;
+    friend struct detail::process_supervisor;
+
     std::experimental::propagate_const<std::unique_ptr<impl>> pimpl;
 };
 
@@ -20,6 +20,7 @@ constexpr auto default_pipe_read_buffer_size = 4096u;
 /// @brief POSIX pipe.
 /// @note This class is movable but not copyable.
 /// @note Instances of this type are made for <code>link</code> instances.
+/// @note The pipe's descriptors are close-on-exec.
 /// @see link.
 struct pipe_channel
 {
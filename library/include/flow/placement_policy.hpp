@@ -0,0 +1,107 @@
+#ifndef placement_policy_hpp
+#define placement_policy_hpp
+
+#include <ostream>
+#include <set>
+
+namespace flow {
+
+/// @brief How to place the process of an executable onto CPUs.
+/// @see placement_policy.
+enum class cpu_policy: unsigned {
+    /// @brief Let it run on any of the CPUs of its placement, else on any
+    ///   that it inherits.
+    any,
+
+    /// @brief Pin it to just one of the CPUs of its placement, else of
+    ///   those this process may run on, taking turns between them.
+    /// @details Each process created with this policy is pinned to the CPU
+    ///   after that of the last one, wrapping around. So replicated stages
+    ///   given the same placement get spread across the CPUs, & a producer
+    ///   & its consumer created one after the other get adjacent ones.
+    spread,
+};
+
+constexpr auto to_cstring(cpu_policy value) noexcept -> const char*
+{
+    switch (value) {
+    case cpu_policy::any: return "any";
+    case cpu_policy::spread: return "spread";
+    }
+    return "unknown";
+}
+
+auto operator<<(std::ostream& os, cpu_policy value) -> std::ostream&;
+
+/// @brief NUMA memory policy to give the process of an executable.
+/// @note These are the modes of <code>set_mempolicy</code>.
+/// @see placement_policy.
+enum class memory_policy: unsigned {
+    /// @brief Keep the policy it inherits.
+    inherit,
+
+    /// @brief Allocate on the node of the CPU it's running on.
+    local,
+
+    /// @brief Allocate only on the nodes of its placement.
+    bind,
+
+    /// @brief Interleave allocations across the nodes of its placement.
+    interleave,
+
+    /// @brief Allocate on the node of its placement if possible.
+    preferred,
+};
+
+constexpr auto to_cstring(memory_policy value) noexcept -> const char*
+{
+    switch (value) {
+    case memory_policy::inherit: return "inherit";
+    case memory_policy::local: return "local";
+    case memory_policy::bind: return "bind";
+    case memory_policy::interleave: return "interleave";
+    case memory_policy::preferred: return "preferred";
+    }
+    return "unknown";
+}
+
+auto operator<<(std::ostream& os, memory_policy value) -> std::ostream&;
+
+/// @brief Placement of the process of an executable onto CPUs & NUMA nodes.
+/// @details This is applied in the created process before it executes its
+///   file, by way of <code>sched_setaffinity</code> &
+///   <code>set_mempolicy</code>. Failing to apply it is reported but isn't
+///   an error, so placements meant for bigger machines still run.
+/// @note Processes that have a placement aren't created with
+///   <code>posix_spawn</code>.
+/// @see executable::placement.
+struct placement_policy
+{
+    /// @brief Maximum number of NUMA nodes that can be placed onto.
+    static constexpr auto max_numa_nodes = 64u;
+
+    /// @brief CPUs to run on, else none for those that are inherited.
+    std::set<unsigned> cpus;
+
+    /// @brief How to place onto the CPUs.
+    cpu_policy cpu{cpu_policy::any};
+
+    /// @brief How to allocate memory from the NUMA nodes.
+    memory_policy memory{memory_policy::inherit};
+
+    /// @brief NUMA nodes to allocate memory from.
+    /// @note These must be less than <code>max_numa_nodes</code>. They're
+    ///   needed for the <code>bind</code> & <code>interleave</code> memory
+    ///   policies. None for the <code>preferred</code> policy is for the
+    ///   local node.
+    std::set<unsigned> numa_nodes;
+
+    auto operator==(const placement_policy& other) const -> bool = default;
+};
+
+auto operator<<(std::ostream& os, const placement_policy& value)
+    -> std::ostream&;
+
+}
+
+#endif /* placement_policy_hpp */
@@ -2,22 +2,30 @@
 #define port_info_hpp
 
 #include <concepts> // for std::regular.
+#include <optional>
 #include <ostream>
 #include <string>
 
 #include "flow/io_type.hpp"
+#include "flow/record_schema.hpp"
 
 namespace flow {
 
 struct port_info {
     std::string comment;
     io_type direction;
+
+    /// @brief Declared schema of the records read or written via the port.
+    /// @note No schema means an untyped byte stream.
+    /// @note Instantiation confirms linked ports' schemas are compatible.
+    std::optional<record_schema> schema{};
 };
 
 inline auto operator==(const port_info& lhs,
                        const port_info& rhs) noexcept
 {
-    return (lhs.comment == rhs.comment) && (lhs.direction == rhs.direction);
+    return (lhs.comment == rhs.comment) && (lhs.direction == rhs.direction)
+        && (lhs.schema == rhs.schema);
 }
 
 static_assert(std::regular<port_info>);
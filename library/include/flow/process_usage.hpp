@@ -0,0 +1,57 @@
+#ifndef process_usage_hpp
+#define process_usage_hpp
+
+#include <chrono>
+#include <compare> // for std::strong_ordering
+#include <ostream>
+
+namespace flow {
+
+/// @brief Resource usage of a terminated process.
+/// @details This is what the kernel accounted to the process by the time it
+///   was waited on. Including what it accounted to those of its own
+///   children that the process waited on.
+/// @see info_wait_result, owning_process_id::usage, total_usage.
+struct process_usage
+{
+    /// @brief CPU time spent executing in user mode.
+    std::chrono::microseconds user_time{};
+
+    /// @brief CPU time spent executing in kernel mode.
+    std::chrono::microseconds system_time{};
+
+    /// @brief Maximum resident set size, in kibibytes.
+    long max_resident_kib{};
+
+    /// @brief Page faults serviced without any I/O.
+    long minor_faults{};
+
+    /// @brief Page faults that required I/O.
+    long major_faults{};
+
+    /// @brief Context switches from giving up the CPU, like to wait for I/O.
+    long voluntary_switches{};
+
+    /// @brief Context switches from being preempted.
+    long involuntary_switches{};
+
+    auto operator<=>(const process_usage& other) const = default;
+};
+
+/// @brief Accumulates the given usage into the given usage.
+/// @note Maximum resident set sizes aren't additive, so the greater one is
+///   taken. Everything else is summed.
+auto operator+=(process_usage& lhs, const process_usage& rhs) noexcept
+    -> process_usage&;
+
+/// @brief Accumulates the given usages.
+/// @see operator+=(process_usage&, const process_usage&).
+auto operator+(process_usage lhs, const process_usage& rhs) noexcept
+    -> process_usage;
+
+auto operator<<(std::ostream& os, const process_usage& value)
+    -> std::ostream&;
+
+}
+
+#endif /* process_usage_hpp */
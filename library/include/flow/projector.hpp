@@ -0,0 +1,61 @@
+#ifndef projector_hpp
+#define projector_hpp
+
+#include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <vector>
+
+#include "flow/reference_descriptor.hpp"
+
+namespace flow {
+
+/// @brief Built-in projection - i.e. a <code>cut</code> that can also
+///   reorder fields and handle quoting.
+/// @details Splits the delimited records read from its standard input port
+///   into fields and writes out just the selected fields, in the order
+///   they're selected, to its standard output port. Delimiters and quotes
+///   are found many bytes at a time using SIMD instructions where the
+///   target supports them, and records are projected straight out of the
+///   input buffer without any allocation per record.
+/// @note Fields are output verbatim, so quoted fields keep their quotes.
+/// @note This is a <code>builtin</code> implementation type.
+/// @see builtin.
+struct projector
+{
+    /// @brief One-based indices of the fields to output, in output order.
+    /// @note Indices may be repeated. Indices beyond a record's last field
+    ///   output empty fields. Empty means to output all fields.
+    std::vector<std::size_t> fields;
+
+    char field_delimiter{'\t'};
+
+    /// @brief Delimiter to separate output fields with.
+    char output_delimiter{'\t'};
+
+    char record_delimiter{'\n'};
+
+    /// @brief Quote character.
+    /// @details Delimiters between a pair of these are part of the field
+    ///   they're in, and a doubled quote within them is a literal quote -
+    ///   as in RFC 4180 CSV.
+    /// @note The null character means that no quoting is recognized.
+    char quote{};
+
+    auto operator==(const projector&) const -> bool = default;
+};
+
+static_assert(std::regular<projector>);
+
+auto operator<<(std::ostream& os, const projector& value) -> std::ostream&;
+
+/// @brief Projects records from the input descriptor to the output
+///   descriptor.
+/// @throws std::system_error if reading or writing fails.
+/// @see projector.
+auto project(const projector& spec, reference_descriptor in,
+             reference_descriptor out) -> void;
+
+}
+
+#endif /* projector_hpp */
@@ -0,0 +1,81 @@
+#ifndef record_batch_hpp
+#define record_batch_hpp
+
+#include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
+#include <cstdint> // for std::int64_t, std::uint64_t
+#include <string_view>
+#include <vector>
+
+#include "flow/record_schema.hpp"
+
+namespace flow {
+
+/// @brief Contiguous array of the values of one field of a batch of records.
+/// @details Values are stored in the array for the column's type. Whether
+///   each value is valid - i.e. not null - is tracked in a bitmap.
+/// @see record_batch.
+struct column
+{
+    field_type type{field_type::text};
+
+    /// @brief Number of values in the column.
+    std::size_t length{};
+
+    /// @brief Values of a <code>field_type::integer</code> column.
+    std::vector<std::int64_t> integers;
+
+    /// @brief Values of a <code>field_type::real</code> column.
+    std::vector<double> reals;
+
+    /// @brief Offsets into <code>chars</code> of the values of a
+    ///   <code>field_type::text</code> column.
+    /// @note Value <code>i</code> ends where value <code>i + 1</code> starts.
+    std::vector<std::size_t> offsets{0u};
+
+    std::vector<char> chars;
+
+    /// @brief Bitmap of which values are valid - bit set for valid.
+    std::vector<std::uint64_t> validity;
+
+    auto operator==(const column&) const -> bool = default;
+};
+
+static_assert(std::regular<column>);
+
+/// @brief Appends the value parsed from the given text to the column.
+/// @note Empty text, or text that isn't entirely a value of the column's
+///   type, appends a null.
+auto append(column& col, std::string_view text) -> void;
+
+auto append_null(column& col) -> void;
+
+auto is_valid(const column& col, std::size_t index) noexcept -> bool;
+
+/// @brief Gets the given value of a <code>field_type::text</code> column.
+auto get_text(const column& col, std::size_t index) noexcept
+    -> std::string_view;
+
+/// @brief Batch of records stored column by column.
+/// @details Storing records this way lets operations on a field be done
+///   over contiguous arrays of values - which compilers can vectorize.
+/// @see batch_channel.
+struct record_batch
+{
+    std::vector<column> columns;
+
+    auto operator==(const record_batch&) const -> bool = default;
+};
+
+static_assert(std::regular<record_batch>);
+
+/// @brief Makes an empty batch with a column for each of the given fields.
+auto make_record_batch(const std::vector<record_field>& fields)
+    -> record_batch;
+
+/// @brief Gets the number of records in the given batch.
+auto get_size(const record_batch& batch) noexcept -> std::size_t;
+
+}
+
+#endif /* record_batch_hpp */
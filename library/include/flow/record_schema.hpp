@@ -0,0 +1,93 @@
+#ifndef record_schema_hpp
+#define record_schema_hpp
+
+#include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace flow {
+
+/// @brief Type of a record's field.
+enum class field_type: unsigned {
+    text,
+    integer, ///< Signed 64-bit integer.
+    real, ///< IEEE 754 double precision floating point.
+};
+
+auto operator<<(std::ostream& os, field_type value) -> std::ostream&;
+
+/// @brief How records are encoded for reading or writing via a port.
+enum class record_encoding: unsigned {
+    /// @brief Fields as text separated by delimiters.
+    delimited,
+
+    /// @brief Fixed-width records of fields in native binary representation.
+    /// @note Text fields are padded out to their width with null characters.
+    binary,
+
+    /// @brief Batches of records stored column by column.
+    /// @note Only ports of built-ins can use this encoding since batches are
+    ///   exchanged in-process instead of through a byte stream.
+    /// @see record_batch, batch_channel.
+    columnar,
+};
+
+auto operator<<(std::ostream& os, record_encoding value) -> std::ostream&;
+
+struct record_field
+{
+    std::string name;
+    field_type type{field_type::text};
+
+    /// @brief Width in bytes of a <code>field_type::text</code> field in
+    ///   <code>record_encoding::binary</code> encoded records.
+    /// @note This is ignored otherwise.
+    std::size_t width{};
+
+    auto operator==(const record_field&) const -> bool = default;
+};
+
+static_assert(std::regular<record_field>);
+
+auto operator<<(std::ostream& os, const record_field& value) -> std::ostream&;
+
+/// @brief Declared schema of the records that a port reads or writes.
+/// @see port_info.
+struct record_schema
+{
+    std::vector<record_field> fields;
+
+    record_encoding encoding{record_encoding::delimited};
+
+    /// @note This is only used for <code>record_encoding::delimited</code>.
+    char field_delimiter{'\t'};
+
+    /// @note This is only used for <code>record_encoding::delimited</code>.
+    char record_delimiter{'\n'};
+
+    auto operator==(const record_schema&) const -> bool = default;
+};
+
+static_assert(std::regular<record_schema>);
+
+auto operator<<(std::ostream& os, const record_schema& value) -> std::ostream&;
+
+/// @brief Gets the width in bytes of the given field when binary encoded.
+auto get_width(const record_field& field) noexcept -> std::size_t;
+
+/// @brief Gets the size in bytes of every record of the given schema.
+/// @return Size of the binary encoded records, or zero for other encodings
+///   since their records' sizes vary.
+auto get_record_size(const record_schema& schema) noexcept -> std::size_t;
+
+/// @brief Whether records written per the given source schema can be read
+///   as is per the given destination schema.
+/// @note Field names only have to match where both are non-empty.
+auto is_compatible(const record_schema& src, const record_schema& dst)
+    -> bool;
+
+}
+
+#endif /* record_schema_hpp */
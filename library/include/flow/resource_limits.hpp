@@ -0,0 +1,53 @@
+#ifndef resource_limits_hpp
+#define resource_limits_hpp
+
+#include <chrono>
+#include <cstdint> // for std::uint64_t
+#include <ostream>
+
+namespace flow {
+
+/// @brief Limits on the resources the processes of a node may use.
+/// @details These are enforced by the cgroup v2 controllers of a control
+///   group made for the node when it's instantiated. Each limit is that
+///   of the control group interface file noted for it. Limits that are
+///   zero are left at that file's default.
+/// @note Built-ins run within this process, so aren't limited by these.
+/// @see executable::resources, system::resources,
+///   instantiate_options::cgroup.
+struct resource_limits
+{
+    /// @brief CPU time the processes may use every
+    ///   <code>cpu_period</code>, else zero for no limit.
+    /// @note This is the quota of <code>cpu.max</code>.
+    std::chrono::microseconds cpu_quota{};
+
+    /// @brief Period of <code>cpu_quota</code>.
+    /// @note This is the period of <code>cpu.max</code>.
+    std::chrono::microseconds cpu_period{100'000};
+
+    /// @brief Share of CPU time relative to siblings, from 1 to 10000.
+    /// @note This is <code>cpu.weight</code>, whose default is 100.
+    unsigned cpu_weight{};
+
+    /// @brief Memory the processes may use, in bytes, else zero for no
+    ///   limit.
+    /// @note This is <code>memory.max</code>. Processes that can't be kept
+    ///   within it get killed.
+    std::uint64_t memory_max{};
+
+    /// @brief Share of I/O relative to siblings, from 1 to 10000.
+    /// @note This is the default weight of <code>io.weight</code>, which
+    ///   itself defaults to 100.
+    unsigned io_weight{};
+
+    auto operator==(const resource_limits& other) const noexcept -> bool =
+        default;
+};
+
+auto operator<<(std::ostream& os, const resource_limits& value)
+    -> std::ostream&;
+
+}
+
+#endif /* resource_limits_hpp */
@@ -0,0 +1,114 @@
+#ifndef scheduling_policy_hpp
+#define scheduling_policy_hpp
+
+#include <optional>
+#include <ostream>
+
+namespace flow {
+
+/// @brief Scheduling class to give the process of an executable.
+/// @note These are the non-realtime policies of
+///   <code>sched_setscheduler</code>, which need no privileges.
+/// @see scheduling_policy.
+enum class scheduling_class: unsigned {
+    /// @brief Keep the class it inherits.
+    inherit,
+
+    /// @brief Time-sharing, as <code>SCHED_OTHER</code>.
+    normal,
+
+    /// @brief For CPU-intensive work that isn't interactive, as
+    ///   <code>SCHED_BATCH</code>. It's scheduled like normal but is
+    ///   preempted less, & as if it always uses up its time slice.
+    batch,
+
+    /// @brief For work to run only when the CPU has nothing else to do, as
+    ///   <code>SCHED_IDLE</code>.
+    idle,
+};
+
+constexpr auto to_cstring(scheduling_class value) noexcept -> const char*
+{
+    switch (value) {
+    case scheduling_class::inherit: return "inherit";
+    case scheduling_class::normal: return "normal";
+    case scheduling_class::batch: return "batch";
+    case scheduling_class::idle: return "idle";
+    }
+    return "unknown";
+}
+
+auto operator<<(std::ostream& os, scheduling_class value) -> std::ostream&;
+
+/// @brief I/O scheduling class to give the process of an executable.
+/// @note These are the classes of <code>ioprio_set</code>.
+/// @see scheduling_policy.
+enum class io_class: unsigned {
+    /// @brief Keep the class it inherits.
+    inherit,
+
+    /// @brief Gets first access to the disk regardless of others.
+    /// @note This needs the <code>CAP_SYS_ADMIN</code> capability.
+    realtime,
+
+    /// @brief Shares the disk with others by priority level.
+    best_effort,
+
+    /// @brief Gets access to the disk only when no one else needs it.
+    idle,
+};
+
+constexpr auto to_cstring(io_class value) noexcept -> const char*
+{
+    switch (value) {
+    case io_class::inherit: return "inherit";
+    case io_class::realtime: return "realtime";
+    case io_class::best_effort: return "best_effort";
+    case io_class::idle: return "idle";
+    }
+    return "unknown";
+}
+
+auto operator<<(std::ostream& os, io_class value) -> std::ostream&;
+
+/// @brief Scheduling attributes of the process of an executable.
+/// @details These are applied in the created process before it executes
+///   its file, by way of <code>setpriority</code>,
+///   <code>sched_setscheduler</code> & <code>ioprio_set</code>. So, unlike
+///   wrapping its file with <code>nice</code> & <code>ionice</code>, there's
+///   no extra file to execute & its arguments are left as they are.
+///   Failing to apply them, like for lack of privileges, is reported but
+///   isn't an error.
+/// @note Processes that have any of these aren't created with
+///   <code>posix_spawn</code>.
+/// @see executable::scheduling.
+struct scheduling_policy
+{
+    static constexpr auto min_nice = -20;
+    static constexpr auto max_nice = 19;
+    static constexpr auto max_io_level = 7u;
+
+    /// @brief Nice value to set, else none to keep the inherited one.
+    /// @note This is absolute, from <code>min_nice</code> to
+    ///   <code>max_nice</code>. Lowering it needs privileges.
+    std::optional<int> nice;
+
+    /// @brief Class to schedule the process's CPU time by.
+    scheduling_class scheduler{scheduling_class::inherit};
+
+    /// @brief Class to schedule the process's disk I/O by.
+    io_class io{io_class::inherit};
+
+    /// @brief Priority level within the realtime or best effort I/O
+    ///   class, from 0 for the highest to <code>max_io_level</code>.
+    unsigned io_level{4u};
+
+    auto operator==(const scheduling_policy& other) const -> bool = default;
+};
+
+auto operator<<(std::ostream& os, const scheduling_policy& value)
+    -> std::ostream&;
+
+}
+
+#endif /* scheduling_policy_hpp */
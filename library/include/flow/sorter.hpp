@@ -0,0 +1,71 @@
+#ifndef sorter_hpp
+#define sorter_hpp
+
+#include <concepts> // for std::regular.
+#include <cstddef> // for std::size_t
+#include <filesystem>
+#include <ostream>
+
+#include "flow/reference_descriptor.hpp"
+
+namespace flow {
+
+/// @brief How keys are ordered.
+enum class sort_order: unsigned {
+    lexicographic,
+    numeric,
+};
+
+auto operator<<(std::ostream& os, sort_order value) -> std::ostream&;
+
+/// @brief Built-in sort.
+/// @details Sorts the delimited records read from its standard input port
+///   and writes them out to its standard output port. Records are sorted in
+///   memory - on multiple threads - in runs of up to the memory budget.
+///   Runs that don't all fit are spilled to temporary files and then k-way
+///   merged. Output starts streaming as soon as merging does.
+/// @note Records with equal keys are ordered by their whole content.
+/// @note This is a <code>builtin</code> implementation type.
+/// @see builtin.
+struct sorter
+{
+    static constexpr auto default_memory_budget =
+        std::size_t{64u * 1024u * 1024u};
+
+    /// @brief One-based index of the field to sort on.
+    /// @note Zero means to sort on the whole record.
+    std::size_t key_field{};
+
+    char field_delimiter{'\t'};
+
+    char record_delimiter{'\n'};
+
+    sort_order order{sort_order::lexicographic};
+
+    /// @brief Approximate limit on the memory to use for sorting.
+    std::size_t memory_budget{default_memory_budget};
+
+    /// @brief Maximum number of threads to sort with.
+    /// @note Zero means to use as many as the hardware supports.
+    std::size_t threads{};
+
+    /// @brief Directory to spill runs to.
+    /// @note Empty means the system's temporary directory.
+    std::filesystem::path temporary_directory;
+
+    auto operator==(const sorter&) const -> bool = default;
+};
+
+static_assert(std::regular<sorter>);
+
+auto operator<<(std::ostream& os, const sorter& value) -> std::ostream&;
+
+/// @brief Sorts records from the input descriptor to the output descriptor.
+/// @throws std::system_error if reading, writing, or spilling fails.
+/// @see sorter.
+auto sort(const sorter& spec, reference_descriptor in,
+          reference_descriptor out) -> void;
+
+}
+
+#endif /* sorter_hpp */
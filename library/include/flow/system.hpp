@@ -9,6 +9,7 @@
 #include "flow/environment_map.hpp"
 #include "flow/link.hpp"
 #include "flow/node_name.hpp"
+#include "flow/resource_limits.hpp"
 
 namespace flow {
 
@@ -29,6 +30,15 @@ struct system
 
     /// @brief Links.
     std::vector<link> links;
+
+    /// @brief Limits on the resources the processes of this system's
+    ///   nodes may use altogether.
+    /// @details If these, or those of any of the system's descendants, are
+    ///   any different from the default, every process of the system is
+    ///   created into a control group of its own, within a control group
+    ///   made for the system that enforces these.
+    /// @see instantiate_options::cgroup.
+    resource_limits resources;
 };
 
 auto operator==(const system& lhs, const system& rhs) noexcept -> bool;
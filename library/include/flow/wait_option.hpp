@@ -26,8 +26,14 @@ constexpr auto operator~(const wait_option& val) noexcept
 }
 
 namespace wait_options {
+
+/// @brief Option to return right away if there's no change of state yet.
 auto nohang() noexcept -> wait_option;
+
+/// @brief Option to also report processes stopping.
+/// @note Processes continuing isn't reported.
 auto untraced() noexcept -> wait_option;
+
 }
 
 }
@@ -1,11 +1,13 @@
 #ifndef wait_result_hpp
 #define wait_result_hpp
 
+#include <chrono>
 #include <concepts> // for std::regular.
 #include <ostream>
 #include <vector>
 
 #include "flow/os_error_code.hpp"
+#include "flow/process_usage.hpp"
 #include "flow/reference_process_id.hpp"
 #include "flow/variant.hpp" // for <variant>, flow::variant, plus ostream support
 #include "flow/wait_option.hpp"
@@ -41,8 +43,13 @@ auto operator<<(std::ostream& os, const error_wait_result& arg)
 struct info_wait_result {
     reference_process_id id{invalid_process_id};
     wait_status status{wait_unknown_status{}};
+
+    /// @brief Resource usage of the process, if it's terminated.
+    process_usage usage{};
 };
 
+/// @note Resource usages aren't compared, since they're measurements of
+///   what the statuses are the outcomes of.
 constexpr auto operator==(const info_wait_result& lhs,
                           const info_wait_result& rhs) noexcept
 {
@@ -69,6 +76,20 @@ auto wait(reference_process_id id = invalid_process_id,
 
 auto wait(instance& object) -> std::vector<wait_result>;
 
+/// @brief Waits for the given instance like <code>wait</code>, but only
+///   until the given deadline.
+/// @return Results for what finished by the deadline. Waiting for the
+///   instance again gets the results for the rest.
+auto wait_until(instance& object,
+                std::chrono::steady_clock::time_point deadline)
+    -> std::vector<wait_result>;
+
+/// @brief Waits for the given instance like <code>wait</code>, but only
+///   for up to the given time.
+/// @see wait_until.
+auto wait_for(instance& object, std::chrono::nanoseconds timeout)
+    -> std::vector<wait_result>;
+
 }
 
 #endif /* wait_result_hpp */
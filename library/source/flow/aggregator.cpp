@@ -0,0 +1,518 @@
+#include <algorithm> // for std::max, std::min
+#include <array>
+#include <charconv> // for std::to_chars
+#include <cstdint> // for std::uint32_t, std::uint64_t
+#include <future>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h> // for ::lseek
+
+#include "flow/aggregator.hpp"
+#include "flow/os_error_code.hpp"
+
+#include "record_io.hpp"
+
+namespace flow {
+
+namespace {
+
+constexpr auto min_partition_budget = std::size_t{256u * 1024u};
+constexpr auto min_batch_size = std::size_t{64u * 1024u};
+constexpr auto max_batch_size = std::size_t{4u * 1024u * 1024u};
+constexpr auto spill_fan_out = std::size_t{16u};
+
+/// @brief Limit on how many times spilled groups get repartitioned.
+/// @note Past this, groups are aggregated in memory regardless of budget
+///   since more partitioning is unlikely to help.
+constexpr auto max_spill_depth = 4u;
+
+auto hash(std::string_view key, std::uint64_t seed) noexcept -> std::uint64_t
+{
+    // FNV-1a, then the MurmurHash3 finalizer to spread the bits.
+    auto h = 0xcbf29ce484222325u ^ (seed * 0x9e3779b97f4a7c15u);
+    for (const auto c: key) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3u;
+    }
+    h ^= h >> 33u;
+    h *= 0xff51afd7ed558ccdu;
+    h ^= h >> 33u;
+    h *= 0xc4ceb9fe1a85ec53u;
+    h ^= h >> 33u;
+    return h;
+}
+
+auto initial_value(aggregate_function function) noexcept -> double
+{
+    switch (function) {
+    case aggregate_function::min:
+        return std::numeric_limits<double>::infinity();
+    case aggregate_function::max:
+        return -std::numeric_limits<double>::infinity();
+    case aggregate_function::count:
+    case aggregate_function::sum:
+        break;
+    }
+    return {};
+}
+
+/// @brief Accumulates the given value.
+/// @note Counts are accumulated by adding the value so that partial counts
+///   from spilled groups merge the same way as counts of one per record.
+auto accumulate(aggregate_function function, double& to, double value)
+    noexcept -> void
+{
+    switch (function) {
+    case aggregate_function::count:
+    case aggregate_function::sum:
+        to += value;
+        return;
+    case aggregate_function::min:
+        to = std::min(to, value);
+        return;
+    case aggregate_function::max:
+        to = std::max(to, value);
+        return;
+    }
+}
+
+/// @brief Open addressing hash table of groups & their aggregates.
+/// @details Uses linear probing over slots of entry indices. Keys are
+///   stored back to back in a single buffer and aggregates in another.
+struct group_table
+{
+    explicit group_table(const std::vector<aggregate>& aggregates)
+    {
+        functions.reserve(size(aggregates));
+        for (auto&& a: aggregates) {
+            functions.push_back(a.function);
+        }
+    }
+
+    auto update(std::string_view key, std::uint64_t key_hash,
+                const std::span<const double>& record_values) -> void
+    {
+        if ((size(entries) + 1u) * 4u > size(slots) * 3u) {
+            grow();
+        }
+        const auto mask = size(slots) - 1u;
+        auto slot = key_hash & mask;
+        for (; slots[slot] != 0u; slot = (slot + 1u) & mask) {
+            const auto& e = entries[slots[slot] - 1u];
+            if ((e.hash == key_hash) && (get_key(e) == key)) {
+                const auto first = (slots[slot] - 1u) * size(functions);
+                for (auto i = 0u; i < size(functions); ++i) {
+                    accumulate(functions[i], values[first + i],
+                               record_values[i]);
+                }
+                return;
+            }
+        }
+        entries.push_back(entry{key_hash, size(keys), size(key)});
+        slots[slot] = static_cast<std::uint32_t>(size(entries));
+        keys.insert(keys.end(), key.begin(), key.end());
+        for (auto i = 0u; i < size(functions); ++i) {
+            values.push_back(initial_value(functions[i]));
+            accumulate(functions[i], values.back(), record_values[i]);
+        }
+    }
+
+    [[nodiscard]] auto memory_usage() const noexcept -> std::size_t
+    {
+        return keys.capacity()
+             + entries.capacity() * sizeof(entry)
+             + values.capacity() * sizeof(double)
+             + size(slots) * sizeof(std::uint32_t);
+    }
+
+    /// @brief Calls the given function with every group's key & aggregates.
+    template <class Function>
+    auto for_each(Function function) const -> void
+    {
+        for (auto i = 0u; i < size(entries); ++i) {
+            function(get_key(entries[i]), std::span<const double>{
+                values.data() + i * size(functions), size(functions)
+            });
+        }
+    }
+
+    /// @brief Clears the table, releasing its memory.
+    auto clear() -> void
+    {
+        keys = {};
+        entries = {};
+        values = {};
+        slots = {};
+    }
+
+private:
+    struct entry
+    {
+        std::uint64_t hash{};
+        std::size_t offset{};
+        std::size_t length{};
+    };
+
+    [[nodiscard]] auto get_key(const entry& e) const noexcept
+        -> std::string_view
+    {
+        return {keys.data() + e.offset, e.length};
+    }
+
+    auto grow() -> void
+    {
+        static constexpr auto initial_slots = std::size_t{1024u};
+        slots.assign(std::max(size(slots) * 2u, initial_slots), 0u);
+        const auto mask = size(slots) - 1u;
+        for (auto i = 0u; i < size(entries); ++i) {
+            auto slot = entries[i].hash & mask;
+            while (slots[slot] != 0u) {
+                slot = (slot + 1u) & mask;
+            }
+            slots[slot] = static_cast<std::uint32_t>(i + 1u);
+        }
+    }
+
+    std::vector<aggregate_function> functions;
+    std::vector<char> keys;
+    std::vector<entry> entries;
+    std::vector<double> values;
+
+    /// @brief Index plus one of the entry in each slot, or zero if empty.
+    std::vector<std::uint32_t> slots;
+};
+
+/// @brief Keys & values of records read but not yet aggregated.
+struct record_batch
+{
+    struct item
+    {
+        std::uint64_t hash{};
+        std::size_t offset{};
+        std::size_t length{};
+    };
+
+    std::vector<char> keys;
+    std::vector<item> items;
+    std::vector<double> values;
+
+    auto clear() noexcept -> void
+    {
+        keys.clear();
+        items.clear();
+        values.clear();
+    }
+};
+
+auto to_chars(double value, std::array<char, 32u>& buffer) -> std::string_view
+{
+    const auto result = std::to_chars(buffer.data(),
+                                      buffer.data() + size(buffer), value);
+    return {buffer.data(), static_cast<std::size_t>(result.ptr - buffer.data())};
+}
+
+auto write_group(const aggregator& spec, std::string_view key,
+                 const std::span<const double>& group_values,
+                 detail::record_writer& writer) -> void
+{
+    auto buffer = std::array<char, 32u>{};
+    writer.append(key);
+    for (const auto value: group_values) {
+        writer.append({&spec.field_delimiter, 1u});
+        writer.append(to_chars(value, buffer));
+    }
+    writer.write({});
+}
+
+/// @brief Spilled partial aggregates of a partition.
+/// @note Each spilled record is a group's aggregates followed by its key,
+///   since keys may themselves contain field delimiters.
+struct spill_files
+{
+    std::vector<owning_descriptor> files;
+
+    /// @brief Writes out the table's groups to these files, clearing it.
+    /// @param[in] depth Depth of the spill, which seeds the hashing of groups
+    ///   to files so that each depth partitions groups differently.
+    auto spill(const aggregator& spec, group_table& table, unsigned depth)
+        -> void
+    {
+        if (empty(files)) {
+            for (auto i = 0u; i < spill_fan_out; ++i) {
+                files.push_back(detail::make_temporary_file(
+                    spec.temporary_directory));
+            }
+        }
+        auto writers = std::vector<detail::record_writer>{};
+        writers.reserve(size(files));
+        for (auto&& file: files) {
+            writers.emplace_back(file, spec.record_delimiter);
+        }
+        auto buffer = std::array<char, 32u>{};
+        table.for_each([&](std::string_view key,
+                           const std::span<const double>& group_values){
+            auto& writer = writers[hash(key, depth) % size(writers)];
+            for (const auto value: group_values) {
+                writer.append(to_chars(value, buffer));
+                writer.append({&spec.field_delimiter, 1u});
+            }
+            writer.write(key);
+        });
+        for (auto&& writer: writers) {
+            writer.flush();
+        }
+        table.clear();
+    }
+};
+
+/// @brief Re-aggregates the given spilled partial aggregates out to the
+///   writer, spilling again if the groups still don't fit.
+auto merge_spilled(const aggregator& spec, std::size_t budget,
+                   owning_descriptor& file, unsigned depth,
+                   detail::record_writer& writer) -> void
+{
+    if (::lseek(int(file), 0, SEEK_SET) == -1) {
+        throw_error(os_error_code(errno), "can't rewind spilled groups");
+    }
+    auto table = group_table{spec.aggregates};
+    auto spills = spill_files{};
+    auto group_values = std::vector<double>(size(spec.aggregates));
+    auto reader = detail::record_reader{file, spec.record_delimiter};
+    while (const auto record = reader.next()) {
+        auto rest = *record;
+        for (auto&& value: group_values) {
+            const auto found = rest.find(spec.field_delimiter);
+            value = detail::to_number(rest.substr(0u, found));
+            rest.remove_prefix(std::min(found + 1u, size(rest)));
+        }
+        table.update(rest, hash(rest, 0u), group_values);
+        if ((depth < max_spill_depth) && (table.memory_usage() > budget)) {
+            spills.spill(spec, table, depth + 1u);
+        }
+    }
+    file = owning_descriptor{};
+    if (empty(spills.files)) {
+        table.for_each([&](std::string_view key,
+                           const std::span<const double>& values){
+            write_group(spec, key, values, writer);
+        });
+        return;
+    }
+    spills.spill(spec, table, depth + 1u);
+    for (auto&& spilled: spills.files) {
+        merge_spilled(spec, budget, spilled, depth + 1u, writer);
+    }
+}
+
+/// @brief Hash partition of the groups & the state for aggregating them.
+struct partition
+{
+    group_table table;
+    spill_files spills;
+    std::size_t budget{};
+};
+
+auto aggregate_batch(const aggregator& spec, const record_batch& batch,
+                     partition& part, std::size_t index, std::size_t count)
+    -> void
+{
+    const auto n = size(spec.aggregates);
+    for (auto i = 0u; i < size(batch.items); ++i) {
+        const auto& item = batch.items[i];
+        if (((item.hash >> 32u) % count) != index) {
+            continue;
+        }
+        part.table.update({batch.keys.data() + item.offset, item.length},
+                          item.hash, {batch.values.data() + i * n, n});
+        if (part.table.memory_usage() > part.budget) {
+            part.spills.spill(spec, part.table, 1u);
+        }
+    }
+}
+
+auto aggregate_batch(const aggregator& spec, const record_batch& batch,
+                     std::vector<partition>& partitions) -> void
+{
+    const auto count = size(partitions);
+    auto futures = std::vector<std::future<void>>{};
+    for (auto i = 1u; i < count; ++i) {
+        futures.push_back(std::async(std::launch::async, [&,i](){
+            aggregate_batch(spec, batch, partitions[i], i, count);
+        }));
+    }
+    aggregate_batch(spec, batch, partitions[0], 0u, count);
+    for (auto&& future: futures) {
+        future.get();
+    }
+}
+
+/// @brief Reads records into the given batch until it's full.
+/// @return Whether any records were read.
+auto read_batch(const aggregator& spec, detail::record_reader& reader,
+                std::size_t batch_size,
+                std::vector<std::string_view>& fields,
+                record_batch& batch) -> bool
+{
+    auto max_field = std::size_t{};
+    for (auto&& index: spec.key_fields) {
+        max_field = std::max(max_field, index);
+    }
+    for (auto&& a: spec.aggregates) {
+        if (a.function != aggregate_function::count) {
+            max_field = std::max(max_field, a.field);
+        }
+    }
+    const auto get = [&fields](std::string_view record, std::size_t index){
+        if (index == 0u) {
+            return record;
+        }
+        return (index <= size(fields))? fields[index - 1u]: std::string_view{};
+    };
+    batch.clear();
+    while (size(batch.keys) < batch_size) {
+        const auto record = reader.next();
+        if (!record) {
+            break;
+        }
+        fields.clear();
+        for (auto rest = *record; size(fields) < max_field;) {
+            const auto found = rest.find(spec.field_delimiter);
+            fields.push_back(rest.substr(0u, found));
+            if (found == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(found + 1u);
+        }
+        const auto offset = size(batch.keys);
+        if (empty(spec.key_fields)) {
+            batch.keys.insert(batch.keys.end(), record->begin(), record->end());
+        }
+        for (auto i = 0u; i < size(spec.key_fields); ++i) {
+            if (i > 0u) {
+                batch.keys.push_back(spec.field_delimiter);
+            }
+            const auto field = get(*record, spec.key_fields[i]);
+            batch.keys.insert(batch.keys.end(), field.begin(), field.end());
+        }
+        const auto length = size(batch.keys) - offset;
+        const auto key = std::string_view{batch.keys.data() + offset, length};
+        batch.items.push_back({hash(key, 0u), offset, length});
+        for (auto&& a: spec.aggregates) {
+            batch.values.push_back((a.function == aggregate_function::count)
+                                   ? 1.0
+                                   : detail::to_number(get(*record, a.field)));
+        }
+    }
+    return !empty(batch.items);
+}
+
+}
+
+auto operator<<(std::ostream& os, aggregate_function value) -> std::ostream&
+{
+    switch (value) {
+    case aggregate_function::count:
+        os << "count";
+        return os;
+    case aggregate_function::sum:
+        os << "sum";
+        return os;
+    case aggregate_function::min:
+        os << "min";
+        return os;
+    case aggregate_function::max:
+        os << "max";
+        return os;
+    }
+    os << "aggregate_function(" << unsigned(value) << ")";
+    return os;
+}
+
+auto operator<<(std::ostream& os, const aggregate& value) -> std::ostream&
+{
+    os << "aggregate{";
+    os << ".function=" << value.function;
+    os << ",.field=" << value.field;
+    os << "}";
+    return os;
+}
+
+auto operator<<(std::ostream& os, const aggregator& value) -> std::ostream&
+{
+    os << "aggregator{";
+    os << ".key_fields={";
+    auto prefix = "";
+    for (auto&& index: value.key_fields) {
+        os << prefix << index;
+        prefix = ",";
+    }
+    os << "},.aggregates={";
+    prefix = "";
+    for (auto&& a: value.aggregates) {
+        os << prefix << a;
+        prefix = ",";
+    }
+    os << "}";
+    os << ",.memory_budget=" << value.memory_budget;
+    os << ",.threads=" << value.threads;
+    if (!value.temporary_directory.empty()) {
+        os << ",.temporary_directory=" << value.temporary_directory;
+    }
+    os << "}";
+    return os;
+}
+
+auto group_by(const aggregator& spec, reference_descriptor in,
+              reference_descriptor out) -> void
+{
+    const auto threads = detail::get_thread_count(spec.threads);
+    const auto budget = std::max(spec.memory_budget / threads,
+                                 min_partition_budget);
+    const auto batch_size = std::clamp(spec.memory_budget / 8u,
+                                       min_batch_size, max_batch_size);
+    auto partitions = std::vector<partition>{};
+    partitions.reserve(threads);
+    for (auto i = 0u; i < threads; ++i) {
+        partitions.push_back(partition{
+            group_table{spec.aggregates}, spill_files{}, budget
+        });
+    }
+    auto reader = detail::record_reader{in, spec.record_delimiter};
+    auto fields = std::vector<std::string_view>{};
+    auto reading = record_batch{};
+    auto aggregating = record_batch{};
+    auto pending = std::future<void>{};
+    // Read the next batch while the last one is being aggregated.
+    while (read_batch(spec, reader, batch_size, fields, reading)) {
+        if (pending.valid()) {
+            pending.get();
+        }
+        std::swap(reading, aggregating);
+        pending = std::async(std::launch::async, [&](){
+            aggregate_batch(spec, aggregating, partitions);
+        });
+    }
+    if (pending.valid()) {
+        pending.get();
+    }
+    detail::record_writer writer{out, spec.record_delimiter};
+    for (auto&& part: partitions) {
+        if (empty(part.spills.files)) {
+            part.table.for_each([&](std::string_view key,
+                                    const std::span<const double>& values){
+                write_group(spec, key, values, writer);
+            });
+            continue;
+        }
+        part.spills.spill(spec, part.table, 1u);
+        for (auto&& file: part.spills.files) {
+            merge_spilled(spec, part.budget, file, 1u, writer);
+        }
+    }
+    writer.flush();
+}
+
+}
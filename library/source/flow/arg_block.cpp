@@ -0,0 +1,152 @@
+#include <functional> // for std::less
+#include <map>
+#include <mutex>
+#include <tuple> // for std::tie
+#include <utility> // for std::forward
+
+#include "flow/reserved.hpp"
+
+#include "arg_block.hpp"
+
+namespace flow::detail {
+
+namespace {
+
+/// @brief Maximum number of blocks of each kind to cache.
+/// @note The cache is cleared when full, so instantiating ever different
+///   arguments or environments doesn't grow memory use without bound.
+constexpr auto max_cached_blocks = 256u;
+
+/// @brief Cache of blocks by what they're made from.
+/// @note Lookups are by anything comparable to <code>Key</code> so that
+///   looking up what's cached doesn't have to copy it.
+template <class Key, class Compare = std::less<>>
+struct block_cache
+{
+    template <class Lookup, class Maker>
+    auto get(const Lookup& lookup, Maker&& maker)
+        -> std::shared_ptr<const arg_block>
+    {
+        const std::lock_guard lock{mutex};
+        if (const auto it = blocks.find(lookup); it != blocks.end()) {
+            return it->second;
+        }
+        if (size(blocks) >= max_cached_blocks) {
+            blocks.clear();
+        }
+        auto block = std::forward<Maker>(maker)();
+        blocks.emplace(Key(lookup), block);
+        return block;
+    }
+
+private:
+    std::mutex mutex;
+    std::map<Key, std::shared_ptr<const arg_block>, Compare> blocks;
+};
+
+struct arg_key_view
+{
+    const std::vector<std::string>& arguments;
+    const std::string& fallback;
+};
+
+struct arg_key
+{
+    explicit arg_key(const arg_key_view& view):
+        arguments{view.arguments}, fallback{view.fallback}
+    {
+        // Intentionally empty.
+    }
+
+    std::vector<std::string> arguments;
+    std::string fallback;
+};
+
+struct arg_key_less
+{
+    using is_transparent = void;
+
+    template <class Lhs, class Rhs>
+    auto operator()(const Lhs& lhs, const Rhs& rhs) const -> bool
+    {
+        return std::tie(lhs.arguments, lhs.fallback) <
+               std::tie(rhs.arguments, rhs.fallback);
+    }
+};
+
+}
+
+arg_block::arg_block(std::span<const std::string> strings)
+{
+    auto total = std::size_t{};
+    for (auto&& string: strings) {
+        total += size(string) + 1u;
+    }
+    chars.reserve(total);
+    auto offsets = std::vector<std::size_t>{};
+    offsets.reserve(size(strings));
+    for (auto&& string: strings) {
+        offsets.push_back(size(chars));
+        chars.insert(end(chars), begin(string), end(string));
+        chars.push_back('\0');
+    }
+    make_pointers(offsets);
+}
+
+arg_block::arg_block(const environment_map& envars)
+{
+    auto total = std::size_t{};
+    for (auto&& entry: envars) {
+        total += size(entry.first.get()) + size(entry.second.get()) + 2u;
+    }
+    chars.reserve(total);
+    auto offsets = std::vector<std::size_t>{};
+    offsets.reserve(size(envars));
+    for (auto&& entry: envars) {
+        offsets.push_back(size(chars));
+        const auto& name = entry.first.get();
+        const auto& value = entry.second.get();
+        chars.insert(end(chars), begin(name), end(name));
+        chars.push_back(reserved::env_separator);
+        chars.insert(end(chars), begin(value), end(value));
+        chars.push_back('\0');
+    }
+    make_pointers(offsets);
+}
+
+auto arg_block::make_pointers(std::span<const std::size_t> offsets) -> void
+{
+    pointers.reserve(size(offsets) + 1u);
+    for (auto&& offset: offsets) {
+        pointers.push_back(chars.data() + offset);
+    }
+    pointers.push_back(nullptr); // last element must always be nullptr!
+}
+
+auto get_arg_block(const std::vector<std::string>& arguments,
+                   const std::string& fallback)
+    -> std::shared_ptr<const arg_block>
+{
+    static block_cache<arg_key, arg_key_less> cache;
+    // Only the arguments matter unless there are none.
+    static const auto no_fallback = std::string{};
+    const auto& key_fallback = empty(arguments)? fallback: no_fallback;
+    return cache.get(arg_key_view{arguments, key_fallback}, [&]{
+        if (empty(arguments) && !empty(fallback)) {
+            return std::make_shared<const arg_block>(
+                std::span<const std::string>{&fallback, 1u});
+        }
+        return std::make_shared<const arg_block>(arguments);
+    });
+}
+
+auto get_env_block(const environment_map& envars)
+    -> std::shared_ptr<const arg_block>
+{
+    static block_cache<environment_map> cache;
+    return cache.get(envars, [&]{
+        return std::make_shared<const arg_block>(envars);
+    });
+}
+
+}
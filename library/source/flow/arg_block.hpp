@@ -0,0 +1,66 @@
+#ifndef arg_block_hpp
+#define arg_block_hpp
+
+#include <memory> // for std::shared_ptr
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flow/environment_map.hpp"
+
+namespace flow::detail {
+
+/// @brief Null terminated vector of strings whose characters are all in
+///   one contiguous block, like for <code>execve</code>'s <code>argv</code>
+///   or <code>envp</code> parameters.
+/// @note This is immutable once made, so it's shareable between threads
+///   and between the children of any number of instantiations.
+struct arg_block
+{
+    /// @brief Makes a block of the given strings.
+    explicit arg_block(std::span<const std::string> strings);
+
+    /// @brief Makes a block of the given environment variables, each as
+    ///   their name and value separated by <code>reserved::env_separator</code>.
+    explicit arg_block(const environment_map& envars);
+
+    /// @brief Gets the null terminated vector of the strings.
+    [[nodiscard]] auto data() const noexcept -> char * const *
+    {
+        return pointers.data();
+    }
+
+    /// @brief Gets the strings, not including the null terminator.
+    [[nodiscard]] auto strings() const noexcept -> std::span<char * const>
+    {
+        return {pointers.data(), pointers.size() - 1u};
+    }
+
+private:
+    /// @brief Makes the pointers to the strings once all are added.
+    auto make_pointers(std::span<const std::size_t> offsets) -> void;
+
+    std::vector<char> chars;
+    std::vector<char*> pointers;
+};
+
+/// @brief Gets a block of the given arguments, or of just the given
+///   fallback if there are no arguments and the fallback isn't empty.
+/// @note Blocks are cached so getting the same arguments again doesn't
+///   allocate memory. This is thread-safe.
+/// @see make_arg_bufs(const std::vector<std::string>&, const std::string&).
+auto get_arg_block(const std::vector<std::string>& arguments,
+                   const std::string& fallback)
+    -> std::shared_ptr<const arg_block>;
+
+/// @brief Gets a block of the given environment variables.
+/// @note Blocks are cached so getting the same environment again doesn't
+///   allocate memory. This is thread-safe.
+/// @see make_arg_bufs(const environment_map&).
+auto get_env_block(const environment_map& envars)
+    -> std::shared_ptr<const arg_block>;
+
+}
+
+#endif /* arg_block_hpp */
@@ -0,0 +1,136 @@
+#include <algorithm> // for std::max
+#include <array>
+#include <charconv> // for std::to_chars
+#include <string_view>
+
+#include "flow/batch_adapter.hpp"
+
+#include "record_io.hpp"
+
+namespace flow {
+
+namespace {
+
+auto make_schema(const batch_adapter& spec, record_encoding encoding)
+    -> record_schema
+{
+    return record_schema{
+        .fields = spec.fields,
+        .encoding = encoding,
+        .field_delimiter = spec.field_delimiter,
+        .record_delimiter = spec.record_delimiter,
+    };
+}
+
+auto write_value(const column& col, std::size_t index,
+                 detail::record_writer& writer) -> void
+{
+    if (!is_valid(col, index)) {
+        return;
+    }
+    auto buffer = std::array<char, 32u>{};
+    auto result = std::to_chars_result{buffer.data(), {}};
+    switch (col.type) {
+    case field_type::text:
+        writer.append(get_text(col, index));
+        return;
+    case field_type::integer:
+        result = std::to_chars(buffer.data(), buffer.data() + size(buffer),
+                               col.integers[index]);
+        break;
+    case field_type::real:
+        result = std::to_chars(buffer.data(), buffer.data() + size(buffer),
+                               col.reals[index]);
+        break;
+    }
+    writer.append({buffer.data(),
+        static_cast<std::size_t>(result.ptr - buffer.data())});
+}
+
+}
+
+auto operator<<(std::ostream& os, batch_conversion value) -> std::ostream&
+{
+    switch (value) {
+    case batch_conversion::from_text:
+        os << "from_text";
+        return os;
+    case batch_conversion::to_text:
+        os << "to_text";
+        return os;
+    }
+    os << "batch_conversion(" << unsigned(value) << ")";
+    return os;
+}
+
+auto operator<<(std::ostream& os, const batch_adapter& value)
+    -> std::ostream&
+{
+    os << "batch_adapter{";
+    os << ".fields=" << make_schema(value, record_encoding::columnar);
+    os << ",.conversion=" << value.conversion;
+    os << ",.batch_size=" << value.batch_size;
+    os << "}";
+    return os;
+}
+
+auto make_port_map(const batch_adapter& adapter) -> port_map
+{
+    const auto text = make_schema(adapter, record_encoding::delimited);
+    const auto batches = make_schema(adapter, record_encoding::columnar);
+    const auto from_text = (adapter.conversion == batch_conversion::from_text);
+    return port_map{
+        {descriptors::stdin_id, {"stdin", io_type::in,
+            from_text? text: batches}},
+        {descriptors::stdout_id, {"stdout", io_type::out,
+            from_text? batches: text}},
+    };
+}
+
+auto adapt(const batch_adapter& spec, reference_descriptor in,
+           const batch_channel::handle& out) -> void
+{
+    const auto batch_size = std::max(spec.batch_size, std::size_t{1u});
+    auto reader = detail::record_reader{in, spec.record_delimiter};
+    auto batch = make_record_batch(spec.fields);
+    while (const auto record = reader.next()) {
+        auto rest = *record;
+        for (auto&& col: batch.columns) {
+            const auto found = rest.find(spec.field_delimiter);
+            append(col, rest.substr(0u, found));
+            rest.remove_prefix((found == std::string_view::npos)
+                               ? size(rest): found + 1u);
+        }
+        if (get_size(batch) >= batch_size) {
+            if (!out.send(std::move(batch))) {
+                return;
+            }
+            batch = make_record_batch(spec.fields);
+        }
+    }
+    if (get_size(batch) > 0u) {
+        out.send(std::move(batch));
+    }
+}
+
+auto adapt(const batch_adapter& spec, const batch_channel::handle& in,
+           reference_descriptor out) -> void
+{
+    detail::record_writer writer{out, spec.record_delimiter};
+    const auto delimiter = std::string_view{&spec.field_delimiter, 1u};
+    while (const auto batch = in.receive()) {
+        const auto count = get_size(*batch);
+        for (auto i = 0u; i < count; ++i) {
+            auto prefix = std::string_view{};
+            for (auto&& col: batch->columns) {
+                writer.append(prefix);
+                write_value(col, i, writer);
+                prefix = delimiter;
+            }
+            writer.write({});
+        }
+    }
+    writer.flush();
+}
+
+}
@@ -0,0 +1,166 @@
+#include <algorithm> // for std::max
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility> // for std::move
+
+#include "flow/batch_channel.hpp"
+
+namespace flow {
+
+struct batch_channel::impl
+{
+    explicit impl(std::size_t capacity_): capacity{capacity_}
+    {
+        // Intentionally empty.
+    }
+
+    auto send(record_batch batch) -> bool
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this]{
+            return (size(queue) < capacity) || read_closed || write_closed;
+        });
+        if (read_closed || write_closed) {
+            return false;
+        }
+        queue.push_back(std::move(batch));
+        ++sent;
+        lock.unlock();
+        cv.notify_all();
+        return true;
+    }
+
+    auto receive() -> std::optional<record_batch>
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this]{
+            return !empty(queue) || read_closed || write_closed;
+        });
+        if (read_closed || empty(queue)) {
+            return {};
+        }
+        auto result = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        cv.notify_all();
+        return result;
+    }
+
+    auto close(io side) -> void
+    {
+        {
+            const std::lock_guard lock{mutex};
+            if (side == io::read) {
+                read_closed = true;
+                queue.clear();
+            }
+            else {
+                write_closed = true;
+            }
+        }
+        cv.notify_all();
+    }
+
+    std::size_t capacity;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<record_batch> queue;
+    std::size_t sent{};
+    bool read_closed{};
+    bool write_closed{};
+};
+
+batch_channel::handle::handle() noexcept = default;
+
+batch_channel::handle::handle(std::shared_ptr<impl> pimpl_, io side_) noexcept:
+    pimpl{std::move(pimpl_)}, side{side_}
+{
+    // Intentionally empty.
+}
+
+auto batch_channel::handle::send(record_batch batch) const -> bool
+{
+    return pimpl && (side == io::write) && pimpl->send(std::move(batch));
+}
+
+auto batch_channel::handle::receive() const -> std::optional<record_batch>
+{
+    if (!pimpl || (side != io::read)) {
+        return {};
+    }
+    return pimpl->receive();
+}
+
+auto batch_channel::handle::close() const -> void
+{
+    if (pimpl) {
+        pimpl->close(side);
+    }
+}
+
+auto batch_channel::handle::get_side() const noexcept -> io
+{
+    return side;
+}
+
+batch_channel::batch_channel(std::size_t capacity):
+    pimpl{std::make_shared<impl>(std::max(capacity, std::size_t{1u}))}
+{
+    // Intentionally empty.
+}
+
+batch_channel::batch_channel(batch_channel&& other) noexcept = default;
+
+batch_channel::~batch_channel() noexcept
+{
+    if (pimpl) {
+        pimpl->close(io::write);
+        pimpl->close(io::read);
+    }
+}
+
+auto batch_channel::operator=(batch_channel&& other) noexcept
+    -> batch_channel&
+{
+    if (this != &other) {
+        if (pimpl) {
+            pimpl->close(io::write);
+            pimpl->close(io::read);
+        }
+        pimpl = std::move(other.pimpl);
+    }
+    return *this;
+}
+
+auto batch_channel::get(io side) const noexcept -> handle
+{
+    return handle{pimpl, side};
+}
+
+auto batch_channel::get_sent() const -> std::size_t
+{
+    if (!pimpl) {
+        return 0u;
+    }
+    const std::lock_guard lock{pimpl->mutex};
+    return pimpl->sent;
+}
+
+auto operator<<(std::ostream& os, batch_channel::io value)
+    -> std::ostream&
+{
+    os << ((value == batch_channel::io::read) ? "read": "write");
+    return os;
+}
+
+auto operator<<(std::ostream& os, const batch_channel& value)
+    -> std::ostream&
+{
+    os << "batch_channel{";
+    os << "sent=" << value.get_sent();
+    os << "}";
+    return os;
+}
+
+}
@@ -0,0 +1,89 @@
+#include <cstdlib> // for EXIT_FAILURE, EXIT_SUCCESS
+#include <sstream> // for std::ostringstream
+#include <stdexcept> // for std::invalid_argument
+
+#include "flow/builtin.hpp"
+#include "flow/utility.hpp"
+
+namespace flow {
+
+namespace {
+
+auto at(const builtin_descriptors& descriptors, reference_descriptor port)
+    -> reference_descriptor
+{
+    const auto found = descriptors.find(port);
+    if (found == descriptors.end()) {
+        std::ostringstream os;
+        os << "no descriptor for port " << port;
+        throw std::invalid_argument{os.str()};
+    }
+    return found->second;
+}
+
+auto at(const builtin_batches& batches, reference_descriptor port)
+    -> const batch_channel::handle&
+{
+    const auto found = batches.find(port);
+    if (found == batches.end()) {
+        std::ostringstream os;
+        os << "no batch channel for port " << port;
+        throw std::invalid_argument{os.str()};
+    }
+    return found->second;
+}
+
+}
+
+auto run(const builtin& implementation,
+         builtin_ports& ports,
+         std::ostream& diags) -> wait_status
+{
+    const auto& descriptors = ports.descriptors;
+    const auto& batches = ports.batches;
+    auto status = wait_status{wait_exit_status{EXIT_SUCCESS}};
+    try {
+        std::visit(detail::overloaded{
+            [&](const sorter& spec) {
+                sort(spec,
+                     at(descriptors, descriptors::stdin_id),
+                     at(descriptors, descriptors::stdout_id));
+            },
+            [&](const aggregator& spec) {
+                group_by(spec,
+                         at(descriptors, descriptors::stdin_id),
+                         at(descriptors, descriptors::stdout_id));
+            },
+            [&](const projector& spec) {
+                project(spec,
+                        at(descriptors, descriptors::stdin_id),
+                        at(descriptors, descriptors::stdout_id));
+            },
+            [&](const batch_adapter& spec) {
+                if (spec.conversion == batch_conversion::from_text) {
+                    adapt(spec,
+                          at(descriptors, descriptors::stdin_id),
+                          at(batches, descriptors::stdout_id));
+                }
+                else {
+                    adapt(spec,
+                          at(batches, descriptors::stdin_id),
+                          at(descriptors, descriptors::stdout_id));
+                }
+            },
+        }, implementation);
+    }
+    catch (const std::exception& ex) {
+        diags << implementation << " failed: " << ex.what() << "\n";
+        status = wait_exit_status{EXIT_FAILURE};
+    }
+    ports.descriptors.clear();
+    for (auto&& entry: ports.batches) {
+        entry.second.close();
+    }
+    ports.batches.clear();
+    diags.flush();
+    return status;
+}
+
+}
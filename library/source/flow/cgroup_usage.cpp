@@ -0,0 +1,22 @@
+#include "flow/cgroup_usage.hpp"
+
+namespace flow {
+
+auto operator<<(std::ostream& os, const cgroup_usage& value)
+    -> std::ostream&
+{
+    os << "cpu-usec=" << value.cpu_time.count();
+    os << ", user-usec=" << value.user_time.count();
+    os << ", system-usec=" << value.system_time.count();
+    os << ", throttled-periods=" << value.throttled_periods;
+    os << ", throttled-usec=" << value.throttled_time.count();
+    if (value.memory_current) {
+        os << ", memory-current=" << *value.memory_current;
+    }
+    if (value.memory_peak) {
+        os << ", memory-peak=" << *value.memory_peak;
+    }
+    return os;
+}
+
+}
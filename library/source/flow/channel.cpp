@@ -1,8 +1,10 @@
+#include <algorithm> // for std::any_of, std::all_of
 #include <cerrno> // for errno
 #include <cstring> // for std::streror
 #include <iostream>
 #include <optional>
 #include <sstream> // for std::ostringstream
+#include <vector>
 
 #include <fcntl.h> // for ::open
 
@@ -12,6 +14,8 @@
 #include "flow/node.hpp"
 #include "flow/utility.hpp"
 
+#include "channel_recipe.hpp"
+
 namespace flow {
 
 auto operator<<(std::ostream& os, const reference_channel& value)
@@ -192,13 +196,95 @@ auto validate(const node_endpoint& end,
         : validate(end, nodes, expected_io);
 }
 
+auto get_port_infos(const node_endpoint& end,
+                    const port_map& interface,
+                    const std::map<node_name, node>& nodes)
+    -> std::vector<const port_info*>
+{
+    const auto& ports = (end.address == node_name{})
+        ? interface
+        : nodes.at(end.address).interface;
+    auto result = std::vector<const port_info*>{};
+    for (auto&& port: end.ports) {
+        result.push_back(&at(ports, port));
+    }
+    return result;
+}
+
+/// @brief Confirms that the record schemas of the linked ports agree.
+/// @note Ports without a schema are untyped and agree with any other.
+auto validate_schemas(const node_endpoint& src,
+                      const node_endpoint& dst,
+                      const port_map& interface,
+                      const std::map<node_name, node>& nodes) -> void
+{
+    for (auto&& src_info: get_port_infos(src, interface, nodes)) {
+        if (!src_info->schema) {
+            continue;
+        }
+        for (auto&& dst_info: get_port_infos(dst, interface, nodes)) {
+            if (dst_info->schema &&
+                !is_compatible(*src_info->schema, *dst_info->schema)) {
+                std::ostringstream os;
+                os << "link between incompatible record schemas";
+                os << ": src-schema=" << *src_info->schema;
+                os << ", dst-schema=" << *dst_info->schema;
+                throw std::invalid_argument{os.str()};
+            }
+        }
+    }
+}
+
+auto is_columnar(const port_info* info) -> bool
+{
+    return info->schema &&
+           (info->schema->encoding == record_encoding::columnar);
+}
+
+auto is_columnar(const node_endpoint& end,
+                 const port_map& interface,
+                 const std::map<node_name, node>& nodes) -> bool
+{
+    const auto infos = get_port_infos(end, interface, nodes);
+    return std::any_of(infos.begin(), infos.end(), [](const port_info* info){
+        return is_columnar(info);
+    });
+}
+
+/// @brief Validates a link between columnar ports.
+/// @note Columnar ports exchange record batches in-process, so they can
+///   only be linked to the columnar ports of other built-ins.
+auto validate_batch_channel(const node_endpoint* src,
+                            const node_endpoint* dst,
+                            const port_map& interface,
+                            const std::map<node_name, node>& nodes)
+    -> void
+{
+    const auto is_builtin = [&](const node_endpoint* end){
+        if (!end || (end->address == node_name{})) {
+            return false;
+        }
+        const auto infos = get_port_infos(*end, interface, nodes);
+        return std::holds_alternative<builtin>(nodes.at(end->address).implementation)
+            && std::all_of(infos.begin(), infos.end(), [](const port_info* info){
+                return is_columnar(info);
+            });
+    };
+    if (!is_builtin(src) || !is_builtin(dst)) {
+        std::ostringstream os;
+        os << "columnar ports can only link to other built-ins'";
+        os << " columnar ports";
+        throw std::invalid_argument{os.str()};
+    }
+}
+
 auto make_forwarding_channel(const file_endpoint& src, const file_endpoint& dst)
     -> forwarding_channel
 {
     const auto mode = 0600;
     auto src_d = owning_descriptor{
         ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
-               src.path.c_str(), O_RDONLY, mode)
+               src.path.c_str(), O_RDONLY|O_CLOEXEC, mode)
     };
     if (!src_d) {
         const auto err = os_error_code(errno);
@@ -209,7 +295,7 @@ auto make_forwarding_channel(const file_endpoint& src, const file_endpoint& dst)
     }
     auto dst_d = owning_descriptor{
         ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
-               dst.path.c_str(), O_WRONLY, mode)
+               dst.path.c_str(), O_WRONLY|O_CLOEXEC, mode)
     };
     if (!dst_d) {
         const auto err = os_error_code(errno);
@@ -230,11 +316,10 @@ auto make_forwarding_channel(const pipe_channel& src, const pipe_channel& dst)
     };
 }
 
-auto make_reference_channel(const std::set<port_id>& dset,
+auto plan_reference_channel(const std::set<port_id>& dset,
                             const node_name& name,
-                            const std::span<const link>& parent_links,
-                            const std::span<channel>& parent_channels)
-    -> reference_channel
+                            const std::span<const link>& parent_links)
+    -> reference_recipe
 {
     const auto look_for = node_endpoint{name, dset};
     const auto found = find_index(parent_links, look_for);
@@ -245,14 +330,13 @@ auto make_reference_channel(const std::set<port_id>& dset,
         os << " endpoint for making reference channel";
         throw std::invalid_argument{os.str()};
     }
-    return {&parent_channels[*found]};
+    return {*found};
 }
 
-auto make_forwarding_channel(const user_endpoint& src,
+auto plan_forwarding_channel(const user_endpoint& src,
                              const user_endpoint& dst,
-                             const std::span<const link>& links,
-                             const std::span<channel>& channels)
-    -> forwarding_channel
+                             const std::span<const link>& links)
+    -> pipe_forwarding_recipe
 {
     const auto src_conn = find_index(links, src);
     if (!src_conn) {
@@ -268,8 +352,7 @@ auto make_forwarding_channel(const user_endpoint& src,
         os << dst;
         throw std::invalid_argument{os.str()};
     }
-    return make_forwarding_channel(std::get<pipe_channel>(channels[*src_conn]),
-                                   std::get<pipe_channel>(channels[*dst_conn]));
+    return {*src_conn, *dst_conn};
 }
 
 auto to_signal_set(const std::set<port_id>& ports) -> std::set<signal>
@@ -281,7 +364,7 @@ auto to_signal_set(const std::set<port_id>& ports) -> std::set<signal>
     return signals;
 }
 
-auto make_signal_channel(const node_endpoint& src,
+auto plan_signal_channel(const node_endpoint& src,
                          const node_endpoint& dst) -> signal_channel
 {
     if (src.ports != dst.ports) {
@@ -308,15 +391,13 @@ auto get_interface_ports(const node_endpoint* end)
     return (end && (end->address == node_name{}))? &(end->ports): nullptr;
 }
 
-auto make_channel(const endpoint& src,
+auto plan_channel(const endpoint& src,
                   const endpoint& dst,
                   const node_name& name,
                   const port_map& interface,
                   const system& implementation,
-                  const std::span<channel>& channels,
-                  const std::span<const link>& parent_links,
-                  const std::span<channel>& parent_channels)
-    -> channel
+                  const std::span<const link>& parent_links)
+    -> channel_recipe
 {
     if (src == dst) {
         throw std::invalid_argument{"must have different endpoints"};
@@ -324,13 +405,13 @@ auto make_channel(const endpoint& src,
     const auto src_file = std::get_if<file_endpoint>(&src);
     const auto dst_file = std::get_if<file_endpoint>(&dst);
     if (src_file && dst_file) {
-        return make_forwarding_channel(*src_file, *dst_file);
+        return file_forwarding_recipe{*src_file, *dst_file};
     }
     const auto src_user = std::get_if<user_endpoint>(&src);
     const auto dst_user = std::get_if<user_endpoint>(&dst);
     if (src_user && dst_user) {
-        return make_forwarding_channel(*src_user, *dst_user,
-                                       implementation.links, channels);
+        return plan_forwarding_channel(*src_user, *dst_user,
+                                       implementation.links);
     }
     const auto src_node = std::get_if<node_endpoint>(&src);
     const auto dst_node = std::get_if<node_endpoint>(&dst);
@@ -343,6 +424,16 @@ auto make_channel(const endpoint& src,
     const auto dst_port_type = dst_node
         ? validate(*dst_node, interface, implementation.nodes, io_type::in)
         : port_type::unknown;
+    if ((src_node && is_columnar(*src_node, interface, implementation.nodes)) ||
+        (dst_node && is_columnar(*dst_node, interface, implementation.nodes))) {
+        if (src_node && dst_node) {
+            validate_schemas(*src_node, *dst_node,
+                             interface, implementation.nodes);
+        }
+        validate_batch_channel(src_node, dst_node,
+                               interface, implementation.nodes);
+        return batch_recipe{};
+    }
     const auto src_dset = get_interface_ports(src_node);
     const auto dst_dset = get_interface_ports(dst_node);
     if (src_dset && dst_dset) {
@@ -358,7 +449,7 @@ auto make_channel(const endpoint& src,
         return file_channel{dst_file->path, io_type::out};
     }
     if (src_user || dst_user) {
-        return pipe_channel{};
+        return pipe_recipe{};
     }
     if (src_node && dst_node) {
         if (src_port_type != dst_port_type) {
@@ -369,22 +460,95 @@ auto make_channel(const endpoint& src,
             throw std::invalid_argument{os.str()};
         }
         if (src_port_type == port_type::signal) {
-            return make_signal_channel(*src_node, *dst_node);
+            return plan_signal_channel(*src_node, *dst_node);
         }
+        validate_schemas(*src_node, *dst_node, interface, implementation.nodes);
     }
     if (src_dset) {
-        return make_reference_channel(*src_dset, name,
-                                      parent_links, parent_channels);
+        return plan_reference_channel(*src_dset, name, parent_links);
     }
     if (dst_dset) {
-        return make_reference_channel(*dst_dset, name,
-                                      parent_links, parent_channels);
+        return plan_reference_channel(*dst_dset, name, parent_links);
+    }
+    return pipe_recipe{};
+}
+
+auto get_pipe_channel(const std::span<channel>& channels, std::size_t index)
+    -> pipe_channel&
+{
+    const auto p = (index < size(channels))
+        ? std::get_if<pipe_channel>(&channels[index]): nullptr;
+    if (!p) {
+        std::ostringstream os;
+        os << "link " << index << " has no pipe channel to forward";
+        throw std::invalid_argument{os.str()};
     }
-    return pipe_channel{};
+    return *p;
+}
+
+auto make_channel(const channel_recipe& recipe,
+                  const std::span<channel>& channels,
+                  const std::span<channel>& parent_channels)
+    -> channel
+{
+    return std::visit(detail::overloaded{
+        [](const pipe_recipe&) -> channel {
+            return pipe_channel{};
+        },
+        [](const batch_recipe&) -> channel {
+            return batch_channel{};
+        },
+        [](const file_channel& arg) -> channel {
+            return arg;
+        },
+        [](const signal_channel& arg) -> channel {
+            return arg;
+        },
+        [&](const reference_recipe& arg) -> channel {
+            return reference_channel{&parent_channels[arg.index]};
+        },
+        [](const file_forwarding_recipe& arg) -> channel {
+            return make_forwarding_channel(arg.src, arg.dst);
+        },
+        [&](const pipe_forwarding_recipe& arg) -> channel {
+            return make_forwarding_channel(get_pipe_channel(channels, arg.src),
+                                           get_pipe_channel(channels, arg.dst));
+        },
+    }, recipe);
 }
 
 }
 
+auto plan_channel(const link& for_link,
+                  const node_name& name,
+                  const port_map& interface,
+                  const system& implementation,
+                  const std::span<const link>& parent_links)
+    -> channel_recipe
+{
+    try {
+        return plan_channel(for_link.a, for_link.b,
+                            name, interface, implementation, parent_links);
+    }
+    catch (const std::invalid_argument& ex) {
+        throw invalid_link{for_link, ex.what()};
+    }
+}
+
+auto make_channel(const link& for_link,
+                  const channel_recipe& recipe,
+                  const std::span<channel>& channels,
+                  const std::span<channel>& parent_channels)
+    -> channel
+{
+    try {
+        return make_channel(recipe, channels, parent_channels);
+    }
+    catch (const std::invalid_argument& ex) {
+        throw invalid_link{for_link, ex.what()};
+    }
+}
+
 auto make_channel(const link& for_link,
                   const node_name& name,
                   const port_map& interface,
@@ -403,14 +567,10 @@ auto make_channel(const link& for_link,
         os << ")";
         throw std::logic_error{os.str()};
     }
-    try {
-        return make_channel(for_link.a, for_link.b,
-                            name, interface, implementation,
-                            channels, parent_links, parent_channels);
-    }
-    catch (std::invalid_argument& ex) {
-        throw invalid_link{for_link, ex.what()};
-    }
+    return make_channel(for_link,
+                        plan_channel(for_link, name, interface,
+                                     implementation, parent_links),
+                        channels, parent_channels);
 }
 
 }
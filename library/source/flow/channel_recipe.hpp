@@ -0,0 +1,86 @@
+#ifndef channel_recipe_hpp
+#define channel_recipe_hpp
+
+#include <cstddef> // for std::size_t
+#include <span>
+#include <variant>
+
+#include "flow/channel.hpp"
+#include "flow/file_endpoint.hpp"
+#include "flow/link.hpp"
+#include "flow/node_name.hpp"
+#include "flow/port_map.hpp"
+
+namespace flow::detail {
+
+/// @brief Recipe for a <code>pipe_channel</code>.
+struct pipe_recipe {};
+
+/// @brief Recipe for a <code>batch_channel</code>.
+struct batch_recipe {};
+
+/// @brief Recipe for a <code>reference_channel</code> to the parent's
+///   channel at the given index.
+struct reference_recipe
+{
+    std::size_t index{};
+};
+
+/// @brief Recipe for a <code>forwarding_channel</code> from one file to
+///   another.
+struct file_forwarding_recipe
+{
+    file_endpoint src;
+    file_endpoint dst;
+};
+
+/// @brief Recipe for a <code>forwarding_channel</code> between the pipe
+///   channels of the links at the given indices.
+struct pipe_forwarding_recipe
+{
+    std::size_t src{};
+    std::size_t dst{};
+};
+
+/// @brief Validated description of the <code>channel</code> to make for
+///   a <code>link</code>.
+/// @details Making a channel from one of these needs no validation, nor
+///   any searching of links, so the same ones can be used to make the
+///   channels for any number of instantiations.
+/// @note File & signal channels are values, so they're their own recipes.
+using channel_recipe = std::variant<
+    pipe_recipe,
+    batch_recipe,
+    file_channel,
+    signal_channel,
+    reference_recipe,
+    file_forwarding_recipe,
+    pipe_forwarding_recipe
+>;
+
+/// @brief Validates a <code>link</code> & gets the recipe for its channel.
+/// @throws invalid_link if something is invalid about @p for_link for the
+///   given context that prevents making its channel.
+/// @see make_channel.
+auto plan_channel(const link& for_link,
+                  const node_name& name,
+                  const port_map& interface,
+                  const system& implementation,
+                  const std::span<const link>& parent_links)
+    -> channel_recipe;
+
+/// @brief Makes the channel for a <code>link</code> from its recipe.
+/// @param[in] channels Channels made so far for the links of the system
+///   @p for_link is one of.
+/// @param[in] parent_channels Channels of the parent system.
+/// @throws invalid_link if the channel can't be made, like from a file
+///   not being openable.
+auto make_channel(const link& for_link,
+                  const channel_recipe& recipe,
+                  const std::span<channel>& channels,
+                  const std::span<channel>& parent_channels)
+    -> channel;
+
+}
+
+#endif /* channel_recipe_hpp */
@@ -0,0 +1,322 @@
+#include <algorithm> // for std::min, std::copy_n
+#include <array>
+#include <cerrno> // for errno
+#include <charconv> // for std::to_chars
+#include <cstring> // for std::strlen, strerrordesc_np
+
+#include <fcntl.h> // for ::open, ::fcntl
+#include <unistd.h> // for ::close, ::close_range, ::dup2, ::fexecve, ...
+
+#include <sys/resource.h> // for ::getrlimit
+#include <sys/syscall.h> // for SYS_set_mempolicy, SYS_ioprio_set
+
+#include <linux/ioprio.h> // for IOPRIO_WHO_PROCESS
+
+#include "child_actions.hpp"
+
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 32)))
+#define FLOW_HAS_STRERRORDESC_NP 1
+#endif
+
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 34)))
+#define FLOW_HAS_CLOSE_RANGE 1
+#endif
+
+namespace flow::detail {
+
+namespace {
+
+/// @brief Diagnostic line formatted without allocating memory.
+/// @note Content that doesn't fit is truncated.
+struct message
+{
+    static constexpr auto max_size = 1024u;
+
+    auto append(const char *s) noexcept -> message&
+    {
+        const auto n = std::min(std::strlen(s), max_size - length);
+        std::copy_n(s, n, data(buffer) + length);
+        length += n;
+        return *this;
+    }
+
+    auto append(long long value) noexcept -> message&
+    {
+        const auto first = data(buffer) + length;
+        const auto result = std::to_chars(first, data(buffer) + max_size,
+                                          value);
+        if (result.ec == std::errc{}) {
+            length += static_cast<std::size_t>(result.ptr - first);
+        }
+        return *this;
+    }
+
+    /// @brief Appends the given error number like
+    ///   <code>operator<<(std::ostream&, os_error_code)</code> does.
+    auto append_error(int err) noexcept -> message&
+    {
+        append("system:").append(err);
+#if defined(FLOW_HAS_STRERRORDESC_NP)
+        if (const auto desc = ::strerrordesc_np(err)) {
+            append(" (").append(desc).append(")");
+        }
+#endif
+        return *this;
+    }
+
+    auto write(int fd) const noexcept -> void
+    {
+        auto first = data(buffer);
+        auto remaining = length;
+        while (remaining > 0u) {
+            const auto n = ::write(fd, first, remaining);
+            if (n == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            first += n;
+            remaining -= static_cast<std::size_t>(n);
+        }
+    }
+
+    std::array<char, max_size> buffer{};
+    std::size_t length{};
+};
+
+auto report(const message& msg, int err, int diags) noexcept -> void
+{
+    auto line = msg;
+    line.append(" failed: ").append_error(err).append("\n");
+    line.write(diags);
+}
+
+auto perform(const close_action& action, int diags) noexcept -> bool
+{
+    if ((::close(action.fd) == -1) && (errno != EBADF)) {
+        report(message{}.append("close(").append(action.fd).append(")"),
+               errno, diags);
+        return false;
+    }
+    return true;
+}
+
+auto perform(const close_range_action& action, int diags) noexcept -> bool
+{
+#if defined(FLOW_HAS_CLOSE_RANGE)
+    if (::close_range(action.first, action.last, 0) == 0) {
+        return true;
+    }
+    if (errno != ENOSYS) {
+        report(message{}.append("close_range(").append(action.first)
+                        .append(",").append(action.last).append(")"),
+               errno, diags);
+        return false;
+    }
+#endif
+    // Fall back to closing every descriptor that could be open.
+    static constexpr auto default_nr_open = 1024ull * 1024ull;
+    auto limit = rlimit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+        report(message{}.append("getrlimit(RLIMIT_NOFILE)"), errno, diags);
+        return false;
+    }
+    const auto max_fds = (limit.rlim_cur == RLIM_INFINITY)
+        ? default_nr_open: static_cast<unsigned long long>(limit.rlim_cur);
+    const auto last = std::min<unsigned long long>(action.last, max_fds - 1u);
+    for (auto fd = static_cast<unsigned long long>(action.first); fd <= last;
+         ++fd) {
+        ::close(int(fd));
+    }
+    return true;
+}
+
+auto perform(const dup2_action& action, int diags) noexcept -> bool
+{
+    if (action.fd == action.newfd) {
+        if (::fcntl(action.fd, F_SETFD, 0) == -1) { // NOLINT(cppcoreguidelines-pro-type-vararg)
+            report(message{}.append("fcntl(").append(action.fd)
+                            .append(",F_SETFD,0)"),
+                   errno, diags);
+            return false;
+        }
+        return true;
+    }
+    if (::dup2(action.fd, action.newfd) == -1) {
+        report(message{}.append("dup2(").append(action.fd)
+                        .append(",").append(action.newfd).append(")"),
+               errno, diags);
+        return false;
+    }
+    return true;
+}
+
+auto perform(const open_action& action, int diags) noexcept -> bool
+{
+    const auto fd = ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
+                           action.path, action.flags, action.mode);
+    if (fd == -1) {
+        report(message{}.append("open file \"").append(action.path)
+                        .append("\" as ").append(action.fd),
+               errno, diags);
+        return false;
+    }
+    if (fd != action.fd) {
+        if (::dup2(fd, action.fd) == -1) {
+            report(message{}.append("dup2(").append(fd)
+                            .append(",").append(action.fd).append(")"),
+                   errno, diags);
+            return false;
+        }
+        ::close(fd);
+    }
+    return true;
+}
+
+auto perform(const chdir_action& action, int diags) noexcept -> bool
+{
+    if (::chdir(action.path) == -1) {
+        report(message{}.append("chdir \"").append(action.path).append("\""),
+               errno, diags);
+        return false;
+    }
+    return true;
+}
+
+auto perform(const fchdir_action& action, int diags) noexcept -> bool
+{
+    if (::fchdir(action.fd) == -1) {
+        report(message{}.append("fchdir(").append(action.fd).append(")"),
+               errno, diags);
+        return false;
+    }
+    return true;
+}
+
+auto perform(const setpgid_action& action, int diags) noexcept -> bool
+{
+    if (::setpgid(0, int(action.pgrp)) == -1) {
+        report(message{}.append("setpgid(0, ")
+                        .append(int(action.pgrp)).append(")"),
+               errno, diags);
+    }
+    return true;
+}
+
+auto perform(const cgroup_action& action, int diags) noexcept -> bool
+{
+    // Writing zero moves the writing process.
+    const auto fd = ::openat( // NOLINT(cppcoreguidelines-pro-type-vararg)
+                             action.fd, "cgroup.procs", O_WRONLY|O_CLOEXEC);
+    if ((fd == -1) || (::write(fd, "0", 1u) == -1)) {
+        const auto err = errno;
+        if (fd != -1) {
+            ::close(fd);
+        }
+        report(message{}.append("joining control group of ")
+                        .append(action.fd),
+               err, diags);
+        return true;
+    }
+    ::close(fd);
+    return true;
+}
+
+auto perform(const affinity_action& action, int diags) noexcept -> bool
+{
+    if (::sched_setaffinity(0, sizeof(action.cpus), &action.cpus) == -1) {
+        report(message{}.append("sched_setaffinity(0, ")
+                        .append(CPU_COUNT(&action.cpus))
+                        .append(" CPUs)"),
+               errno, diags);
+    }
+    return true;
+}
+
+auto perform(const mempolicy_action& action, int diags) noexcept -> bool
+{
+    // glibc has no wrapper for this. The maximum node is one more than the
+    // number of bits of the mask, as the kernel ignores the last one.
+    static constexpr auto max_node = (sizeof(action.nodes) * 8u) + 1u;
+    const auto nodes = (action.nodes != 0u)? &action.nodes: nullptr;
+    if (::syscall(SYS_set_mempolicy, // NOLINT(cppcoreguidelines-pro-type-vararg)
+                  action.mode, nodes, nodes? max_node: 0u) == -1) {
+        report(message{}.append("set_mempolicy(").append(action.mode)
+                        .append(", ").append(static_cast<long long>(action.nodes))
+                        .append(")"),
+               errno, diags);
+    }
+    return true;
+}
+
+auto perform(const nice_action& action, int diags) noexcept -> bool
+{
+    if (::setpriority(PRIO_PROCESS, 0, action.value) == -1) {
+        report(message{}.append("setpriority(PRIO_PROCESS, 0, ")
+                        .append(action.value).append(")"),
+               errno, diags);
+    }
+    return true;
+}
+
+auto perform(const scheduler_action& action, int diags) noexcept -> bool
+{
+    const auto param = sched_param{};
+    if (::sched_setscheduler(0, action.policy, &param) == -1) {
+        report(message{}.append("sched_setscheduler(0, ")
+                        .append(action.policy).append(")"),
+               errno, diags);
+    }
+    return true;
+}
+
+auto perform(const ioprio_action& action, int diags) noexcept -> bool
+{
+    // glibc has no wrapper for this.
+    if (::syscall(SYS_ioprio_set, // NOLINT(cppcoreguidelines-pro-type-vararg)
+                  IOPRIO_WHO_PROCESS, 0, action.value) == -1) {
+        report(message{}.append("ioprio_set(IOPRIO_WHO_PROCESS, 0, ")
+                        .append(action.value).append(")"),
+               errno, diags);
+    }
+    return true;
+}
+
+}
+
+auto perform(const std::vector<child_action>& actions, int diags) noexcept
+    -> bool
+{
+    for (auto&& action: actions) {
+        const auto ok = std::visit([diags](const auto& a) noexcept {
+            return perform(a, diags);
+        }, action);
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto exec(const char *path,
+          int fd,
+          char * const *argv,
+          char * const *envp,
+          const std::vector<child_action>& actions,
+          int diags) noexcept -> void
+{
+    if (!perform(actions, diags)) {
+        return;
+    }
+    if (fd >= 0) {
+        ::fexecve(fd, argv, envp);
+    }
+    ::execve(path, argv, envp);
+    report(message{}.append("execve of \"").append(path).append("\""),
+           errno, diags);
+}
+
+}
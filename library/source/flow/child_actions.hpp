@@ -0,0 +1,170 @@
+#ifndef child_actions_hpp
+#define child_actions_hpp
+
+#include <variant>
+#include <vector>
+
+#include <sched.h> // for cpu_set_t
+#include <sys/types.h> // for mode_t
+
+#include "flow/reference_process_id.hpp"
+
+namespace flow::detail {
+
+/// @brief Closes a descriptor of the child.
+/// @note Failing to close a descriptor that isn't open is not an error.
+struct close_action
+{
+    int fd{-1};
+};
+
+/// @brief Closes the descriptors of the child from first to last inclusive.
+/// @note Use <code>close_range_action::unbounded</code> as the last
+///   descriptor to close every descriptor from the first on.
+struct close_range_action
+{
+    static constexpr auto unbounded = ~0u;
+
+    unsigned first{};
+    unsigned last{unbounded};
+};
+
+/// @brief Duplicates a descriptor of the child onto another descriptor.
+/// @note The new descriptor is never close-on-exec, even if it's the same
+///   as the duplicated descriptor.
+struct dup2_action
+{
+    int fd{-1};
+    int newfd{-1};
+};
+
+/// @brief Opens a file as the given descriptor of the child.
+/// @note The path must outlive the creation of the child.
+struct open_action
+{
+    int fd{-1};
+    const char *path{};
+    int flags{};
+    mode_t mode{};
+};
+
+/// @brief Changes the working directory of the child.
+/// @note The path must outlive the creation of the child.
+struct chdir_action
+{
+    const char *path{};
+};
+
+/// @brief Changes the working directory of the child to the given
+///   directory descriptor of the child.
+struct fchdir_action
+{
+    int fd{-1};
+};
+
+/// @brief Puts the child into the given process group.
+/// @note <code>no_process_id</code> makes the child leader of its own group.
+/// @note Failing to do this is reported but not an error.
+struct setpgid_action
+{
+    reference_process_id pgrp{no_process_id};
+};
+
+/// @brief Moves the child into the cgroup v2 control group of the given
+///   directory descriptor.
+/// @note This does nothing for a child that was created into the group.
+/// @note Failing to do this is reported but not an error.
+struct cgroup_action
+{
+    int fd{-1};
+};
+
+/// @brief Sets the CPU affinity of the child to the given CPUs.
+/// @note Failing to do this is reported but not an error.
+struct affinity_action
+{
+    cpu_set_t cpus{};
+};
+
+/// @brief Sets the NUMA memory policy of the child.
+/// @note The mode is one of the <code>MPOL_*</code> modes of
+///   <code>set_mempolicy</code>, & nodes is its node mask.
+/// @note Failing to do this is reported but not an error.
+struct mempolicy_action
+{
+    int mode{};
+    unsigned long nodes{};
+};
+
+/// @brief Sets the nice value of the child.
+/// @note Failing to do this is reported but not an error.
+struct nice_action
+{
+    int value{};
+};
+
+/// @brief Sets the scheduling policy of the child to the given
+///   non-realtime policy.
+/// @note Failing to do this is reported but not an error.
+struct scheduler_action
+{
+    int policy{};
+};
+
+/// @brief Sets the I/O priority of the child.
+/// @note The value is as made by <code>IOPRIO_PRIO_VALUE</code>.
+/// @note Failing to do this is reported but not an error.
+struct ioprio_action
+{
+    int value{};
+};
+
+/// @brief Primitive action to perform in a child before it executes a file.
+/// @note Actions are computed by the parent so the child need not allocate
+///   memory or otherwise do anything that isn't async-signal-safe.
+using child_action = std::variant<
+    close_action,
+    close_range_action,
+    dup2_action,
+    open_action,
+    chdir_action,
+    fchdir_action,
+    setpgid_action,
+    cgroup_action,
+    affinity_action,
+    mempolicy_action,
+    nice_action,
+    scheduler_action,
+    ioprio_action
+>;
+
+/// @brief Performs the given actions in order.
+/// @note This is for calling from a forked child and is async-signal-safe.
+/// @param[in] actions Actions to perform.
+/// @param[in] diags Descriptor to write a line describing any failure to.
+/// @return Whether all the actions succeeded. Performing actions stops at
+///   the first that fails.
+auto perform(const std::vector<child_action>& actions, int diags) noexcept
+    -> bool;
+
+/// @brief Executes the given file after performing the given actions.
+/// @note This is for calling from a forked child and is async-signal-safe.
+/// @note This only returns if performing the actions, or executing the file,
+///   fails. Either way, a line describing the failure is written to
+///   @p diags.
+/// @param[in] path Path of the file to execute.
+/// @param[in] fd Descriptor of the file to execute via <code>fexecve</code>
+///   instead of by @p path, or -1 for none. This must be kept open by the
+///   actions. The file is executed by @p path still if this fails, like
+///   for interpreted files which can't be executed from a close-on-exec
+///   descriptor.
+auto exec(const char *path,
+          int fd,
+          char * const *argv,
+          char * const *envp,
+          const std::vector<child_action>& actions,
+          int diags) noexcept -> void;
+
+}
+
+#endif /* child_actions_hpp */
@@ -0,0 +1,255 @@
+#include <sys/eventfd.h>
+#include <unistd.h> // for ::read, ::write
+
+#include <cerrno> // for errno
+#include <chrono>
+#include <cstdint> // for std::uint64_t
+#include <memory> // for std::make_shared, std::shared_ptr
+#include <mutex>
+#include <stdexcept> // for std::invalid_argument
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility> // for std::move, std::exchange
+
+#include "flow/completion_monitor.hpp"
+#include "flow/owning_descriptor.hpp"
+#include "flow/utility.hpp"
+
+#include "notifier.hpp"
+
+namespace flow {
+
+namespace {
+
+/// @brief Instances that have changed state, & the eventfd that's readable
+///   while there are any.
+/// @note This is shared with the functions notified of changes, which run
+///   on other threads & may outlive the monitor.
+struct changes
+{
+    changes();
+
+    /// @brief Records that the given instance has changed state.
+    auto mark(instance* object) -> void;
+
+    /// @brief Takes the instances that have changed state.
+    auto take() -> std::unordered_set<instance*>;
+
+    std::mutex mutex;
+    std::unordered_set<instance*> changed;
+    owning_descriptor event;
+};
+
+changes::changes():
+    event{::eventfd(0u, EFD_CLOEXEC|EFD_NONBLOCK)}
+{
+    if (!event) {
+        throw std::system_error{errno, std::system_category(),
+                                "can't make completion monitor eventfd"};
+    }
+}
+
+auto changes::mark(instance* object) -> void
+{
+    const std::lock_guard lock{mutex};
+    if (changed.insert(object).second && (size(changed) == 1u)) {
+        const auto one = std::uint64_t{1u};
+        (void) ::write(int(event), &one, sizeof(one));
+    }
+}
+
+auto changes::take() -> std::unordered_set<instance*>
+{
+    const std::lock_guard lock{mutex};
+    auto count = std::uint64_t{};
+    (void) ::read(int(event), &count, sizeof(count));
+    return std::exchange(changed, {});
+}
+
+/// @brief Sets the given function to be called whenever a process or
+///   built-in of the given instance changes state.
+/// @note Processes & built-ins that can't notify of changes are treated
+///   as having changed, so they're checked at least once.
+auto observe(instance& object, const std::function<void()>& function,
+             changes& observer, instance& root) -> void
+{
+    std::visit(detail::overloaded{
+        [&](instance::system& info) {
+            for (auto&& entry: info.children) {
+                observe(entry.second, function, observer, root);
+            }
+        },
+        [&](instance::forked& info) {
+            if (const auto p = std::get_if<owning_process_id>(&info.state);
+                p && (reference_process_id(*p) != invalid_process_id)) {
+                p->on_change(function);
+                return;
+            }
+            if (function) {
+                observer.mark(&root);
+            }
+        },
+        [&](instance::builtin& info) {
+            if (info.finishing) {
+                info.finishing->set(function);
+                return;
+            }
+            if (function) {
+                observer.mark(&root);
+            }
+        },
+    }, object.info);
+}
+
+/// @brief Whether all the processes & built-ins of the given instance have
+///   been waited for.
+auto is_complete(const instance& object) -> bool
+{
+    return std::visit(detail::overloaded{
+        [](const instance::system& info) {
+            for (auto&& entry: info.children) {
+                if (!is_complete(entry.second)) {
+                    return false;
+                }
+            }
+            return true;
+        },
+        [](const instance::forked& info) {
+            return std::holds_alternative<wait_status>(info.state);
+        },
+        [](const instance::builtin& info) {
+            // One that was never started has nothing to wait for.
+            const auto p = std::get_if<std::future<wait_status>>(&info.state);
+            return !p || !p->valid();
+        },
+    }, object.info);
+}
+
+}
+
+struct completion_monitor::impl
+{
+    struct entry
+    {
+        callback on_complete;
+        std::promise<std::vector<wait_result>> promise;
+        std::vector<wait_result> results;
+    };
+
+    impl() = default;
+    ~impl() noexcept;
+
+    /// @brief Stops the processes & built-ins of the given instance from
+    ///   notifying of changes.
+    auto ignore(instance& object) -> void;
+
+    std::shared_ptr<changes> observer{std::make_shared<changes>()};
+    std::unordered_map<instance*, entry> tracked;
+};
+
+completion_monitor::impl::~impl() noexcept
+{
+    for (auto&& entry: tracked) {
+        try {
+            ignore(*entry.first);
+        }
+        catch (...) {
+            // Nothing more to do about it.
+        }
+    }
+}
+
+auto completion_monitor::impl::ignore(instance& object) -> void
+{
+    observe(object, {}, *observer, object);
+}
+
+completion_monitor::completion_monitor():
+    pimpl{std::make_unique<impl>()}
+{
+    // Intentionally empty.
+}
+
+completion_monitor::completion_monitor(completion_monitor&& other) noexcept =
+    default;
+
+completion_monitor::~completion_monitor() = default;
+
+auto completion_monitor::operator=(completion_monitor&& other) noexcept
+    -> completion_monitor& = default;
+
+auto completion_monitor::track(instance& object, callback on_complete)
+    -> std::future<std::vector<wait_result>>
+{
+    const auto [it, inserted] = pimpl->tracked.try_emplace(&object);
+    if (!inserted) {
+        throw std::invalid_argument{"instance already tracked"};
+    }
+    it->second.on_complete = std::move(on_complete);
+    auto result = it->second.promise.get_future();
+    // Weakly referenced, since the function may outlive the monitor.
+    const auto weak = std::weak_ptr<changes>{pimpl->observer};
+    const auto root = &object;
+    observe(object, [weak,root]{
+        if (const auto observer = weak.lock()) {
+            observer->mark(root);
+        }
+    }, *pimpl->observer, object);
+    // It may have finished already, or have nothing that can change.
+    pimpl->observer->mark(root);
+    return result;
+}
+
+auto completion_monitor::untrack(instance& object) -> bool
+{
+    const auto it = pimpl->tracked.find(&object);
+    if (it == pimpl->tracked.end()) {
+        return false;
+    }
+    pimpl->ignore(object);
+    pimpl->tracked.erase(it);
+    return true;
+}
+
+auto completion_monitor::poll() -> std::size_t
+{
+    auto count = std::size_t{};
+    for (auto&& changed: pimpl->observer->take()) {
+        // Found by lookup, since earlier callbacks may have untracked it.
+        const auto it = pimpl->tracked.find(changed);
+        if (it == pimpl->tracked.end()) {
+            continue;
+        }
+        auto& object = *(it->first);
+        const auto results = wait_until(object,
+                                        std::chrono::steady_clock::now());
+        auto& entry = it->second;
+        entry.results.insert(end(entry.results),
+                             begin(results), end(results));
+        if (!is_complete(object)) {
+            continue;
+        }
+        pimpl->ignore(object);
+        auto done = std::move(entry);
+        pimpl->tracked.erase(it);
+        ++count;
+        if (done.on_complete) {
+            done.on_complete(object, done.results);
+        }
+        done.promise.set_value(std::move(done.results));
+    }
+    return count;
+}
+
+auto completion_monitor::descriptor() const noexcept -> reference_descriptor
+{
+    return reference_descriptor(pimpl->observer->event);
+}
+
+auto completion_monitor::size() const noexcept -> std::size_t
+{
+    return pimpl->tracked.size();
+}
+
+}
@@ -0,0 +1,189 @@
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory> // for std::make_shared
+#include <mutex>
+#include <utility> // for std::move
+
+#include "flow/completion_order.hpp"
+#include "flow/utility.hpp"
+
+#include "notifier.hpp"
+
+namespace flow {
+
+namespace {
+
+/// @brief Process or built-in of an instance, that's yet to be waited for.
+struct descendant
+{
+    std::vector<node_name> names;
+    instance *object{};
+};
+
+/// @brief Collects the processes & built-ins of the given instance that
+///   are yet to be waited for.
+auto collect(instance& object, std::vector<node_name>& names,
+             std::vector<descendant>& found) -> void
+{
+    std::visit(detail::overloaded{
+        [&](instance::system& info) {
+            for (auto&& entry: info.children) {
+                names.push_back(entry.first);
+                collect(entry.second, names, found);
+                names.pop_back();
+            }
+        },
+        [&](instance::forked& info) {
+            if (!std::holds_alternative<wait_status>(info.state)) {
+                found.push_back(descendant{names, &object});
+            }
+        },
+        [&](instance::builtin& info) {
+            // One that was never started has nothing to wait for.
+            const auto p = std::get_if<std::future<wait_status>>(&info.state);
+            if (p && p->valid()) {
+                found.push_back(descendant{names, &object});
+            }
+        },
+    }, object.info);
+}
+
+/// @brief Sets the given function to be called whenever the given process
+///   or built-in changes state.
+/// @return Whether it'll be called.
+auto observe(instance& object, const std::function<void()>& function) -> bool
+{
+    if (const auto p = std::get_if<instance::forked>(&object.info)) {
+        if (const auto q = std::get_if<owning_process_id>(&p->state);
+            q && (reference_process_id(*q) != invalid_process_id)) {
+            q->on_change(function);
+            return true;
+        }
+    }
+    else if (const auto p = std::get_if<instance::builtin>(&object.info)) {
+        if (p->finishing) {
+            p->finishing->set(function);
+            return true;
+        }
+    }
+    return false;
+}
+
+auto is_finished(const instance& object) -> bool
+{
+    if (const auto p = std::get_if<instance::forked>(&object.info)) {
+        return std::holds_alternative<wait_status>(p->state);
+    }
+    if (const auto p = std::get_if<instance::builtin>(&object.info)) {
+        return std::holds_alternative<wait_status>(p->state);
+    }
+    return true;
+}
+
+/// @brief Whether anything's changed since last cleared.
+struct change_flag
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool changed{};
+};
+
+}
+
+auto operator<<(std::ostream& os, const descendant_wait_result& value)
+    -> std::ostream&
+{
+    auto prefix = "";
+    for (auto&& name: value.names) {
+        os << prefix << name;
+        prefix = ".";
+    }
+    os << ": " << value.result;
+    return os;
+}
+
+auto wait_any(instance& object) -> std::optional<descendant_wait_result>
+{
+    auto descendants = std::vector<descendant>{};
+    {
+        auto names = std::vector<node_name>{};
+        collect(object, names, descendants);
+    }
+    if (empty(descendants)) {
+        return {};
+    }
+    // Shared since the notifying threads may still be using it as this
+    // returns.
+    const auto flag = std::make_shared<change_flag>();
+    const auto notify = std::function<void()>{[flag]{
+        {
+            const std::lock_guard lock{flag->mutex};
+            flag->changed = true;
+        }
+        flag->cv.notify_all();
+    }};
+    // Those that can't notify are polled instead of waited on.
+    auto polling = false;
+    for (auto&& entry: descendants) {
+        polling = !observe(*entry.object, notify) || polling;
+    }
+    auto result = std::optional<descendant_wait_result>{};
+    for (;;) {
+        {
+            const std::lock_guard lock{flag->mutex};
+            flag->changed = false;
+        }
+        for (auto&& entry: descendants) {
+            auto results = wait_until(*entry.object,
+                                      std::chrono::steady_clock::now());
+            if (!is_finished(*entry.object)) {
+                continue;
+            }
+            // One whose process was never created has no result, just a
+            // status.
+            result = descendant_wait_result{
+                std::move(entry.names),
+                empty(results)
+                    ? wait_result{info_wait_result{
+                        .id = no_process_id,
+                        .status = get_wait_status(*entry.object)
+                    }}
+                    : std::move(results.back())
+            };
+            break;
+        }
+        if (result) {
+            break;
+        }
+        std::unique_lock lock{flag->mutex};
+        if (polling) {
+            flag->cv.wait_for(lock, std::chrono::milliseconds{10}, [&flag]{
+                return flag->changed;
+            });
+        }
+        else {
+            flag->cv.wait(lock, [&flag]{
+                return flag->changed;
+            });
+        }
+    }
+    for (auto&& entry: descendants) {
+        (void) observe(*entry.object, {});
+    }
+    return result;
+}
+
+completion_order::iterator::iterator(instance& object):
+    object{&object}, current{wait_any(object)}
+{
+    // Intentionally empty.
+}
+
+auto completion_order::iterator::operator++() -> iterator&
+{
+    current = wait_any(*object);
+    return *this;
+}
+
+}
@@ -0,0 +1,285 @@
+#include <array>
+#include <atomic>
+#include <cerrno> // for errno
+#include <charconv> // for std::from_chars
+#include <cstdint> // for std::uint64_t
+#include <fstream>
+#include <sstream> // for std::istringstream, std::ostringstream
+#include <string_view>
+#include <utility> // for std::move
+
+#include <fcntl.h> // for ::openat, O_* flags
+#include <sys/stat.h> // for ::mkdir
+#include <unistd.h> // for ::read, ::write, ::rmdir
+
+#include "flow/os_error_code.hpp"
+#include "flow/reference_process_id.hpp"
+
+#include "control_group.hpp"
+
+namespace flow::detail {
+
+namespace {
+
+/// @brief Reads the whole of the named file of the given directory.
+auto read_file(int directory, const char *name) -> std::optional<std::string>
+{
+    const auto fd = owning_descriptor{
+        ::openat(directory, name, O_RDONLY|O_CLOEXEC) // NOLINT(cppcoreguidelines-pro-type-vararg)
+    };
+    if (!fd) {
+        return {};
+    }
+    auto result = std::string{};
+    auto buffer = std::array<char, 4096u>{};
+    for (;;) {
+        const auto n = ::read(int(fd), data(buffer), size(buffer));
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return {};
+        }
+        if (n == 0) {
+            return {std::move(result)};
+        }
+        result.append(data(buffer), std::size_t(n));
+    }
+}
+
+/// @brief Writes the given value to the named file of the given directory.
+/// @return Zero on success, else the error number of why not.
+auto write_file(int directory, const char *name, const std::string& value)
+    -> int
+{
+    const auto fd = owning_descriptor{
+        ::openat(directory, name, O_WRONLY|O_CLOEXEC) // NOLINT(cppcoreguidelines-pro-type-vararg)
+    };
+    if (!fd) {
+        return errno;
+    }
+    if (::write(int(fd), value.data(), size(value)) == -1) {
+        return errno;
+    }
+    return 0;
+}
+
+auto write_limit(const control_group& group, const char *name,
+                 const std::string& value, std::ostream& diags) -> void
+{
+    if (const auto err = write_file(int(group.directory), name, value);
+        err != 0) {
+        diags << "can't set " << name << " of control group ";
+        diags << group.path << ": " << os_error_code(err) << "\n";
+    }
+}
+
+auto to_uint64(std::string_view value) -> std::optional<std::uint64_t>
+{
+    auto result = std::uint64_t{};
+    const auto last = value.data() + size(value);
+    const auto [ptr, ec] = std::from_chars(value.data(), last, result);
+    if (ec != std::errc{}) {
+        return {};
+    }
+    return result;
+}
+
+}
+
+auto controllers_of(const resource_limits& limits) noexcept
+    -> controller_set
+{
+    auto result = controller_set{};
+    if ((limits.cpu_quota.count() > 0) || (limits.cpu_weight > 0u)) {
+        result |= cpu_controller;
+    }
+    if (limits.memory_max > 0u) {
+        result |= memory_controller;
+    }
+    if (limits.io_weight > 0u) {
+        result |= io_controller;
+    }
+    return result;
+}
+
+control_group::control_group(std::filesystem::path p, owning_descriptor d,
+                             std::shared_ptr<const control_group> up)
+    noexcept:
+    path{std::move(p)}, directory{std::move(d)}, parent{std::move(up)}
+{
+    // Intentionally empty.
+}
+
+control_group::~control_group()
+{
+    // Fails if processes remain in it, which there's nothing to do about.
+    (void) ::rmdir(path.c_str());
+}
+
+auto find_own_cgroup() -> std::filesystem::path
+{
+    // The unified hierarchy's line is like "0::/user.slice/session.scope".
+    auto relative = std::optional<std::string>{};
+    {
+        std::ifstream in{"/proc/self/cgroup"};
+        for (std::string line; std::getline(in, line);) {
+            if (line.starts_with("0::/")) {
+                relative = line.substr(4u);
+                break;
+            }
+        }
+    }
+    if (!relative) {
+        return {};
+    }
+    std::ifstream in{"/proc/self/mounts"};
+    for (std::string line; std::getline(in, line);) {
+        auto fields = std::istringstream{line};
+        auto device = std::string{};
+        auto directory = std::string{};
+        auto type = std::string{};
+        if ((fields >> device >> directory >> type) && (type == "cgroup2")) {
+            return std::filesystem::path{directory} / *relative;
+        }
+    }
+    return {};
+}
+
+auto is_root_cgroup(const std::filesystem::path& directory) -> bool
+{
+    // Every group but the root one has a type.
+    auto ec = std::error_code{};
+    return std::filesystem::is_directory(directory, ec) &&
+           !std::filesystem::exists(directory / "cgroup.type", ec);
+}
+
+auto make_cgroup_name() -> std::string
+{
+    static std::atomic<unsigned> counter;
+    std::ostringstream os;
+    os << "flow-" << int(current_process_id()) << "-" << counter++;
+    return os.str();
+}
+
+auto enable_controllers(const std::filesystem::path& directory,
+                        controller_set controllers,
+                        std::ostream& diags) -> controller_set
+{
+    auto result = controller_set{};
+    if (controllers == controller_set{}) {
+        return result;
+    }
+    const auto fd = owning_descriptor{
+        ::open(directory.c_str(), O_PATH|O_DIRECTORY|O_CLOEXEC) // NOLINT(cppcoreguidelines-pro-type-vararg)
+    };
+    if (!fd) {
+        const auto err = errno;
+        diags << "can't open control group " << directory << ": ";
+        diags << os_error_code(err) << "\n";
+        return result;
+    }
+    // One at a time, so one not being available doesn't stop the others.
+    for (const auto& [controller, name]: {
+        std::pair{cpu_controller, "cpu"},
+        std::pair{memory_controller, "memory"},
+        std::pair{io_controller, "io"},
+    }) {
+        if ((controllers & controller) == 0u) {
+            continue;
+        }
+        const auto err = write_file(int(fd), "cgroup.subtree_control",
+                                    std::string{"+"} + name);
+        if (err != 0) {
+            diags << "can't enable " << name << " controller for ";
+            diags << directory << ": " << os_error_code(err) << "\n";
+            continue;
+        }
+        result |= controller;
+    }
+    return result;
+}
+
+auto make_control_group(const std::filesystem::path& path,
+                        const resource_limits& limits,
+                        std::shared_ptr<const control_group> parent,
+                        std::ostream& diags)
+    -> std::shared_ptr<control_group>
+{
+    static constexpr auto mode = 0755;
+    if (::mkdir(path.c_str(), mode) == -1) {
+        const auto err = errno;
+        diags << "can't make control group " << path << ": ";
+        diags << os_error_code(err) << "\n";
+        return {};
+    }
+    auto fd = owning_descriptor{
+        ::open(path.c_str(), O_PATH|O_DIRECTORY|O_CLOEXEC) // NOLINT(cppcoreguidelines-pro-type-vararg)
+    };
+    if (!fd) {
+        const auto err = errno;
+        (void) ::rmdir(path.c_str());
+        diags << "can't open control group " << path << ": ";
+        diags << os_error_code(err) << "\n";
+        return {};
+    }
+    const auto result = std::make_shared<control_group>(path, std::move(fd),
+                                                        std::move(parent));
+    if (limits.cpu_quota.count() > 0) {
+        std::ostringstream os;
+        os << limits.cpu_quota.count() << " " << limits.cpu_period.count();
+        write_limit(*result, "cpu.max", os.str(), diags);
+    }
+    if (limits.cpu_weight > 0u) {
+        write_limit(*result, "cpu.weight",
+                    std::to_string(limits.cpu_weight), diags);
+    }
+    if (limits.memory_max > 0u) {
+        write_limit(*result, "memory.max",
+                    std::to_string(limits.memory_max), diags);
+    }
+    if (limits.io_weight > 0u) {
+        write_limit(*result, "io.weight",
+                    "default " + std::to_string(limits.io_weight), diags);
+    }
+    return result;
+}
+
+auto read_usage(const control_group& group) -> std::optional<cgroup_usage>
+{
+    const auto stat = read_file(int(group.directory), "cpu.stat");
+    if (!stat) {
+        return {};
+    }
+    auto result = cgroup_usage{};
+    auto in = std::istringstream{*stat};
+    auto key = std::string{};
+    auto value = std::chrono::microseconds::rep{};
+    while (in >> key >> value) {
+        using std::chrono::microseconds;
+        if (key == "usage_usec") {
+            result.cpu_time = microseconds{value};
+        }
+        else if (key == "user_usec") {
+            result.user_time = microseconds{value};
+        }
+        else if (key == "system_usec") {
+            result.system_time = microseconds{value};
+        }
+        else if (key == "nr_throttled") {
+            result.throttled_periods = std::uint64_t(value);
+        }
+        else if (key == "throttled_usec") {
+            result.throttled_time = microseconds{value};
+        }
+    }
+    if (const auto s = read_file(int(group.directory), "memory.current")) {
+        result.memory_current = to_uint64(*s);
+    }
+    if (const auto s = read_file(int(group.directory), "memory.peak")) {
+        result.memory_peak = to_uint64(*s);
+    }
+    return result;
+}
+
+}
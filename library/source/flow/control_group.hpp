@@ -0,0 +1,95 @@
+#ifndef control_group_hpp
+#define control_group_hpp
+
+#include <filesystem>
+#include <memory> // for std::shared_ptr
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "flow/cgroup_usage.hpp"
+#include "flow/owning_descriptor.hpp"
+#include "flow/resource_limits.hpp"
+
+namespace flow::detail {
+
+/// @brief Set of cgroup v2 controllers, as a bitmask of the following.
+using controller_set = unsigned;
+
+constexpr auto cpu_controller = controller_set{1u};
+constexpr auto memory_controller = controller_set{2u};
+constexpr auto io_controller = controller_set{4u};
+
+/// @brief Gets the controllers needed to enforce the given limits.
+auto controllers_of(const resource_limits& limits) noexcept
+    -> controller_set;
+
+/// @brief Control group made for the processes of an instance.
+/// @details Its directory is removed when this is destroyed, which it
+///   only can be once the processes in it have terminated. A group made
+///   within another keeps that other one around, so groups are removed
+///   from the bottom up.
+struct control_group
+{
+    control_group(std::filesystem::path path, owning_descriptor directory,
+                  std::shared_ptr<const control_group> parent) noexcept;
+
+    control_group(const control_group& other) = delete;
+
+    ~control_group();
+
+    auto operator=(const control_group& other) -> control_group& = delete;
+
+    std::filesystem::path path;
+
+    /// @brief Descriptor of the group's directory, for creating processes
+    ///   into the group & for reading & writing its interface files.
+    owning_descriptor directory;
+
+    std::shared_ptr<const control_group> parent;
+};
+
+/// @brief Finds the directory of this process's own cgroup v2 control
+///   group.
+/// @return Path of the directory, else an empty path if this process
+///   isn't in a cgroup v2 hierarchy that's mounted.
+auto find_own_cgroup() -> std::filesystem::path;
+
+/// @brief Whether the given directory is that of the root control group
+///   of its cgroup v2 hierarchy.
+/// @note The root group's the only one that can have processes in it &
+///   also have controllers enabled for the groups within it.
+auto is_root_cgroup(const std::filesystem::path& directory) -> bool;
+
+/// @brief Makes a name for a control group that's unique to this process.
+auto make_cgroup_name() -> std::string;
+
+/// @brief Enables the given controllers for the groups within the given
+///   directory.
+/// @note Failures are written to @p diags, but are otherwise ignored.
+/// @return Those of the controllers that are enabled.
+auto enable_controllers(const std::filesystem::path& directory,
+                        controller_set controllers,
+                        std::ostream& diags) -> controller_set;
+
+/// @brief Makes a control group at the given path that enforces the given
+///   limits.
+/// @note Failures to apply limits are written to @p diags, but are
+///   otherwise ignored. Processes in the group are then just not limited
+///   by them.
+/// @return The group, else null if it couldn't be made. In which case why
+///   not is written to @p diags.
+auto make_control_group(const std::filesystem::path& path,
+                        const resource_limits& limits,
+                        std::shared_ptr<const control_group> parent,
+                        std::ostream& diags)
+    -> std::shared_ptr<control_group>;
+
+/// @brief Reads the resource usage accounted to the given group.
+/// @return Usage, else nothing if the group's CPU statistics can't be
+///   read.
+auto read_usage(const control_group& group) -> std::optional<cgroup_usage>;
+
+}
+
+#endif /* control_group_hpp */
@@ -0,0 +1,39 @@
+#ifndef deadline_hpp
+#define deadline_hpp
+
+#include <chrono>
+
+namespace flow::detail {
+
+/// @brief Gets the time the given duration after the given time.
+/// @note This saturates instead of overflowing. So durations too long to
+///   add, like <code>std::chrono::nanoseconds::max()</code>, give the
+///   latest time there is, which is as good as never.
+constexpr auto deadline_after(std::chrono::steady_clock::time_point start,
+                              std::chrono::nanoseconds duration) noexcept
+    -> std::chrono::steady_clock::time_point
+{
+    using time_point = std::chrono::steady_clock::time_point;
+    const auto since_epoch = start.time_since_epoch();
+    if ((duration.count() > 0) &&
+        (since_epoch > time_point::duration::max() - duration)) {
+        return time_point::max();
+    }
+    if ((duration.count() < 0) &&
+        (since_epoch < time_point::duration::min() - duration)) {
+        return time_point::min();
+    }
+    return start + duration;
+}
+
+/// @brief Gets the time the given duration from now.
+/// @see deadline_after.
+inline auto deadline_after(std::chrono::nanoseconds duration) noexcept
+    -> std::chrono::steady_clock::time_point
+{
+    return deadline_after(std::chrono::steady_clock::now(), duration);
+}
+
+}
+
+#endif /* deadline_hpp */
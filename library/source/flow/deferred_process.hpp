@@ -0,0 +1,37 @@
+#ifndef deferred_process_hpp
+#define deferred_process_hpp
+
+#include "flow/owning_descriptor.hpp"
+#include "flow/owning_process_id.hpp"
+#include "flow/reference_process_id.hpp"
+#include "flow/wait_status.hpp"
+
+namespace flow::detail {
+
+/// @brief Creator's side of an <code>owning_process_id</code> for a process
+///   whose creation is deferred.
+/// @note The owner waits for this to either start or cancel the process
+///   before it can wait for the process or be destroyed. So one of those
+///   must eventually be done, once.
+struct deferred_process
+{
+    /// @brief Makes the owning process identifier for the process.
+    /// @note Call this just once.
+    auto make_owner() -> owning_process_id;
+
+    /// @brief Gives the owner the process now that it's been created.
+    /// @note This is thread-safe.
+    auto start(reference_process_id pid, owning_descriptor pidfd = {}) -> void;
+
+    /// @brief Tells the owner the process won't be created, & to consider
+    ///   it to have finished with the given status.
+    /// @note This is thread-safe.
+    auto cancel(wait_status status) -> void;
+
+private:
+    owning_process_id::impl *pimpl{};
+};
+
+}
+
+#endif /* deferred_process_hpp */
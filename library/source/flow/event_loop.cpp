@@ -0,0 +1,214 @@
+#include <array>
+#include <atomic>
+#include <cerrno> // for errno
+#include <condition_variable>
+#include <cstdint> // for std::uint64_t
+#include <future>
+#include <iostream> // for std::cerr
+#include <map>
+#include <memory> // for std::shared_ptr
+#include <mutex>
+#include <system_error>
+#include <thread> // for std::this_thread
+
+#include <unistd.h> // for ::read, ::write
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "flow/owning_descriptor.hpp"
+
+#include "event_loop.hpp"
+
+namespace flow::detail {
+
+namespace {
+
+/// @brief Watch identifier of the loop's own wake-up descriptor.
+constexpr auto wakeup_id = watch_id{0u};
+
+struct event_loop
+{
+    event_loop();
+    ~event_loop() noexcept;
+
+    auto watch(int fd, std::uint32_t events, watch_handler handler)
+        -> watch_id;
+    auto unwatch(watch_id id) -> void;
+
+private:
+    struct entry
+    {
+        int fd{-1};
+        std::shared_ptr<watch_handler> handler;
+    };
+
+    auto run() -> void;
+    auto dispatch(watch_id id, std::uint32_t events) -> void;
+    auto erase(std::map<watch_id, entry>::iterator it) -> void;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    owning_descriptor epoll{::epoll_create1(EPOLL_CLOEXEC)};
+    owning_descriptor wakeup{::eventfd(0u, EFD_CLOEXEC|EFD_NONBLOCK)};
+    std::map<watch_id, entry> entries;
+    watch_id next_id{wakeup_id + 1u};
+
+    /// @brief Identifier of the watch whose handler is being called, if any.
+    watch_id dispatching{wakeup_id};
+
+    std::thread::id loop_thread;
+    std::atomic_bool do_run{true};
+    std::future<void> runner;
+};
+
+event_loop::event_loop()
+{
+    if (!epoll || !wakeup) {
+        throw std::system_error{errno, std::system_category(),
+                                "can't make event loop"};
+    }
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.u64 = wakeup_id;
+    if (::epoll_ctl(int(epoll), EPOLL_CTL_ADD, int(wakeup), &event) == -1) {
+        throw std::system_error{errno, std::system_category(),
+                                "can't watch event loop wake-ups"};
+    }
+    runner = std::async(std::launch::async, &event_loop::run, this);
+}
+
+event_loop::~event_loop() noexcept
+{
+    if (runner.valid()) {
+        do_run = false;
+        const auto one = std::uint64_t{1u};
+        (void) ::write(int(wakeup), &one, sizeof(one));
+        try {
+            runner.get();
+        }
+        catch (...) {
+            std::cerr << "event_loop: runner.get() threw exception\n";
+        }
+    }
+}
+
+auto event_loop::watch(int fd, std::uint32_t events, watch_handler handler)
+    -> watch_id
+{
+    const std::lock_guard lock{mutex};
+    const auto id = next_id++;
+    auto event = epoll_event{};
+    event.events = events;
+    event.data.u64 = id;
+    if (::epoll_ctl(int(epoll), EPOLL_CTL_ADD, fd, &event) == -1) {
+        throw std::system_error{errno, std::system_category(),
+                                "can't watch descriptor"};
+    }
+    entries.emplace(id, entry{
+        fd, std::make_shared<watch_handler>(std::move(handler))
+    });
+    return id;
+}
+
+auto event_loop::erase(std::map<watch_id, entry>::iterator it) -> void
+{
+    (void) ::epoll_ctl(int(epoll), EPOLL_CTL_DEL, it->second.fd, nullptr);
+    entries.erase(it);
+}
+
+auto event_loop::unwatch(watch_id id) -> void
+{
+    std::unique_lock lock{mutex};
+    if (const auto it = entries.find(id); it != entries.end()) {
+        erase(it);
+    }
+    if (std::this_thread::get_id() != loop_thread) {
+        cv.wait(lock, [this,id]{
+            return dispatching != id;
+        });
+    }
+}
+
+auto event_loop::dispatch(watch_id id, std::uint32_t events) -> void
+{
+    auto handler = std::shared_ptr<watch_handler>{};
+    {
+        const std::lock_guard lock{mutex};
+        const auto it = entries.find(id);
+        if (it == entries.end()) {
+            return; // Unwatched since the event.
+        }
+        handler = it->second.handler;
+        dispatching = id;
+    }
+    auto keep = false;
+    try {
+        keep = (*handler)(events);
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "event_loop: handler threw exception: ";
+        std::cerr << ex.what() << "\n";
+    }
+    {
+        const std::lock_guard lock{mutex};
+        dispatching = wakeup_id;
+        if (!keep) {
+            if (const auto it = entries.find(id); it != entries.end()) {
+                erase(it);
+            }
+        }
+    }
+    cv.notify_all();
+}
+
+auto event_loop::run() -> void
+{
+    static constexpr auto max_events = 64u;
+    {
+        const std::lock_guard lock{mutex};
+        loop_thread = std::this_thread::get_id();
+    }
+    std::array<epoll_event, max_events> events{};
+    while (do_run) {
+        const auto n = ::epoll_wait(int(epoll), data(events),
+                                    int(size(events)), -1);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "event_loop: epoll_wait failed: ";
+            std::cerr << std::system_category().message(errno) << "\n";
+            break;
+        }
+        for (auto i = 0; i < n; ++i) {
+            const auto& event = events[std::size_t(i)];
+            if (event.data.u64 == wakeup_id) {
+                auto count = std::uint64_t{};
+                (void) ::read(int(wakeup), &count, sizeof(count));
+                continue;
+            }
+            dispatch(event.data.u64, event.events);
+        }
+    }
+}
+
+auto the_event_loop() -> event_loop&
+{
+    static event_loop singleton;
+    return singleton;
+}
+
+}
+
+auto watch(int fd, std::uint32_t events, watch_handler handler) -> watch_id
+{
+    return the_event_loop().watch(fd, events, std::move(handler));
+}
+
+auto unwatch(watch_id id) -> void
+{
+    the_event_loop().unwatch(id);
+}
+
+}
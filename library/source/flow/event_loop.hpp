@@ -0,0 +1,35 @@
+#ifndef event_loop_hpp
+#define event_loop_hpp
+
+#include <cstdint> // for std::uint32_t, std::uint64_t
+#include <functional>
+
+namespace flow::detail {
+
+/// @brief Identifier of a watch of a descriptor.
+/// @see watch, unwatch.
+using watch_id = std::uint64_t;
+
+/// @brief Handler of events on a watched descriptor.
+/// @param[in] events <code>epoll</code> events that occurred.
+/// @return Whether to keep watching the descriptor.
+using watch_handler = std::function<bool(std::uint32_t events)>;
+
+/// @brief Watches the given descriptor for the given <code>epoll</code>
+///   events, calling the given handler whenever any occur.
+/// @details Watches are served by a single event loop thread, started on
+///   first use. So handlers must not block for long.
+/// @note The descriptor must stay open for as long as it's watched.
+/// @note This is thread-safe.
+/// @throws std::system_error if the descriptor can't be watched.
+auto watch(int fd, std::uint32_t events, watch_handler handler) -> watch_id;
+
+/// @brief Stops watching for what the identified watch was watching for.
+/// @note Once this returns, its handler isn't called again. Unless this is
+///   being called from its handler, in which case that call finishes.
+/// @note This is thread-safe, including from handlers.
+auto unwatch(watch_id id) -> void;
+
+}
+
+#endif /* event_loop_hpp */
@@ -2,6 +2,30 @@
 
 namespace flow {
 
+auto operator<<(std::ostream& os, start_policy value) -> std::ostream&
+{
+    os << to_cstring(value);
+    return os;
+}
+
+auto operator<<(std::ostream& os, restart_policy value) -> std::ostream&
+{
+    os << to_cstring(value);
+    return os;
+}
+
+auto operator<<(std::ostream& os, const restart_limits& value)
+    -> std::ostream&
+{
+    os << "restart_limits{";
+    os << ".initial_backoff=" << value.initial_backoff.count() << "ms";
+    os << ",.max_backoff=" << value.max_backoff.count() << "ms";
+    os << ",.max_restarts=" << value.max_restarts;
+    os << ",.window=" << value.window.count() << "ms";
+    os << "}";
+    return os;
+}
+
 auto operator<<(std::ostream& os, const executable& value)
     -> std::ostream&
 {
@@ -15,6 +39,22 @@ auto operator<<(std::ostream& os, const executable& value)
     }
     os << "}";
     os << ",.working_directory=" << value.working_directory;
+    if (value.start != start_policy::eager) {
+        os << ",.start=" << value.start;
+    }
+    if (value.restart != restart_policy::never) {
+        os << ",.restart=" << value.restart;
+        os << ",.limits=" << value.limits;
+    }
+    if (value.resources != resource_limits{}) {
+        os << ",.resources=" << value.resources;
+    }
+    if (value.placement != placement_policy{}) {
+        os << ",.placement=" << value.placement;
+    }
+    if (value.scheduling != scheduling_policy{}) {
+        os << ",.scheduling=" << value.scheduling;
+    }
     os << "}";
     return os;
 }
@@ -0,0 +1,184 @@
+#include <array>
+#include <cerrno> // for errno
+#include <cstdint> // for std::uint32_t
+#include <map>
+#include <memory> // for std::make_shared
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility> // for std::pair
+
+#include <fcntl.h> // for ::open
+#include <unistd.h> // for ::read
+
+#include <sys/inotify.h>
+
+#include "flow/reference_process_id.hpp"
+
+#include "executable_cache.hpp"
+
+namespace flow::detail {
+
+namespace {
+
+/// @brief Directory changes that may change what a search finds.
+constexpr auto watch_mask = std::uint32_t{
+    IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO|IN_ATTRIB|
+    IN_DELETE_SELF|IN_MOVE_SELF
+};
+
+struct executable_cache
+{
+    using key_type = std::pair<std::string, std::string>;
+
+    auto find(const std::filesystem::path& file, const env_value& path)
+        -> std::optional<resolved_executable>;
+
+private:
+    /// @brief Makes this usable by the current process.
+    /// @note A forked copy of the process that made the notifier shares its
+    ///   events, so it needs its own.
+    auto update_owner() -> void;
+
+    /// @brief Clears the cache if any watched directory has changed.
+    auto update_entries() -> void;
+
+    /// @brief Watches the given directory for changes.
+    auto watch(const std::filesystem::path& dir) -> void;
+
+    auto search(const std::filesystem::path& file, const env_value& path,
+                bool& cacheable) -> std::optional<resolved_executable>;
+
+    std::mutex mutex;
+    reference_process_id owner{invalid_process_id};
+    owning_descriptor notifier;
+    std::set<std::filesystem::path> watched;
+    std::map<key_type, resolved_executable> entries;
+};
+
+auto executable_cache::update_owner() -> void
+{
+    if (owner == current_process_id()) {
+        return;
+    }
+    entries.clear();
+    watched.clear();
+    notifier = owning_descriptor{::inotify_init1(IN_NONBLOCK|IN_CLOEXEC)};
+    owner = current_process_id();
+}
+
+auto executable_cache::update_entries() -> void
+{
+    if (!notifier) {
+        return;
+    }
+    alignas(inotify_event) std::array<char, 4096u> buffer{};
+    auto changed = false;
+    for (;;) {
+        const auto n = ::read(int(notifier), data(buffer), size(buffer));
+        if (n > 0) {
+            changed = true;
+            continue;
+        }
+        if ((n == -1) && (errno == EINTR)) {
+            continue;
+        }
+        break;
+    }
+    if (changed) {
+        // Watches of removed directories are gone, so rewatch them all.
+        entries.clear();
+        watched.clear();
+    }
+}
+
+auto executable_cache::watch(const std::filesystem::path& dir) -> void
+{
+    if (!notifier || watched.contains(dir)) {
+        return;
+    }
+    if (::inotify_add_watch(int(notifier), dir.c_str(), watch_mask) != -1) {
+        watched.insert(dir);
+    }
+}
+
+auto executable_cache::search(const std::filesystem::path& file,
+                              const env_value& path,
+                              bool& cacheable)
+    -> std::optional<resolved_executable>
+{
+    static constexpr auto delimiter = ':';
+    cacheable = bool(notifier);
+    auto last = std::size_t{};
+    for (;;) {
+        const auto next = path.get().find(delimiter, last);
+        const auto dir = std::filesystem::path{
+            path.get().substr(last, (next == std::string::npos)
+                              ? std::string::npos: next - last)
+        };
+        if (!dir.empty()) {
+            const auto absolute = dir.is_absolute();
+            if (absolute) {
+                // Watch before looking, so no change goes unnoticed.
+                watch(dir);
+            }
+            else {
+                // What's found here depends on the working directory.
+                cacheable = false;
+            }
+            const auto full_path = dir / file;
+            auto fd = owning_descriptor{
+                ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
+                       full_path.c_str(), O_PATH|O_CLOEXEC)
+            };
+            if (fd) {
+                auto result = resolved_executable{full_path, {}};
+                if (absolute) {
+                    result.descriptor =
+                        std::make_shared<const owning_descriptor>(
+                            std::move(fd));
+                }
+                return result;
+            }
+        }
+        if (next == std::string::npos) {
+            return {};
+        }
+        last = next + 1u;
+    }
+}
+
+auto executable_cache::find(const std::filesystem::path& file,
+                            const env_value& path)
+    -> std::optional<resolved_executable>
+{
+    const std::lock_guard lock{mutex};
+    update_owner();
+    update_entries();
+    auto key = key_type{file.native(), path.get()};
+    if (const auto it = entries.find(key); it != entries.end()) {
+        return it->second;
+    }
+    auto cacheable = false;
+    auto result = search(file, path, cacheable);
+    if (result && cacheable) {
+        entries.emplace(std::move(key), *result);
+    }
+    return result;
+}
+
+auto the_cache() -> executable_cache&
+{
+    static executable_cache singleton;
+    return singleton;
+}
+
+}
+
+auto find_executable(const std::filesystem::path& file, const env_value& path)
+    -> std::optional<resolved_executable>
+{
+    return the_cache().find(file, path);
+}
+
+}
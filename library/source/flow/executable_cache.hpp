@@ -0,0 +1,40 @@
+#ifndef executable_cache_hpp
+#define executable_cache_hpp
+
+#include <filesystem>
+#include <memory> // for std::shared_ptr
+#include <optional>
+
+#include "flow/env_value.hpp"
+#include "flow/owning_descriptor.hpp"
+
+namespace flow::detail {
+
+/// @brief Executable file found by <code>find_executable</code>.
+struct resolved_executable
+{
+    /// @brief Path of the file.
+    std::filesystem::path path;
+
+    /// @brief Descriptor of the file opened with <code>O_PATH</code>, for
+    ///   executing it via <code>fexecve</code>. Null if the file wasn't
+    ///   found through an absolute directory.
+    std::shared_ptr<const owning_descriptor> descriptor;
+};
+
+/// @brief Finds the given file in the directories of the given
+///   <code>PATH</code> environment variable value.
+/// @details Results found through absolute directories are cached per
+///   file & <code>PATH</code> value. The cache is cleared whenever any
+///   directory a cached result was searched for through has an entry
+///   created, removed, renamed, or its attributes changed, as reported by
+///   <code>inotify</code>. Without <code>inotify</code>, nothing's cached.
+/// @note Directories that don't exist when searched aren't watched, so
+///   creating them doesn't clear the cache.
+/// @note This is thread-safe.
+auto find_executable(const std::filesystem::path& file, const env_value& path)
+    -> std::optional<resolved_executable>;
+
+}
+
+#endif /* executable_cache_hpp */
@@ -4,8 +4,34 @@
 #include "flow/node.hpp"
 #include "flow/utility.hpp"
 
+#include "control_group.hpp"
+
 namespace flow {
 
+namespace {
+
+auto write(std::ostream& os, const instance::builtin& value) -> void
+{
+    if (const auto p = std::get_if<wait_status>(&value.state)) {
+        os << *p;
+        return;
+    }
+    os << "running";
+}
+
+auto get_cgroup(const instance& object) -> const detail::control_group*
+{
+    if (const auto p = std::get_if<instance::forked>(&object.info)) {
+        return p->cgroup.get();
+    }
+    if (const auto p = std::get_if<instance::system>(&object.info)) {
+        return p->cgroup.get();
+    }
+    return nullptr;
+}
+
+}
+
 auto operator<<(std::ostream& os, const instance& value) -> std::ostream&
 {
     os << "instance{";
@@ -33,6 +59,13 @@ auto operator<<(std::ostream& os, const instance& value) -> std::ostream&
     }
     else if (const auto p = std::get_if<instance::forked>(&value.info)) {
         os << ",.state=" << p->state;
+        if (p->restarts > 0u) {
+            os << ",.restarts=" << p->restarts;
+        }
+    }
+    else if (const auto p = std::get_if<instance::builtin>(&value.info)) {
+        os << ",.state=";
+        write(os, *p);
     }
     os << "}";
     return os;
@@ -76,6 +109,13 @@ auto pretty_print(std::ostream& os, const instance& value) -> void
     }
     else if (const auto p = std::get_if<instance::forked>(&value.info)) {
         os << "  .state=" << p->state;
+        if (p->restarts > 0u) {
+            os << ",\n  .restarts=" << p->restarts;
+        }
+    }
+    else if (const auto p = std::get_if<instance::builtin>(&value.info)) {
+        os << "  .state=";
+        write(os, *p);
     }
     os << "}\n";
 }
@@ -139,6 +179,49 @@ auto total_channels(const instance& object) -> std::size_t
     return result;
 }
 
+auto total_usage(const instance& object) -> process_usage
+{
+    if (const auto p = std::get_if<instance::forked>(&object.info)) {
+        return p->usage;
+    }
+    auto result = process_usage{};
+    if (const auto p = std::get_if<instance::system>(&object.info)) {
+        for (auto&& child: p->children) {
+            result += total_usage(child.second);
+        }
+    }
+    return result;
+}
+
+auto set_deadline(instance& object,
+                  std::chrono::steady_clock::time_point deadline,
+                  std::chrono::nanoseconds grace) -> void
+{
+    if (const auto p = std::get_if<instance::forked>(&object.info)) {
+        if (const auto q = std::get_if<owning_process_id>(&p->state)) {
+            q->set_deadline(deadline, grace);
+        }
+        return;
+    }
+    if (const auto p = std::get_if<instance::system>(&object.info)) {
+        for (auto&& entry: p->children) {
+            set_deadline(entry.second, deadline, grace);
+        }
+    }
+}
+
+auto get_cgroup_path(const instance& object) -> std::filesystem::path
+{
+    const auto group = get_cgroup(object);
+    return group? group->path: std::filesystem::path{};
+}
+
+auto get_cgroup_usage(const instance& object) -> std::optional<cgroup_usage>
+{
+    const auto group = get_cgroup(object);
+    return group? detail::read_usage(*group): std::nullopt;
+}
+
 auto get_wait_status(const instance& object) -> wait_status
 {
     if (const auto q = std::get_if<instance::forked>(&object.info)) {
@@ -146,6 +229,11 @@ auto get_wait_status(const instance& object) -> wait_status
             return *r;
         }
     }
+    if (const auto q = std::get_if<instance::builtin>(&object.info)) {
+        if (const auto r = std::get_if<wait_status>(&(q->state))) {
+            return *r;
+        }
+    }
     return {wait_unknown_status{}};
 }
 
@@ -0,0 +1,257 @@
+#include <algorithm> // for std::any_of, std::max
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream> // for std::cerr
+#include <mutex>
+#include <optional>
+#include <sstream> // for std::ostringstream
+#include <utility> // for std::exchange
+#include <vector>
+
+#include "flow/instance_pool.hpp"
+#include "flow/utility.hpp"
+
+#include "deadline.hpp"
+
+namespace flow {
+
+namespace {
+
+/// @brief Gets the given options without their deadline.
+auto without_deadline(instantiate_options opts) -> instantiate_options
+{
+    opts.deadline = {};
+    return opts;
+}
+
+/// @brief Whether any of the processes or built-ins of the given instance
+///   are known to have finished.
+auto has_finished(const instance& object) -> bool
+{
+    return std::visit(detail::overloaded{
+        [](const instance::system& info) {
+            return std::any_of(begin(info.children), end(info.children),
+                               [](const auto& entry){
+                return has_finished(entry.second);
+            });
+        },
+        [](const instance::forked& info) {
+            const auto p = std::get_if<owning_process_id>(&info.state);
+            if (!p || (reference_process_id(*p) == invalid_process_id)) {
+                return true;
+            }
+            // A process yet to start on data has no identifier nor exit
+            // status yet.
+            const auto status = p->status();
+            return std::holds_alternative<wait_exit_status>(status) ||
+                   std::holds_alternative<wait_signaled_status>(status);
+        },
+        [](const instance::builtin& info) {
+            const auto p = std::get_if<std::future<wait_status>>(&info.state);
+            return !p || !p->valid() ||
+                   (p->wait_for(std::chrono::seconds{0}) ==
+                    std::future_status::ready);
+        },
+    }, object.info);
+}
+
+}
+
+struct instance_pool::impl
+{
+    impl(const node& node, std::size_t capacity_,
+         const instantiate_options& opts);
+    ~impl() noexcept;
+
+    /// @brief Instantiates the plan, recording how that went.
+    /// @throws Whatever <code>instantiate</code> throws.
+    auto spawn() -> instance;
+
+    /// @brief Keeps the pool filled & destroys recycled instances until
+    ///   stopped.
+    auto refill() -> void;
+
+    /// @brief Checks out the given instance, starting its deadline.
+    auto check_out(instance object) const -> instance;
+
+    /// @brief Compiled without the deadline, which is only for checked
+    ///   out instances.
+    const plan compiled;
+    const std::size_t capacity;
+    const std::chrono::nanoseconds deadline;
+    const std::chrono::nanoseconds kill_grace;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<instance> ready;
+    std::vector<instance> recycled;
+    instance_pool_metrics metrics;
+
+    /// @brief Whether refilling is paused after a failed instantiation,
+    ///   until the next checkout.
+    bool paused{};
+    bool stopping{};
+
+    std::future<void> refiller;
+};
+
+instance_pool::impl::impl(const node& node, std::size_t capacity_,
+                          const instantiate_options& opts):
+    compiled{compile(node, without_deadline(opts))},
+    capacity{capacity_},
+    deadline{opts.deadline},
+    kill_grace{opts.kill_grace},
+    refiller{std::async(std::launch::async, &impl::refill, this)}
+{
+    // Intentionally empty.
+}
+
+instance_pool::impl::~impl() noexcept
+{
+    {
+        const std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    cv.notify_all();
+    try {
+        refiller.get();
+    }
+    catch (...) {
+        std::cerr << "instance_pool: refiller.get() threw exception\n";
+    }
+}
+
+auto instance_pool::impl::spawn() -> instance
+{
+    using clock = std::chrono::steady_clock;
+    std::ostringstream diags;
+    const auto start = clock::now();
+    auto result = instance{};
+    try {
+        result = instantiate(compiled, diags);
+    }
+    catch (...) {
+        const std::lock_guard lock{mutex};
+        ++metrics.failures;
+        throw;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - start);
+    const std::lock_guard lock{mutex};
+    ++metrics.spawns;
+    metrics.total_spawn_time += elapsed;
+    metrics.max_spawn_time = std::max(metrics.max_spawn_time, elapsed);
+    return result;
+}
+
+auto instance_pool::impl::check_out(instance object) const -> instance
+{
+    if (deadline.count() > 0) {
+        set_deadline(object, detail::deadline_after(deadline), kill_grace);
+    }
+    return object;
+}
+
+auto instance_pool::impl::refill() -> void
+{
+    std::unique_lock lock{mutex};
+    for (;;) {
+        cv.wait(lock, [this]{
+            return stopping || !empty(recycled) ||
+                   (!paused && (size(ready) < capacity));
+        });
+        if (stopping) {
+            break;
+        }
+        if (!empty(recycled)) {
+            // Destroy them unlocked, since that waits for their processes.
+            auto objects = std::exchange(recycled, {});
+            lock.unlock();
+            objects.clear();
+            lock.lock();
+            continue;
+        }
+        lock.unlock();
+        auto object = std::optional<instance>{};
+        try {
+            object = spawn();
+        }
+        catch (...) {
+            // Counted as a failure by spawn.
+        }
+        lock.lock();
+        if (object) {
+            ready.push_back(std::move(*object));
+        }
+        else {
+            paused = true;
+        }
+    }
+}
+
+instance_pool::instance_pool(const node& node, std::size_t capacity,
+                             const instantiate_options& opts):
+    pimpl{std::make_unique<impl>(node, capacity, opts)}
+{
+    // Intentionally empty.
+}
+
+instance_pool::instance_pool(instance_pool&& other) noexcept = default;
+
+instance_pool::~instance_pool() = default;
+
+auto instance_pool::operator=(instance_pool&& other) noexcept
+    -> instance_pool& = default;
+
+auto instance_pool::checkout() -> instance
+{
+    auto& impl = *pimpl;
+    {
+        const std::lock_guard lock{impl.mutex};
+        impl.paused = false;
+        while (!empty(impl.ready)) {
+            auto object = std::move(impl.ready.front());
+            impl.ready.pop_front();
+            if (!has_finished(object)) {
+                ++impl.metrics.hits;
+                impl.cv.notify_all();
+                return impl.check_out(std::move(object));
+            }
+            ++impl.metrics.expired;
+            impl.recycled.push_back(std::move(object));
+        }
+        ++impl.metrics.misses;
+    }
+    impl.cv.notify_all();
+    return impl.check_out(impl.spawn());
+}
+
+auto instance_pool::recycle(instance object) -> void
+{
+    auto& impl = *pimpl;
+    {
+        const std::lock_guard lock{impl.mutex};
+        impl.recycled.push_back(std::move(object));
+    }
+    impl.cv.notify_all();
+}
+
+auto instance_pool::capacity() const noexcept -> std::size_t
+{
+    return pimpl->capacity;
+}
+
+auto instance_pool::ready() const -> std::size_t
+{
+    const std::lock_guard lock{pimpl->mutex};
+    return size(pimpl->ready);
+}
+
+auto instance_pool::metrics() const -> instance_pool_metrics
+{
+    const std::lock_guard lock{pimpl->mutex};
+    return pimpl->metrics;
+}
+
+}
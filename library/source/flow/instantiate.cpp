@@ -1,20 +1,49 @@
-#include <concepts> // for std::convertible_to
+#include <algorithm> // for std::any_of, std::none_of, std::sort
+#include <atomic>
+#include <charconv> // for std::to_chars
+#include <chrono>
 #include <csignal>
 #include <cstdlib> // for std::exit, EXIT_FAILURE
 #include <cstring> // for std::strcmp
-#include <iomanip> // for std::setfill
+#include <future>
+#include <iomanip> // for std::setw
+#include <initializer_list>
+#include <iterator> // for std::back_inserter
+#include <list>
+#include <map>
+#include <memory> // for std::make_unique, std::make_shared, std::shared_ptr
+#include <mutex>
+#include <set>
 #include <sstream> // for std::ostringstream
+#include <utility> // for std::exchange
 
-#include <fcntl.h> // for ::open
+#include <fcntl.h> // for ::open, ::fcntl
 #include <pthread.h>
+#include <sched.h> // for ::sched_getaffinity, CPU_* macros
 #include <unistd.h> // for getpid, setpgid
 
+#include <sys/epoll.h> // for EPOLLIN
+#include <sys/ioctl.h> // for ::ioctl, FIONREAD
+
+#include <linux/ioprio.h> // for IOPRIO_PRIO_VALUE, IOPRIO_CLASS_*
+#include <linux/mempolicy.h> // for MPOL_* modes
+
 #include "ext/expected.hpp"
 
 #include "flow/instantiate.hpp"
 #include "flow/utility.hpp"
 
-#include "pipe_registry.hpp"
+#include "arg_block.hpp"
+#include "channel_recipe.hpp"
+#include "control_group.hpp"
+#include "deadline.hpp"
+#include "deferred_process.hpp"
+#include "event_loop.hpp"
+#include "executable_cache.hpp"
+#include "notifier.hpp"
+#include "process_supervisor.hpp"
+#include "spawn.hpp"
+#include "zygote.hpp"
 
 namespace flow {
 
@@ -39,62 +68,37 @@ auto exit(int exit_code) -> void
     ::_exit(exit_code); // NOLINT(concurrency-mt-unsafe)
 }
 
-auto dup2(int fd, reference_descriptor from) -> bool
-{
-    return ::dup2(fd, int(from)) != -1;
-}
-
-auto close(reference_descriptor d) -> bool
-{
-    return ::close(int(d)) != -1;
-}
-
-auto close(const std::set<port_id>& ports) -> void
-{
-    for (auto&& port: ports) {
-        if (std::holds_alternative<reference_descriptor>(port)) {
-            close(std::get<reference_descriptor>(port));
-        }
-    }
-}
-
 constexpr auto pid_buffer_size = 32u;
 using pid_buffer = std::array<char, pid_buffer_size>;
 
-auto getpid_as_char_array() -> pid_buffer
+/// @brief Argument that's substituted with the child's process ID.
+constexpr auto pid_request = "$$";
+
+/// @note This is async-signal-safe for calling from a forked child.
+auto getpid_as_char_array() noexcept -> pid_buffer
 {
     pid_buffer buffer{};
-    std::snprintf( // NOLINT(cppcoreguidelines-pro-type-vararg)
-                  data(buffer), size(buffer) - 1u, "%d", ::getpid());
+    std::to_chars(data(buffer), data(buffer) + size(buffer) - 1u,
+                  ::getpid());
     return buffer;
 }
 
-auto make_substitutions(std::vector<char*>& argv)
-    -> void
+auto has_substitutions(std::span<char * const> argv) -> bool
 {
-    static constexpr const auto pid_request = "$$";
-    for (auto&& arg: argv) {
-        if (arg && std::strcmp(arg, pid_request) == 0) {
-            static auto pid_argv = getpid_as_char_array();
-            arg = std::data(pid_argv);
-        }
-    }
+    return std::any_of(begin(argv), end(argv), [](const char *arg){
+        return arg && (std::strcmp(arg, pid_request) == 0);
+    });
 }
 
-auto find_parent(const instance& root, const instance& child)
-    -> const instance*
+/// @note This is async-signal-safe for calling from a forked child.
+auto make_substitutions(std::vector<char*>& argv, pid_buffer& pid_argv)
+    noexcept -> void
 {
-    if (const auto p = std::get_if<instance::system>(&root.info)) {
-        for (auto&& entry: p->children) {
-            if (&entry.second == &child) {
-                return &root;
-            }
-            if (const auto found = find_parent(entry.second, child)) {
-                return found;
-            }
+    for (auto&& arg: argv) {
+        if (arg && std::strcmp(arg, pid_request) == 0) {
+            arg = std::data(pid_argv);
         }
     }
-    return nullptr;
 }
 
 template <class T>
@@ -109,104 +113,6 @@ auto fully_deref(T&& chan_p)
     return chan_p;
 }
 
-template <std::convertible_to<channel> T>
-auto is_channel_for(const std::span<const channel>& channels,
-                    const T *key) -> bool
-{
-    for (auto&& channel: channels) {
-        auto chan_p = &channel;
-        using ref_type = decltype(std::get_if<reference_channel>(chan_p));
-        auto ref_p = static_cast<ref_type>(nullptr);
-        while ((ref_p = std::get_if<reference_channel>(chan_p)) != nullptr) {
-            if constexpr (std::is_same_v<T, reference_channel>) {
-                if (ref_p == key) {
-                    return true;
-                }
-            }
-            chan_p = ref_p->other;
-        }
-        if constexpr (!std::is_same_v<T, reference_channel>) {
-            if (const auto q = std::get_if<T>(chan_p)) {
-                if (q == key) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-
-auto close(pipe_channel& p, pipe_channel::io side, const node_name& name,
-           const link& c, std::ostream& diags) -> void
-{
-    diags << name << " " << c << " " << p;
-    diags << ", close  " << side << "-side\n";
-    if (!p.close(side, diags)) { // close unused end
-        diags.flush();
-        exit(exit_failure_code);
-    }
-}
-
-auto dup2(pipe_channel& p, pipe_channel::io side, reference_descriptor id,
-          const node_name& name, const link& c, std::ostream& diags) -> void
-{
-    diags << name << " " << c << " " << p;
-    diags << ", dup " << side << "-side to ";
-    diags << id << "\n";
-    if (!p.dup(side, id, diags)) {
-        diags.flush();
-        exit(exit_failure_code);
-    }
-}
-
-auto dup2(pipe_channel& pc,
-          pipe_channel::io side,
-          const std::set<port_id>& ports,
-          const node_name& name,
-          const link& conn,
-          std::ostream& diags) -> void
-{
-    for (auto&& port: ports) {
-        if (std::holds_alternative<reference_descriptor>(port)) {
-            dup2(pc, side, std::get<reference_descriptor>(port),
-                 name, conn, diags);
-        }
-    }
-}
-
-auto setup(const node_name& name,
-           const link& conn,
-           pipe_channel& p,
-           std::ostream& diags) -> void
-{
-    using io = pipe_channel::io;
-    const auto ends = make_endpoints<node_endpoint>(conn);
-    if (!ends[0] && !ends[1]) {
-        diags << "link has no node_endpoint: " << conn << "\n";
-        return;
-    }
-    if ((!ends[0] || (ends[0]->address != name)) &&
-        (!ends[1] || (ends[1]->address != name))) {
-        diags << name << " (unaffiliation) " << conn;
-        diags << " " << p << ", close in & out setup\n";
-        close(p, io::read, name, conn, diags);
-        close(p, io::write, name, conn, diags);
-        return;
-    }
-    if (ends[0]) { // src
-        if (ends[0]->address == name) {
-            close(p, io::read, name, conn, diags);
-            dup2(p, io::write, ends[0]->ports, name, conn, diags);
-        }
-    }
-    if (ends[1]) { // dst
-        if (ends[1]->address == name) {
-            close(p, io::write, name, conn, diags);
-            dup2(p, io::read, ends[1]->ports, name, conn, diags);
-        }
-    }
-}
-
 auto to_open_flags(io_type direction) -> expected<int, std::string>
 {
     switch (direction) {
@@ -218,74 +124,6 @@ auto to_open_flags(io_type direction) -> expected<int, std::string>
     return unexpected<std::string>{"unrecognized io_type value"};
 }
 
-auto setup(const node_name& name,
-           const link& conn,
-           file_channel& chan,
-           std::ostream& diags) -> void
-{
-    const auto sys_ends = make_endpoints<node_endpoint>(conn);
-    assert(sys_ends[0] || sys_ends[1]);
-    const auto op = [&sys_ends,&name](){
-        for (auto&& sys_end: sys_ends) {
-            if (sys_end && sys_end->address == name) {
-                return sys_end;
-            }
-        }
-        return static_cast<const node_endpoint*>(nullptr);
-    }();
-    if (op) {
-        const auto flags = to_open_flags(chan.io);
-        if (!flags) {
-            if (!empty(flags.error())) {
-                diags << name << " " << conn;
-                diags << ", can't get needed open flags: ";
-                diags << flags.error();
-                diags << "\n";
-                diags.flush();
-                exit(exit_failure_code);
-            }
-            close(op->ports);
-            return;
-        }
-        const auto mode = 0600;
-        const auto fd = ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
-                               chan.path.c_str(), *flags, mode);
-        if (fd == -1) {
-            static constexpr auto mode_width = 5;
-            diags << name << " " << conn;
-            diags << ", open file " << chan.path << " with mode ";
-            diags << std::oct << std::setfill('0') << std::setw(mode_width);
-            diags << *flags;
-            diags << " failed: " << os_error_code(errno) << "\n";
-            exit(exit_failure_code);
-        }
-        for (auto&& port: op->ports) {
-            if (std::holds_alternative<reference_descriptor>(port)) {
-                if (!dup2(fd, std::get<reference_descriptor>(port))) {
-                    diags << name << " " << conn;
-                    diags << ", dup2(" << fd << "," << port << ") failed: ";
-                    diags << os_error_code(errno) << "\n";
-                    exit(exit_failure_code);
-                }
-            }
-        }
-    }
-}
-
-[[noreturn]]
-auto exec_child(const std::filesystem::path& path,
-                char * const *argv,
-                char * const *envp,
-                std::ostream& diags) -> void
-{
-    diags.flush();
-    ::execve(path.c_str(), argv, envp);
-    const auto ec = os_error_code(errno);
-    diags << "execve of " << path << " failed: " << ec << "\n";
-    diags.flush();
-    exit(exit_failure_code);
-}
-
 auto confirm_closed(const node_name& name,
                     const port_map& ports,
                     const std::span<const link>& links,
@@ -327,6 +165,58 @@ auto throw_has_no_filename(const std::filesystem::path& path,
     throw invalid_executable{os.str()};
 }
 
+/// @brief Confirms the given placement can be applied.
+/// @throws invalid_executable if it has CPUs or NUMA nodes that are out of
+///   range, or a memory policy that needs NUMA nodes but has none.
+auto confirm_placeable(const placement_policy& placement,
+                       const std::string& prefix = {}) -> void
+{
+    std::ostringstream os;
+    if (!empty(placement.cpus) && (*placement.cpus.rbegin() >= CPU_SETSIZE)) {
+        os << prefix << "placement CPU " << *placement.cpus.rbegin();
+        os << " is not less than " << CPU_SETSIZE;
+    }
+    else if (!empty(placement.numa_nodes) &&
+             (*placement.numa_nodes.rbegin() >=
+              placement_policy::max_numa_nodes)) {
+        os << prefix << "placement NUMA node ";
+        os << *placement.numa_nodes.rbegin() << " is not less than ";
+        os << placement_policy::max_numa_nodes;
+    }
+    else if (empty(placement.numa_nodes) &&
+             ((placement.memory == memory_policy::bind) ||
+              (placement.memory == memory_policy::interleave))) {
+        os << prefix << "placement memory policy " << placement.memory;
+        os << " has no NUMA nodes";
+    }
+    if (const auto msg = os.str(); !empty(msg)) {
+        throw invalid_executable{msg};
+    }
+}
+
+/// @brief Confirms the given scheduling attributes can be applied.
+/// @throws invalid_executable if its nice value or I/O priority level is
+///   out of range.
+auto confirm_schedulable(const scheduling_policy& scheduling,
+                         const std::string& prefix = {}) -> void
+{
+    std::ostringstream os;
+    if (scheduling.nice &&
+        ((*scheduling.nice < scheduling_policy::min_nice) ||
+         (*scheduling.nice > scheduling_policy::max_nice))) {
+        os << prefix << "scheduling nice value " << *scheduling.nice;
+        os << " is not from " << scheduling_policy::min_nice;
+        os << " to " << scheduling_policy::max_nice;
+    }
+    else if (scheduling.io_level > scheduling_policy::max_io_level) {
+        os << prefix << "scheduling I/O level " << scheduling.io_level;
+        os << " is greater than " << scheduling_policy::max_io_level;
+    }
+    if (const auto msg = os.str(); !empty(msg)) {
+        throw invalid_executable{msg};
+    }
+}
+
 auto make_child(instance& parent,
                 const node_name& name,
                 const node& node,
@@ -347,7 +237,23 @@ auto make_child(const node_name& name,
         os << ": executable file path ";
         throw_has_no_filename(implementation.file, os.str());
     }
-    return instance{instance::forked{ext::temporary_fstream(), {}}};
+    std::ostringstream os;
+    os << "cannot instantiate " << name << ": ";
+    confirm_placeable(implementation.placement, os.str());
+    confirm_schedulable(implementation.scheduling, os.str());
+    return instance{instance::forked{ext::temporary_fstream(), {}, {}, {}, {}}};
+}
+
+auto make_child(const node_name& name,
+                const port_map& interface,
+                const builtin&,
+                const std::span<const link>& parent_links,
+                const port_map& parent_ports) -> instance
+{
+    confirm_closed(name, interface, parent_links, parent_ports);
+    return instance{instance::builtin{
+        std::make_unique<ext::fstream>(ext::temporary_fstream()), {}, {}
+    }};
 }
 
 auto make_child(instance& parent,
@@ -393,198 +299,544 @@ auto make_child(instance& parent,
         [&](const system& implementation) {
             return make_child(parent, name, node.interface, implementation,
                               parent_links, parent_ports);
+        },
+        [&](const builtin& implementation) {
+            return make_child(name, node.interface, implementation,
+                              parent_links, parent_ports);
         }
     }, node.implementation);
 }
 
-auto change_directory(const std::filesystem::path& path, std::ostream& diags)
-    -> void
+auto add_close_actions(const std::set<port_id>& ports,
+                       std::vector<detail::child_action>& actions) -> void
 {
-    auto ec = std::error_code{};
-    std::filesystem::current_path(path, ec);
-    if (ec) {
-        diags << "chdir " << path << " failed: ";
-        write(diags, ec);
-        diags << "\n";
-        diags.flush();
-        exit(exit_failure_code);
+    for (auto&& port: ports) {
+        if (const auto p = std::get_if<reference_descriptor>(&port)) {
+            actions.emplace_back(detail::close_action{int(*p)});
+        }
     }
 }
 
-auto set_found(const std::span<bool>& found, const port_id& port)
-    -> void
+/// @brief Pipe descriptor of a child's dup2 action.
+struct pipe_fixup
+{
+    /// @brief Index of the <code>detail::dup2_action</code> it's for.
+    std::size_t action{};
+
+    /// @brief Index of the pipe channel. Flattened for planned children.
+    std::size_t channel{};
+
+    pipe_channel::io side{};
+};
+
+/// @brief Adds the actions for the named child to duplicate its end(s) of
+///   the given pipe into place.
+/// @note The pipe's descriptors are close-on-exec, so the child needn't
+///   close them.
+auto add_actions(const node_name& name,
+                 const link& conn,
+                 const pipe_channel& p,
+                 std::size_t index,
+                 std::vector<detail::child_action>& actions,
+                 std::vector<pipe_fixup>& fixups,
+                 std::ostream& diags) -> void
+{
+    using io = pipe_channel::io;
+    const auto add_dup2 = [&](io side, const std::set<port_id>& ports){
+        for (auto&& port: ports) {
+            if (const auto id = std::get_if<reference_descriptor>(&port)) {
+                diags << name << " " << conn << " " << p;
+                diags << ", dup " << side << "-side to " << *id << "\n";
+                fixups.push_back({size(actions), index, side});
+                actions.emplace_back(detail::dup2_action{
+                    int(p.get(side)), int(*id)
+                });
+            }
+        }
+    };
+    const auto ends = make_endpoints<node_endpoint>(conn);
+    if (ends[0] && (ends[0]->address == name)) { // src
+        add_dup2(io::write, ends[0]->ports);
+    }
+    if (ends[1] && (ends[1]->address == name)) { // dst
+        add_dup2(io::read, ends[1]->ports);
+    }
+}
+
+/// @brief Adds the actions for the named child to open the given file
+///   channel as its linked ports.
+auto add_actions(const node_name& name,
+                 const link& conn,
+                 const file_channel& chan,
+                 std::vector<detail::child_action>& actions,
+                 std::ostream& diags) -> void
 {
-    if (std::holds_alternative<reference_descriptor>(port)) {
-        const auto d = int(std::get<reference_descriptor>(port));
-        if ((d >= 0) && (unsigned(d) < size(found))) {
-            found[d] = true;
+    static constexpr auto mode = 0600;
+    for (auto&& end: make_endpoints<node_endpoint>(conn)) {
+        if (!end || (end->address != name)) {
+            continue;
+        }
+        const auto flags = to_open_flags(chan.io);
+        if (!flags) {
+            if (!empty(flags.error())) {
+                diags << name << " " << conn;
+                diags << ", can't get needed open flags: ";
+                diags << flags.error();
+                diags << "\n";
+            }
+            add_close_actions(end->ports, actions);
+            return;
+        }
+        auto first = static_cast<const reference_descriptor*>(nullptr);
+        for (auto&& port: end->ports) {
+            if (const auto p = std::get_if<reference_descriptor>(&port)) {
+                if (first) {
+                    actions.emplace_back(detail::dup2_action{
+                        int(*first), int(*p)
+                    });
+                    continue;
+                }
+                actions.emplace_back(detail::open_action{
+                    int(*p), chan.path.c_str(), *flags, mode
+                });
+                first = p;
+            }
         }
+        return;
     }
 }
 
-auto set_found(const std::span<bool>& found, const std::set<port_id>& ports)
-    -> void
+auto add_needed(const std::set<port_id>& ports,
+                std::vector<unsigned>& needed) -> void
 {
     for (auto&& port: ports) {
-        set_found(found, port);
+        if (const auto p = std::get_if<reference_descriptor>(&port)) {
+            if (int(*p) >= 0) {
+                needed.push_back(unsigned(*p));
+            }
+        }
     }
 }
 
-auto set_found(const std::span<bool>& found, const port_map& ports)
+/// @brief Adds the actions to close every descriptor that's not needed.
+/// @note These are <code>close_range_action</code>s for the gaps between
+///   the needed descriptors.
+auto add_close_range_actions(std::vector<unsigned>& needed,
+                             std::vector<detail::child_action>& actions)
     -> void
 {
-    for (auto&& entry: ports) {
-        set_found(found, entry.first);
+    std::sort(begin(needed), end(needed));
+    auto first = 0u;
+    for (auto&& fd: needed) {
+        if (fd > first) {
+            actions.emplace_back(detail::close_range_action{first, fd - 1u});
+        }
+        first = std::max(first, fd + 1u);
     }
+    actions.emplace_back(detail::close_range_action{first});
 }
 
-auto close_unused_ports(const node_name& name,
-                        const std::span<const link>& conns,
-                        const port_map& ports)
-    -> void
+/// @brief Descriptors of this process that a child keeps open for itself,
+///   besides those of its ports.
+struct kept_descriptors
 {
-    auto using_des = std::array<bool, 3u>{};
-    for (auto&& conn: conns) {
-        const auto ends = make_endpoints<node_endpoint>(conn);
-        for (auto&& end: ends) {
-            if (end && end->address == name) {
-                set_found(using_des, end->ports);
+    /// @brief Descriptor the child reports failures to.
+    int diags{-1};
+
+    /// @brief Descriptor of the file for the child to execute, if any.
+    int exe{-1};
+
+    /// @brief Directory descriptor of the control group for the child to
+    ///   join, if any.
+    int cgroup{-1};
+
+    /// @brief Duplicates made to keep descriptors clear of the child's
+    ///   ports.
+    std::vector<owning_descriptor> duplicates;
+};
+
+/// @brief Gets the descriptors the given actions close, duplicate, or open
+///   onto.
+auto get_targets(const std::vector<detail::child_action>& actions)
+    -> std::set<int>
+{
+    auto result = std::set<int>{};
+    for (auto&& action: actions) {
+        if (const auto p = std::get_if<detail::dup2_action>(&action)) {
+            result.insert(p->newfd);
+        }
+        else if (const auto p = std::get_if<detail::open_action>(&action)) {
+            result.insert(p->fd);
+        }
+        else if (const auto p = std::get_if<detail::close_action>(&action)) {
+            result.insert(p->fd);
+        }
+    }
+    return result;
+}
+
+/// @brief Gets the lowest descriptor above all those the given actions
+///   close, duplicate, or open onto.
+auto get_lowest_clear(const std::vector<detail::child_action>& actions)
+    -> int
+{
+    const auto targets = get_targets(actions);
+    return empty(targets)? 0: (*targets.rbegin() + 1);
+}
+
+/// @brief Keeps the given kept descriptors, & the pipe descriptors of the
+///   given dup2 actions, clear of what the actions target.
+/// @details Otherwise the child's actions for its ports could replace them
+///   before they're used. Like the zygote does with the descriptors passed
+///   to it, ones that are targets are duplicated above all the targets.
+/// @param[in] fixups Where the dup2 actions of pipes are in @p actions.
+/// @return Whether successful. If not, why not is written to @p diags.
+auto keep_clear_of_targets(std::vector<detail::child_action>& actions,
+                           const std::span<const pipe_fixup>& fixups,
+                           kept_descriptors& kept,
+                           std::ostream& diags) -> bool
+{
+    const auto targets = get_targets(actions);
+    if (empty(targets)) {
+        return true;
+    }
+    const auto lowest = *targets.rbegin() + 1;
+    auto moved = std::map<int, int>{};
+    const auto keep_clear = [&](int& fd){
+        if ((fd < 0) || !targets.contains(fd)) {
+            return true;
+        }
+        auto [it, inserted] = moved.emplace(fd, -1);
+        if (inserted) {
+            it->second = int(kept.duplicates.emplace_back(
+                ::fcntl(fd, F_DUPFD_CLOEXEC, lowest))); // NOLINT(cppcoreguidelines-pro-type-vararg)
+            if (it->second == -1) {
+                diags << "can't keep descriptor " << fd;
+                diags << " clear of child's ports: ";
+                diags << os_error_code(errno) << "\n";
+                return false;
             }
         }
+        fd = it->second;
+        return true;
+    };
+    for (auto&& fixup: fixups) {
+        auto& action = std::get<detail::dup2_action>(actions[fixup.action]);
+        // One onto itself is done before anything replaces it.
+        if ((action.fd != action.newfd) && !keep_clear(action.fd)) {
+            return false;
+        }
+    }
+    return keep_clear(kept.diags) && keep_clear(kept.exe) &&
+           keep_clear(kept.cgroup);
+}
+
+/// @brief Gets the CPU for the next process to be spread onto the given
+///   CPUs.
+/// @note This takes turns between the CPUs across all instantiations.
+auto next_spread_cpu(const cpu_set_t& cpus) noexcept -> int
+{
+    static std::atomic<unsigned> counter;
+    const auto count = unsigned(CPU_COUNT(&cpus));
+    if (count == 0u) {
+        return -1;
     }
-    set_found(using_des, ports);
-    for (auto&& use: using_des) {
-        if (!use) {
-            ::close(int(&use - data(using_des)));
+    auto n = counter++ % count;
+    for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpus) && (n-- == 0u)) {
+            return cpu;
         }
     }
+    return -1;
 }
 
-auto close_pipes_except(instance& root, instance& child) -> void
+/// @brief Adds the actions that apply the given placement.
+auto add_placement_actions(const placement_policy& placement,
+                           std::vector<detail::child_action>& actions)
+    -> void
 {
-    if (const auto parent = find_parent(root, child)) {
-        auto& parent_info = std::get<instance::system>(parent->info);
-        auto& child_info = std::get<instance::forked>(child.info);
-        for (auto&& pipe: the_pipe_registry().pipes) {
-            if (!is_channel_for(parent_info.channels, pipe)) {
-                pipe->close(pipe_channel::io::read, child_info.diags);
-                pipe->close(pipe_channel::io::write, child_info.diags);
-            }
+    auto cpus = cpu_set_t{};
+    CPU_ZERO(&cpus);
+    for (auto&& cpu: placement.cpus) {
+        CPU_SET(cpu, &cpus);
+    }
+    if (placement.cpu == cpu_policy::spread) {
+        if (empty(placement.cpus)) {
+            (void) ::sched_getaffinity(0, sizeof(cpus), &cpus);
         }
+        const auto cpu = next_spread_cpu(cpus);
+        CPU_ZERO(&cpus);
+        if (cpu >= 0) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (CPU_COUNT(&cpus) > 0) {
+        actions.emplace_back(detail::affinity_action{cpus});
+    }
+    auto nodes = 0ul;
+    for (auto&& node: placement.numa_nodes) {
+        nodes |= 1ul << node;
+    }
+    switch (placement.memory) {
+    case memory_policy::inherit:
+        break;
+    case memory_policy::local:
+        actions.emplace_back(detail::mempolicy_action{MPOL_LOCAL});
+        break;
+    case memory_policy::bind:
+        actions.emplace_back(detail::mempolicy_action{MPOL_BIND, nodes});
+        break;
+    case memory_policy::interleave:
+        actions.emplace_back(detail::mempolicy_action{MPOL_INTERLEAVE,
+                                                      nodes});
+        break;
+    case memory_policy::preferred:
+        actions.emplace_back(detail::mempolicy_action{MPOL_PREFERRED,
+                                                      nodes});
+        break;
     }
 }
 
-auto setup(const node_name& name,
-           const link& conn,
-           channel& chan,
-           std::ostream& diags) -> void
+/// @brief Adds the actions that apply the given scheduling attributes.
+auto add_scheduling_actions(const scheduling_policy& scheduling,
+                            std::vector<detail::child_action>& actions)
+    -> void
 {
-    const auto chan_p = fully_deref(&chan);
-    assert(chan_p != nullptr);
-    if (const auto pipe_p = std::get_if<pipe_channel>(chan_p)) {
-        setup(name, conn, *pipe_p, diags);
-        return;
+    switch (scheduling.scheduler) {
+    case scheduling_class::inherit:
+        break;
+    case scheduling_class::normal:
+        actions.emplace_back(detail::scheduler_action{SCHED_OTHER});
+        break;
+    case scheduling_class::batch:
+        actions.emplace_back(detail::scheduler_action{SCHED_BATCH});
+        break;
+    case scheduling_class::idle:
+        actions.emplace_back(detail::scheduler_action{SCHED_IDLE});
+        break;
     }
-    if (const auto file_p = std::get_if<file_channel>(chan_p)) {
-        setup(name, conn, *file_p, diags);
-        return;
+    if (scheduling.nice) {
+        actions.emplace_back(detail::nice_action{*scheduling.nice});
+    }
+    const auto level = int(scheduling.io_level);
+    switch (scheduling.io) {
+    case io_class::inherit:
+        break;
+    case io_class::realtime:
+        actions.emplace_back(detail::ioprio_action{
+            IOPRIO_PRIO_VALUE(IOPRIO_CLASS_RT, level)
+        });
+        break;
+    case io_class::best_effort:
+        actions.emplace_back(detail::ioprio_action{
+            IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, level)
+        });
+        break;
+    case io_class::idle:
+        actions.emplace_back(detail::ioprio_action{
+            IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)
+        });
+        break;
     }
-    diags << "found UNKNOWN channel type!!!!\n";
 }
 
-auto setup(instance& root,
-           const node_name& name,
-           const port_map& ports,
-           const std::span<const link>& links,
-           const std::span<channel>& channels,
-           instance& child) -> void
+/// @brief Makes the actions for the named child to perform before
+///   executing its file.
+/// @details These put the child into its process group, set up the
+///   descriptors of its ports from the channels of its links, close all
+///   other descriptors, and change its working directory.
+/// @param[in,out] kept Descriptors to keep open regardless, which are
+///   kept clear of the ports. Negative ones are ignored. This is for a
+///   forked child to be able to report failures, execute its file from a
+///   descriptor, & join its control group.
+/// @param[out] fixups Where the dup2 actions of pipes are.
+/// @note These are made by the parent, so neither a spawned nor a forked
+///   child has to do anything but the actions themselves.
+/// @return The actions, else none if the kept descriptors couldn't be kept
+///   clear of the ports. In which case why not is written to @p diags.
+auto make_child_actions(const node_name& name,
+                        const port_map& ports,
+                        const executable& implementation,
+                        reference_process_id pgrp,
+                        const std::span<const link>& links,
+                        const std::span<channel>& channels,
+                        kept_descriptors& kept,
+                        std::vector<pipe_fixup>& fixups,
+                        std::ostream& diags)
+    -> std::vector<detail::child_action>
 {
-    // close & dup the channels needed for name, and close those that aren't
-    auto& child_info = std::get<instance::forked>(child.info);
+    auto actions = std::vector<detail::child_action>{};
+    auto needed = std::vector<unsigned>{};
+    actions.emplace_back(detail::setpgid_action{pgrp});
     const auto max_index = size(links);
     assert(max_index == size(channels));
     for (auto index = 0u; index < max_index; ++index) {
-        setup(name, links[index], channels[index], child_info.diags);
+        const auto ends = make_endpoints<node_endpoint>(links[index]);
+        const auto is_linked = [&name](const node_endpoint* end){
+            return end && (end->address == name);
+        };
+        if (!is_linked(ends[0]) && !is_linked(ends[1])) {
+            continue;
+        }
+        for (auto&& end: ends) {
+            if (is_linked(end)) {
+                add_needed(end->ports, needed);
+            }
+        }
+        const auto chan_p = fully_deref(&channels[index]);
+        if (const auto pipe_p = std::get_if<pipe_channel>(chan_p)) {
+            add_actions(name, links[index], *pipe_p, index, actions,
+                        fixups, diags);
+            continue;
+        }
+        if (const auto file_p = std::get_if<file_channel>(chan_p)) {
+            add_actions(name, links[index], *file_p, actions, diags);
+            continue;
+        }
+        diags << "found UNKNOWN channel type!!!!\n";
     }
-    close_unused_ports(name, links, ports);
-    close_pipes_except(root, child);
-}
-
-auto find_file(const std::filesystem::path& file, const env_value& path)
-    -> std::optional<std::filesystem::path>
-{
-    static constexpr auto delimiter = ':';
-    auto ec = std::error_code{};
-    auto last = std::size_t{};
-    auto next = std::size_t{};
-    while ((next = path.get().find(delimiter, last)) != std::string::npos) {
-        const auto dir = path.get().substr(last, next - last);
-        if (!dir.empty()) {
-            const auto full_path = dir / file;
-            if (exists(full_path, ec) && !ec) {
-                return full_path;
+    if (!keep_clear_of_targets(actions, fixups, kept, diags)) {
+        return {};
+    }
+    // Unlinked ports use the parent's descriptors.
+    for (auto&& entry: ports) {
+        if (const auto p = std::get_if<reference_descriptor>(&entry.first)) {
+            if (int(*p) >= 0) {
+                needed.push_back(unsigned(*p));
             }
         }
-        last = next + 1u;
     }
-    const auto dir = path.get().substr(last);
-    if (!dir.empty()) {
-        const auto full_path = dir / file;
-        if (exists(full_path, ec) && !ec) {
-            return full_path;
+    for (auto&& fd: {kept.diags, kept.exe, kept.cgroup}) {
+        if (fd >= 0) {
+            needed.push_back(unsigned(fd));
         }
     }
-    return {};
+    // Close file descriptors inherited by child that it's not using.
+    // See: https://stackoverflow.com/a/7976880/7410358
+    add_close_range_actions(needed, actions);
+    if (!implementation.working_directory.empty()) {
+        actions.emplace_back(detail::chdir_action{
+            implementation.working_directory.c_str()
+        });
+    }
+    return actions;
 }
 
-auto fork_child(const node_name& name,
-                const port_map& interface,
-                const executable& implementation,
-                const environment_map& env,
-                instance& child,
-                reference_process_id& pgrp,
-                const std::span<const link>& links,
-                const std::span<channel>& channels,
-                instance& root,
-                std::ostream& diags) -> void
+/// @brief Finds the file to execute for the given file path.
+/// @details Paths of just a filename are searched for in the directories
+///   of the <code>PATH</code> environment variable.
+/// @note Failures to find the file are reported to @p diags.
+auto find_file(const std::filesystem::path& file,
+               const environment_map& env,
+               std::ostream& diags) -> std::optional<detail::resolved_executable>
 {
-    auto exe_path = implementation.file;
-    if (exe_path.empty()) {
+    if (file.empty()) {
         diags << "no file specified to execute\n";
-        return;
+        return {};
     }
-    if (exe_path.is_relative() && !exe_path.has_parent_path()) {
-        auto path_env_value = static_cast<const env_value*>(nullptr);
-        if (const auto it = env.find("PATH"); it != env.end()) {
-            path_env_value = &(it->second);
-        }
-        if (!path_env_value) {
-            diags << "no PATH to find file " << exe_path << "\n";
-            return;
-        }
-        const auto found = find_file(exe_path, *path_env_value);
-        if (!found) {
-            diags << "no such file in PATH as " << exe_path << "\n";
-            return;
+    if (!file.is_relative() || file.has_parent_path()) {
+        return detail::resolved_executable{file, {}};
+    }
+    const auto it = env.find("PATH");
+    if (it == env.end()) {
+        diags << "no PATH to find file " << file << "\n";
+        return {};
+    }
+    auto found = detail::find_executable(file, it->second);
+    if (!found) {
+        diags << "no such file in PATH as " << file << "\n";
+    }
+    return found;
+}
+
+/// @brief Process created for a child.
+struct new_process
+{
+    reference_process_id pid{invalid_process_id};
+
+    /// @brief Descriptor referring to the process, if one came with it.
+    owning_descriptor pidfd;
+
+    /// @brief Why the zygote couldn't be used, if that's to be reported.
+    std::string zygote_unavailable;
+};
+
+/// @brief Finds the directory descriptor of the control group the given
+///   actions have the child join, else -1 if they don't.
+auto find_cgroup(const std::vector<detail::child_action>& actions) -> int
+{
+    for (auto&& action: actions) {
+        if (const auto p = std::get_if<detail::cgroup_action>(&action)) {
+            return p->fd;
         }
-        exe_path = *found;
     }
-    auto& child_info = std::get<instance::forked>(child.info);
-    auto arg_buffers = make_arg_bufs(implementation.arguments, exe_path);
-    auto env_buffers = make_arg_bufs(env);
-    auto argv = make_argv(arg_buffers);
-    auto envp = make_argv(env_buffers);
+    return -1;
+}
+
+/// @brief Creates the process of a child from what's been prepared for it.
+/// @param[in] substituting Whether any of @p args are to be substituted.
+/// @param[in] actions Actions for the child, which must keep @p diags_fd
+///   open.
+/// @param[in] diags_fd Descriptor a forked child reports failures to.
+/// @return The new process, whose identifier is
+///   <code>invalid_process_id</code> if it couldn't be created. In which
+///   case <code>errno</code> says why.
+auto create_process(const std::filesystem::path& exe_path,
+                    int exe_fd,
+                    const detail::arg_block& args,
+                    char * const *envp,
+                    bool substituting,
+                    const std::vector<detail::child_action>& actions,
+                    int diags_fd,
+                    process_creation creation) -> new_process
+{
+    // Only arguments to substitute into need their own vector of them.
+    auto argv_copy = std::vector<char*>{};
+    if (substituting) {
+        const auto strings = args.strings();
+        argv_copy.assign(args.data(), args.data() + size(strings) + 1u);
+    }
+    const auto argv = substituting? argv_copy.data(): args.data();
     sigset_t old_set{};
     sigset_t new_set{};
     sigemptyset(&old_set);
     sigemptyset(&new_set);
     sigaddset(&new_set, SIGCHLD);
     pthread_sigmask(SIG_BLOCK, &new_set, &old_set);
-    const auto pid = owning_process_id::fork();
+    // Spawn whenever the child needn't do anything it can only do for
+    // itself. Spawning failures, and failures to have the zygote create
+    // the child, fall through to forking. Which reproduces any failures of
+    // the child with diagnostics from it & an exit failure code.
+    if ((creation == process_creation::spawn) && !substituting &&
+        detail::is_spawnable(actions)) {
+        const auto pid = detail::spawn(exe_path, argv, envp, actions,
+                                       old_set);
+        if (pid != invalid_process_id) {
+            pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+            return {pid, {}, {}};
+        }
+    }
+    auto zygote_unavailable = std::string{};
+    if ((creation == process_creation::zygote) && !substituting) {
+        auto result = detail::zygote_spawn(exe_path, exe_fd, argv, envp,
+                                           actions, old_set, diags_fd);
+        if (result.pid != invalid_process_id) {
+            pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+            return {result.pid, std::move(result.pidfd), {}};
+        }
+        zygote_unavailable = std::move(result.unavailable);
+    }
+    const auto cgroup = find_cgroup(actions);
+    const auto pid = (cgroup >= 0)
+        ? owning_process_id::fork(reference_descriptor{cgroup})
+        : owning_process_id::fork();
     switch (pid) {
-    case invalid_process_id:
-        diags << "fork failed: " << os_error_code(errno) << "\n";
-        return;
+    case invalid_process_id: {
+        const auto error = errno;
+        pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+        errno = error;
+        return {};
+    }
     case no_process_id: { // child process
         // Have to be careful here!
         // From https://man7.org/linux/man-pages/man2/fork.2.html:
@@ -593,47 +845,528 @@ auto fork_child(const node_name& name,
         //   time as it calls execve(2)."
         // See https://man7.org/linux/man-pages/man7/signal-safety.7.html
         // for "functions required to be async-signal-safe by POSIX.1".
+        // So the child only performs its precomputed actions & reports
+        // failures directly to its diags' descriptor.
         pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
-        if (::setpgid(0, int(pgrp)) == -1) {
-            child_info.diags << "setpgid failed(0, ";
-            child_info.diags << pgrp;
-            child_info.diags << "): ";
-            child_info.diags << os_error_code(errno);
-            child_info.diags << "\n";
-        }
-        make_substitutions(argv);
-        // Deal with:
-        // link{
-        //   node_endpoint{ls_process_name, flow::reference_descriptor{1}},
-        //   node_endpoint{cat_process_name, flow::reference_descriptor{0}}
-        // }
-        //
-        // Also:
-        // Close file descriptors inherited by child that it's not using.
-        // See: https://stackoverflow.com/a/7976880/7410358
-        setup(root, name, interface, links, channels, child);
-        // NOTE: child.diags streams opened close-on-exec, so no need
-        //   to close them.
-        if (!implementation.working_directory.empty()) {
-            change_directory(implementation.working_directory, child_info.diags);
-        }
-        // NOTE: the following does not return!
-        exec_child(exe_path, argv.data(), envp.data(), child_info.diags);
+        auto pid_argv = getpid_as_char_array();
+        make_substitutions(argv_copy, pid_argv);
+        // NOTE: the following only returns on failure!
+        detail::exec(exe_path.c_str(), exe_fd, argv, envp, actions,
+                     diags_fd);
+        exit(exit_failure_code);
     }
     default: // case for the spawning/parent process
-        child_info.state = owning_process_id(pid);
-        if (pgrp == no_process_id) {
-            pgrp = pid;
-        }
         pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
-        break;
+        return {pid, {}, std::move(zygote_unavailable)};
+    }
+}
+
+/// @brief Creates the process of a child from what's been prepared for it.
+/// @param[in] actions Actions for the child, which must keep @p diags_fd
+///   open.
+/// @param[in] diags_fd Descriptor of @p child_info's diagnostics, or a
+///   duplicate of it.
+auto create_process(const std::filesystem::path& exe_path,
+                    int exe_fd,
+                    const detail::arg_block& args,
+                    char * const *envp,
+                    bool substituting,
+                    const std::vector<detail::child_action>& actions,
+                    int diags_fd,
+                    instance::forked& child_info,
+                    reference_process_id& pgrp,
+                    process_creation creation,
+                    std::ostream& diags) -> void
+{
+    // Flush now so a forked child doesn't have a copy of what's buffered.
+    child_info.diags.flush();
+    auto created = create_process(exe_path, exe_fd, args, envp,
+                                  substituting, actions, diags_fd, creation);
+    if (!created.zygote_unavailable.empty()) {
+        diags << created.zygote_unavailable << ", forking instead\n";
+    }
+    if (created.pid == invalid_process_id) {
+        diags << "fork failed: " << os_error_code(errno) << "\n";
+        return;
+    }
+    child_info.state = owning_process_id(created.pid,
+                                         std::move(created.pidfd));
+    if (pgrp == no_process_id) {
+        pgrp = created.pid;
+    }
+}
+
+/// @brief What's needed to create the process of a child any time after
+///   it's been instantiated.
+/// @note The actions refer to the recipe's own duplicates of the pipe
+///   descriptors & copies of paths. So they stay valid however long the
+///   recipe's kept, & the pipes don't see end-of-file until it's gone.
+struct child_recipe
+{
+    detail::resolved_executable file;
+    std::shared_ptr<const detail::arg_block> args;
+    std::shared_ptr<const detail::arg_block> envp;
+    bool substituting{};
+    std::vector<detail::child_action> actions;
+    std::list<std::string> paths;
+    std::vector<owning_descriptor> descriptors;
+
+    /// @brief Duplicates of the read ends of the child's input pipes.
+    std::vector<int> inputs;
+
+    int exe_fd{-1};
+    int diags_fd{-1};
+    process_creation creation{};
+
+    /// @brief Control group the actions have the child join, if any.
+    std::shared_ptr<const detail::control_group> cgroup;
+};
+
+/// @brief Makes a recipe for creating the process of a child later.
+/// @param[in] fixups Where the dup2 actions of pipes are in @p actions.
+/// @param[in,out] kept Descriptors the actions keep. The recipe takes over
+///   any duplicates of them.
+/// @return The recipe, else null if it couldn't be made. In which case
+///   why not is written to @p diags.
+auto make_recipe(const detail::resolved_executable& file,
+                 std::shared_ptr<const detail::arg_block> args,
+                 std::shared_ptr<const detail::arg_block> envp,
+                 bool substituting,
+                 std::vector<detail::child_action> actions,
+                 const std::span<const pipe_fixup>& fixups,
+                 kept_descriptors& kept,
+                 process_creation creation,
+                 std::ostream& diags) -> std::shared_ptr<child_recipe>
+{
+    using io = pipe_channel::io;
+    const auto recipe = std::make_shared<child_recipe>();
+    // Above the ports, so no action replaces them before they're used.
+    const auto lowest = get_lowest_clear(actions);
+    auto duplicates = std::map<int, int>{};
+    for (auto&& fixup: fixups) {
+        auto& fd = std::get<detail::dup2_action>(actions[fixup.action]).fd;
+        auto [it, inserted] = duplicates.emplace(fd, -1);
+        if (inserted) {
+            it->second = int(recipe->descriptors.emplace_back(
+                ::fcntl(fd, F_DUPFD_CLOEXEC, lowest))); // NOLINT(cppcoreguidelines-pro-type-vararg)
+            if (it->second == -1) {
+                diags << "can't duplicate pipe descriptor for child: ";
+                diags << os_error_code(errno) << "\n";
+                return {};
+            }
+            if (fixup.side == io::read) {
+                recipe->inputs.push_back(it->second);
+            }
+        }
+        fd = it->second;
+    }
+    for (auto&& action: actions) {
+        if (const auto p = std::get_if<detail::open_action>(&action)) {
+            p->path = recipe->paths.emplace_back(p->path).c_str();
+        }
+        else if (const auto p = std::get_if<detail::chdir_action>(&action)) {
+            p->path = recipe->paths.emplace_back(p->path).c_str();
+        }
+    }
+    recipe->file = file;
+    recipe->args = std::move(args);
+    recipe->envp = std::move(envp);
+    recipe->substituting = substituting;
+    recipe->actions = std::move(actions);
+    recipe->exe_fd = kept.exe;
+    recipe->diags_fd = kept.diags;
+    std::move(begin(kept.duplicates), end(kept.duplicates),
+              std::back_inserter(recipe->descriptors));
+    kept.duplicates.clear();
+    recipe->creation = creation;
+    return recipe;
+}
+
+auto create_process(const child_recipe& recipe) -> new_process
+{
+    return create_process(recipe.file.path, recipe.exe_fd,
+                          *recipe.args, recipe.envp->data(),
+                          recipe.substituting, recipe.actions,
+                          recipe.diags_fd, recipe.creation);
+}
+
+/// @brief What's needed to create the process of a child whose start is
+///   deferred until there's data for it.
+struct deferred_child
+{
+    std::mutex mutex;
+    detail::deferred_process process;
+    std::shared_ptr<const child_recipe> recipe;
+    std::vector<detail::watch_id> watches;
+
+    /// @brief Number of inputs not yet found to be at end-of-file.
+    std::size_t open_inputs{};
+
+    /// @brief Whether the process has been started or cancelled.
+    bool done{};
+};
+
+/// @brief Starts or cancels the given deferred child's process, & stops
+///   watching its inputs.
+/// @note The record's mutex must be held.
+auto finish(deferred_child& record, bool start) -> void
+{
+    if (!start) {
+        record.process.cancel(wait_exit_status{EXIT_SUCCESS});
+    }
+    else {
+        auto created = create_process(*record.recipe);
+        if (created.pid == invalid_process_id) {
+            record.process.cancel(wait_exit_status{exit_failure_code});
+        }
+        else {
+            record.process.start(created.pid, std::move(created.pidfd));
+        }
+    }
+    record.done = true;
+    for (auto&& id: record.watches) {
+        detail::unwatch(id);
+    }
+    record.watches.clear();
+    // Lets go of its pipes, unless restarting holds onto them too.
+    record.recipe.reset();
+}
+
+/// @brief Defers creating the process of a child until there's data to
+///   read from any of its input pipes.
+/// @details If instead all the inputs reach end-of-file, the process is
+///   never created & is considered to have exited successfully.
+/// @return Whether deferred. Which it's not if the child has no input
+///   pipes, or they can't be watched.
+auto defer_process(std::shared_ptr<const child_recipe> recipe,
+                   instance::forked& child_info,
+                   std::ostream& diags) -> bool
+{
+    if (empty(recipe->inputs)) {
+        return false;
+    }
+    // Flush now so a forked child doesn't have a copy of what's buffered.
+    child_info.diags.flush();
+    const auto record = std::make_shared<deferred_child>();
+    record->open_inputs = size(recipe->inputs);
+    record->recipe = std::move(recipe);
+    // Hold the lock so no handler runs until all the inputs are watched.
+    std::unique_lock lock{record->mutex};
+    auto owner = record->process.make_owner();
+    try {
+        for (auto&& fd: record->recipe->inputs) {
+            record->watches.push_back(detail::watch(fd, EPOLLIN,
+                                                    [record,fd](std::uint32_t) {
+                const std::lock_guard handler_lock{record->mutex};
+                if (record->done) {
+                    return false;
+                }
+                auto available = 0;
+                if ((::ioctl(fd, FIONREAD, &available) == 0) && // NOLINT(cppcoreguidelines-pro-type-vararg)
+                    (available > 0)) {
+                    finish(*record, true);
+                    return false;
+                }
+                // Readable without data means all its writers closed.
+                if (--record->open_inputs == 0u) {
+                    finish(*record, false);
+                }
+                return false;
+            }));
+        }
+    }
+    catch (const std::system_error& ex) {
+        diags << "can't defer starting child: " << ex.what() << "\n";
+        record->done = true;
+        record->process.cancel(wait_exit_status{exit_failure_code});
+        const auto watches = std::exchange(record->watches, {});
+        // Unlocked since unwatching waits for any running handler.
+        lock.unlock();
+        for (auto&& id: watches) {
+            detail::unwatch(id);
+        }
+        return false;
+    }
+    child_info.state = std::move(owner);
+    return true;
+}
+
+/// @brief Has the process of the given child restarted per the given
+///   policy & limits, by creating it from the given recipe.
+auto supervise(instance::forked& child_info,
+               restart_policy policy,
+               const restart_limits& limits,
+               std::shared_ptr<const child_recipe> recipe,
+               std::ostream& diags) -> void
+{
+    const auto p = std::get_if<owning_process_id>(&child_info.state);
+    if (!p) {
+        return;
+    }
+    try {
+        detail::process_supervisor::supervise(*p, policy, limits, [recipe]{
+            auto created = create_process(*recipe);
+            return detail::respawned_process{created.pid,
+                                             std::move(created.pidfd)};
+        });
+    }
+    catch (const std::system_error& ex) {
+        diags << "can't restart child: " << ex.what() << "\n";
+    }
+}
+
+/// @brief Creates the process of a child, or defers creating it per the
+///   given start policy, & has it restarted per the given restart policy.
+/// @param[in] fixups Where the dup2 actions of pipes are in @p actions.
+/// @param[in,out] kept Descriptors the actions keep.
+auto start_child(const detail::resolved_executable& file,
+                 std::shared_ptr<const detail::arg_block> args,
+                 std::shared_ptr<const detail::arg_block> envp,
+                 bool substituting,
+                 const std::vector<detail::child_action>& actions,
+                 const std::span<const pipe_fixup>& fixups,
+                 kept_descriptors& kept,
+                 start_policy start,
+                 restart_policy restart,
+                 const restart_limits& limits,
+                 instance::forked& child_info,
+                 reference_process_id& pgrp,
+                 process_creation creation,
+                 std::ostream& diags) -> void
+{
+    // Only processes created after instantiating need a recipe.
+    const auto recipe = ((start == start_policy::on_data) ||
+                         (restart != restart_policy::never))
+        ? make_recipe(file, args, envp, substituting, actions, fixups,
+                      kept, creation, diags)
+        : std::shared_ptr<child_recipe>{};
+    if (!recipe || (start != start_policy::on_data) ||
+        !defer_process(recipe, child_info, diags)) {
+        create_process(file.path, kept.exe, *args, envp->data(),
+                       substituting, actions, kept.diags, child_info, pgrp,
+                       creation, diags);
+    }
+    if (recipe) {
+        recipe->cgroup = child_info.cgroup;
+    }
+    if (recipe && (restart != restart_policy::never)) {
+        // So replacements join the process group the first one made.
+        // Deferred ones already have it, so are left alone.
+        if (const auto p = std::get_if<detail::setpgid_action>(
+                &recipe->actions.front()); p && (p->pgrp != pgrp)) {
+            p->pgrp = pgrp;
+        }
+        supervise(child_info, restart, limits, recipe, diags);
+    }
+}
+
+auto fork_child(const node_name& name,
+                const port_map& interface,
+                const executable& implementation,
+                const environment_map& env,
+                instance& child,
+                reference_process_id& pgrp,
+                const std::span<const link>& links,
+                const std::span<channel>& channels,
+                process_creation creation,
+                std::ostream& diags) -> void
+{
+    const auto found = find_file(implementation.file, env, diags);
+    if (!found) {
+        return;
+    }
+    auto& child_info = std::get<instance::forked>(child.info);
+    // Blocks are cached, so siblings & repeated instantiations share them.
+    const auto args = detail::get_arg_block(implementation.arguments,
+                                            found->path.native());
+    const auto envp = detail::get_env_block(env);
+    auto kept = kept_descriptors{
+        .diags = child_info.diags.native_handle(),
+        .exe = found->descriptor? int(*found->descriptor): -1,
+        .cgroup = child_info.cgroup? int(child_info.cgroup->directory): -1,
+        .duplicates = {},
+    };
+    auto fixups = std::vector<pipe_fixup>{};
+    auto actions = make_child_actions(name, interface, implementation, pgrp,
+                                      links, channels, kept, fixups,
+                                      child_info.diags);
+    if (empty(actions)) {
+        return;
+    }
+    if (kept.cgroup >= 0) {
+        actions.emplace_back(detail::cgroup_action{kept.cgroup});
     }
+    add_placement_actions(implementation.placement, actions);
+    add_scheduling_actions(implementation.scheduling, actions);
+    const auto substituting = has_substitutions(args->strings());
+    start_child(*found, args, envp, substituting, actions, fixups, kept,
+                implementation.start, implementation.restart,
+                implementation.limits, child_info, pgrp, creation, diags);
 }
 
 auto fork_executables(const system& system,
                       instance& object,
-                      instance& root,
+                      process_creation creation,
                       std::ostream& diags) -> void
+{
+    auto& info = std::get<instance::system>(object.info);
+    // Children starting on data go last, so there's a process group for
+    // them to join by then.
+    for (const auto policy: {start_policy::eager, start_policy::on_data}) {
+        for (auto&& entry: system.nodes) {
+            const auto& name = entry.first;
+            const auto& node = entry.second;
+            const auto found = info.children.find(name);
+            if (found == info.children.end()) {
+                if (policy == start_policy::eager) {
+                    diags << "can't find child instance for " << name;
+                    diags << "!\n";
+                }
+                continue;
+            }
+            std::visit(detail::overloaded{
+                [&](const flow::executable& implementation) {
+                    if (implementation.start != policy) {
+                        return;
+                    }
+                    fork_child(name, node.interface, implementation,
+                               system.environment, found->second, info.pgrp,
+                               system.links, info.channels, creation, diags);
+                },
+                [&](const flow::system& implementation) {
+                    if (policy == start_policy::eager) {
+                        fork_executables(implementation, found->second,
+                                         creation, diags);
+                    }
+                },
+                [&](const flow::builtin&) {
+                    // Started by start_builtins instead.
+                }
+            }, node.implementation);
+        }
+    }
+}
+
+/// @brief Blocks <code>SIGPIPE</code> for the calling thread.
+/// @note Writes to pipes whose read ends are all closed then fail with
+///   <code>EPIPE</code> instead of the signal terminating this process.
+auto block_sigpipe() -> void
+{
+    sigset_t set{};
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+auto dup_cloexec(reference_descriptor d) -> owning_descriptor
+{
+    return owning_descriptor{
+        ::fcntl(int(d), F_DUPFD_CLOEXEC, 0) // NOLINT(cppcoreguidelines-pro-type-vararg)
+    };
+}
+
+auto open_cloexec(const file_channel& chan) -> owning_descriptor
+{
+    const auto flags = to_open_flags(chan.io);
+    if (!flags) {
+        return {};
+    }
+    const auto mode = 0600;
+    return owning_descriptor{
+        ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
+               chan.path.c_str(), *flags|O_CLOEXEC, mode)
+    };
+}
+
+auto add_ports(const node_name& name,
+               const node_endpoint& end,
+               io_type io,
+               channel& chan,
+               builtin_ports& ports,
+               std::ostream& diags) -> void
+{
+    const auto chan_p = fully_deref(&chan);
+    for (auto&& port: end.ports) {
+        const auto id = std::get_if<reference_descriptor>(&port);
+        if (!id) {
+            continue;
+        }
+        if (const auto batch_p = std::get_if<batch_channel>(chan_p)) {
+            ports.batches.insert_or_assign(*id, batch_p->get(
+                (io == io_type::in)? batch_channel::io::read
+                                   : batch_channel::io::write));
+            continue;
+        }
+        auto d = owning_descriptor{};
+        if (const auto pipe_p = std::get_if<pipe_channel>(chan_p)) {
+            d = dup_cloexec(pipe_p->get((io == io_type::in)
+                                        ? pipe_channel::io::read
+                                        : pipe_channel::io::write));
+        }
+        else if (const auto file_p = std::get_if<file_channel>(chan_p)) {
+            d = open_cloexec(*file_p);
+        }
+        else {
+            diags << name << " " << port;
+            diags << ": channel type not supported for built-in\n";
+        }
+        if (!d) {
+            diags << name << " " << port << ": can't get descriptor: ";
+            diags << os_error_code(errno) << "\n";
+        }
+        // Invalid descriptors get added too so the built-in fails to use
+        // them rather than using whatever the parent's port has.
+        ports.descriptors.insert_or_assign(*id, std::move(d));
+    }
+}
+
+auto start_builtin(const node_name& name,
+                   const port_map& interface,
+                   const builtin& implementation,
+                   const std::span<const link>& links,
+                   const std::span<channel>& channels,
+                   instance& child) -> void
+{
+    auto& child_info = std::get<instance::builtin>(child.info);
+    auto& diags = *child_info.diags;
+    auto ports = builtin_ports{};
+    const auto max_index = size(links);
+    assert(max_index == size(channels));
+    for (auto index = 0u; index < max_index; ++index) {
+        const auto ends = make_endpoints<node_endpoint>(links[index]);
+        if (ends[0] && (ends[0]->address == name)) {
+            add_ports(name, *ends[0], io_type::out, channels[index],
+                      ports, diags);
+        }
+        if (ends[1] && (ends[1]->address == name)) {
+            add_ports(name, *ends[1], io_type::in, channels[index],
+                      ports, diags);
+        }
+    }
+    // Like a forked child, use the parent's descriptors for unlinked ports.
+    for (auto&& entry: interface) {
+        const auto id = std::get_if<reference_descriptor>(&entry.first);
+        if (id && !ports.descriptors.contains(*id) &&
+            !ports.batches.contains(*id)) {
+            ports.descriptors.emplace(*id, dup_cloexec(*id));
+        }
+    }
+    child_info.finishing = std::make_shared<detail::notifier>();
+    child_info.state = std::async(std::launch::async,
+                                  [implementation,
+                                   ports = std::move(ports),
+                                   finishing = child_info.finishing,
+                                   &diags]() mutable {
+        block_sigpipe();
+        const auto status = run(implementation, ports, diags);
+        finishing->notify();
+        return status;
+    });
+}
+
+auto start_builtins(const system& system,
+                    instance& object,
+                    std::ostream& diags) -> void
 {
     auto& info = std::get<instance::system>(object.info);
     for (auto&& entry: system.nodes) {
@@ -644,16 +1377,13 @@ auto fork_executables(const system& system,
             diags << "can't find child instance for " << name << "!\n";
             continue;
         }
-        std::visit(detail::overloaded{
-            [&](const flow::executable& implementation) {
-                fork_child(name, node.interface, implementation, system.environment,
-                           found->second, info.pgrp, system.links, info.channels,
-                           root, diags);
-            },
-            [&](const flow::system& implementation) {
-                fork_executables(implementation, found->second, root, diags);
-            }
-        }, node.implementation);
+        if (const auto p = std::get_if<builtin>(&node.implementation)) {
+            start_builtin(name, node.interface, *p, system.links,
+                          info.channels, found->second);
+        }
+        else if (const auto p = std::get_if<flow::system>(&node.implementation)) {
+            start_builtins(*p, found->second, diags);
+        }
     }
 }
 
@@ -704,6 +1434,529 @@ auto close_all_internal_ends(instance::system& instance,
     }
 }
 
+/// @brief Everything about creating the process of an executable that
+///   doesn't depend on the instantiation.
+struct planned_executable
+{
+    /// @brief Diagnostic about why the process can't be created, if it
+    ///   can't be.
+    std::string failure;
+
+    detail::resolved_executable file;
+    std::shared_ptr<const detail::arg_block> args;
+    std::shared_ptr<const detail::arg_block> envp;
+    bool substituting{};
+
+    /// @brief Actions up to closing unneeded descriptors. The first is the
+    ///   <code>detail::setpgid_action</code>, & dup2 actions of pipes are
+    ///   missing their pipe descriptors.
+    std::vector<detail::child_action> actions;
+
+    std::vector<pipe_fixup> fixups;
+
+    /// @brief Descriptors of ports to keep open.
+    std::vector<unsigned> needed;
+
+    const char *working_directory{};
+
+    start_policy start{};
+    restart_policy restart{};
+    restart_limits limits;
+    placement_policy placement;
+    scheduling_policy scheduling;
+
+    /// @brief Diagnostics for the child's diagnostics stream.
+    std::string notes;
+};
+
+struct planned_builtin {};
+
+struct planned_node;
+
+struct planned_system
+{
+    bool all_closed{};
+
+    /// @brief Flattened index of the first of this system's channels.
+    std::size_t first_channel{};
+
+    std::vector<detail::channel_recipe> channels;
+
+    /// @brief Planned children in the order of the system's nodes.
+    std::vector<planned_node> children;
+};
+
+struct planned_node
+{
+    variant<planned_executable, planned_system, planned_builtin> info;
+};
+
+/// @brief State of compiling a plan.
+/// @note Channels are flattened into the order they're made in.
+struct plan_compiler
+{
+    /// @brief Recipes of the channels.
+    std::vector<const detail::channel_recipe*> recipes;
+
+    /// @brief Flattened indices of the channels reference channels
+    ///   ultimately refer to, else of the channels themselves.
+    std::vector<std::size_t> targets;
+};
+
+/// @brief Plans the actions for the named child like
+///   <code>make_child_actions</code> makes them.
+auto plan_child_actions(const node_name& name,
+                        const port_map& ports,
+                        const std::span<const link>& links,
+                        std::size_t first_channel,
+                        const plan_compiler& compiler,
+                        planned_executable& result) -> void
+{
+    using io = pipe_channel::io;
+    std::ostringstream notes;
+    auto& actions = result.actions;
+    auto& needed = result.needed;
+    actions.emplace_back(detail::setpgid_action{});
+    const auto max_index = size(links);
+    for (auto index = 0u; index < max_index; ++index) {
+        const auto ends = make_endpoints<node_endpoint>(links[index]);
+        const auto is_linked = [&name](const node_endpoint* end){
+            return end && (end->address == name);
+        };
+        if (!is_linked(ends[0]) && !is_linked(ends[1])) {
+            continue;
+        }
+        for (auto&& end: ends) {
+            if (is_linked(end)) {
+                add_needed(end->ports, needed);
+            }
+        }
+        const auto target = compiler.targets[first_channel + index];
+        const auto& recipe = *compiler.recipes[target];
+        if (std::holds_alternative<detail::pipe_recipe>(recipe)) {
+            const auto add_dup2 = [&](io side, const std::set<port_id>& ids){
+                for (auto&& port: ids) {
+                    if (const auto id = std::get_if<reference_descriptor>(&port)) {
+                        result.fixups.push_back({size(actions), target, side});
+                        actions.emplace_back(detail::dup2_action{-1, int(*id)});
+                    }
+                }
+            };
+            if (is_linked(ends[0])) { // src
+                add_dup2(io::write, ends[0]->ports);
+            }
+            if (is_linked(ends[1])) { // dst
+                add_dup2(io::read, ends[1]->ports);
+            }
+            continue;
+        }
+        if (const auto file_p = std::get_if<file_channel>(&recipe)) {
+            add_actions(name, links[index], *file_p, actions, notes);
+            continue;
+        }
+        notes << "found UNKNOWN channel type!!!!\n";
+    }
+    // Unlinked ports use the parent's descriptors.
+    for (auto&& entry: ports) {
+        if (const auto p = std::get_if<reference_descriptor>(&entry.first)) {
+            if (int(*p) >= 0) {
+                needed.push_back(unsigned(*p));
+            }
+        }
+    }
+    std::sort(begin(needed), end(needed));
+    result.notes = notes.str();
+}
+
+auto plan_executable(const node_name& name,
+                     const port_map& interface,
+                     const executable& implementation,
+                     const environment_map& env,
+                     const std::span<const link>& links,
+                     std::size_t first_channel,
+                     const plan_compiler& compiler,
+                     planned_executable& result) -> void
+{
+    std::ostringstream failure;
+    auto found = find_file(implementation.file, env, failure);
+    if (!found) {
+        result.failure = failure.str();
+        return;
+    }
+    result.file = std::move(*found);
+    result.args = detail::get_arg_block(implementation.arguments,
+                                        result.file.path.native());
+    result.envp = detail::get_env_block(env);
+    result.substituting = has_substitutions(result.args->strings());
+    plan_child_actions(name, interface, links, first_channel, compiler,
+                       result);
+    if (!implementation.working_directory.empty()) {
+        result.working_directory = implementation.working_directory.c_str();
+    }
+    result.start = implementation.start;
+    result.restart = implementation.restart;
+    result.limits = implementation.limits;
+    result.placement = implementation.placement;
+    result.scheduling = implementation.scheduling;
+}
+
+auto plan_system(const node_name& name,
+                 const port_map& interface,
+                 const system& implementation,
+                 const std::span<const link>& parent_links,
+                 std::size_t parent_first_channel,
+                 const port_map& parent_ports,
+                 plan_compiler& compiler,
+                 planned_system& result) -> void;
+
+/// @brief Plans the named node of a system like <code>make_child</code>
+///   makes its instance.
+auto plan_child(const node_name& name,
+                const node& node,
+                const system& parent,
+                std::size_t parent_first_channel,
+                const port_map& parent_ports,
+                plan_compiler& compiler,
+                planned_node& result) -> void
+{
+    const auto all_closed = confirm_closed(name, node.interface,
+                                           parent.links, parent_ports);
+    std::visit(detail::overloaded{
+        [&](const executable& implementation) {
+            if (!implementation.file.has_filename()) {
+                std::ostringstream os;
+                os << "cannot instantiate ";
+                os << name;
+                os << ": executable file path ";
+                throw_has_no_filename(implementation.file, os.str());
+            }
+            std::ostringstream os;
+            os << "cannot instantiate " << name << ": ";
+            confirm_placeable(implementation.placement, os.str());
+            confirm_schedulable(implementation.scheduling, os.str());
+            plan_executable(name, node.interface, implementation,
+                            parent.environment, parent.links,
+                            parent_first_channel, compiler,
+                            result.info.emplace<planned_executable>());
+        },
+        [&](const system& implementation) {
+            auto& planned = result.info.emplace<planned_system>();
+            planned.all_closed = all_closed;
+            plan_system(name, node.interface, implementation, parent.links,
+                        parent_first_channel, parent_ports, compiler,
+                        planned);
+        },
+        [&](const builtin&) {
+            result.info.emplace<planned_builtin>();
+        }
+    }, node.implementation);
+}
+
+auto plan_system(const node_name& name,
+                 const port_map& interface,
+                 const system& implementation,
+                 const std::span<const link>& parent_links,
+                 std::size_t parent_first_channel,
+                 const port_map& parent_ports,
+                 plan_compiler& compiler,
+                 planned_system& result) -> void
+{
+    result.first_channel = size(compiler.recipes);
+    result.channels.reserve(size(implementation.links));
+    for (auto&& link: implementation.links) {
+        const auto& recipe = result.channels.emplace_back(
+            detail::plan_channel(link, name, interface, implementation,
+                                 parent_links));
+        const auto ref = std::get_if<detail::reference_recipe>(&recipe);
+        compiler.targets.push_back(ref
+            ? compiler.targets[parent_first_channel + ref->index]
+            : size(compiler.recipes));
+        compiler.recipes.push_back(&recipe);
+    }
+    // Children are planned in place, so nothing planned ever moves.
+    result.children.reserve(size(implementation.nodes));
+    for (auto&& entry: implementation.nodes) {
+        plan_child(entry.first, entry.second, implementation,
+                   result.first_channel, parent_ports, compiler,
+                   result.children.emplace_back());
+    }
+}
+
+auto make_instance(const planned_node& planned,
+                   const node& node,
+                   const std::span<channel>& parent_channels,
+                   std::vector<channel*>& channels) -> instance
+{
+    return std::visit(detail::overloaded{
+        [](const planned_executable&) {
+            return instance{instance::forked{ext::temporary_fstream(), {}, {}, {}, {}}};
+        },
+        [](const planned_builtin&) {
+            return instance{instance::builtin{
+                std::make_unique<ext::fstream>(ext::temporary_fstream()), {}, {}
+            }};
+        },
+        [&](const planned_system& sys_plan) {
+            const auto& sys = std::get<flow::system>(node.implementation);
+            instance result;
+            auto& info = result.info.emplace<instance::system>();
+            if (!sys_plan.all_closed) {
+                info.pgrp = current_process_id();
+            }
+            const auto max_index = size(sys_plan.channels);
+            info.channels.reserve(max_index);
+            for (auto index = 0u; index < max_index; ++index) {
+                channels[sys_plan.first_channel + index] =
+                    &info.channels.emplace_back(detail::make_channel(
+                        sys.links[index], sys_plan.channels[index],
+                        info.channels, parent_channels));
+            }
+            auto planned_child = begin(sys_plan.children);
+            for (auto&& entry: sys.nodes) {
+                info.children.emplace(entry.first,
+                                      make_instance(*planned_child++,
+                                                    entry.second,
+                                                    info.channels, channels));
+            }
+            return result;
+        }
+    }, planned.info);
+}
+
+auto create_process(const planned_executable& planned,
+                    instance& child,
+                    reference_process_id& pgrp,
+                    const std::vector<channel*>& channels,
+                    process_creation creation,
+                    std::ostream& diags) -> void
+{
+    if (!empty(planned.failure)) {
+        diags << planned.failure;
+        return;
+    }
+    auto& child_info = std::get<instance::forked>(child.info);
+    child_info.diags << planned.notes;
+    auto actions = planned.actions;
+    actions.front() = detail::setpgid_action{pgrp};
+    for (auto&& fixup: planned.fixups) {
+        const auto& pipe = std::get<pipe_channel>(*channels[fixup.channel]);
+        std::get<detail::dup2_action>(actions[fixup.action]).fd =
+            int(pipe.get(fixup.side));
+    }
+    auto kept = kept_descriptors{
+        .diags = child_info.diags.native_handle(),
+        .exe = planned.file.descriptor? int(*planned.file.descriptor): -1,
+        .cgroup = child_info.cgroup? int(child_info.cgroup->directory): -1,
+        .duplicates = {},
+    };
+    if (!keep_clear_of_targets(actions, planned.fixups, kept,
+                               child_info.diags)) {
+        return;
+    }
+    auto needed = planned.needed;
+    for (const auto fd: {kept.diags, kept.exe, kept.cgroup}) {
+        if (fd >= 0) {
+            needed.insert(std::upper_bound(begin(needed), end(needed),
+                                           unsigned(fd)),
+                          unsigned(fd));
+        }
+    }
+    add_close_range_actions(needed, actions);
+    if (planned.working_directory) {
+        actions.emplace_back(detail::chdir_action{planned.working_directory});
+    }
+    if (kept.cgroup >= 0) {
+        actions.emplace_back(detail::cgroup_action{kept.cgroup});
+    }
+    add_placement_actions(planned.placement, actions);
+    add_scheduling_actions(planned.scheduling, actions);
+    start_child(planned.file, planned.args, planned.envp,
+                planned.substituting, actions, planned.fixups, kept,
+                planned.start, planned.restart, planned.limits, child_info,
+                pgrp, creation, diags);
+}
+
+auto create_processes(const planned_system& planned,
+                      const system& system,
+                      instance& object,
+                      const std::vector<channel*>& channels,
+                      process_creation creation,
+                      std::ostream& diags) -> void
+{
+    auto& info = std::get<instance::system>(object.info);
+    // Like fork_executables, children starting on data go last.
+    for (const auto policy: {start_policy::eager, start_policy::on_data}) {
+        auto planned_child = begin(planned.children);
+        auto child = begin(info.children);
+        for (auto&& entry: system.nodes) {
+            std::visit(detail::overloaded{
+                [&](const planned_executable& arg) {
+                    if (arg.start == policy) {
+                        create_process(arg, child->second, info.pgrp,
+                                       channels, creation, diags);
+                    }
+                },
+                [&](const planned_system& arg) {
+                    if (policy == start_policy::eager) {
+                        create_processes(arg,
+                                         std::get<flow::system>(entry.second.implementation),
+                                         child->second, channels, creation,
+                                         diags);
+                    }
+                },
+                [&](const planned_builtin&) {
+                    // Started by start_builtins instead.
+                }
+            }, planned_child->info);
+            ++planned_child;
+            ++child;
+        }
+    }
+}
+
+auto is_limited(const executable& implementation) -> bool
+{
+    return implementation.resources != resource_limits{};
+}
+
+/// @brief Whether the given system, or any of its descendants, has
+///   resource limits.
+auto is_limited(const system& implementation) -> bool
+{
+    if (implementation.resources != resource_limits{}) {
+        return true;
+    }
+    return std::any_of(begin(implementation.nodes), end(implementation.nodes),
+                       [](const auto& entry){
+        return std::visit(detail::overloaded{
+            [](const executable& arg) {
+                return is_limited(arg);
+            },
+            [](const system& arg) {
+                return is_limited(arg);
+            },
+            [](const builtin&) {
+                return false;
+            },
+        }, entry.second.implementation);
+    });
+}
+
+auto controllers_of(const executable& implementation)
+    -> detail::controller_set
+{
+    return detail::controllers_of(implementation.resources);
+}
+
+/// @brief Gets the controllers needed by the limits of the given system &
+///   of its descendants.
+auto controllers_of(const system& implementation) -> detail::controller_set
+{
+    auto result = detail::controllers_of(implementation.resources);
+    for (auto&& entry: implementation.nodes) {
+        const auto& node = entry.second;
+        if (const auto p = std::get_if<executable>(&node.implementation)) {
+            result |= controllers_of(*p);
+        }
+        else if (const auto p = std::get_if<system>(&node.implementation)) {
+            result |= controllers_of(*p);
+        }
+    }
+    return result;
+}
+
+auto make_cgroups(const executable& implementation,
+                  instance& object,
+                  const std::filesystem::path& path,
+                  std::shared_ptr<const detail::control_group> parent,
+                  detail::controller_set,
+                  std::ostream& diags) -> void
+{
+    std::get<instance::forked>(object.info).cgroup =
+        detail::make_control_group(path, implementation.resources,
+                                   std::move(parent), diags);
+}
+
+/// @brief Makes the control groups of the given instance of the given
+///   system & of its descendants.
+/// @details Every process gets a group of its own. So no group with
+///   processes in it has groups within it, as cgroup v2 requires of groups
+///   with controllers enabled for those within.
+auto make_cgroups(const system& implementation,
+                  instance& object,
+                  const std::filesystem::path& path,
+                  std::shared_ptr<const detail::control_group> parent,
+                  detail::controller_set controllers,
+                  std::ostream& diags) -> void
+{
+    auto& info = std::get<instance::system>(object.info);
+    info.cgroup = detail::make_control_group(path, implementation.resources,
+                                             std::move(parent), diags);
+    if (!info.cgroup) {
+        return;
+    }
+    // Those that couldn't be enabled for this group can't be for any
+    // within it either.
+    controllers = detail::enable_controllers(path, controllers, diags);
+    for (auto&& entry: implementation.nodes) {
+        const auto found = info.children.find(entry.first);
+        if (found == info.children.end()) {
+            continue;
+        }
+        const auto sub_path = path / entry.first.get();
+        std::visit(detail::overloaded{
+            [&](const executable& arg) {
+                make_cgroups(arg, found->second, sub_path, info.cgroup,
+                             controllers, diags);
+            },
+            [&](const system& arg) {
+                make_cgroups(arg, found->second, sub_path, info.cgroup,
+                             controllers, diags);
+            },
+            [](const builtin&) {
+                // Built-ins run within this process, so aren't limited.
+            },
+        }, entry.second.implementation);
+    }
+}
+
+/// @brief Makes the control groups of the given instance of the given
+///   executable or system, if it has resource limits, within the given
+///   control group directory.
+/// @param[in] parent Directory to make them within, else empty for this
+///   process's own control group.
+/// @note Controllers aren't enabled for this process's own control group,
+///   unless it's the root group. The kernel only allows that for groups
+///   without processes, & this process is in it. So limits then aren't
+///   enforced, & the groups are just for accounting.
+template <class T>
+auto make_cgroups(const T& implementation,
+                  instance& object,
+                  const std::filesystem::path& parent,
+                  std::ostream& diags) -> void
+{
+    if (!is_limited(implementation)) {
+        return;
+    }
+    const auto base = parent.empty()? detail::find_own_cgroup(): parent;
+    if (base.empty()) {
+        diags << "can't find control group to limit resources within\n";
+        return;
+    }
+    auto controllers = controllers_of(implementation);
+    if (parent.empty() && (controllers != detail::controller_set{}) &&
+        !detail::is_root_cgroup(base)) {
+        diags << "can't enforce resource limits within own control group ";
+        diags << base << ", which has this process in it: set ";
+        diags << "instantiate_options::cgroup to a group delegated to ";
+        diags << "this process that it's not in\n";
+        controllers = {};
+    }
+    controllers = detail::enable_controllers(base, controllers, diags);
+    make_cgroups(implementation, object, base / detail::make_cgroup_name(),
+                 {}, controllers, diags);
+}
+
 auto instantiate(const port_map& ports,
                  const executable& impl,
                  std::ostream& diags,
@@ -713,11 +1966,28 @@ auto instantiate(const port_map& ports,
     if (!impl.file.has_filename()) {
         throw_has_no_filename(impl.file, "executable file path ");
     }
+    confirm_placeable(impl.placement);
+    confirm_schedulable(impl.scheduling);
     const auto all_closed = confirm_closed({}, ports, {}, opts.ports);
-    result.info = instance::forked{ext::temporary_fstream(), {}};
+    result.info = instance::forked{ext::temporary_fstream(), {}, {}, {}, {}};
     auto pgrp = all_closed? no_process_id: current_process_id();
+    make_cgroups(impl, result, opts.cgroup, diags);
     fork_child({}, ports, impl, opts.environment, result, pgrp, {}, {},
-               result, diags);
+               opts.creation, diags);
+    return result;
+}
+
+auto instantiate(const port_map& ports,
+                 const builtin& impl,
+                 std::ostream&,
+                 const instantiate_options& opts) -> instance
+{
+    instance result;
+    confirm_closed({}, ports, {}, opts.ports);
+    result.info = instance::builtin{
+        std::make_unique<ext::fstream>(ext::temporary_fstream()), {}, {}
+    };
+    start_builtin({}, ports, impl, {}, {}, result);
     return result;
 }
 
@@ -747,8 +2017,12 @@ auto instantiate(const port_map& ports,
                               make_child(result, sub_name, sub_node,
                                          impl.links, opts.ports));
     }
-    fork_executables(impl, result, result, diags);
-    // Only now, after making child processes,
+    make_cgroups(impl, result, opts.cgroup, diags);
+    fork_executables(impl, result, opts.creation, diags);
+    // Start built-ins after forking so children don't inherit their
+    // descriptors at all.
+    start_builtins(impl, result, diags);
+    // Only now, after making child processes & starting built-ins,
     // close parent side of pipe_channels...
     close_all_internal_ends(info, impl, diags);
     return result;
@@ -756,19 +2030,133 @@ auto instantiate(const port_map& ports,
 
 }
 
+
 auto instantiate(const node& node,
                  std::ostream& diags,
                  const instantiate_options& opts)
     -> instance
 {
-    return std::visit(detail::overloaded{
+    const auto start = std::chrono::steady_clock::now();
+    auto result = std::visit(detail::overloaded{
         [&](const executable& implementation) {
             return instantiate(node.interface, implementation, diags, opts);
         },
         [&](const system& implementation) {
             return instantiate(node.interface, implementation, diags, opts);
+        },
+        [&](const builtin& implementation) {
+            return instantiate(node.interface, implementation, diags, opts);
         }
     }, node.implementation);
+    if (opts.deadline.count() > 0) {
+        set_deadline(result, detail::deadline_after(start, opts.deadline),
+                     opts.kill_grace);
+    }
+    return result;
+}
+
+struct plan::impl
+{
+    /// @brief Copy of the compiled node, which the plan refers into.
+    node root;
+
+    process_creation creation{};
+
+    std::chrono::nanoseconds deadline{};
+
+    std::chrono::nanoseconds kill_grace{};
+
+    std::filesystem::path cgroup;
+
+    /// @brief Whether the ports of a root executable are all closed.
+    bool all_closed{};
+
+    std::size_t total_channels{};
+
+    planned_node compiled;
+};
+
+auto compile(const node& node, const instantiate_options& opts) -> plan
+{
+    auto result = std::make_shared<plan::impl>();
+    result->root = node;
+    result->creation = opts.creation;
+    result->deadline = opts.deadline;
+    result->kill_grace = opts.kill_grace;
+    result->cgroup = opts.cgroup;
+    const auto& root = result->root;
+    auto compiler = plan_compiler{};
+    std::visit(detail::overloaded{
+        [&](const executable& implementation) {
+            if (!implementation.file.has_filename()) {
+                throw_has_no_filename(implementation.file,
+                                      "executable file path ");
+            }
+            confirm_placeable(implementation.placement);
+            confirm_schedulable(implementation.scheduling);
+            result->all_closed = confirm_closed({}, root.interface, {},
+                                                opts.ports);
+            plan_executable({}, root.interface, implementation,
+                            opts.environment, {}, 0u, compiler,
+                            result->compiled.info.emplace<planned_executable>());
+        },
+        [&](const system& implementation) {
+            auto& planned = result->compiled.info.emplace<planned_system>();
+            planned.all_closed = confirm_closed({}, root.interface,
+                                                implementation.links,
+                                                opts.ports);
+            plan_system({}, root.interface, implementation, {}, 0u,
+                        opts.ports, compiler, planned);
+        },
+        [&](const builtin&) {
+            confirm_closed({}, root.interface, {}, opts.ports);
+            result->compiled.info.emplace<planned_builtin>();
+        }
+    }, root.implementation);
+    result->total_channels = size(compiler.recipes);
+    return plan{std::move(result)};
+}
+
+auto instantiate(const plan& plan, std::ostream& diags) -> instance
+{
+    if (!plan.pimpl) {
+        throw std::invalid_argument{"plan not compiled"};
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto& impl = *plan.pimpl;
+    const auto& root = impl.root;
+    auto channels = std::vector<channel*>(impl.total_channels);
+    auto result = make_instance(impl.compiled, root, {}, channels);
+    std::visit(detail::overloaded{
+        [&](const planned_executable& planned) {
+            auto pgrp = impl.all_closed? no_process_id: current_process_id();
+            make_cgroups(std::get<executable>(root.implementation), result,
+                         impl.cgroup, diags);
+            create_process(planned, result, pgrp, channels, impl.creation,
+                           diags);
+        },
+        [&](const planned_system& planned) {
+            const auto& implementation = std::get<flow::system>(root.implementation);
+            make_cgroups(implementation, result, impl.cgroup, diags);
+            create_processes(planned, implementation, result, channels,
+                             impl.creation, diags);
+            // Like instantiating the node, start built-ins after creating
+            // processes & only then close the parent's internal pipe ends.
+            start_builtins(implementation, result, diags);
+            close_all_internal_ends(std::get<instance::system>(result.info),
+                                    implementation, diags);
+        },
+        [&](const planned_builtin&) {
+            start_builtin({}, root.interface,
+                          std::get<builtin>(root.implementation), {}, {},
+                          result);
+        }
+    }, impl.compiled.info);
+    if (impl.deadline.count() > 0) {
+        set_deadline(result, detail::deadline_after(start, impl.deadline),
+                     impl.kill_grace);
+    }
+    return result;
 }
 
 }
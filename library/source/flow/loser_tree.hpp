@@ -0,0 +1,77 @@
+#ifndef loser_tree_hpp
+#define loser_tree_hpp
+
+#include <cstddef> // for std::size_t
+#include <utility> // for std::move, std::swap
+#include <vector>
+
+namespace flow::detail {
+
+/// @brief Tournament tree of losers for merging k ordered sources.
+/// @details Finding the next element to output takes only one comparison per
+///   level of the tree - i.e. log2(k) comparisons - since each internal node
+///   remembers the loser of the match played there. Leaves are the sources.
+/// @tparam Less Predicate called with two source indices that returns
+///   whether the current head of the first source orders before that of the
+///   second. It must order exhausted sources after all others.
+/// @see https://en.wikipedia.org/wiki/K-way_merge_algorithm.
+template <class Less>
+struct loser_tree
+{
+    loser_tree(std::size_t k, Less less_):
+        losers(k), less{std::move(less_)}
+    {
+        if (k > 0u) {
+            champion = build(1u);
+        }
+    }
+
+    /// @brief Index of the source whose head is to be output next.
+    [[nodiscard]] auto winner() const noexcept -> std::size_t
+    {
+        return champion;
+    }
+
+    /// @brief Replays the matches along the winner's path to the root.
+    /// @note Call this after the winner's source has advanced.
+    auto replay() -> void
+    {
+        const auto k = size(losers);
+        auto contender = champion;
+        for (auto node = (contender + k) / 2u; node > 0u; node /= 2u) {
+            if (less(losers[node], contender)) {
+                std::swap(losers[node], contender);
+            }
+        }
+        champion = contender;
+    }
+
+private:
+    auto build(std::size_t node) -> std::size_t
+    {
+        const auto k = size(losers);
+        if (node >= k) {
+            return node - k;
+        }
+        const auto lhs = build(node * 2u);
+        const auto rhs = build(node * 2u + 1u);
+        if (less(rhs, lhs)) {
+            losers[node] = lhs;
+            return rhs;
+        }
+        losers[node] = rhs;
+        return lhs;
+    }
+
+    /// @brief Losers of the match at each internal node.
+    /// @note Element zero is unused.
+    std::vector<std::size_t> losers;
+
+    std::size_t champion{};
+
+    Less less;
+};
+
+}
+
+#endif /* loser_tree_hpp */
@@ -22,6 +22,9 @@ auto operator<<(std::ostream& os, const node& value)
     else if (const auto p = std::get_if<system>(&(value.implementation))) {
         os << *p;
     }
+    else if (const auto p = std::get_if<builtin>(&(value.implementation))) {
+        os << *p;
+    }
     else {
         os << "{}";
     }
@@ -117,6 +120,10 @@ auto pretty_print(std::ostream& os, const node& value) -> void
         }
         os << "  }\n";
     }
+    else if (const auto p = std::get_if<builtin>(&value.implementation)) {
+        os << top_prefix;
+        os << "  .implementation=" << *p << "\n";
+    }
     os << "}\n";
 }
 
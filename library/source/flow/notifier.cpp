@@ -0,0 +1,31 @@
+#include <utility> // for std::move
+
+#include "notifier.hpp"
+
+namespace flow::detail {
+
+auto notifier::set(std::function<void()> callback) -> void
+{
+    const std::lock_guard lock{mutex};
+    function = std::move(callback);
+    if (changed && function) {
+        function();
+    }
+}
+
+auto notifier::notify() -> void
+{
+    const std::lock_guard lock{mutex};
+    changed = true;
+    if (function) {
+        function();
+    }
+}
+
+auto notifier::notified() const -> bool
+{
+    const std::lock_guard lock{mutex};
+    return changed;
+}
+
+}
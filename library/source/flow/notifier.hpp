@@ -0,0 +1,34 @@
+#ifndef notifier_hpp
+#define notifier_hpp
+
+#include <functional>
+#include <mutex>
+
+namespace flow::detail {
+
+/// @brief Notifier of changes, to whatever function's been set for them.
+/// @note This is thread-safe.
+struct notifier
+{
+    /// @brief Sets the function to call for changes, replacing any other.
+    /// @note If there's already been a change, it's called right away.
+    /// @note Once this returns, any function this replaced isn't called
+    ///   anymore. So this must not be called from the function itself.
+    auto set(std::function<void()> callback) -> void;
+
+    /// @brief Notifies of a change, calling the set function if any.
+    /// @note The function's called from the calling thread.
+    auto notify() -> void;
+
+    /// @brief Whether there's been any change.
+    [[nodiscard]] auto notified() const -> bool;
+
+private:
+    mutable std::mutex mutex;
+    std::function<void()> function;
+    bool changed{};
+};
+
+}
+
+#endif /* notifier_hpp */
@@ -1,26 +1,60 @@
 #include <pthread.h>
-#include <unistd.h> // for pid_t
+#include <unistd.h> // for pid_t, ::syscall
 
+#include <linux/sched.h> // for clone_args, CLONE_INTO_CGROUP
+#include <sys/epoll.h> // for EPOLLIN
+#include <sys/eventfd.h>
+#include <sys/resource.h> // for rusage
+#include <sys/syscall.h> // for SYS_pidfd_open, SYS_clone3, ...
+#include <sys/timerfd.h>
 #include <sys/wait.h>
 
+#include <algorithm> // for std::min
+#include <atomic>
 #include <cerrno> // for errno
+#include <chrono>
+#include <cstdint> // for std::uint64_t
+#include <cstdlib> // for std::getenv, EXIT_SUCCESS
 #include <condition_variable>
 #include <csignal>
+#include <deque>
 #include <functional> // for std::reference_wrapper
 #include <future>
+#include <iostream> // for std::cerr
 #include <mutex>
+#include <optional>
 #include <queue>
-#include <set>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
 #include <utility> // for std::exchange
 
 #include "flow/owning_process_id.hpp"
 #include "flow/utility.hpp"
 
+#include "deadline.hpp"
+#include "deferred_process.hpp"
+#include "event_loop.hpp"
+#include "notifier.hpp"
+#include "process_supervisor.hpp"
+#include "process_status.hpp"
+
+#if defined(SYS_pidfd_open)
+#define FLOW_HAS_PIDFD_OPEN 1
+#endif
+
 namespace flow {
 
 struct owning_process_id::impl
 {
-    impl(reference_process_id id);
+    struct deferred_tag {};
+    struct supervision;
+
+    impl(reference_process_id id, owning_descriptor fd = {});
+
+    /// @brief Makes this for a process whose creation is deferred.
+    explicit impl(deferred_tag);
+
     ~impl() noexcept;
 
     mutable std::mutex mutex;
@@ -28,21 +62,366 @@ struct owning_process_id::impl
     reference_process_id pid{default_process_id};
     std::queue<wait_status> statuses;
     wait_status last_status{default_status};
+    owning_descriptor pidfd;
+
+    /// @brief Resource usage of the process once it's terminated.
+    process_usage usage;
+
+    /// @brief Whether the process is yet to be created or cancelled.
+    bool deferred{};
+
+    /// @brief Timer for the deadline of the process, if one's been set.
+    owning_descriptor deadline_timer;
+
+    /// @brief Watch of the deadline timer, if one's been set.
+    std::optional<detail::watch_id> deadline_watch;
+
+    /// @brief How long after <code>SIGTERM</code> to send
+    ///   <code>SIGKILL</code>.
+    std::chrono::nanoseconds kill_grace{};
+
+    /// @brief Whether the deadline passed before the process started.
+    bool deadline_passed{};
+
+    /// @brief Whether <code>SIGTERM</code> has been sent for the deadline.
+    bool terminating{};
+
+    /// @brief Notifier of state changes of the process.
+    /// @note Notified with the mutex held, so the impl can't be destroyed
+    ///   mid-notification.
+    detail::notifier changes;
+
+    /// @brief Supervision of the process, if it's to be restarted.
+    std::unique_ptr<supervision> supervisor;
+
+    /// @brief Number of times the process has been restarted.
+    std::size_t restarts{};
+
+    /// @brief Number of waits for the process that report it stopping.
+    std::size_t stop_waiters{};
+};
+
+/// @brief Supervision of a process that's to be restarted when it
+///   terminates.
+/// @see detail::process_supervisor.
+struct owning_process_id::impl::supervision
+{
+    restart_policy policy{};
+    restart_limits limits;
+    detail::respawn_function respawn;
+
+    /// @brief Timer for the backoff before restarting.
+    owning_descriptor timer;
+
+    /// @brief Watch of the timer.
+    std::optional<detail::watch_id> watch;
+
+    /// @brief Times of the restarts within the window of the limits.
+    std::deque<std::chrono::steady_clock::time_point> restarted;
+
+    /// @brief Backoff before the next restart.
+    std::chrono::nanoseconds backoff{};
+
+    /// @brief When the current process was started.
+    std::chrono::steady_clock::time_point started;
+
+    /// @brief Identifier of the terminated process to replace.
+    reference_process_id held_pid{invalid_process_id};
+
+    /// @brief Status of the terminated process to replace.
+    wait_status held_status{wait_unknown_status{}};
+
+    /// @brief Whether backing off before replacing a terminated process.
+    bool backing_off{};
+
+    /// @brief Whether restarting has stopped for good.
+    bool stopped{};
 };
 
 static_assert(!std::is_default_constructible_v<owning_process_id::impl>);
 
-auto wait(owning_process_id::impl& impl, wait_option flags = wait_option{})
-    -> wait_status
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+auto is_terminal(const wait_status& status) noexcept -> bool
+{
+    return std::holds_alternative<wait_exit_status>(status) ||
+           std::holds_alternative<wait_signaled_status>(status);
+}
+
+/// @brief Arms the given timer to expire at the given time.
+/// @note Steady clock time points are of <code>CLOCK_MONOTONIC</code>.
+auto arm(const owning_descriptor& timer, clock::time_point when) -> bool
+{
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    using std::chrono::seconds;
+    const auto since_epoch = when.time_since_epoch();
+    const auto secs = duration_cast<seconds>(since_epoch);
+    auto spec = itimerspec{};
+    spec.it_value.tv_sec = secs.count();
+    spec.it_value.tv_nsec = duration_cast<nanoseconds>(since_epoch - secs).count();
+    if ((spec.it_value.tv_sec <= 0) && (spec.it_value.tv_nsec <= 0)) {
+        spec.it_value.tv_nsec = 1; // Zero would disarm the timer instead.
+    }
+    return ::timerfd_settime(int(timer), TFD_TIMER_ABSTIME, &spec, nullptr) != -1;
+}
+
+/// @brief Signals the process of the given impl, preferring its process
+///   descriptor like <code>send_signal</code> does.
+/// @note The impl's mutex must be held.
+auto signal_process(const owning_process_id::impl& impl, int sig) -> void
+{
+#if defined(SYS_pidfd_send_signal)
+    const auto rv = impl.pidfd
+        ? int(::syscall(SYS_pidfd_send_signal, // NOLINT(cppcoreguidelines-pro-type-vararg)
+                        int(impl.pidfd), sig, nullptr, 0u))
+        : ::kill(pid_t(impl.pid), sig);
+#else
+    const auto rv = ::kill(pid_t(impl.pid), sig);
+#endif
+    if ((rv == -1) && (errno != ESRCH)) {
+        std::cerr << "can't signal process " << impl.pid << ": ";
+        std::cerr << os_error_code(errno) << "\n";
+    }
+}
+
+auto is_failure(const wait_status& status) noexcept -> bool
+{
+    if (const auto p = std::get_if<wait_exit_status>(&status)) {
+        return p->value != EXIT_SUCCESS;
+    }
+    return std::holds_alternative<wait_signaled_status>(status);
+}
+
+/// @brief Stops restarting the process of the given impl.
+/// @details If backing off before replacing a terminated process, that
+///   process's termination is reported instead.
+/// @note The impl's mutex must be held.
+auto stop_restarting(owning_process_id::impl& impl) -> void
+{
+    auto& supervisor = *impl.supervisor;
+    supervisor.stopped = true;
+    // Releases what it holds, like duplicates of pipe descriptors.
+    supervisor.respawn = {};
+    if (supervisor.backing_off) {
+        supervisor.backing_off = false;
+        impl.pid = supervisor.held_pid;
+        impl.statuses.push(supervisor.held_status);
+        impl.deferred = false;
+        impl.changes.notify();
+        impl.cv.notify_all();
+    }
+}
+
+/// @brief Schedules replacing the terminated process of the given impl,
+///   if it's to be restarted.
+/// @note The impl's mutex must be held.
+/// @return Whether scheduled.
+auto schedule_restart(owning_process_id::impl& impl,
+                      const wait_status& status) -> bool
+{
+    auto& supervisor = *impl.supervisor;
+    if (supervisor.stopped || impl.terminating) {
+        return false;
+    }
+    switch (supervisor.policy) {
+    case restart_policy::never:
+        return false;
+    case restart_policy::on_failure:
+        if (!is_failure(status)) {
+            return false;
+        }
+        break;
+    case restart_policy::always:
+        break;
+    }
+    const auto& limits = supervisor.limits;
+    const auto now = clock::now();
+    if (limits.window.count() > 0) {
+        while (!empty(supervisor.restarted) &&
+               ((now - supervisor.restarted.front()) >= limits.window)) {
+            supervisor.restarted.pop_front();
+        }
+    }
+    if ((limits.max_restarts > 0u) &&
+        (size(supervisor.restarted) >= limits.max_restarts)) {
+        return false;
+    }
+    if ((now - supervisor.started) >= limits.max_backoff) {
+        supervisor.backoff = limits.initial_backoff;
+    }
+    if (!arm(supervisor.timer,
+             detail::deadline_after(now, supervisor.backoff))) {
+        std::cerr << "can't schedule restart of " << impl.pid << ": ";
+        std::cerr << os_error_code(errno) << "\n";
+        return false;
+    }
+    supervisor.backoff = std::min<std::chrono::nanoseconds>(
+        supervisor.backoff * 2, limits.max_backoff);
+    supervisor.held_pid = impl.pid;
+    supervisor.held_status = status;
+    supervisor.backing_off = true;
+    // Like a process whose creation is deferred, until it's replaced.
+    impl.pid = no_process_id;
+    impl.deferred = true;
+    return true;
+}
+
+/// @brief Takes the given new status of the process of the given impl.
+/// @details The termination of a process that's to be restarted isn't
+///   reported. Its replacement's scheduled instead.
+/// @note The impl's mutex must be held.
+auto take_status(owning_process_id::impl& impl, const wait_status& status)
+    -> void
+{
+    if (impl.supervisor && is_terminal(status)) {
+        if (schedule_restart(impl, status)) {
+            return;
+        }
+        stop_restarting(impl);
+    }
+    impl.statuses.push(status);
+    impl.changes.notify();
+}
+
+/// @brief Handles the deadline timer of the given impl expiring.
+/// @return Whether to keep watching the timer.
+auto handle_deadline(owning_process_id::impl& impl) -> bool
+{
+    auto expirations = std::uint64_t{};
+    const std::lock_guard lock{impl.mutex};
+    (void) ::read(int(impl.deadline_timer), &expirations, sizeof(expirations));
+    if (impl.supervisor) {
+        // Nothing's restarted past the deadline.
+        const auto backing_off = impl.supervisor->backing_off;
+        stop_restarting(impl);
+        if (backing_off) {
+            return false;
+        }
+    }
+    if (impl.deferred) {
+        // Terminated as soon as it starts, if it ever does.
+        impl.deadline_passed = true;
+        return true;
+    }
+    if ((impl.pid <= no_process_id) ||
+        (!empty(impl.statuses) && is_terminal(impl.statuses.back()))) {
+        return false;
+    }
+    if (!impl.terminating) {
+        impl.terminating = true;
+        signal_process(impl, SIGTERM);
+        return arm(impl.deadline_timer,
+                   detail::deadline_after(impl.kill_grace));
+    }
+    signal_process(impl, SIGKILL);
+    return false;
+}
+
+/// @brief Number of waits that report their processes stopping.
+/// @note Lets signals of children be ignored while there's none.
+std::atomic_size_t stop_waiters;
+
+/// @brief Takes the stop of the process of the given impl, if it's
+///   stopped & that's not been taken yet.
+/// @details Process descriptors only deliver exits. So this gets stops
+///   like waiting with <code>WUNTRACED</code> does, leaving exits to be
+///   reaped as usual.
+/// @note The impl's mutex must be held.
+/// @return Whether a stop was taken.
+auto take_stop(owning_process_id::impl& impl) -> bool
+{
+    if ((impl.pid <= no_process_id) ||
+        (!empty(impl.statuses) && is_terminal(impl.statuses.back()))) {
+        return false;
+    }
+    auto info = siginfo_t{};
+    auto rv = ::waitid(P_PID, id_t(pid_t(impl.pid)), &info, WSTOPPED|WNOHANG);
+    while ((rv == -1) && (errno == EINTR)) {
+        rv = ::waitid(P_PID, id_t(pid_t(impl.pid)), &info, WSTOPPED|WNOHANG);
+    }
+    // Nothing to take if the wait-any fallback's waited on it instead.
+    if ((rv == -1) || (info.si_pid == 0)) {
+        return false;
+    }
+    take_status(impl, wait_stopped_status{info.si_status});
+    return true;
+}
+
+/// @brief Registration of a wait for the process of an impl that reports
+///   it stopping.
+/// @details While registered, stops are taken whenever a child signals.
+/// @note The impl's mutex must be held when this is made & destroyed.
+struct stop_wait
+{
+    stop_wait(owning_process_id::impl& impl, bool enabled) noexcept:
+        pimpl{enabled? &impl: nullptr}
+    {
+        if (pimpl) {
+            ++pimpl->stop_waiters;
+            ++stop_waiters;
+        }
+    }
+
+    ~stop_wait() noexcept
+    {
+        if (pimpl) {
+            --stop_waiters;
+            --pimpl->stop_waiters;
+        }
+    }
+
+    stop_wait(const stop_wait&) = delete;
+    auto operator=(const stop_wait&) -> stop_wait& = delete;
+
+    explicit operator bool() const noexcept
+    {
+        return pimpl != nullptr;
+    }
+
+    /// @brief Impl whose process is waited on, else null if not registered.
+    owning_process_id::impl* pimpl{};
+};
+
+}
+
+/// @brief Waits for the process of the given impl to change state.
+/// @return Status it changed to, else nothing if the deadline passed first.
+auto wait(owning_process_id::impl& impl, wait_option flags,
+          const std::optional<clock::time_point>& deadline)
+    -> std::optional<wait_status>
 {
     std::unique_lock lk(impl.mutex);
+    const auto await = [&](const auto& predicate){
+        if (!deadline) {
+            impl.cv.wait(lk, predicate);
+            return true;
+        }
+        return impl.cv.wait_until(lk, *deadline, predicate);
+    };
+    if (impl.deferred) {
+        if ((flags & wait_options::nohang()) != wait_option{}) {
+            return impl.last_status;
+        }
+        if (!await([&impl]{ return !impl.deferred; })) {
+            return {};
+        }
+    }
     const auto pid = impl.pid;
     switch (pid) {
     case invalid_process_id:
     case no_process_id:
         return impl.last_status;
     }
+    // Process descriptors only deliver exits. So stops are taken here too.
+    const auto untraced = (flags & wait_options::untraced()) != wait_option{};
+    const auto stops = stop_wait{impl, untraced && bool(impl.pidfd)};
     if ((flags & wait_options::nohang()) != wait_option{}) {
+        if (stops) {
+            take_stop(impl);
+        }
         if (!empty(impl.statuses)) {
             impl.last_status = impl.statuses.front();
             impl.statuses.pop();
@@ -54,9 +433,12 @@ auto wait(owning_process_id::impl& impl, wait_option flags = wait_option{})
         return impl.last_status;
     };
     for (;;) {
-        impl.cv.wait(lk, [&impl]{
-            return !empty(impl.statuses);
-        });
+        if (stops) {
+            take_stop(impl);
+        }
+        if (!await([&impl]{ return !empty(impl.statuses); })) {
+            return {};
+        }
         impl.last_status = impl.statuses.front();
         impl.statuses.pop();
         if (std::holds_alternative<wait_exit_status>(impl.last_status) ||
@@ -64,7 +446,7 @@ auto wait(owning_process_id::impl& impl, wait_option flags = wait_option{})
             impl.pid = owning_process_id::default_process_id;
             return impl.last_status;
         };
-        if ((flags & wait_options::untraced()) != wait_option{}) {
+        if (untraced) {
             return impl.last_status;
         }
         if (!std::holds_alternative<wait_stopped_status>(impl.last_status) &&
@@ -74,35 +456,197 @@ auto wait(owning_process_id::impl& impl, wait_option flags = wait_option{})
     }
 }
 
+auto wait(owning_process_id::impl& impl, wait_option flags = wait_option{})
+    -> wait_status
+{
+    return *wait(impl, flags, std::nullopt);
+}
+
 namespace {
 
-auto count_alive(const std::set<owning_process_id::impl*>& impls)
-    -> std::size_t
+/// @brief Opens a process descriptor for the identified process.
+/// @return Descriptor that's invalid if it couldn't be opened, in which
+///   case <code>errno</code> says why.
+auto open_pidfd(reference_process_id pid) noexcept -> owning_descriptor
 {
-    auto count = std::size_t{};
-    for (auto&& impl: impls) {
-        const std::lock_guard lk{impl->mutex};
-        if (impl->pid > no_process_id) {
-            ++count;
+#if defined(FLOW_HAS_PIDFD_OPEN)
+    return owning_descriptor{int(::syscall(SYS_pidfd_open, // NOLINT(cppcoreguidelines-pro-type-vararg)
+                                           pid_t(pid), 0u))};
+#else
+    errno = ENOSYS;
+    return owning_descriptor{};
+#endif
+}
+
+/// @brief Status & resource usage of a terminated process.
+struct exit_info
+{
+    wait_status status{wait_unknown_status{}};
+    process_usage usage;
+};
+
+/// @brief Gets the status of the given child process if it's terminated.
+/// @note This doesn't block.
+/// @return Status & usage of the terminated process, else
+///   <code>wait_unknown_status</code> if it's not terminated, else nothing
+///   if it can't be waited on. Like once the wait-any fallback's reaped it.
+auto take_exit_info(reference_process_id pid) -> std::optional<exit_info>
+{
+    auto status = 0;
+    auto usage = ::rusage{};
+    auto rv = ::wait4(pid_t(pid), &status, WNOHANG, &usage);
+    while ((rv == -1) && (errno == EINTR)) {
+        rv = ::wait4(pid_t(pid), &status, WNOHANG, &usage);
+    }
+    if (rv == -1) {
+        if (errno != ECHILD) {
+            std::cerr << "wait4(" << pid << ") failed: ";
+            std::cerr << os_error_code(errno) << "\n";
         }
+        return {};
     }
-    return count;
+    if (rv == 0) {
+        return exit_info{};
+    }
+    return exit_info{
+        detail::to_wait_status(status), detail::to_process_usage(usage)
+    };
 }
 
+/// @brief Descriptor to write to whenever a child signals, else -1.
+/// @note Atomic since it's read by the signal handler.
+std::atomic_int child_signals_fd{-1};
+
+/// @brief Action for <code>SIGCHLD</code> that <code>on_child_signal</code>
+///   replaced & calls on to.
+struct sigaction replaced_child_action{};
+
+/// @brief Handler of <code>SIGCHLD</code> while process descriptors are
+///   in use.
+/// @note This only does what's safe for a signal handler to do.
+auto on_child_signal(int sig, siginfo_t* info, void* context) -> void
+{
+    const auto saved_errno = errno;
+    if (const auto fd = child_signals_fd.load(); fd != -1) {
+        const auto value = std::uint64_t{1};
+        (void) ::write(fd, &value, sizeof(value));
+    }
+    if ((replaced_child_action.sa_flags & SA_SIGINFO) != 0) {
+        replaced_child_action.sa_sigaction(sig, info, context);
+    }
+    else if ((replaced_child_action.sa_handler != SIG_DFL) && // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+             (replaced_child_action.sa_handler != SIG_IGN)) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+        replaced_child_action.sa_handler(sig);
+    }
+    errno = saved_errno;
+}
+
+/// @brief Manager of the processes of <code>owning_process_id</code>s.
+/// @details Each process is waited on via a process descriptor for it
+///   that's watched by the event loop. So exits are delivered per process
+///   as they happen. Where process descriptors aren't supported, or one
+///   can't be watched for a process, like for running out of descriptors,
+///   a thread instead waits on any child process & hands its statuses out.
+///   That thread's only started once it's needed. Setting the
+///   <code>FLOW_NO_PIDFDS</code> environment variable forces it.
+/// @note Only exits are delivered via process descriptors. So stops of
+///   processes are taken by waits that report them, & whenever a child
+///   signals while there's any. Continuing isn't reported, like it isn't
+///   by the fallback.
+/// @note Once the fallback's running, it reaps processes that are watched
+///   too. Their watches then just find nothing to wait on.
 struct manager
 {
     manager();
     ~manager() noexcept;
-    auto handle(const flow::info_wait_result& result) -> void;
-    auto handle(const flow::wait_result& result) -> void;
     auto insert(owning_process_id::impl* pimpl) -> bool;
     auto erase(owning_process_id::impl* pimpl) -> bool;
 
 private:
+    struct entry
+    {
+        /// @brief Identifier of the process when inserted.
+        pid_t pid{};
+
+        /// @brief Watch of the impl's process descriptor, if watched.
+        std::optional<detail::watch_id> watch;
+    };
+
+    /// @brief Hands out the given statuses of waiting on any child.
+    /// @note Their impls are found & notified with the mutex taken just
+    ///   once for all of them.
+    auto handle(const std::vector<info_wait_result>& results) -> void;
+
+    /// @brief Waits for & handles the next statuses of waiting on any
+    ///   child, including all others that are available without waiting.
+    auto reap_any() -> void;
+
+    /// @brief Watches the process descriptor of the given impl, opening
+    ///   one if it doesn't already have one.
+    /// @note The mutex must be held.
+    /// @return Identifier of the watch, else nothing if the descriptor
+    ///   can't be opened or watched.
+    auto watch(owning_process_id::impl& impl) -> std::optional<detail::watch_id>;
+
+    /// @brief Starts the thread that waits on any child, if not started.
+    /// @note The mutex must be held.
+    auto start_runner() -> void;
+
+    /// @brief Watches for children signalling, to take the stops of the
+    ///   processes of waits that report them.
+    /// @return Whether watching.
+    auto watch_child_signals() -> bool;
+
+    /// @brief Takes the stops of the processes of waits that report them,
+    ///   once a child's signalled.
+    /// @return Whether to keep watching for children signalling.
+    auto take_stops() -> bool;
+
+    /// @brief Takes the exit status of the given impl's process once its
+    ///   process descriptor says it's terminated.
+    /// @return Whether to keep watching the process descriptor.
+    static auto reap(owning_process_id::impl& impl) -> bool;
+
+    /// @brief Counts the impls whose processes haven't been waited on.
+    /// @note The mutex must be held.
+    auto count_alive() const -> std::size_t;
+
     std::mutex mutex;
     std::condition_variable cv;
     reference_process_id pid{current_process_id()};
-    std::set<owning_process_id::impl*> impls;
+
+    std::unordered_map<owning_process_id::impl*, entry> impls;
+
+    /// @brief Inserted impls by their process identifiers.
+    /// @note An identifier gets reused once its process has been waited
+    ///   on. So this refers to the last impl inserted with it.
+    std::unordered_map<pid_t, owning_process_id::impl*> pids;
+
+    /// @brief Whether processes are waited on via process descriptors.
+    bool using_pidfds{
+        !std::getenv("FLOW_NO_PIDFDS") && // NOLINT(concurrency-mt-unsafe)
+        bool(open_pidfd(current_process_id()))
+    };
+
+    struct orphan
+    {
+        std::queue<wait_status> statuses;
+        process_usage usage;
+    };
+
+    /// @brief Statuses of processes waited on by the runner before being
+    ///   inserted.
+    /// @note A child can terminate & be waited on before its spawner has
+    ///   made its impl. Particularly when spawning, since the spawner only
+    ///   resumes after the child has executed its file.
+    std::unordered_map<pid_t, orphan> orphans;
+
+    /// @brief Descriptor written to whenever a child signals.
+    owning_descriptor child_signals;
+
+    /// @brief Watch of <code>child_signals</code>, if watched.
+    std::optional<detail::watch_id> child_signals_watch;
+
     std::atomic_bool do_run{true};
     std::future<void> runner;
 };
@@ -110,17 +654,20 @@ private:
 manager::manager()
 {
     set_signal_handler(signals::child());
-    runner = std::async(std::launch::async, [&](){
-        const auto opts = wait_options::untraced();
-        while (do_run) {
-            handle(wait(invalid_process_id, opts));
-        }
-    });
+    if (!using_pidfds || !watch_child_signals()) {
+        // The runner reports stops itself.
+        const std::lock_guard lock{mutex};
+        start_runner();
+    }
 }
 
 manager::~manager() noexcept
 {
     if (pid == current_process_id()) {
+        child_signals_fd = -1;
+        if (child_signals_watch) {
+            detail::unwatch(*child_signals_watch);
+        }
         if (runner.valid()) {
             try {
                 do_run = false;
@@ -134,22 +681,161 @@ manager::~manager() noexcept
     }
 }
 
+auto manager::start_runner() -> void
+{
+    if (runner.valid()) {
+        return;
+    }
+    runner = std::async(std::launch::async, [&](){
+        while (do_run) {
+            reap_any();
+        }
+    });
+}
+
+auto manager::watch_child_signals() -> bool
+{
+    child_signals = owning_descriptor{::eventfd(0u, EFD_CLOEXEC|EFD_NONBLOCK)};
+    if (!child_signals) {
+        return false;
+    }
+    try {
+        child_signals_watch = detail::watch(int(child_signals), EPOLLIN,
+                                            [this](std::uint32_t){
+            return take_stops();
+        });
+    }
+    catch (const std::system_error&) {
+        return false;
+    }
+    child_signals_fd = int(child_signals);
+    struct sigaction sa{};
+    sa.sa_sigaction = on_child_signal;
+    sa.sa_flags = SA_SIGINFO|SA_RESTART;
+    sigfillset(&sa.sa_mask);
+    if (::sigaction(SIGCHLD, &sa, &replaced_child_action) == -1) {
+        child_signals_fd = -1;
+        detail::unwatch(*std::exchange(child_signals_watch, std::nullopt));
+        return false;
+    }
+    return true;
+}
+
+auto manager::take_stops() -> bool
+{
+    auto count = std::uint64_t{};
+    (void) ::read(int(child_signals), &count, sizeof(count));
+    if (stop_waiters == 0u) {
+        return true;
+    }
+    // Notified while locked, since impls can't be erased & destroyed then.
+    const std::lock_guard lock{mutex};
+    for (auto&& entry: impls) {
+        auto& impl = *entry.first;
+        {
+            const std::lock_guard impl_lock{impl.mutex};
+            if ((impl.stop_waiters == 0u) || !take_stop(impl)) {
+                continue;
+            }
+        }
+        impl.cv.notify_all();
+    }
+    return true;
+}
+
+auto manager::count_alive() const -> std::size_t
+{
+    auto count = std::size_t{};
+    for (auto&& entry: impls) {
+        const std::lock_guard lk{entry.first->mutex};
+        if (entry.first->pid > no_process_id) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+auto manager::reap(owning_process_id::impl& impl) -> bool
+{
+    auto process = reference_process_id{};
+    {
+        const std::lock_guard lock{impl.mutex};
+        process = impl.pid;
+    }
+    const auto info = take_exit_info(process);
+    if (!info) {
+        // The runner reaped it, so hands out its status instead.
+        return false;
+    }
+    if (std::holds_alternative<wait_unknown_status>(info->status)) {
+        return true;
+    }
+    {
+        const std::lock_guard lock{impl.mutex};
+        impl.usage += info->usage;
+        take_status(impl, info->status);
+    }
+    impl.cv.notify_all();
+    return false;
+}
+
+auto manager::watch(owning_process_id::impl& impl)
+    -> std::optional<detail::watch_id>
+{
+    auto fd = -1;
+    {
+        const std::lock_guard lock{impl.mutex};
+        if (!impl.pidfd) {
+            impl.pidfd = open_pidfd(impl.pid);
+        }
+        fd = int(impl.pidfd);
+    }
+    if (fd == -1) {
+        return {};
+    }
+    try {
+        return detail::watch(fd, EPOLLIN, [&impl](std::uint32_t){
+            return reap(impl);
+        });
+    }
+    catch (const std::system_error&) {
+        return {};
+    }
+}
+
 auto manager::insert(owning_process_id::impl* pimpl) -> bool
 {
     if (!pimpl || (reference_process_id(pimpl->pid) <= no_process_id)) {
         return false;
     }
-    auto first = false;
     {
         const std::lock_guard lock{mutex};
-        first = empty(impls);
-        if (!impls.insert(pimpl).second) {
+        const auto key = pid_t(pimpl->pid);
+        const auto [it, inserted] = impls.try_emplace(pimpl, entry{key, {}});
+        if (!inserted) {
             return false;
         }
+        pids[key] = pimpl;
+        if (const auto found = orphans.find(key); found != orphans.end()) {
+            const std::lock_guard impl_lock{pimpl->mutex};
+            pimpl->statuses = std::move(found->second.statuses);
+            pimpl->usage = found->second.usage;
+            pimpl->changes.notify();
+            orphans.erase(found);
+        }
+        if (using_pidfds) {
+            it->second.watch = watch(*pimpl);
+            if (it->second.watch) {
+                return true;
+            }
+            // Like for running out of descriptors. Have the runner wait
+            // on it instead of leaving it unreaped.
+            start_runner();
+        }
     }
-    if (first) {
-        cv.notify_one();
-    }
+    // Always notify, since the runner waits for a live process to be
+    // inserted even when the set has others that aren't alive anymore.
+    cv.notify_one();
     return true;
 }
 
@@ -158,46 +844,74 @@ auto manager::erase(owning_process_id::impl* pimpl) -> bool
     if (!pimpl) {
         return false;
     }
-    const std::lock_guard lock{mutex};
-    return impls.erase(pimpl) > 0u;
+    auto watched = std::optional<detail::watch_id>{};
+    {
+        const std::lock_guard lock{mutex};
+        const auto it = impls.find(pimpl);
+        if (it == impls.end()) {
+            return false;
+        }
+        if (const auto found = pids.find(it->second.pid);
+            (found != pids.end()) && (found->second == pimpl)) {
+            pids.erase(found);
+        }
+        watched = it->second.watch;
+        impls.erase(it);
+    }
+    // Unlocked since unwatching waits for any running handler.
+    if (watched) {
+        detail::unwatch(*watched);
+    }
+    return true;
 }
 
-auto manager::handle(const flow::info_wait_result& result) -> void
+auto manager::handle(const std::vector<info_wait_result>& results) -> void
 {
+    // Notified while locked, since impls can't be erased & destroyed then.
     const std::lock_guard lock{mutex};
-    const auto it = find_if(begin(impls), end(impls),
-                            [&result](const owning_process_id::impl *pimpl){
-        return pimpl->pid == result.id;
-    });
-    if (it == end(impls)) {
-        std::cerr << "not found in impls list?!\n";
-        return;
-    }
-    auto& impl = *(*it);
-    {
-        const std::lock_guard lock{impl.mutex};
-        impl.statuses.push(result.status);
+    for (auto&& result: results) {
+        const auto it = pids.find(pid_t(result.id));
+        if (it == pids.end()) {
+            auto& entry = orphans[pid_t(result.id)];
+            entry.statuses.push(result.status);
+            entry.usage += result.usage;
+            continue;
+        }
+        auto& impl = *(it->second);
+        {
+            const std::lock_guard impl_lock{impl.mutex};
+            impl.usage += result.usage;
+            take_status(impl, result.status);
+        }
+        impl.cv.notify_all();
     }
-    impl.cv.notify_one();
 }
 
-auto manager::handle(const flow::wait_result& result) -> void
+auto manager::reap_any() -> void
 {
-    std::visit(detail::overloaded{
-        [](auto) noexcept {},
-        [&](const nokids_wait_result&) {
+    const auto opts = wait_options::untraced();
+    auto results = std::vector<info_wait_result>{};
+    for (auto result = wait(invalid_process_id, opts);;
+         result = wait(invalid_process_id, opts|wait_options::nohang())) {
+        if (const auto p = std::get_if<info_wait_result>(&result)) {
+            results.push_back(*p);
+            continue;
+        }
+        if (std::holds_alternative<nokids_wait_result>(result) &&
+            empty(results)) {
             std::unique_lock lk(mutex);
             cv.wait(lk, [this]{
-                return (count_alive(impls) > 0) || !do_run;
+                return (count_alive() > 0) || !do_run;
             });
-        },
-        [](const error_wait_result& result) {
-            std::cerr << result << ": odd?\n";
-        },
-        [this](const info_wait_result& results) {
-            handle(results);
-        },
-    }, result);
+        }
+        else if (const auto p = std::get_if<error_wait_result>(&result)) {
+            std::cerr << *p << ": odd?\n";
+        }
+        break;
+    }
+    if (!empty(results)) {
+        handle(results);
+    }
 }
 
 auto the_manager() -> manager&
@@ -206,6 +920,55 @@ auto the_manager() -> manager&
     return singleton;
 }
 
+/// @brief Replaces the terminated process of the given impl once its
+///   backoff's over.
+/// @return Whether to keep watching the backoff timer.
+auto restart(owning_process_id::impl& impl) -> bool
+{
+    auto respawn = detail::respawn_function{};
+    {
+        const std::lock_guard lock{impl.mutex};
+        auto& supervisor = *impl.supervisor;
+        auto expirations = std::uint64_t{};
+        (void) ::read(int(supervisor.timer), &expirations, sizeof(expirations));
+        if (!supervisor.backing_off || supervisor.stopped) {
+            // Whoever stopped it reports the termination.
+            return !supervisor.stopped;
+        }
+        respawn = supervisor.respawn;
+    }
+    // Unlocked since creating a process takes a while.
+    auto created = respawn();
+    {
+        const std::lock_guard lock{impl.mutex};
+        auto& supervisor = *impl.supervisor;
+        if (created.pid == invalid_process_id) {
+            std::cerr << "can't restart process " << supervisor.held_pid;
+            std::cerr << ": " << os_error_code(errno) << "\n";
+            stop_restarting(impl);
+            return false;
+        }
+        impl.pid = created.pid;
+        impl.pidfd = std::move(created.pidfd);
+        ++impl.restarts;
+        supervisor.backing_off = false;
+        supervisor.started = clock::now();
+        if (supervisor.limits.max_restarts > 0u) {
+            supervisor.restarted.push_back(supervisor.started);
+        }
+    }
+    // Reinserted while still deferred, so the owner can't have gone yet.
+    the_manager().erase(&impl);
+    the_manager().insert(&impl);
+    {
+        const std::lock_guard lock{impl.mutex};
+        impl.deferred = false;
+        impl.changes.notify();
+    }
+    impl.cv.notify_all();
+    return true;
+}
+
 }
 
 auto owning_process_id::fork() -> reference_process_id
@@ -214,13 +977,75 @@ auto owning_process_id::fork() -> reference_process_id
     return reference_process_id{::fork()};
 }
 
-owning_process_id::impl::impl(reference_process_id id): pid{id}
+auto owning_process_id::fork(reference_descriptor cgroup)
+    -> reference_process_id
+{
+    the_manager();
+#if defined(SYS_clone3) && defined(CLONE_INTO_CGROUP)
+    auto args = clone_args{};
+    args.flags = CLONE_INTO_CGROUP;
+    args.exit_signal = SIGCHLD;
+    args.cgroup = std::uint64_t(int(cgroup));
+    if (const auto pid = ::syscall(SYS_clone3, &args, sizeof(args)); // NOLINT(cppcoreguidelines-pro-type-vararg)
+        pid != -1) {
+        return reference_process_id{int(pid)};
+    }
+#else
+    (void) cgroup;
+#endif
+    return reference_process_id{::fork()};
+}
+
+auto owning_process_id::spawn(const char *path,
+                              const posix_spawn_file_actions_t *file_actions,
+                              const posix_spawnattr_t *attrs,
+                              char * const *argv,
+                              char * const *envp) -> reference_process_id
+{
+    the_manager();
+    auto pid = pid_t{};
+    if (const auto err = ::posix_spawn(&pid, path, file_actions, attrs,
+                                       argv, envp); err != 0) {
+        errno = err;
+        return invalid_process_id;
+    }
+    return reference_process_id{pid};
+}
+
+owning_process_id::impl::impl(reference_process_id id, owning_descriptor fd):
+    pid{id}, pidfd{std::move(fd)}
 {
     the_manager().insert(this);
 }
 
+owning_process_id::impl::impl(deferred_tag):
+    pid{no_process_id}, deferred{true}
+{
+    // Intentionally empty.
+}
+
 owning_process_id::impl::~impl() noexcept
 {
+    auto restart_watch = std::optional<detail::watch_id>{};
+    {
+        const std::lock_guard lock{mutex};
+        if (supervisor) {
+            supervisor->stopped = true;
+            restart_watch = supervisor->watch;
+        }
+    }
+    if (restart_watch) {
+        // Waits for any running handler, which may be restarting.
+        detail::unwatch(*restart_watch);
+        const std::lock_guard lock{mutex};
+        stop_restarting(*this);
+    }
+    {
+        std::unique_lock lk(mutex);
+        cv.wait(lk, [this]{
+            return !deferred;
+        });
+    }
     for (;;) {
         if (pid == invalid_process_id || pid == no_process_id) {
             break;
@@ -240,6 +1065,10 @@ owning_process_id::impl::~impl() noexcept
         std::cerr << "impl::~impl()";
         std::cerr << ": call to the_manager().erase(this) threw exception\n";
     }
+    if (deadline_watch) {
+        // Waits for any running handler, which uses this.
+        detail::unwatch(*deadline_watch);
+    }
 }
 
 owning_process_id::owning_process_id()
@@ -253,6 +1082,14 @@ owning_process_id::owning_process_id(reference_process_id id):
     // Intentionally empty.
 }
 
+owning_process_id::owning_process_id(reference_process_id id,
+                                     owning_descriptor pidfd):
+    pimpl{(id <= no_process_id)? nullptr:
+          std::make_unique<impl>(id, std::move(pidfd))}
+{
+    // Intentionally empty.
+}
+
 owning_process_id::owning_process_id(owning_process_id&& other) noexcept =
     default;
 
@@ -262,7 +1099,11 @@ owning_process_id::~owning_process_id() = default; // NOLINT(performance-trivial
 
 owning_process_id::operator reference_process_id() const noexcept
 {
-    return pimpl? pimpl->pid: default_process_id;
+    if (pimpl) {
+        const std::lock_guard lock{pimpl->mutex};
+        return pimpl->pid;
+    }
+    return default_process_id;
 }
 
 auto owning_process_id::operator<=>(const owning_process_id& other) const noexcept
@@ -270,12 +1111,21 @@ auto owning_process_id::operator<=>(const owning_process_id& other) const noexce
     return reference_process_id(*this) <=> reference_process_id(other);
 }
 
+auto owning_process_id::pidfd() const noexcept -> reference_descriptor
+{
+    if (pimpl) {
+        const std::lock_guard lock{pimpl->mutex};
+        return reference_descriptor(pimpl->pidfd);
+    }
+    return descriptors::invalid_id;
+}
+
 auto owning_process_id::status() const noexcept -> wait_status
 {
     if (pimpl) {
         auto& impl = *pimpl;
         const std::lock_guard lock{impl.mutex};
-        return empty(impl.statuses)? default_status: impl.statuses.front();
+        return empty(impl.statuses)? impl.last_status: impl.statuses.front();
     }
     return default_status;
 }
@@ -288,4 +1138,197 @@ auto owning_process_id::wait(wait_option flags) noexcept -> wait_status
     return pimpl? ::flow::wait(*pimpl, flags): default_status;
 }
 
+auto owning_process_id::wait_until(std::chrono::steady_clock::time_point deadline,
+                                   wait_option flags) noexcept
+    -> std::optional<wait_status>
+{
+    return pimpl? ::flow::wait(*pimpl, flags, deadline):
+                  std::optional<wait_status>{default_status};
+}
+
+auto owning_process_id::wait_for(std::chrono::nanoseconds timeout,
+                                 wait_option flags) noexcept
+    -> std::optional<wait_status>
+{
+    return wait_until(detail::deadline_after(timeout), flags);
+}
+
+auto owning_process_id::set_deadline(std::chrono::steady_clock::time_point deadline,
+                                     std::chrono::nanoseconds grace) -> void
+{
+    if (!pimpl) {
+        return;
+    }
+    auto& impl = *pimpl;
+    {
+        const std::lock_guard lock{impl.mutex};
+        impl.kill_grace = grace;
+        if (!impl.deadline_timer) {
+            impl.deadline_timer = owning_descriptor{
+                ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC|TFD_NONBLOCK)
+            };
+            if (!impl.deadline_timer) {
+                throw std::system_error{errno, std::system_category(),
+                                        "can't make deadline timer"};
+            }
+        }
+        if (!arm(impl.deadline_timer, deadline)) {
+            throw std::system_error{errno, std::system_category(),
+                                    "can't set deadline timer"};
+        }
+        if (impl.deadline_watch) {
+            return;
+        }
+    }
+    // Unlocked since the handler takes the lock.
+    const auto id = detail::watch(int(impl.deadline_timer), EPOLLIN,
+                                  [&impl](std::uint32_t){
+        return handle_deadline(impl);
+    });
+    const std::lock_guard lock{impl.mutex};
+    impl.deadline_watch = id;
+}
+
+auto owning_process_id::on_change(std::function<void()> callback) -> void
+{
+    if (pimpl) {
+        pimpl->changes.set(std::move(callback));
+    }
+}
+
+auto owning_process_id::usage() const noexcept -> process_usage
+{
+    if (pimpl) {
+        const std::lock_guard lock{pimpl->mutex};
+        return pimpl->usage;
+    }
+    return process_usage{};
+}
+
+auto owning_process_id::restarts() const noexcept -> std::size_t
+{
+    if (pimpl) {
+        const std::lock_guard lock{pimpl->mutex};
+        return pimpl->restarts;
+    }
+    return 0u;
+}
+
+auto owning_process_id::await_start() noexcept -> reference_process_id
+{
+    if (!pimpl) {
+        return default_process_id;
+    }
+    auto& impl = *pimpl;
+    std::unique_lock lk(impl.mutex);
+    impl.cv.wait(lk, [&impl]{
+        return !impl.deferred;
+    });
+    return impl.pid;
+}
+
+auto owning_process_id::await_start(std::chrono::steady_clock::time_point deadline)
+    noexcept -> std::optional<reference_process_id>
+{
+    if (!pimpl) {
+        return default_process_id;
+    }
+    auto& impl = *pimpl;
+    std::unique_lock lk(impl.mutex);
+    if (!impl.cv.wait_until(lk, deadline, [&impl]{ return !impl.deferred; })) {
+        return {};
+    }
+    return impl.pid;
+}
+
+auto detail::deferred_process::make_owner() -> owning_process_id
+{
+    auto result = owning_process_id{};
+    result.pimpl = std::make_unique<owning_process_id::impl>(
+        owning_process_id::impl::deferred_tag{});
+    pimpl = result.pimpl.get();
+    return result;
+}
+
+auto detail::deferred_process::start(reference_process_id pid,
+                                     owning_descriptor pidfd) -> void
+{
+    {
+        const std::lock_guard lock{pimpl->mutex};
+        pimpl->pid = pid;
+        pimpl->pidfd = std::move(pidfd);
+    }
+    // Insert while still deferred, so the owner can't have gone yet.
+    the_manager().insert(pimpl);
+    const std::lock_guard lock{pimpl->mutex};
+    pimpl->deferred = false;
+    if (pimpl->deadline_passed) {
+        // Have the deadline's handler terminate it right away.
+        (void) arm(pimpl->deadline_timer, clock::now());
+    }
+    pimpl->changes.notify();
+    pimpl->cv.notify_all();
+}
+
+auto detail::deferred_process::cancel(wait_status status) -> void
+{
+    const std::lock_guard lock{pimpl->mutex};
+    pimpl->last_status = status;
+    pimpl->deferred = false;
+    pimpl->changes.notify();
+    pimpl->cv.notify_all();
+}
+
+auto detail::process_supervisor::supervise(owning_process_id& owner,
+                                           restart_policy policy,
+                                           const restart_limits& limits,
+                                           respawn_function respawn) -> void
+{
+    if (!owner.pimpl || (policy == restart_policy::never)) {
+        return;
+    }
+    auto& impl = *owner.pimpl;
+    auto timer = owning_descriptor{
+        ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC|TFD_NONBLOCK)
+    };
+    if (!timer) {
+        throw std::system_error{errno, std::system_category(),
+                                "can't make restart timer"};
+    }
+    const auto fd = int(timer);
+    {
+        const std::lock_guard lock{impl.mutex};
+        impl.supervisor = std::make_unique<owning_process_id::impl::supervision>();
+        auto& supervisor = *impl.supervisor;
+        supervisor.policy = policy;
+        supervisor.limits = limits;
+        supervisor.respawn = std::move(respawn);
+        supervisor.timer = std::move(timer);
+        supervisor.backoff = limits.initial_backoff;
+        supervisor.started = clock::now();
+        // It may have terminated already, before its owner was returned.
+        if (!empty(impl.statuses) && is_terminal(impl.statuses.back())) {
+            auto statuses = std::exchange(impl.statuses, {});
+            for (; size(statuses) > 1u; statuses.pop()) {
+                impl.statuses.push(statuses.front());
+            }
+            // Its timer gets handled once it's watched.
+            take_status(impl, statuses.front());
+        }
+    }
+    try {
+        const auto id = detail::watch(fd, EPOLLIN, [&impl](std::uint32_t){
+            return restart(impl);
+        });
+        const std::lock_guard lock{impl.mutex};
+        impl.supervisor->watch = id;
+    }
+    catch (...) {
+        const std::lock_guard lock{impl.mutex};
+        stop_restarting(impl);
+        impl.supervisor.reset();
+        throw;
+    }
+}
+
 }
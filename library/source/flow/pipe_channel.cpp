@@ -1,10 +1,8 @@
-#include <cassert> // for assert
 #include <stdexcept> // for std::runtime_error
 #include <utility> // for std::exchange
 
-#include <unistd.h> // for pipe, close
-
-#include "pipe_registry.hpp"
+#include <fcntl.h> // for O_CLOEXEC
+#include <unistd.h> // for pipe2, close
 
 #include "flow/os_error_code.hpp"
 #include "flow/pipe_channel.hpp"
@@ -13,24 +11,21 @@ namespace flow {
 
 pipe_channel::pipe_channel()
 {
-    [[maybe_unused]] const auto ret = the_pipe_registry().pipes.insert(this);
-    assert(ret.second);
-    if (::pipe(descriptors.data()) == -1) {
+    // Close-on-exec so child processes only get the descriptors that are
+    // explicitly duplicated into place for them.
+    if (::pipe2(descriptors.data(), O_CLOEXEC) == -1) {
         throw std::runtime_error{to_string(os_error_code(errno))};
     }
 }
 
 pipe_channel::pipe_channel(pipe_channel&& other) noexcept: descriptors{std::exchange(other.descriptors, {-1, -1})}
 {
-    [[maybe_unused]] const auto ret = the_pipe_registry().pipes.insert(this);
-    assert(ret.second);
+    // Intentionally empty.
 }
 
 pipe_channel::~pipe_channel() noexcept
 {
     close();
-    [[maybe_unused]] const auto ret = the_pipe_registry().pipes.erase(this);
-    assert(ret == 1u);
 }
 
 auto pipe_channel::operator=(pipe_channel&& other) noexcept -> pipe_channel&
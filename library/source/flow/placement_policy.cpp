@@ -0,0 +1,46 @@
+#include "flow/placement_policy.hpp"
+
+namespace flow {
+
+namespace {
+
+auto operator<<(std::ostream& os, const std::set<unsigned>& value)
+    -> std::ostream&
+{
+    os << "{";
+    auto prefix = "";
+    for (auto&& element: value) {
+        os << prefix << element;
+        prefix = ",";
+    }
+    os << "}";
+    return os;
+}
+
+}
+
+auto operator<<(std::ostream& os, cpu_policy value) -> std::ostream&
+{
+    os << to_cstring(value);
+    return os;
+}
+
+auto operator<<(std::ostream& os, memory_policy value) -> std::ostream&
+{
+    os << to_cstring(value);
+    return os;
+}
+
+auto operator<<(std::ostream& os, const placement_policy& value)
+    -> std::ostream&
+{
+    os << "placement_policy{";
+    os << ".cpus=" << value.cpus;
+    os << ",.cpu=" << value.cpu;
+    os << ",.memory=" << value.memory;
+    os << ",.numa_nodes=" << value.numa_nodes;
+    os << "}";
+    return os;
+}
+
+}
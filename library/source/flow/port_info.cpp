@@ -10,6 +10,9 @@ auto operator<<(std::ostream& os, const port_info& value)
         os << ":";
         os << value.comment;
     }
+    if (value.schema) {
+        os << ":" << *value.schema;
+    }
     return os;
 }
 
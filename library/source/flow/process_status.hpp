@@ -0,0 +1,19 @@
+#ifndef process_status_hpp
+#define process_status_hpp
+
+#include <sys/resource.h> // for rusage
+
+#include "flow/process_usage.hpp"
+#include "flow/wait_status.hpp"
+
+namespace flow::detail {
+
+/// @brief Converts the given resource usage from <code>wait4</code>.
+auto to_process_usage(const ::rusage& usage) noexcept -> process_usage;
+
+/// @brief Converts the given status from <code>wait4</code>.
+auto to_wait_status(int status) noexcept -> wait_status;
+
+}
+
+#endif /* process_status_hpp */
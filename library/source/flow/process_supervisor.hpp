@@ -0,0 +1,46 @@
+#ifndef process_supervisor_hpp
+#define process_supervisor_hpp
+
+#include <functional>
+
+#include "flow/executable.hpp"
+#include "flow/owning_descriptor.hpp"
+#include "flow/owning_process_id.hpp"
+#include "flow/reference_process_id.hpp"
+
+namespace flow::detail {
+
+/// @brief Process created to replace a terminated one.
+struct respawned_process
+{
+    reference_process_id pid{invalid_process_id};
+
+    /// @brief Descriptor referring to the process, if one came with it.
+    owning_descriptor pidfd;
+};
+
+/// @brief Function creating a process to replace a terminated one.
+/// @note It's called from the event loop's thread.
+/// @return The new process, whose identifier is
+///   <code>invalid_process_id</code> if it couldn't be created.
+using respawn_function = std::function<respawned_process()>;
+
+/// @brief Restarter of the processes of <code>owning_process_id</code>s.
+struct process_supervisor
+{
+    /// @brief Has the process of the given owner be restarted per the given
+    ///   policy & limits whenever it terminates.
+    /// @details Its termination is only reported to waiters once it's not
+    ///   to be restarted. That's when the policy or limits say not to, when
+    ///   the given function fails, when the owner's deadline has passed,
+    ///   or when the owner's being destroyed. The function's released then.
+    /// @throws std::system_error if the process can't be supervised.
+    static auto supervise(owning_process_id& owner,
+                          restart_policy policy,
+                          const restart_limits& limits,
+                          respawn_function respawn) -> void;
+};
+
+}
+
+#endif /* process_supervisor_hpp */
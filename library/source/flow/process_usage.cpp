@@ -0,0 +1,88 @@
+#include <algorithm> // for std::max
+
+#include <sys/wait.h>
+
+#include "flow/process_usage.hpp"
+
+#include "process_status.hpp"
+
+namespace flow {
+
+auto operator+=(process_usage& lhs, const process_usage& rhs) noexcept
+    -> process_usage&
+{
+    lhs.user_time += rhs.user_time;
+    lhs.system_time += rhs.system_time;
+    lhs.max_resident_kib = std::max(lhs.max_resident_kib,
+                                    rhs.max_resident_kib);
+    lhs.minor_faults += rhs.minor_faults;
+    lhs.major_faults += rhs.major_faults;
+    lhs.voluntary_switches += rhs.voluntary_switches;
+    lhs.involuntary_switches += rhs.involuntary_switches;
+    return lhs;
+}
+
+auto operator+(process_usage lhs, const process_usage& rhs) noexcept
+    -> process_usage
+{
+    lhs += rhs;
+    return lhs;
+}
+
+auto operator<<(std::ostream& os, const process_usage& value)
+    -> std::ostream&
+{
+    os << "user-usec=" << value.user_time.count();
+    os << ", system-usec=" << value.system_time.count();
+    os << ", max-rss-kib=" << value.max_resident_kib;
+    os << ", minor-faults=" << value.minor_faults;
+    os << ", major-faults=" << value.major_faults;
+    os << ", voluntary-switches=" << value.voluntary_switches;
+    os << ", involuntary-switches=" << value.involuntary_switches;
+    return os;
+}
+
+auto detail::to_process_usage(const ::rusage& usage) noexcept
+    -> process_usage
+{
+    const auto to_duration = [](const ::timeval& tv){
+        return std::chrono::seconds{tv.tv_sec} +
+               std::chrono::microseconds{tv.tv_usec};
+    };
+    return process_usage{
+        .user_time = to_duration(usage.ru_utime),
+        .system_time = to_duration(usage.ru_stime),
+        .max_resident_kib = usage.ru_maxrss,
+        .minor_faults = usage.ru_minflt,
+        .major_faults = usage.ru_majflt,
+        .voluntary_switches = usage.ru_nvcsw,
+        .involuntary_switches = usage.ru_nivcsw,
+    };
+}
+
+auto detail::to_wait_status(int status) noexcept -> wait_status
+{
+    if (WIFEXITED(status)) {
+        // process terminated normally
+        return wait_exit_status{WEXITSTATUS(status)};
+    }
+    if (WIFSIGNALED(status)) {
+        // process terminated due to signal
+        return wait_signaled_status{WTERMSIG(status), WCOREDUMP(status) != 0};
+    }
+    if (WIFSTOPPED(status)) {
+        // See "man 4 termios" for more info. From "man 2 waitpid":
+        // Process not terminated, but stopped due to a SIGTTIN, SIGTTOU,
+        // SIGTSTP, or SIGSTOP signal and can be restarted.
+        // Can be true only if wait call specified WUNTRACED option or if
+        // child process is being traced.
+        return wait_stopped_status{WSTOPSIG(status)};
+    }
+    if (WIFCONTINUED(status)) {
+        // process was resumed
+        return wait_continued_status{};
+    }
+    return wait_unknown_status{};
+}
+
+}
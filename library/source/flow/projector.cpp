@@ -0,0 +1,202 @@
+#include <algorithm> // for std::copy, std::find_if
+#include <bit> // for std::countr_zero
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "flow/projector.hpp"
+
+#include "record_io.hpp"
+
+namespace flow {
+
+namespace {
+
+/// @brief Finder of the characters that give records their structure.
+/// @note Uses SSE2 to compare 16 bytes at a time where that's available,
+///   otherwise compares a byte at a time.
+struct structure_finder
+{
+    structure_finder(char a_, char b_, char c_) noexcept:
+#if defined(__SSE2__)
+        va{_mm_set1_epi8(a_)}, vb{_mm_set1_epi8(b_)}, vc{_mm_set1_epi8(c_)},
+#endif
+        a{a_}, b{b_}, c{c_}
+    {
+        // Intentionally empty.
+    }
+
+    /// @brief Finds the first structural character within the given range.
+    /// @return Pointer to the character found or <code>last</code>.
+    auto operator()(const char* first, const char* last) const noexcept
+        -> const char*
+    {
+#if defined(__SSE2__)
+        static constexpr auto width = std::ptrdiff_t{sizeof(__m128i)};
+        for (; (last - first) >= width; first += width) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+            const auto matches = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)),
+                _mm_cmpeq_epi8(v, vc));
+            const auto mask = static_cast<unsigned>(_mm_movemask_epi8(matches));
+            if (mask != 0u) {
+                return first + std::countr_zero(mask);
+            }
+        }
+#endif
+        return std::find_if(first, last, [this](char ch){
+            return (ch == a) || (ch == b) || (ch == c);
+        });
+    }
+
+private:
+#if defined(__SSE2__)
+    __m128i va;
+    __m128i vb;
+    __m128i vc;
+#endif
+    char a;
+    char b;
+    char c;
+};
+
+/// @brief Writes out the selected fields of the given record.
+/// @param[in] bounds Offsets within the record of its field delimiters.
+auto write_projection(const projector& spec, std::string_view record,
+                      const std::vector<std::size_t>& bounds,
+                      detail::record_writer& writer) -> void
+{
+    const auto get = [&](std::size_t index){
+        if (index > size(bounds)) {
+            return std::string_view{};
+        }
+        const auto first = (index == 0u)? 0u: bounds[index - 1u] + 1u;
+        const auto last = (index < size(bounds))? bounds[index]: size(record);
+        return record.substr(first, last - first);
+    };
+    const auto delimiter = std::string_view{&spec.output_delimiter, 1u};
+    if (empty(spec.fields)) {
+        for (auto i = 0u; i <= size(bounds); ++i) {
+            if (i > 0u) {
+                writer.append(delimiter);
+            }
+            writer.append(get(i));
+        }
+    }
+    for (auto i = 0u; i < size(spec.fields); ++i) {
+        if (i > 0u) {
+            writer.append(delimiter);
+        }
+        if (spec.fields[i] > 0u) {
+            writer.append(get(spec.fields[i] - 1u));
+        }
+    }
+    writer.write({});
+}
+
+}
+
+auto operator<<(std::ostream& os, const projector& value) -> std::ostream&
+{
+    os << "projector{";
+    os << ".fields={";
+    auto prefix = "";
+    for (auto&& index: value.fields) {
+        os << prefix << index;
+        prefix = ",";
+    }
+    os << "}";
+    if (value.quote != '\0') {
+        os << ",.quote=" << value.quote;
+    }
+    os << "}";
+    return os;
+}
+
+auto project(const projector& spec, reference_descriptor in,
+             reference_descriptor out) -> void
+{
+    const auto quoting = (spec.quote != '\0');
+    const auto find = structure_finder{
+        spec.field_delimiter,
+        spec.record_delimiter,
+        quoting? spec.quote: spec.field_delimiter,
+    };
+    // Only the delimiters up to the last selected field are needed.
+    auto max_bounds = std::numeric_limits<std::size_t>::max();
+    if (!empty(spec.fields)) {
+        max_bounds = 0u;
+        for (auto&& index: spec.fields) {
+            max_bounds = std::max(max_bounds, index);
+        }
+    }
+    auto buffer = std::vector<char>(detail::default_record_buffer_size);
+    auto bounds = std::vector<std::size_t>{};
+    auto first = std::size_t{}; // start of the current record
+    auto scan = std::size_t{}; // where to resume scanning from
+    auto last = std::size_t{};
+    auto in_quotes = false;
+    auto eof = false;
+    detail::record_writer writer{out, spec.record_delimiter};
+    for (;;) {
+        for (;;) {
+            const auto found = find(buffer.data() + scan, buffer.data() + last);
+            const auto pos = static_cast<std::size_t>(found - buffer.data());
+            if (pos == last) {
+                scan = last;
+                break;
+            }
+            scan = pos + 1u;
+            const auto ch = *found;
+            if (quoting && (ch == spec.quote)) {
+                in_quotes = !in_quotes;
+            }
+            else if (in_quotes) {
+                continue;
+            }
+            else if (ch == spec.field_delimiter) {
+                if (size(bounds) < max_bounds) {
+                    bounds.push_back(pos - first);
+                }
+            }
+            else if (ch == spec.record_delimiter) {
+                write_projection(spec, {buffer.data() + first, pos - first},
+                                 bounds, writer);
+                bounds.clear();
+                first = pos + 1u;
+            }
+        }
+        if (eof) {
+            if (first < last) {
+                write_projection(spec, {buffer.data() + first, last - first},
+                                 bounds, writer);
+            }
+            break;
+        }
+        // Make room for more - growing the buffer if a record won't fit.
+        if (first > 0u) {
+            std::copy(buffer.begin() + std::ptrdiff_t(first),
+                      buffer.begin() + std::ptrdiff_t(last), buffer.begin());
+            last -= first;
+            scan -= first;
+            first = 0u;
+        }
+        if (last == size(buffer)) {
+            buffer.resize(size(buffer) * 2u);
+        }
+        const auto nread = detail::read_some(in, std::span<char>{
+            buffer.data() + last, size(buffer) - last
+        });
+        eof = (nread == 0u);
+        last += nread;
+    }
+    writer.flush();
+}
+
+}
@@ -0,0 +1,113 @@
+#include <charconv> // for std::from_chars
+#include <climits> // for CHAR_BIT
+
+#include "flow/record_batch.hpp"
+
+namespace flow {
+
+namespace {
+
+constexpr auto bits_per_word = sizeof(std::uint64_t) * CHAR_BIT;
+
+template <class T>
+auto parse(std::string_view text, T& value) -> bool
+{
+    const auto last = text.data() + size(text);
+    const auto result = std::from_chars(text.data(), last, value);
+    return (result.ec == std::errc{}) && (result.ptr == last);
+}
+
+auto push_validity(column& col, bool valid) -> void
+{
+    const auto bit = col.length % bits_per_word;
+    if (bit == 0u) {
+        col.validity.push_back(0u);
+    }
+    if (valid) {
+        col.validity.back() |= std::uint64_t{1u} << bit;
+    }
+    ++col.length;
+}
+
+}
+
+auto append(column& col, std::string_view text) -> void
+{
+    if (empty(text)) {
+        append_null(col);
+        return;
+    }
+    switch (col.type) {
+    case field_type::text:
+        col.chars.insert(col.chars.end(), text.begin(), text.end());
+        col.offsets.push_back(size(col.chars));
+        push_validity(col, true);
+        return;
+    case field_type::integer: {
+        auto value = std::int64_t{};
+        const auto valid = parse(text, value);
+        col.integers.push_back(valid? value: std::int64_t{});
+        push_validity(col, valid);
+        return;
+    }
+    case field_type::real: {
+        auto value = double{};
+        const auto valid = parse(text, value);
+        col.reals.push_back(valid? value: double{});
+        push_validity(col, valid);
+        return;
+    }
+    }
+}
+
+auto append_null(column& col) -> void
+{
+    switch (col.type) {
+    case field_type::text:
+        col.offsets.push_back(size(col.chars));
+        break;
+    case field_type::integer:
+        col.integers.push_back({});
+        break;
+    case field_type::real:
+        col.reals.push_back({});
+        break;
+    }
+    push_validity(col, false);
+}
+
+auto is_valid(const column& col, std::size_t index) noexcept -> bool
+{
+    const auto word = index / bits_per_word;
+    const auto bit = index % bits_per_word;
+    return (word < size(col.validity)) &&
+           ((col.validity[word] & (std::uint64_t{1u} << bit)) != 0u);
+}
+
+auto get_text(const column& col, std::size_t index) noexcept
+    -> std::string_view
+{
+    if ((index + 1u) >= size(col.offsets)) {
+        return {};
+    }
+    const auto first = col.offsets[index];
+    return {col.chars.data() + first, col.offsets[index + 1u] - first};
+}
+
+auto make_record_batch(const std::vector<record_field>& fields)
+    -> record_batch
+{
+    auto result = record_batch{};
+    result.columns.reserve(size(fields));
+    for (auto&& field: fields) {
+        result.columns.emplace_back().type = field.type;
+    }
+    return result;
+}
+
+auto get_size(const record_batch& batch) noexcept -> std::size_t
+{
+    return empty(batch.columns)? 0u: batch.columns.front().length;
+}
+
+}
@@ -0,0 +1,207 @@
+#include <algorithm> // for std::copy, std::find, std::max
+#include <cerrno> // for errno
+#include <charconv> // for std::from_chars
+#include <cmath> // for std::isnan
+#include <cstdlib> // for ::mkstemp
+#include <string>
+#include <thread> // for std::thread::hardware_concurrency
+
+#include <fcntl.h> // for ::open, O_TMPFILE
+#include <unistd.h> // for ::read, ::write, ::unlink
+
+#include "flow/os_error_code.hpp"
+
+#include "record_io.hpp"
+
+namespace flow::detail {
+
+auto get_thread_count(std::size_t requested) noexcept -> std::size_t
+{
+    if (requested > 0u) {
+        return requested;
+    }
+    return std::max(std::size_t{std::thread::hardware_concurrency()},
+                    std::size_t{1u});
+}
+
+auto read_some(reference_descriptor fd, const std::span<char>& buffer)
+    -> std::size_t
+{
+    for (;;) {
+        const auto nread = ::read(int(fd), data(buffer), size(buffer));
+        if (nread != -1) {
+            return static_cast<std::size_t>(nread);
+        }
+        if (errno != EINTR) {
+            const auto err = os_error_code(errno);
+            throw_error(err, "read from descriptor " +
+                        std::to_string(int(fd)) + " failed");
+        }
+    }
+}
+
+auto write_all(reference_descriptor fd, const std::span<const char>& data)
+    -> void
+{
+    auto remaining = data;
+    while (!empty(remaining)) {
+        const auto nwrite = ::write(int(fd), remaining.data(),
+                                    size(remaining));
+        if (nwrite == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            const auto err = os_error_code(errno);
+            throw_error(err, "write to descriptor " +
+                        std::to_string(int(fd)) + " failed");
+        }
+        remaining = remaining.subspan(static_cast<std::size_t>(nwrite));
+    }
+}
+
+auto make_temporary_file(const std::filesystem::path& dir)
+    -> owning_descriptor
+{
+    const auto path = dir.empty()? std::filesystem::temp_directory_path(): dir;
+    static constexpr auto mode = 0600;
+#if defined(O_TMPFILE)
+    {
+        const auto fd = ::open( // NOLINT(cppcoreguidelines-pro-type-vararg)
+                               path.c_str(),
+                               O_TMPFILE|O_RDWR|O_EXCL|O_CLOEXEC, mode);
+        if (fd != -1) {
+            return owning_descriptor{fd};
+        }
+    }
+#endif
+    auto name = (path / "flow-XXXXXX").native();
+    const auto fd = ::mkostemp(name.data(), O_CLOEXEC);
+    if (fd == -1) {
+        throw_error(os_error_code(errno),
+                    "can't make temporary file in " + path.native());
+    }
+    ::unlink(name.c_str());
+    return owning_descriptor{fd};
+}
+
+auto get_field(std::string_view record, char delimiter, std::size_t index)
+    -> std::string_view
+{
+    for (; index > 0u; --index) {
+        const auto found = record.find(delimiter);
+        if (found == std::string_view::npos) {
+            return {};
+        }
+        record.remove_prefix(found + 1u);
+    }
+    return record.substr(0u, record.find(delimiter));
+}
+
+auto to_number(std::string_view text) noexcept -> double
+{
+    const auto first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    text.remove_prefix(first);
+    if (text.starts_with('+')) {
+        text.remove_prefix(1u);
+    }
+    auto value = double{};
+    const auto result = std::from_chars(text.data(),
+                                        text.data() + size(text), value);
+    if ((result.ec != std::errc{}) || std::isnan(value)) {
+        return {};
+    }
+    return value;
+}
+
+record_reader::record_reader(reference_descriptor fd_, char delimiter_,
+                             std::size_t buffer_size):
+    fd{fd_},
+    delimiter{delimiter_},
+    buffer(std::max(buffer_size, std::size_t{1u}))
+{
+    // Intentionally empty.
+}
+
+auto record_reader::next() -> std::optional<std::string_view>
+{
+    for (;;) {
+        const auto begin_it = buffer.begin() + std::ptrdiff_t(first);
+        const auto end_it = buffer.begin() + std::ptrdiff_t(last);
+        const auto found = std::find(begin_it, end_it, delimiter);
+        if (found != end_it) {
+            const auto result = std::string_view{
+                buffer.data() + first,
+                static_cast<std::size_t>(found - begin_it)
+            };
+            first += size(result) + 1u;
+            return result;
+        }
+        if (eof) {
+            if (first == last) {
+                return {};
+            }
+            const auto result = std::string_view{
+                buffer.data() + first, last - first
+            };
+            first = last;
+            return result;
+        }
+        // Make room for more - growing the buffer if a record won't fit.
+        if (first > 0u) {
+            std::copy(begin_it, end_it, buffer.begin());
+            last -= first;
+            first = 0u;
+        }
+        if (last == size(buffer)) {
+            buffer.resize(size(buffer) * 2u);
+        }
+        const auto nread = read_some(fd, std::span<char>{
+            buffer.data() + last, size(buffer) - last
+        });
+        if (nread == 0u) {
+            eof = true;
+        }
+        last += nread;
+    }
+}
+
+record_writer::record_writer(reference_descriptor fd_, char delimiter_,
+                             std::size_t buffer_size):
+    fd{fd_}, delimiter{delimiter_}
+{
+    buffer.reserve(buffer_size);
+}
+
+auto record_writer::write(std::string_view record) -> void
+{
+    append(record);
+    if (size(buffer) == buffer.capacity()) {
+        flush();
+    }
+    buffer.push_back(delimiter);
+}
+
+auto record_writer::append(std::string_view data) -> void
+{
+    if (size(buffer) + size(data) > buffer.capacity()) {
+        flush();
+        if (size(data) > buffer.capacity()) {
+            write_all(fd, data);
+            return;
+        }
+    }
+    buffer.insert(buffer.end(), data.begin(), data.end());
+}
+
+auto record_writer::flush() -> void
+{
+    if (!empty(buffer)) {
+        write_all(fd, buffer);
+        buffer.clear();
+    }
+}
+
+}
@@ -0,0 +1,101 @@
+#ifndef record_io_hpp
+#define record_io_hpp
+
+#include <cstddef> // for std::size_t
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "flow/owning_descriptor.hpp"
+#include "flow/reference_descriptor.hpp"
+
+namespace flow::detail {
+
+constexpr auto default_record_buffer_size = std::size_t{64u * 1024u};
+
+/// @brief Gets the number of threads to use for the requested number.
+/// @return Requested number, or the number of threads the hardware supports
+///   if that's zero.
+auto get_thread_count(std::size_t requested) noexcept -> std::size_t;
+
+/// @brief Reads up to the size of the given buffer from the given descriptor.
+/// @note Retries the read if interrupted by a signal.
+/// @return Number of bytes read, zero on end-of-file.
+/// @throws std::system_error if the underlying OS call fails.
+auto read_some(reference_descriptor fd, const std::span<char>& buffer)
+    -> std::size_t;
+
+/// @brief Writes all of the given data to the given descriptor.
+/// @note Retries partial & interrupted writes.
+/// @throws std::system_error if the underlying OS call fails.
+auto write_all(reference_descriptor fd, const std::span<const char>& data)
+    -> void;
+
+/// @brief Makes an unnamed temporary file in the given directory.
+/// @param[in] dir Directory to make the file in. The system's temporary
+///   directory is used if this is empty.
+/// @return Close-on-exec descriptor opened for reading and writing.
+/// @throws std::system_error if the underlying OS calls fail.
+auto make_temporary_file(const std::filesystem::path& dir)
+    -> owning_descriptor;
+
+/// @brief Gets the field at the given zero-based index of the given record.
+/// @return View of the field, or an empty view if the record has too few
+///   fields.
+auto get_field(std::string_view record, char delimiter, std::size_t index)
+    -> std::string_view;
+
+/// @brief Parses the given text as a number.
+/// @note Leading blanks are skipped. Text not starting with a number is
+///   treated as zero - like <code>sort -n</code> does.
+auto to_number(std::string_view text) noexcept -> double;
+
+/// @brief Buffered reader of delimited records from a descriptor.
+/// @note Records are returned as views into this object's buffer which are
+///   only valid until the next call to <code>next</code>.
+struct record_reader
+{
+    record_reader(reference_descriptor fd_, char delimiter_,
+                  std::size_t buffer_size = default_record_buffer_size);
+
+    /// @brief Gets the next record without its delimiter.
+    /// @note The last record of the input doesn't need to be delimited.
+    /// @return Record view or empty optional at end-of-file.
+    auto next() -> std::optional<std::string_view>;
+
+private:
+    reference_descriptor fd;
+    char delimiter;
+    std::vector<char> buffer;
+    std::size_t first{};
+    std::size_t last{};
+    bool eof{};
+};
+
+/// @brief Buffered writer of delimited records to a descriptor.
+/// @note Anything still buffered when this is destroyed is discarded.
+///   Call <code>flush</code> first to avoid that.
+struct record_writer
+{
+    record_writer(reference_descriptor fd_, char delimiter_,
+                  std::size_t buffer_size = default_record_buffer_size);
+
+    /// @brief Writes the given record followed by the delimiter.
+    auto write(std::string_view record) -> void;
+
+    /// @brief Writes the given data as is.
+    auto append(std::string_view data) -> void;
+
+    auto flush() -> void;
+
+private:
+    reference_descriptor fd;
+    char delimiter;
+    std::vector<char> buffer;
+};
+
+}
+
+#endif /* record_io_hpp */
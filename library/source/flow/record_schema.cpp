@@ -0,0 +1,120 @@
+#include <cstdint> // for std::int64_t
+
+#include "flow/record_schema.hpp"
+
+namespace flow {
+
+auto operator<<(std::ostream& os, field_type value) -> std::ostream&
+{
+    switch (value) {
+    case field_type::text:
+        os << "text";
+        return os;
+    case field_type::integer:
+        os << "integer";
+        return os;
+    case field_type::real:
+        os << "real";
+        return os;
+    }
+    os << "field_type(" << unsigned(value) << ")";
+    return os;
+}
+
+auto operator<<(std::ostream& os, record_encoding value) -> std::ostream&
+{
+    switch (value) {
+    case record_encoding::delimited:
+        os << "delimited";
+        return os;
+    case record_encoding::binary:
+        os << "binary";
+        return os;
+    case record_encoding::columnar:
+        os << "columnar";
+        return os;
+    }
+    os << "record_encoding(" << unsigned(value) << ")";
+    return os;
+}
+
+auto operator<<(std::ostream& os, const record_field& value) -> std::ostream&
+{
+    if (!empty(value.name)) {
+        os << value.name << ":";
+    }
+    os << value.type;
+    if ((value.type == field_type::text) && (value.width > 0u)) {
+        os << "[" << value.width << "]";
+    }
+    return os;
+}
+
+auto operator<<(std::ostream& os, const record_schema& value) -> std::ostream&
+{
+    os << value.encoding << "{";
+    auto prefix = "";
+    for (auto&& field: value.fields) {
+        os << prefix << field;
+        prefix = ",";
+    }
+    os << "}";
+    return os;
+}
+
+auto get_width(const record_field& field) noexcept -> std::size_t
+{
+    switch (field.type) {
+    case field_type::integer:
+        return sizeof(std::int64_t);
+    case field_type::real:
+        return sizeof(double);
+    case field_type::text:
+        break;
+    }
+    return field.width;
+}
+
+auto get_record_size(const record_schema& schema) noexcept -> std::size_t
+{
+    if (schema.encoding != record_encoding::binary) {
+        return 0u;
+    }
+    auto result = std::size_t{};
+    for (auto&& field: schema.fields) {
+        result += get_width(field);
+    }
+    return result;
+}
+
+auto is_compatible(const record_schema& src, const record_schema& dst)
+    -> bool
+{
+    if ((src.encoding != dst.encoding) ||
+        (size(src.fields) != size(dst.fields))) {
+        return false;
+    }
+    if ((src.encoding == record_encoding::delimited) &&
+        ((src.field_delimiter != dst.field_delimiter) ||
+         (src.record_delimiter != dst.record_delimiter))) {
+        return false;
+    }
+    for (auto i = 0u; i < size(src.fields); ++i) {
+        const auto& src_field = src.fields[i];
+        const auto& dst_field = dst.fields[i];
+        if (src_field.type != dst_field.type) {
+            return false;
+        }
+        if ((src.encoding == record_encoding::binary) &&
+            (get_width(src_field) != get_width(dst_field))) {
+            return false;
+        }
+        if (!empty(src_field.name) && !empty(dst_field.name) &&
+            (src_field.name != dst_field.name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
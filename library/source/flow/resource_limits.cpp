@@ -0,0 +1,18 @@
+#include "flow/resource_limits.hpp"
+
+namespace flow {
+
+auto operator<<(std::ostream& os, const resource_limits& value)
+    -> std::ostream&
+{
+    os << "resource_limits{";
+    os << ".cpu_quota=" << value.cpu_quota.count() << "us";
+    os << ",.cpu_period=" << value.cpu_period.count() << "us";
+    os << ",.cpu_weight=" << value.cpu_weight;
+    os << ",.memory_max=" << value.memory_max;
+    os << ",.io_weight=" << value.io_weight;
+    os << "}";
+    return os;
+}
+
+}
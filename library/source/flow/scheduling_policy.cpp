@@ -0,0 +1,35 @@
+#include "flow/scheduling_policy.hpp"
+
+namespace flow {
+
+auto operator<<(std::ostream& os, scheduling_class value) -> std::ostream&
+{
+    os << to_cstring(value);
+    return os;
+}
+
+auto operator<<(std::ostream& os, io_class value) -> std::ostream&
+{
+    os << to_cstring(value);
+    return os;
+}
+
+auto operator<<(std::ostream& os, const scheduling_policy& value)
+    -> std::ostream&
+{
+    os << "scheduling_policy{";
+    os << ".nice=";
+    if (value.nice) {
+        os << *value.nice;
+    }
+    else {
+        os << "inherit";
+    }
+    os << ",.scheduler=" << value.scheduler;
+    os << ",.io=" << value.io;
+    os << ",.io_level=" << value.io_level;
+    os << "}";
+    return os;
+}
+
+}
@@ -0,0 +1,292 @@
+#include <algorithm> // for std::clamp, std::sort
+#include <future>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h> // for ::lseek
+
+#include "flow/os_error_code.hpp"
+#include "flow/sorter.hpp"
+
+#include "loser_tree.hpp"
+#include "record_io.hpp"
+
+namespace flow {
+
+namespace {
+
+constexpr auto min_arena_size = std::size_t{64u * 1024u};
+constexpr auto min_merge_buffer_size = detail::default_record_buffer_size;
+constexpr auto min_slice_size = std::size_t{4096u};
+
+struct sort_record
+{
+    std::string_view text;
+    std::string_view key;
+    double number{};
+};
+
+auto make_record(const sorter& spec, std::string_view text) -> sort_record
+{
+    const auto key = (spec.key_field == 0u)
+        ? text
+        : detail::get_field(text, spec.field_delimiter, spec.key_field - 1u);
+    const auto number = (spec.order == sort_order::numeric)
+        ? detail::to_number(key)
+        : double{};
+    return {text, key, number};
+}
+
+struct record_less
+{
+    sort_order order;
+
+    auto operator()(const sort_record& lhs,
+                    const sort_record& rhs) const noexcept -> bool
+    {
+        if (order == sort_order::numeric) {
+            if (lhs.number != rhs.number) {
+                return lhs.number < rhs.number;
+            }
+        }
+        else if (const auto cmp = lhs.key.compare(rhs.key); cmp != 0) {
+            return cmp < 0;
+        }
+        return lhs.text < rhs.text;
+    }
+};
+
+/// @brief Sorts contiguous slices of the given records concurrently.
+/// @return Boundaries of the slices, first to last.
+auto sort_slices(std::vector<sort_record>& records,
+                 std::size_t threads,
+                 const record_less& less) -> std::vector<std::size_t>
+{
+    const auto total = size(records);
+    const auto count = std::clamp(total / min_slice_size,
+                                  std::size_t{1u}, threads);
+    auto bounds = std::vector<std::size_t>(count + 1u);
+    for (auto i = 0u; i <= count; ++i) {
+        bounds[i] = (total * i) / count;
+    }
+    const auto sort_slice = [&records,&bounds,&less](std::size_t i){
+        const auto first = records.begin() + std::ptrdiff_t(bounds[i]);
+        const auto last = records.begin() + std::ptrdiff_t(bounds[i + 1u]);
+        std::sort(first, last, less);
+    };
+    auto futures = std::vector<std::future<void>>{};
+    for (auto i = 1u; i < count; ++i) {
+        futures.push_back(std::async(std::launch::async, sort_slice, i));
+    }
+    sort_slice(0u);
+    for (auto&& future: futures) {
+        future.get();
+    }
+    return bounds;
+}
+
+/// @brief Merges the sorted slices of the given records out to the writer.
+auto write_merged(const std::vector<sort_record>& records,
+                  const std::vector<std::size_t>& bounds,
+                  const record_less& less,
+                  detail::record_writer& writer) -> void
+{
+    const auto k = size(bounds) - 1u;
+    auto heads = std::vector<std::size_t>(bounds.begin(),
+                                          bounds.begin() + std::ptrdiff_t(k));
+    detail::loser_tree tree{k, [&](std::size_t lhs, std::size_t rhs){
+        if (heads[lhs] == bounds[lhs + 1u]) {
+            return false;
+        }
+        if (heads[rhs] == bounds[rhs + 1u]) {
+            return true;
+        }
+        return less(records[heads[lhs]], records[heads[rhs]]);
+    }};
+    for (;;) {
+        const auto w = tree.winner();
+        if (heads[w] == bounds[w + 1u]) {
+            break;
+        }
+        writer.write(records[heads[w]].text);
+        ++heads[w];
+        tree.replay();
+    }
+}
+
+/// @brief Merges the given spilled runs out to the writer.
+auto merge_runs(const sorter& spec,
+                const std::span<owning_descriptor>& runs,
+                detail::record_writer& writer) -> void
+{
+    const auto k = size(runs);
+    if (k == 0u) {
+        return;
+    }
+    const auto buffer_size = std::max(spec.memory_budget / (k + 1u),
+                                      min_merge_buffer_size);
+    auto readers = std::vector<detail::record_reader>{};
+    readers.reserve(k);
+    for (auto&& run: runs) {
+        if (::lseek(int(run), 0, SEEK_SET) == -1) {
+            throw_error(os_error_code(errno), "can't rewind spilled run");
+        }
+        readers.emplace_back(run, spec.record_delimiter, buffer_size);
+    }
+    auto heads = std::vector<std::optional<sort_record>>(k);
+    const auto advance = [&](std::size_t i){
+        if (const auto text = readers[i].next()) {
+            heads[i] = make_record(spec, *text);
+        }
+        else {
+            heads[i].reset();
+        }
+    };
+    for (auto i = 0u; i < k; ++i) {
+        advance(i);
+    }
+    const auto less = record_less{spec.order};
+    detail::loser_tree tree{k, [&](std::size_t lhs, std::size_t rhs){
+        if (!heads[lhs]) {
+            return false;
+        }
+        if (!heads[rhs]) {
+            return true;
+        }
+        return less(*heads[lhs], *heads[rhs]);
+    }};
+    for (;;) {
+        const auto w = tree.winner();
+        if (!heads[w]) {
+            break;
+        }
+        writer.write(heads[w]->text);
+        advance(w);
+        tree.replay();
+    }
+}
+
+/// @brief Merges the given spilled runs, in as many passes as the memory
+///   budget requires, out to the writer.
+auto merge_all_runs(const sorter& spec,
+                    std::vector<owning_descriptor>& runs,
+                    detail::record_writer& writer) -> void
+{
+    const auto fan_in = std::max(spec.memory_budget / min_merge_buffer_size,
+                                 std::size_t{2u});
+    while (size(runs) > fan_in) {
+        auto merged = std::vector<owning_descriptor>{};
+        for (auto first = 0u; first < size(runs); first += fan_in) {
+            const auto count = std::min(fan_in, size(runs) - first);
+            auto run = detail::make_temporary_file(spec.temporary_directory);
+            detail::record_writer run_writer{run, spec.record_delimiter};
+            merge_runs(spec, std::span{runs}.subspan(first, count),
+                       run_writer);
+            run_writer.flush();
+            merged.push_back(std::move(run));
+        }
+        runs = std::move(merged);
+    }
+    merge_runs(spec, runs, writer);
+}
+
+}
+
+auto operator<<(std::ostream& os, sort_order value) -> std::ostream&
+{
+    switch (value) {
+    case sort_order::lexicographic:
+        os << "lexicographic";
+        return os;
+    case sort_order::numeric:
+        os << "numeric";
+        return os;
+    }
+    os << "sort_order(" << unsigned(value) << ")";
+    return os;
+}
+
+auto operator<<(std::ostream& os, const sorter& value) -> std::ostream&
+{
+    os << "sorter{";
+    os << ".key_field=" << value.key_field;
+    os << ",.order=" << value.order;
+    os << ",.memory_budget=" << value.memory_budget;
+    os << ",.threads=" << value.threads;
+    if (!value.temporary_directory.empty()) {
+        os << ",.temporary_directory=" << value.temporary_directory;
+    }
+    os << "}";
+    return os;
+}
+
+auto sort(const sorter& spec, reference_descriptor in,
+          reference_descriptor out) -> void
+{
+    const auto threads = detail::get_thread_count(spec.threads);
+    const auto less = record_less{spec.order};
+    auto arena = std::vector<char>(std::max(spec.memory_budget / 2u,
+                                            min_arena_size));
+    auto filled = std::size_t{};
+    auto eof = false;
+    auto records = std::vector<sort_record>{};
+    auto runs = std::vector<owning_descriptor>{};
+    detail::record_writer writer{out, spec.record_delimiter};
+    while (!eof || (filled > 0u)) {
+        while (!eof && (filled < size(arena))) {
+            const auto nread = detail::read_some(in, std::span<char>{
+                arena.data() + filled, size(arena) - filled
+            });
+            eof = (nread == 0u);
+            filled += nread;
+        }
+        // Split off as many whole records as the memory budget allows.
+        records.clear();
+        auto used = std::size_t{};
+        while (used < filled) {
+            const auto rest = std::string_view{
+                arena.data() + used, filled - used
+            };
+            const auto found = rest.find(spec.record_delimiter);
+            if ((found == std::string_view::npos) && !eof) {
+                break;
+            }
+            const auto length = std::min(found, size(rest));
+            const auto cost = used + (size(records) + 1u) * sizeof(sort_record);
+            if (!empty(records) && (cost > spec.memory_budget)) {
+                break;
+            }
+            records.push_back(make_record(spec, rest.substr(0u, length)));
+            used += std::min(length + 1u, size(rest));
+        }
+        if (empty(records)) {
+            if (eof) {
+                break;
+            }
+            // Current record is bigger than the arena.
+            arena.resize(size(arena) * 2u);
+            continue;
+        }
+        const auto bounds = sort_slices(records, threads, less);
+        if (empty(runs) && eof && (used == filled)) {
+            // Everything fit in memory, so skip spilling.
+            write_merged(records, bounds, less, writer);
+            writer.flush();
+            return;
+        }
+        auto run = detail::make_temporary_file(spec.temporary_directory);
+        detail::record_writer run_writer{run, spec.record_delimiter};
+        write_merged(records, bounds, less, run_writer);
+        run_writer.flush();
+        runs.push_back(std::move(run));
+        std::copy(arena.begin() + std::ptrdiff_t(used),
+                  arena.begin() + std::ptrdiff_t(filled), arena.begin());
+        filled -= used;
+    }
+    merge_all_runs(spec, runs, writer);
+    writer.flush();
+}
+
+}
@@ -0,0 +1,218 @@
+#include <algorithm> // for std::none_of
+#include <cerrno> // for errno
+
+#include <spawn.h>
+#include <unistd.h> // for getpgrp
+
+#include "flow/owning_process_id.hpp"
+#include "flow/utility.hpp"
+
+#include "spawn.hpp"
+
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 29)))
+#define FLOW_HAS_SPAWN_ADDCHDIR 1
+#endif
+
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 34)))
+#define FLOW_HAS_SPAWN_ADDCLOSEFROM 1
+#endif
+
+namespace flow::detail {
+
+namespace {
+
+struct spawn_file_actions
+{
+    spawn_file_actions() noexcept
+    {
+        ::posix_spawn_file_actions_init(&value);
+    }
+
+    ~spawn_file_actions() noexcept
+    {
+        ::posix_spawn_file_actions_destroy(&value);
+    }
+
+    spawn_file_actions(const spawn_file_actions&) = delete;
+    auto operator=(const spawn_file_actions&) -> spawn_file_actions& = delete;
+
+    auto add(const child_action& action) noexcept -> int
+    {
+        return std::visit(overloaded{
+            [](const setpgid_action&) {
+                return 0; // Handled by spawn_attributes instead.
+            },
+            [this](const close_action& a) {
+                return ::posix_spawn_file_actions_addclose(&value, a.fd);
+            },
+            [this](const close_range_action& a) {
+                if (a.last == close_range_action::unbounded) {
+#if defined(FLOW_HAS_SPAWN_ADDCLOSEFROM)
+                    return ::posix_spawn_file_actions_addclosefrom_np(
+                        &value, int(a.first));
+#else
+                    return ENOTSUP;
+#endif
+                }
+                for (auto fd = a.first; fd <= a.last; ++fd) {
+                    if (const auto err = ::posix_spawn_file_actions_addclose(
+                            &value, int(fd)); err != 0) {
+                        return err;
+                    }
+                }
+                return 0;
+            },
+            [this](const dup2_action& a) {
+                return ::posix_spawn_file_actions_adddup2(&value, a.fd,
+                                                          a.newfd);
+            },
+            [this](const open_action& a) {
+                return ::posix_spawn_file_actions_addopen(&value, a.fd,
+                                                          a.path, a.flags,
+                                                          a.mode);
+            },
+            [this](const chdir_action& a) {
+#if defined(FLOW_HAS_SPAWN_ADDCHDIR)
+                return ::posix_spawn_file_actions_addchdir_np(&value,
+                                                              a.path);
+#else
+                return ENOTSUP;
+#endif
+            },
+            [this](const fchdir_action& a) {
+#if defined(FLOW_HAS_SPAWN_ADDCHDIR)
+                return ::posix_spawn_file_actions_addfchdir_np(&value, a.fd);
+#else
+                return ENOTSUP;
+#endif
+            },
+            [](const cgroup_action&) {
+                return ENOTSUP;
+            },
+            [](const affinity_action&) {
+                return ENOTSUP;
+            },
+            [](const mempolicy_action&) {
+                return ENOTSUP;
+            },
+            [](const nice_action&) {
+                return ENOTSUP;
+            },
+            [](const scheduler_action&) {
+                return ENOTSUP;
+            },
+            [](const ioprio_action&) {
+                return ENOTSUP;
+            },
+        }, action);
+    }
+
+    posix_spawn_file_actions_t value{};
+};
+
+struct spawn_attributes
+{
+    spawn_attributes() noexcept
+    {
+        ::posix_spawnattr_init(&value);
+    }
+
+    ~spawn_attributes() noexcept
+    {
+        ::posix_spawnattr_destroy(&value);
+    }
+
+    spawn_attributes(const spawn_attributes&) = delete;
+    auto operator=(const spawn_attributes&) -> spawn_attributes& = delete;
+
+    posix_spawnattr_t value{};
+};
+
+}
+
+auto is_spawnable(const std::vector<child_action>& actions) noexcept -> bool
+{
+    return std::none_of(begin(actions), end(actions), [](const auto& a){
+        return std::visit(overloaded{
+            [](const auto&) {
+                return false;
+            },
+            [](const chdir_action&) {
+#if defined(FLOW_HAS_SPAWN_ADDCHDIR)
+                return false;
+#else
+                return true;
+#endif
+            },
+            [](const fchdir_action&) {
+#if defined(FLOW_HAS_SPAWN_ADDCHDIR)
+                return false;
+#else
+                return true;
+#endif
+            },
+            [](const close_range_action& a) {
+#if defined(FLOW_HAS_SPAWN_ADDCLOSEFROM)
+                (void) a;
+                return false;
+#else
+                return a.last == close_range_action::unbounded;
+#endif
+            },
+            [](const cgroup_action&) {
+                return true;
+            },
+            [](const affinity_action&) {
+                return true;
+            },
+            [](const mempolicy_action&) {
+                return true;
+            },
+            [](const nice_action&) {
+                return true;
+            },
+            [](const scheduler_action&) {
+                return true;
+            },
+            [](const ioprio_action&) {
+                return true;
+            },
+        }, a);
+    });
+}
+
+auto spawn(const std::filesystem::path& path,
+           char * const *argv,
+           char * const *envp,
+           const std::vector<child_action>& actions,
+           const sigset_t& mask) -> reference_process_id
+{
+    spawn_file_actions file_actions;
+    spawn_attributes attrs;
+    auto flags = short{POSIX_SPAWN_SETSIGMASK};
+    ::posix_spawnattr_setsigmask(&attrs.value, &mask);
+    for (auto&& action: actions) {
+        if (const auto p = std::get_if<setpgid_action>(&action)) {
+            // The child is already in the calling process's group. Setting
+            // that explicitly only fails when this process isn't the
+            // group's leader.
+            if ((p->pgrp != current_process_id()) &&
+                (p->pgrp != reference_process_id{::getpgrp()})) {
+                flags |= POSIX_SPAWN_SETPGROUP;
+                ::posix_spawnattr_setpgroup(&attrs.value, int(p->pgrp));
+            }
+            continue;
+        }
+        if (const auto err = file_actions.add(action); err != 0) {
+            errno = err;
+            return invalid_process_id;
+        }
+    }
+    ::posix_spawnattr_setflags(&attrs.value, flags);
+    return owning_process_id::spawn(path.c_str(), &file_actions.value,
+                                    &attrs.value, argv, envp);
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef spawn_hpp
+#define spawn_hpp
+
+#include <csignal> // for sigset_t
+#include <filesystem>
+#include <vector>
+
+#include "flow/reference_process_id.hpp"
+
+#include "child_actions.hpp"
+
+namespace flow::detail {
+
+/// @brief Whether the given actions can all be performed by
+///   <code>spawn</code> on this platform.
+auto is_spawnable(const std::vector<child_action>& actions) noexcept -> bool;
+
+/// @brief Spawns a child process executing the given file.
+/// @details Uses <code>posix_spawn</code> which on Linux shares the parent's
+///   address space until the child executes the file. So unlike
+///   <code>fork</code>, the cost of this doesn't grow with the parent's
+///   resident set size.
+/// @param[in] path Path of the file to execute.
+/// @param[in] argv Null terminated argument vector.
+/// @param[in] envp Null terminated environment vector.
+/// @param[in] actions Actions for the child to perform in order.
+/// @param[in] mask Signal mask for the child.
+/// @return Identifier of the child on success, else
+///   <code>invalid_process_id</code> with <code>errno</code> set to the
+///   reason. Failures of actions or of executing the file are failures.
+auto spawn(const std::filesystem::path& path,
+           char * const *argv,
+           char * const *envp,
+           const std::vector<child_action>& actions,
+           const sigset_t& mask) -> reference_process_id;
+
+}
+
+#endif /* spawn_hpp */
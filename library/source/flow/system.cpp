@@ -7,7 +7,8 @@ auto operator==(const system& lhs, const system& rhs) noexcept -> bool
 {
     return (lhs.nodes == rhs.nodes)
         && (lhs.environment == rhs.environment)
-        && (lhs.links == rhs.links);
+        && (lhs.links == rhs.links)
+        && (lhs.resources == rhs.resources);
 }
 
 auto operator<<(std::ostream& os, const system& value)
@@ -36,6 +37,10 @@ auto operator<<(std::ostream& os, const system& value)
     if (!empty(value.links)) {
         os << sub_prefix << ".links={";
         os << "}";
+        sub_prefix = ",";
+    }
+    if (value.resources != resource_limits{}) {
+        os << sub_prefix << ".resources=" << value.resources;
     }
     os << "}";
     return os;
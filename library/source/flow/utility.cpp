@@ -28,6 +28,12 @@
 #include "flow/wait_result.hpp"
 #include "flow/wait_status.hpp"
 
+#include <sys/syscall.h> // for SYS_pidfd_send_signal
+
+#if defined(SYS_pidfd_send_signal)
+#define FLOW_HAS_PIDFD_SEND_SIGNAL 1
+#endif
+
 namespace flow {
 
 namespace {
@@ -230,6 +236,14 @@ auto write_diags(instance& object, std::ostream& os,
             show_diags(os, name, p->diags);
         }
     }
+    else if (const auto p = std::get_if<instance::builtin>(&object.info)) {
+        if (!p->diags || !p->diags->is_open()) {
+            os << "Diags are closed for " << name << "\n";
+        }
+        else {
+            show_diags(os, name, *p->diags);
+        }
+    }
     else if (const auto p = std::get_if<instance::system>(&object.info)) {
         for (auto&& entry: p->children) {
             const auto full_name = std::string{name} + "." + entry.first.get();
@@ -290,7 +304,7 @@ auto find_index(const std::span<const link>& links,
 
 auto touch(const file_endpoint& file) -> void
 {
-    static constexpr auto flags = O_CREAT|O_WRONLY;
+    static constexpr auto flags = O_CREAT|O_WRONLY|O_CLOEXEC;
     static constexpr auto mode = 0666;
     if (const auto fd = ::open(file.path.c_str(), flags, mode); fd != -1) { // NOLINT(cppcoreguidelines-pro-type-vararg)
         ::close(fd);
@@ -345,7 +359,18 @@ auto send_signal(signal sig,
             diags << " (";
             diags << pid;
             diags << ")\n";
-            if (kill(pid, sig) == -1) {
+            // Prefer the process file descriptor, when there is one, since
+            // it can't refer to another process that reused the ID.
+#if defined(FLOW_HAS_PIDFD_SEND_SIGNAL)
+            const auto pidfd = q->pidfd();
+            const auto rv = (pidfd != descriptors::invalid_id)
+                ? int(::syscall(SYS_pidfd_send_signal, // NOLINT(cppcoreguidelines-pro-type-vararg)
+                                int(pidfd), int(sig), nullptr, 0u))
+                : kill(pid, sig);
+#else
+            const auto rv = kill(pid, sig);
+#endif
+            if (rv == -1) {
                 diags << "kill(" << *q;
                 diags << "," << sig;
                 diags << ") failed: " << os_error_code(errno);
@@ -369,6 +394,10 @@ auto send_signal(signal sig,
         },
         [&](const instance::forked& info) {
             send_signal(sig, info, diags, name);
+        },
+        [&](const instance::builtin&) {
+            diags << "not sending " << sig << " to built-in ";
+            diags << std::quoted(name) << "\n";
         }
     }, instance.info);
 }
@@ -377,7 +406,9 @@ auto set_signal_handler(signal sig) -> void
 {
     struct sigaction sa{};
     sa.sa_sigaction = sigaction_cb;
-    sa.sa_flags = SA_SIGINFO;
+    // Restart interrupted calls, as the signal may be delivered to any
+    // thread that hasn't blocked it, like ones reading from channels.
+    sa.sa_flags = SA_SIGINFO|SA_RESTART;
     sigfillset(&sa.sa_mask);
     const auto psig = int(sig);
     if (::sigaction(psig, &sa, nullptr) == -1) {
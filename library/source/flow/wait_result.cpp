@@ -1,33 +1,69 @@
+#include <sys/resource.h> // for rusage
 #include <sys/wait.h>
 
+#include <chrono>
 #include <csignal> // for kill
+#include <optional>
 
 #include "flow/instance.hpp"
 #include "flow/node_name.hpp"
 #include "flow/utility.hpp"
 #include "flow/wait_result.hpp"
 
+#include "deadline.hpp"
+#include "notifier.hpp"
+#include "process_status.hpp"
+
 namespace flow {
 
 namespace {
 
-auto wait(instance::forked& instance) -> std::vector<wait_result>
+using clock = std::chrono::steady_clock;
+
+/// @brief Waits for the given instance until the given deadline, if any.
+auto wait(instance::forked& instance,
+          const std::optional<clock::time_point>& deadline)
+    -> std::vector<wait_result>
 {
     return std::visit(detail::overloaded{
-        [&instance](owning_process_id& id){
-            const auto pid = reference_process_id(id);
+        [&instance,&deadline](owning_process_id& id){
+            // A deferred process only has an identifier once it's created.
+            const auto started = deadline
+                ? id.await_start(*deadline)
+                : std::optional{id.await_start()};
+            if (!started) {
+                return std::vector<wait_result>{};
+            }
+            const auto pid = *started;
+            if (pid <= no_process_id) {
+                // No process, or one that was never created.
+                instance.state = id.wait();
+                return std::vector<wait_result>{};
+            }
             auto results = std::vector<wait_result>{};
             for (;;) {
-                const auto result = id.wait();
+                const auto result = deadline
+                    ? id.wait_until(*deadline)
+                    : std::optional{id.wait()};
+                instance.restarts = id.restarts();
+                if (!result) {
+                    break;
+                }
+                if (std::holds_alternative<wait_exit_status>(*result) ||
+                    std::holds_alternative<wait_signaled_status>(*result)) {
+                    instance.usage = id.usage();
+                    results.emplace_back(info_wait_result{
+                        .id = pid,
+                        .status = *result,
+                        .usage = instance.usage
+                    });
+                    instance.state = *result;
+                    break;
+                }
                 results.emplace_back(info_wait_result{
                     .id = pid,
-                    .status = result
+                    .status = *result
                 });
-                if (std::holds_alternative<wait_exit_status>(result) ||
-                    std::holds_alternative<wait_signaled_status>(result)) {
-                    instance.state = result;
-                    break;
-                }
             }
             return results;
         },
@@ -37,6 +73,52 @@ auto wait(instance::forked& instance) -> std::vector<wait_result>
     }, instance.state);
 }
 
+/// @brief Waits for the given instance until the given deadline, if any.
+auto wait(instance::builtin& instance,
+          const std::optional<clock::time_point>& deadline)
+    -> std::vector<wait_result>
+{
+    const auto p = std::get_if<std::future<wait_status>>(&instance.state);
+    if (!p || !p->valid()) {
+        return {};
+    }
+    // One that's notified of finishing is just returning its status.
+    const auto finishing = instance.finishing && instance.finishing->notified();
+    if (deadline && !finishing &&
+        (p->wait_until(*deadline) != std::future_status::ready)) {
+        return {};
+    }
+    const auto status = p->get();
+    instance.state = status;
+    // Built-ins run within this process, so identify them by its ID.
+    return {info_wait_result{
+        .id = current_process_id(),
+        .status = status
+    }};
+}
+
+/// @brief Waits for the given instance until the given deadline, if any.
+auto wait(instance& object, const std::optional<clock::time_point>& deadline)
+    -> std::vector<wait_result>
+{
+    return std::visit(detail::overloaded{
+        [&deadline](instance::forked& obj){
+            return wait(obj, deadline);
+        },
+        [&deadline](instance::builtin& obj){
+            return wait(obj, deadline);
+        },
+        [&deadline](instance::system& obj){
+            auto results = std::vector<wait_result>{};
+            for (auto&& entry: obj.children) {
+                const auto waits = wait(entry.second, deadline);
+                results.insert(end(results), begin(waits), end(waits));
+            }
+            return results;
+        },
+    }, object.info);
+}
+
 }
 
 auto operator<<(std::ostream& os, const empty_wait_result&)
@@ -71,14 +153,15 @@ auto wait(reference_process_id id, wait_option flags) noexcept
     -> wait_result
 {
     auto status = 0;
-    auto pid = decltype(::waitpid(pid_t(id), &status, int(flags))){};
+    auto usage = ::rusage{};
+    auto pid = decltype(::wait4(pid_t(id), &status, int(flags), &usage)){};
     auto err = 0;
     if (pid_t(id) > 0) {
         sigsafe_counter_reset();
     }
     auto sig = SIGINT;
     for (;;) {
-        pid = ::waitpid(pid_t(id), &status, int(flags));
+        pid = ::wait4(pid_t(id), &status, int(flags), &usage);
         err = errno;
         if (pid != -1) {
             break;
@@ -86,7 +169,7 @@ auto wait(reference_process_id id, wait_option flags) noexcept
         if (err != EINTR) {
             break;
         }
-        std::cerr << "waitpid(" << id << ") interrupted by signal\n";
+        std::cerr << "wait4(" << id << ") interrupted by signal\n";
         if (pid_t(id) > 0) {
             if (sigsafe_counter_take()) {
                 ::kill(pid_t(id), sig);
@@ -103,48 +186,30 @@ auto wait(reference_process_id id, wait_option flags) noexcept
     if (pid == 0) {
         return empty_wait_result{};
     }
-    if (WIFEXITED(status)) {
-        // process terminated normally
-        return info_wait_result{reference_process_id{pid},
-            wait_exit_status{WEXITSTATUS(status)}};
-    }
-    if (WIFSIGNALED(status)) {
-        // process terminated due to signal
-        return info_wait_result{reference_process_id{pid},
-            wait_signaled_status{WTERMSIG(status), WCOREDUMP(status) != 0}};
-    }
-    if (WIFSTOPPED(status)) {
-        // See "man 4 termios" for more info. From "man 2 waitpid":
-        // Process not terminated, but stopped due to a SIGTTIN, SIGTTOU,
-        // SIGTSTP, or SIGSTOP signal and can be restarted.
-        // Can be true only if wait call specified WUNTRACED option or if
-        // child process is being traced.
-        return info_wait_result{reference_process_id{pid},
-            wait_stopped_status{WSTOPSIG(status)}};
-    }
-    if (WIFCONTINUED(status)) {
-        // process was resumed
-        return info_wait_result{reference_process_id{pid},
-            wait_continued_status{}};
-    }
-    return info_wait_result{reference_process_id{pid}};
+    // Usage is only reported for processes that have terminated.
+    const auto terminated = WIFEXITED(status) || WIFSIGNALED(status);
+    return info_wait_result{
+        reference_process_id{pid},
+        detail::to_wait_status(status),
+        terminated? detail::to_process_usage(usage): process_usage{}
+    };
 }
 
 auto wait(instance& object) -> std::vector<wait_result>
 {
-    return std::visit(detail::overloaded{
-        [](instance::forked& obj){
-            return wait(obj);
-        },
-        [](instance::system& obj){
-            auto results = std::vector<wait_result>{};
-            for (auto&& entry: obj.children) {
-                const auto waits = wait(entry.second);
-                results.insert(end(results), begin(waits), end(waits));
-            }
-            return results;
-        },
-    }, object.info);
+    return wait(object, std::nullopt);
+}
+
+auto wait_until(instance& object, std::chrono::steady_clock::time_point deadline)
+    -> std::vector<wait_result>
+{
+    return wait(object, std::optional{deadline});
+}
+
+auto wait_for(instance& object, std::chrono::nanoseconds timeout)
+    -> std::vector<wait_result>
+{
+    return wait_until(object, detail::deadline_after(timeout));
 }
 
 }
@@ -0,0 +1,825 @@
+#include <algorithm> // for std::max, std::none_of, std::stable_partition
+#include <cerrno> // for errno
+#include <cstdint> // for std::uint64_t
+#include <cstdlib> // for std::getenv, EXIT_FAILURE
+#include <cstring> // for std::memcpy, std::strlen
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <sstream> // for std::ostringstream
+#include <string>
+#include <type_traits> // for std::is_trivially_copyable_v
+#include <utility> // for std::pair
+#include <variant>
+
+#include <dlfcn.h> // for ::dladdr
+#include <fcntl.h> // for ::open, ::fcntl
+#include <spawn.h>
+#include <unistd.h> // for ::access, ::close, ::syscall, ::_exit
+
+#include <linux/sched.h> // for clone_args, CLONE_PIDFD
+#include <sys/socket.h>
+#include <sys/syscall.h> // for SYS_clone3
+
+#include "flow/os_error_code.hpp"
+#include "flow/owning_process_id.hpp"
+#include "flow/utility.hpp"
+
+#include "zygote.hpp"
+
+#if defined(__GLIBC__) && \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 34)))
+#define FLOW_HAS_SPAWN_ADDCLOSEFROM 1
+#endif
+
+namespace flow::detail {
+
+namespace {
+
+constexpr auto exit_failure_code = EXIT_FAILURE;
+
+/// @brief Maximum number of descriptors passable in one message.
+/// @note This is Linux's <code>SCM_MAX_FD</code>.
+constexpr auto max_fds = 253u;
+
+/// @brief Capacity to initially reserve for encoding a request.
+constexpr auto initial_request_size = 4096u;
+
+/// @brief Reply of the zygote to a request.
+/// @note The child's process file descriptor, if any, accompanies this.
+struct reply
+{
+    int err{};
+    int pid{-1};
+};
+
+struct encoder
+{
+    template <class T>
+    requires std::is_trivially_copyable_v<T>
+    auto put(const T& value) -> void
+    {
+        const auto p = reinterpret_cast<const char*>(&value);
+        data.insert(end(data), p, p + sizeof(T));
+    }
+
+    auto put_string(const char *s) -> void
+    {
+        const auto n = std::strlen(s);
+        put(n);
+        data.insert(end(data), s, s + n);
+    }
+
+    auto put_strings(char * const *strings) -> void
+    {
+        auto n = std::size_t{};
+        while (strings[n]) {
+            ++n;
+        }
+        put(n);
+        for (auto i = std::size_t{}; i < n; ++i) {
+            put_string(strings[i]);
+        }
+    }
+
+    std::vector<char> data;
+};
+
+struct decoder
+{
+    template <class T>
+    requires std::is_trivially_copyable_v<T>
+    auto get(T& value) -> bool
+    {
+        if ((size(data) - pos) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    auto get_string(std::string& value) -> bool
+    {
+        auto n = std::size_t{};
+        if (!get(n) || ((size(data) - pos) < n)) {
+            return false;
+        }
+        value.assign(data.data() + pos, n);
+        pos += n;
+        return true;
+    }
+
+    std::span<const char> data;
+    std::size_t pos{};
+};
+
+/// @brief Decoded request for the zygote to create a child.
+struct request
+{
+    /// @brief Storage for the strings pointed to by the other members.
+    /// @note This is a deque so adding to it doesn't move the strings.
+    std::deque<std::string> strings;
+    const char *path{};
+    std::vector<char*> argv;
+    std::vector<char*> envp;
+    std::vector<child_action> actions;
+    sigset_t mask{};
+    int diags{-1};
+
+    /// @brief Index of the passed descriptor of the file to execute, or -1.
+    int fd{-1};
+};
+
+auto get_string(decoder& in, request& req) -> const char*
+{
+    auto& s = req.strings.emplace_back();
+    return in.get_string(s)? s.c_str(): nullptr;
+}
+
+auto get_strings(decoder& in, request& req, std::vector<char*>& strings)
+    -> bool
+{
+    auto n = std::size_t{};
+    if (!in.get(n)) {
+        return false;
+    }
+    for (auto i = std::size_t{}; i < n; ++i) {
+        const auto s = get_string(in, req);
+        if (!s) {
+            return false;
+        }
+        strings.push_back(const_cast<char*>(s)); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    }
+    strings.push_back(nullptr);
+    return true;
+}
+
+auto put(encoder& out, const child_action& action,
+         std::map<int, std::size_t>& sources) -> void
+{
+    out.put(action.index());
+    std::visit(overloaded{
+        [&out](const close_action& a) {
+            out.put(a.fd);
+        },
+        [&out](const close_range_action& a) {
+            out.put(a.first);
+            out.put(a.last);
+        },
+        [&out,&sources](const dup2_action& a) {
+            // Sources are sent as indices into the passed descriptors.
+            const auto index = sources.emplace(a.fd, size(sources) + 1u);
+            out.put(int(index.first->second));
+            out.put(a.newfd);
+        },
+        [&out](const open_action& a) {
+            out.put(a.fd);
+            out.put_string(a.path);
+            out.put(a.flags);
+            out.put(a.mode);
+        },
+        [&out](const chdir_action& a) {
+            out.put_string(a.path);
+        },
+        [&out](const fchdir_action& a) {
+            out.put(a.fd);
+        },
+        [&out](const setpgid_action& a) {
+            out.put(int(a.pgrp));
+        },
+        [&out,&sources](const cgroup_action& a) {
+            // Sent like the sources of dup2 actions.
+            const auto index = sources.emplace(a.fd, size(sources) + 1u);
+            out.put(int(index.first->second));
+        },
+        [&out](const affinity_action& a) {
+            out.put(a.cpus);
+        },
+        [&out](const mempolicy_action& a) {
+            out.put(a.mode);
+            out.put(a.nodes);
+        },
+        [&out](const nice_action& a) {
+            out.put(a.value);
+        },
+        [&out](const scheduler_action& a) {
+            out.put(a.policy);
+        },
+        [&out](const ioprio_action& a) {
+            out.put(a.value);
+        },
+    }, action);
+}
+
+template <class T>
+auto get_action(decoder& in, request& req, T& action) -> bool;
+
+template <>
+auto get_action(decoder& in, request&, close_action& action) -> bool
+{
+    return in.get(action.fd);
+}
+
+template <>
+auto get_action(decoder& in, request&, close_range_action& action) -> bool
+{
+    return in.get(action.first) && in.get(action.last);
+}
+
+template <>
+auto get_action(decoder& in, request&, dup2_action& action) -> bool
+{
+    return in.get(action.fd) && in.get(action.newfd);
+}
+
+template <>
+auto get_action(decoder& in, request& req, open_action& action) -> bool
+{
+    return in.get(action.fd) &&
+           ((action.path = get_string(in, req)) != nullptr) &&
+           in.get(action.flags) && in.get(action.mode);
+}
+
+template <>
+auto get_action(decoder& in, request& req, chdir_action& action) -> bool
+{
+    return (action.path = get_string(in, req)) != nullptr;
+}
+
+template <>
+auto get_action(decoder& in, request&, fchdir_action& action) -> bool
+{
+    return in.get(action.fd);
+}
+
+template <>
+auto get_action(decoder& in, request&, setpgid_action& action) -> bool
+{
+    auto pgrp = int{};
+    if (!in.get(pgrp)) {
+        return false;
+    }
+    action.pgrp = reference_process_id{pgrp};
+    return true;
+}
+
+template <>
+auto get_action(decoder& in, request&, cgroup_action& action) -> bool
+{
+    return in.get(action.fd);
+}
+
+template <>
+auto get_action(decoder& in, request&, affinity_action& action) -> bool
+{
+    return in.get(action.cpus);
+}
+
+template <>
+auto get_action(decoder& in, request&, mempolicy_action& action) -> bool
+{
+    return in.get(action.mode) && in.get(action.nodes);
+}
+
+template <>
+auto get_action(decoder& in, request&, nice_action& action) -> bool
+{
+    return in.get(action.value);
+}
+
+template <>
+auto get_action(decoder& in, request&, scheduler_action& action) -> bool
+{
+    return in.get(action.policy);
+}
+
+template <>
+auto get_action(decoder& in, request&, ioprio_action& action) -> bool
+{
+    return in.get(action.value);
+}
+
+template <std::size_t I = 0u>
+auto get_action(decoder& in, request& req, std::size_t index) -> bool
+{
+    if constexpr (I < std::variant_size_v<child_action>) {
+        if (index == I) {
+            auto action = std::variant_alternative_t<I, child_action>{};
+            if (!get_action(in, req, action)) {
+                return false;
+            }
+            req.actions.emplace_back(action);
+            return true;
+        }
+        return get_action<I + 1u>(in, req, index);
+    }
+    else {
+        return false;
+    }
+}
+
+auto decode(std::span<const char> data) -> std::optional<request>
+{
+    auto in = decoder{data};
+    auto result = request{};
+    auto count = std::size_t{};
+    result.path = get_string(in, result);
+    if (!result.path ||
+        !in.get(result.mask) || !in.get(result.diags) ||
+        !in.get(result.fd) ||
+        !get_strings(in, result, result.argv) ||
+        !get_strings(in, result, result.envp) ||
+        !in.get(count)) {
+        return {};
+    }
+    for (auto i = std::size_t{}; i < count; ++i) {
+        auto index = std::size_t{};
+        if (!in.get(index) || !get_action(in, result, index)) {
+            return {};
+        }
+    }
+    return {std::move(result)};
+}
+
+/// @brief Whether the child keeps the given descriptor open from its
+///   creator, given the actions it performs.
+auto is_inherited(int fd, const std::vector<child_action>& actions) -> bool
+{
+    return std::none_of(begin(actions), end(actions), [fd](const auto& a){
+        return std::visit(overloaded{
+            [](const auto&) {
+                return false;
+            },
+            [fd](const close_action& a) {
+                return a.fd == fd;
+            },
+            [fd](const close_range_action& a) {
+                return (unsigned(fd) >= a.first) && (unsigned(fd) <= a.last);
+            },
+            [fd](const dup2_action& a) {
+                return a.newfd == fd;
+            },
+            [fd](const open_action& a) {
+                return a.fd == fd;
+            },
+        }, a);
+    });
+}
+
+/// @brief Gets one past the highest descriptor the child could inherit.
+/// @note Descriptors the child's actions leave open from its creator must
+///   be passed to the zygote for it to do the same.
+auto inheritable_bound(const std::vector<child_action>& actions) -> int
+{
+    auto result = 0u;
+    for (auto&& action: actions) {
+        if (const auto p = std::get_if<close_range_action>(&action)) {
+            if (p->last == close_range_action::unbounded) {
+                result = std::max(result, p->first);
+            }
+        }
+    }
+    return int(result);
+}
+
+auto send(int socket, const std::vector<char>& data,
+          const std::vector<int>& fds) -> bool
+{
+    auto iov = iovec{
+        const_cast<char*>(data.data()), // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        size(data)
+    };
+    auto control = std::vector<char>(CMSG_SPACE(sizeof(int) * size(fds)));
+    auto msg = msghdr{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1u;
+    if (!empty(fds)) {
+        msg.msg_control = control.data();
+        msg.msg_controllen = size(control);
+        const auto cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * size(fds));
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * size(fds));
+    }
+    for (;;) {
+        if (::sendmsg(socket, &msg, MSG_NOSIGNAL) != -1) {
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+/// @brief Receives a message and the descriptors accompanying it.
+/// @note Received descriptors are close-on-exec.
+/// @return Size of the message, zero at end of file, else -1 with
+///   <code>errno</code> set to the reason.
+auto receive(int socket, std::vector<char>& data,
+             std::vector<owning_descriptor>& fds) -> ssize_t
+{
+    auto control = std::vector<char>(CMSG_SPACE(sizeof(int) * max_fds));
+    auto iov = iovec{data.data(), size(data)};
+    auto msg = msghdr{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1u;
+    msg.msg_control = control.data();
+    msg.msg_controllen = size(control);
+    auto n = ssize_t{};
+    do {
+        n = ::recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+    } while ((n == -1) && (errno == EINTR));
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if ((cmsg->cmsg_level == SOL_SOCKET) &&
+            (cmsg->cmsg_type == SCM_RIGHTS)) {
+            const auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (auto i = std::size_t{}; i < count; ++i) {
+                auto fd = int{};
+                std::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int),
+                            sizeof(int));
+                fds.emplace_back(fd);
+            }
+        }
+    }
+    if ((n != -1) && ((msg.msg_flags & (MSG_TRUNC|MSG_CTRUNC)) != 0)) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    return n;
+}
+
+/// @brief Creates a child of the zygote's parent for the given request.
+/// @param[in,out] req Request whose <code>dup2_action</code> sources, &
+///   <code>cgroup_action</code> directories, are indices into @p fds.
+///   Element zero of which is the directory for the child to work in.
+auto serve(request& req, const std::vector<owning_descriptor>& fds)
+    -> std::pair<reply, owning_descriptor>
+{
+    // Move the passed descriptors out of the way of those the actions
+    // target, so no action overwrites the source of another.
+    auto min_fd = std::max(req.diags, 2) + 1;
+    for (auto&& action: req.actions) {
+        if (const auto p = std::get_if<dup2_action>(&action)) {
+            min_fd = std::max(min_fd, p->newfd + 1);
+        }
+        else if (const auto p = std::get_if<open_action>(&action)) {
+            min_fd = std::max(min_fd, p->fd + 1);
+        }
+    }
+    auto moved = std::vector<owning_descriptor>{};
+    for (auto&& fd: fds) {
+        moved.emplace_back(::fcntl( // NOLINT(cppcoreguidelines-pro-type-vararg)
+                                   int(fd), F_DUPFD_CLOEXEC, min_fd));
+        if (!moved.back()) {
+            return {reply{.err = errno}, owning_descriptor{}};
+        }
+    }
+    if (empty(moved)) {
+        return {reply{.err = EPROTO}, owning_descriptor{}};
+    }
+    // The child's created straight into its control group where possible.
+    auto cgroup = -1;
+    for (auto&& action: req.actions) {
+        if (const auto p = std::get_if<dup2_action>(&action)) {
+            const auto index = std::size_t(p->fd);
+            if ((index == 0u) || (index >= size(moved))) {
+                return {reply{.err = EPROTO}, owning_descriptor{}};
+            }
+            p->fd = int(moved[index]);
+        }
+        else if (const auto p = std::get_if<cgroup_action>(&action)) {
+            const auto index = std::size_t(p->fd);
+            if ((index == 0u) || (index >= size(moved))) {
+                return {reply{.err = EPROTO}, owning_descriptor{}};
+            }
+            p->fd = int(moved[index]);
+            cgroup = p->fd;
+        }
+    }
+    if (req.fd >= 0) {
+        if ((req.fd == 0) || (std::size_t(req.fd) >= size(moved))) {
+            return {reply{.err = EPROTO}, owning_descriptor{}};
+        }
+        req.fd = int(moved[std::size_t(req.fd)]);
+    }
+    // Joining the group goes first, since its descriptor's been moved to
+    // where the actions may close it.
+    std::stable_partition(begin(req.actions), end(req.actions),
+                          [](const child_action& a){
+        return std::holds_alternative<cgroup_action>(a);
+    });
+    req.actions.insert(begin(req.actions), fchdir_action{int(moved[0])});
+
+    // CLONE_PARENT makes the child a child of the zygote's parent, which
+    // then waits on it like any other child of its own.
+    auto pidfd = -1;
+    auto args = clone_args{};
+    args.flags = CLONE_PARENT|CLONE_PIDFD;
+    args.pidfd = std::uint64_t(reinterpret_cast<std::uintptr_t>(&pidfd));
+    if (cgroup >= 0) {
+        args.flags |= CLONE_INTO_CGROUP;
+        args.cgroup = std::uint64_t(cgroup);
+    }
+    auto pid = ::syscall(SYS_clone3, &args, sizeof(args)); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    if ((pid == -1) && (cgroup >= 0)) {
+        // Leave joining the control group to the child's action for it.
+        args.flags &= ~std::uint64_t{CLONE_INTO_CGROUP};
+        args.cgroup = 0u;
+        pid = ::syscall(SYS_clone3, &args, sizeof(args)); // NOLINT(cppcoreguidelines-pro-type-vararg)
+    }
+    if (pid == -1) {
+        return {reply{.err = errno}, owning_descriptor{}};
+    }
+    if (pid == 0) {
+        ::sigprocmask(SIG_SETMASK, &req.mask, nullptr);
+        // NOTE: the following only returns on failure!
+        exec(req.path, req.fd, req.argv.data(), req.envp.data(),
+             req.actions, req.diags);
+        ::_exit(exit_failure_code);
+    }
+    return {reply{.pid = int(pid)}, owning_descriptor{pidfd}};
+}
+
+/// @brief Name of the zygote's executable.
+constexpr auto zygote_name = "flow-zygote";
+
+/// @brief Finds the zygote's executable.
+/// @details This is the file the <code>FLOW_ZYGOTE</code> environment
+///   variable names if it's set. Else it's the first executable named
+///   <code>zygote_name</code> that's in the directory of the file this
+///   library's loaded from, in the <code>bin</code> directory beside that,
+///   or in the directory of this process's executable. So it's found in
+///   build & install trees alike, wherever they've been moved to.
+/// @return Path of the executable, else the empty path if none's found.
+auto find_zygote() -> std::filesystem::path
+{
+    if (const auto env_path = std::getenv("FLOW_ZYGOTE")) { // NOLINT(concurrency-mt-unsafe)
+        return env_path;
+    }
+    auto dirs = std::vector<std::filesystem::path>{};
+    auto info = Dl_info{};
+    if ((::dladdr(reinterpret_cast<void*>(&zygote_spawn), &info) != 0) && // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        (info.dli_fname != nullptr) && (*info.dli_fname != '\0')) {
+        auto ec = std::error_code{};
+        const auto dir = std::filesystem::canonical(info.dli_fname, ec)
+                             .parent_path();
+        if (!ec) {
+            dirs.push_back(dir);
+            dirs.push_back(dir.parent_path() / "bin");
+        }
+    }
+    auto ec = std::error_code{};
+    const auto exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (!ec) {
+        dirs.push_back(exe.parent_path());
+    }
+    for (auto&& dir: dirs) {
+        const auto path = dir / zygote_name;
+        if (::access(path.c_str(), X_OK) == 0) {
+            return path;
+        }
+    }
+    return {};
+}
+
+/// @brief Client side of the zygote.
+struct client
+{
+    /// @brief Starts the zygote if not already running for this process.
+    /// @note On failure, <code>errno</code> says why.
+    auto start() -> bool;
+
+    /// @brief Describes why the zygote couldn't be started.
+    /// @return The description the first time this is called, else the
+    ///   empty string, so it's only reported once.
+    auto take_failure(int err) -> std::string;
+
+    std::mutex mutex;
+    owning_descriptor socket;
+
+    /// @brief Path of the zygote's executable, once it's been looked for.
+    std::optional<std::filesystem::path> path;
+
+    /// @brief Whether a failure to start the zygote's been described.
+    bool failure_taken{};
+
+    /// @brief Process the zygote was started by.
+    /// @note A forked copy of that process must start its own zygote,
+    ///   since the zygote's children are children of the starting process.
+    reference_process_id owner{invalid_process_id};
+};
+
+auto client::start() -> bool
+{
+    if (socket && (owner == current_process_id())) {
+        return true;
+    }
+    socket = {};
+    if (!path) {
+        path = find_zygote();
+    }
+    if (path->empty()) {
+        errno = ENOENT;
+        return false;
+    }
+    int fds[2]; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    if (::socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC, 0, fds) == -1) {
+        return false;
+    }
+    auto ours = owning_descriptor{fds[0]};
+    auto theirs = owning_descriptor{fds[1]};
+    if (int(theirs) == zygote_fd) {
+        // Duplicating a descriptor onto itself may leave it close-on-exec.
+        theirs = owning_descriptor{
+            ::fcntl(int(theirs), F_DUPFD_CLOEXEC, zygote_fd + 1) // NOLINT(cppcoreguidelines-pro-type-vararg)
+        };
+        if (!theirs) {
+            return false;
+        }
+    }
+    posix_spawn_file_actions_t file_actions{};
+    ::posix_spawn_file_actions_init(&file_actions);
+    ::posix_spawn_file_actions_adddup2(&file_actions, int(theirs), zygote_fd);
+#if defined(FLOW_HAS_SPAWN_ADDCLOSEFROM)
+    ::posix_spawn_file_actions_addclosefrom_np(&file_actions, zygote_fd + 1);
+#endif
+    posix_spawnattr_t attrs{};
+    ::posix_spawnattr_init(&attrs);
+    sigset_t mask{};
+    sigemptyset(&mask);
+    ::posix_spawnattr_setsigmask(&attrs, &mask);
+    ::posix_spawnattr_setflags(&attrs, POSIX_SPAWN_SETSIGMASK);
+    std::string arg0{zygote_name};
+    char *argv[] = {arg0.data(), nullptr}; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    char *envp[] = {nullptr}; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    // The zygote's not owned: its exit status is left to the manager, and
+    // owning it would have a forked copy of this process wait on it.
+    const auto pid = owning_process_id::spawn(path->c_str(), &file_actions,
+                                              &attrs, argv, envp);
+    const auto err = errno;
+    ::posix_spawnattr_destroy(&attrs);
+    ::posix_spawn_file_actions_destroy(&file_actions);
+    if (pid == invalid_process_id) {
+        errno = err;
+        return false;
+    }
+    socket = std::move(ours);
+    owner = current_process_id();
+    return true;
+}
+
+auto client::take_failure(int err) -> std::string
+{
+    if (failure_taken) {
+        return {};
+    }
+    failure_taken = true;
+    std::ostringstream os;
+    if (path && !path->empty()) {
+        os << "can't start zygote " << *path << ": " << os_error_code(err);
+    }
+    else {
+        os << "can't find " << zygote_name;
+        os << ", set FLOW_ZYGOTE to its path";
+    }
+    return os.str();
+}
+
+auto the_client() -> client&
+{
+    static client singleton;
+    return singleton;
+}
+
+}
+
+auto zygote_spawn(const std::filesystem::path& path,
+                  int fd,
+                  char * const *argv,
+                  char * const *envp,
+                  const std::vector<child_action>& actions,
+                  const sigset_t& mask,
+                  int diags) -> zygote_child
+{
+    const auto cwd = owning_descriptor{
+        ::open(".", O_PATH|O_DIRECTORY|O_CLOEXEC) // NOLINT(cppcoreguidelines-pro-type-vararg)
+    };
+    if (!cwd) {
+        return {};
+    }
+    auto fds = std::vector<int>{int(cwd)};
+    auto sources = std::map<int, std::size_t>{};
+    auto inherited = std::vector<child_action>{};
+    // Inherit diags first so failures of the other actions reach it.
+    if (diags >= 0) {
+        inherited.emplace_back(dup2_action{diags, diags});
+    }
+    // Other descriptors that are close-on-exec needn't be inherited.
+    const auto bound = inheritable_bound(actions);
+    for (auto d = 0; d < bound; ++d) {
+        if ((d != diags) && is_inherited(d, actions)) {
+            const auto flags = ::fcntl(d, F_GETFD); // NOLINT(cppcoreguidelines-pro-type-vararg)
+            if ((flags != -1) && ((flags & FD_CLOEXEC) == 0)) {
+                inherited.emplace_back(dup2_action{d, d});
+            }
+        }
+    }
+    auto out = encoder{};
+    // Also keeps GCC 12 from warning of bogus overflows of the empty data.
+    out.data.reserve(initial_request_size);
+    out.put_string(path.c_str());
+    out.put(mask);
+    out.put(diags);
+    out.put((fd >= 0)? int(sources.emplace(fd, 1u).first->second): -1);
+    out.put_strings(argv);
+    out.put_strings(envp);
+    out.put(size(inherited) + size(actions));
+    for (auto&& action: inherited) {
+        put(out, action, sources);
+    }
+    for (auto&& action: actions) {
+        put(out, action, sources);
+    }
+    fds.resize(size(sources) + 1u);
+    for (auto&& entry: sources) {
+        fds[entry.second] = entry.first;
+    }
+    if (size(fds) > max_fds) {
+        errno = EMSGSIZE;
+        return {};
+    }
+
+    auto& zygote = the_client();
+    const std::lock_guard lock{zygote.mutex};
+    if (!zygote.start()) {
+        const auto err = errno;
+        auto result = zygote_child{};
+        result.unavailable = zygote.take_failure(err);
+        errno = err;
+        return result;
+    }
+    if (!send(int(zygote.socket), out.data, fds)) {
+        zygote.socket = {};
+        return {};
+    }
+    auto data = std::vector<char>(sizeof(reply));
+    auto pidfds = std::vector<owning_descriptor>{};
+    const auto n = receive(int(zygote.socket), data, pidfds);
+    if (n != ssize_t(sizeof(reply))) {
+        zygote.socket = {};
+        errno = (n == -1)? errno: EPIPE;
+        return {};
+    }
+    auto result = reply{};
+    std::memcpy(&result, data.data(), sizeof(result));
+    if (result.err != 0) {
+        errno = result.err;
+        return {};
+    }
+    return {
+        reference_process_id{result.pid},
+        empty(pidfds)? owning_descriptor{}: std::move(pidfds.front()),
+        {}
+    };
+}
+
+auto zygote_main() -> int
+{
+    const auto fd = zygote_fd;
+    for (;;) {
+        const auto size = ::recv(fd, nullptr, 0u, MSG_PEEK|MSG_TRUNC);
+        if (size == 0) {
+            return 0;
+        }
+        if (size == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return exit_failure_code;
+        }
+        auto data = std::vector<char>(std::size_t(size));
+        auto fds = std::vector<owning_descriptor>{};
+        if (receive(fd, data, fds) != size) {
+            return exit_failure_code;
+        }
+        auto req = decode(data);
+        auto result = req? serve(*req, fds):
+            std::pair{reply{.err = EPROTO}, owning_descriptor{}};
+        auto out = encoder{};
+        out.put(result.first);
+        auto pidfds = std::vector<int>{};
+        if (result.second) {
+            pidfds.push_back(int(result.second));
+        }
+        if (!send(fd, out.data, pidfds)) {
+            return exit_failure_code;
+        }
+    }
+}
+
+}
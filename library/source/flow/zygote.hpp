@@ -0,0 +1,74 @@
+#ifndef zygote_hpp
+#define zygote_hpp
+
+#include <csignal> // for sigset_t
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "flow/owning_descriptor.hpp"
+#include "flow/reference_process_id.hpp"
+
+#include "child_actions.hpp"
+
+namespace flow::detail {
+
+/// @brief Result of having the zygote create a child.
+struct zygote_child
+{
+    /// @brief Identifier of the child, else <code>invalid_process_id</code>.
+    reference_process_id pid{invalid_process_id};
+
+    /// @brief Process file descriptor for the child, if one was made.
+    owning_descriptor pidfd;
+
+    /// @brief Why the zygote couldn't be started, if it couldn't be.
+    /// @note This is only given the first time, so it's reported once.
+    std::string unavailable;
+};
+
+/// @brief Has the zygote create a child executing the given file.
+/// @details The zygote is a small helper process, started on first use,
+///   that creates children by forking its own small address space instead
+///   of this process's. Its children are made children of this process so
+///   they're waited on like any other. This process's working directory and
+///   the descriptors the actions need are passed along with the request.
+///   Other attributes, like resource limits, are those this process had
+///   when the zygote was started.
+/// @note The zygote's file is found from the <code>FLOW_ZYGOTE</code>
+///   environment variable if set, else beside this library or this
+///   process's executable.
+/// @param[in] path Path of the file to execute.
+/// @param[in] fd Descriptor of the file to execute, or -1 for none.
+/// @param[in] argv Null terminated argument vector.
+/// @param[in] envp Null terminated environment vector.
+/// @param[in] actions Actions for the child to perform in order.
+/// @param[in] mask Signal mask for the child.
+/// @param[in] diags Descriptor for the child to write a line describing
+///   any failure to. This must be kept open by the actions.
+/// @see exec.
+/// @return Identifier of the child on success, else
+///   <code>invalid_process_id</code> with <code>errno</code> set to the
+///   reason. Failures of actions or of executing the file aren't failures
+///   of this, but are reported to @p diags and exit the child with a
+///   failure code.
+auto zygote_spawn(const std::filesystem::path& path,
+                  int fd,
+                  char * const *argv,
+                  char * const *envp,
+                  const std::vector<child_action>& actions,
+                  const sigset_t& mask,
+                  int diags) -> zygote_child;
+
+/// @brief Descriptor of the socket the zygote serves requests from.
+constexpr auto zygote_fd = 3;
+
+/// @brief Serves requests from <code>zygote_spawn</code> until the socket
+///   they come from is closed.
+/// @note This is the body of the zygote's executable.
+/// @return Exit status for the zygote.
+auto zygote_main() -> int;
+
+}
+
+#endif /* zygote_hpp */
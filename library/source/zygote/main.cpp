@@ -0,0 +1,10 @@
+/// @file main.cpp
+/// @brief Zygote executable that creates processes on behalf of the library.
+/// @see flow::detail::zygote_spawn.
+
+#include "../flow/zygote.hpp"
+
+auto main() -> int
+{
+    return flow::detail::zygote_main();
+}
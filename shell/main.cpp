@@ -1,10 +1,12 @@
-#include <cstdlib> // for std::strtol
+#include <chrono>
+#include <cstdlib> // for std::strtol, std::strtod
 #include <functional> // for std::function, std::reference_wrapper
 #include <iomanip> // for std::quoted
 #include <iostream>
 #include <iterator>
 #include <iomanip> // for std::setw
 #include <memory> // for std::unique_ptr
+#include <optional>
 #include <ostream> // for std::flush
 #include <span>
 #include <stack>
@@ -41,6 +43,7 @@ const auto file_prefix = std::string{"--file="};
 const auto src_prefix = std::string{"--src="};
 const auto dst_prefix = std::string{"--dst="};
 const auto rebase_prefix = std::string{"--rebase="};
+const auto timeout_prefix = std::string{"--timeout="};
 const auto help_argument = std::string{"--help"};
 const auto usage_argument = std::string{"--usage"};
 const auto closed_argument = std::string{"--closed"};
@@ -1068,6 +1071,25 @@ auto do_show_nodes(const flow::node& context, const string_span& args) -> void
     }
 }
 
+/// @brief Whether every process of the given instance has been waited on.
+auto is_waited(const flow::instance& instance) -> bool
+{
+    if (const auto p = std::get_if<flow::instance::forked>(&instance.info)) {
+        return std::holds_alternative<flow::wait_status>(p->state);
+    }
+    if (const auto p = std::get_if<flow::instance::builtin>(&instance.info)) {
+        return std::holds_alternative<flow::wait_status>(p->state);
+    }
+    if (const auto p = std::get_if<flow::instance::system>(&instance.info)) {
+        for (auto&& entry: p->children) {
+            if (!is_waited(entry.second)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 auto do_wait(flow::instance& instance, const string_span& args) -> void
 {
     auto usage = [&](std::ostream& os){
@@ -1077,8 +1099,9 @@ auto do_wait(flow::instance& instance, const string_span& args) -> void
         os << help_argument;
         os << '|';
         os << usage_argument;
-        os << "|<instance-name>...\n";
+        os << "|[" << timeout_prefix << "<seconds>] <instance-name>...\n";
     };
+    auto timeout = std::optional<std::chrono::nanoseconds>{};
     auto& instances = std::get<flow::instance::system>(instance.info).children;
     for (auto&& arg: args.subspan(1u)) {
         if (arg == help_argument) {
@@ -1089,6 +1112,25 @@ auto do_wait(flow::instance& instance, const string_span& args) -> void
             usage(std::cout);
             return;
         }
+        if (arg.starts_with(timeout_prefix)) {
+            const auto value = arg.substr(size(timeout_prefix));
+            auto end = static_cast<char*>(nullptr);
+            const auto seconds = std::strtod(value.c_str(), &end);
+            // Rules out infinities, NaNs & what nanoseconds can't hold,
+            // which converting to them would be undefined for.
+            static const auto max_seconds = std::chrono::duration<double>{
+                std::chrono::nanoseconds::max()
+            }.count();
+            if (value.empty() || (*end != '\0') || !(seconds >= 0) ||
+                !(seconds < max_seconds)) {
+                std::cerr << std::quoted(value);
+                std::cerr << ": not a valid number of seconds\n";
+                return;
+            }
+            timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::duration<double>{seconds});
+            continue;
+        }
         auto name = flow::node_name{};
         try {
             name = flow::node_name{arg};
@@ -1105,9 +1147,17 @@ auto do_wait(flow::instance& instance, const string_span& args) -> void
             std::cerr << "\n";
             continue;
         }
-        const auto results = wait(it->second);
+        const auto results = timeout
+            ? wait_for(it->second, *timeout)
+            : wait(it->second);
         print(results, true);
         write_diags(it->second, std::cerr, arg);
+        if (!is_waited(it->second)) {
+            std::cerr << "timed out waiting for all of ";
+            std::cerr << name;
+            std::cerr << "\n";
+            continue;
+        }
         instances.erase(it);
     }
 }
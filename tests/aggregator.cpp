@@ -0,0 +1,111 @@
+#include <algorithm> // for std::sort
+#include <future>
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream, std::istringstream
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flow/aggregator.hpp"
+#include "flow/pipe_channel.hpp"
+
+using namespace flow;
+
+namespace {
+
+/// @brief Gets the lines of the given aggregation's output, sorted since
+///   groups are output in no particular order.
+auto group_by(const aggregator& spec, const std::string& input)
+    -> std::vector<std::string>
+{
+    pipe_channel in;
+    pipe_channel out;
+    auto aggregating = std::async(std::launch::async, [&](){
+        group_by(spec, in.get(pipe_channel::io::read),
+                 out.get(pipe_channel::io::write));
+        out.close(pipe_channel::io::write, std::cerr);
+    });
+    write(in, input);
+    std::ostringstream os;
+    read(out, std::ostream_iterator<char>(os));
+    aggregating.get();
+    auto lines = std::vector<std::string>{};
+    std::istringstream is{os.str()};
+    for (std::string line; std::getline(is, line);) {
+        lines.push_back(line);
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+}
+
+TEST(aggregator, default_construction)
+{
+    const auto obj = aggregator{};
+    EXPECT_TRUE(empty(obj.key_fields));
+    ASSERT_EQ(size(obj.aggregates), 1u);
+    EXPECT_EQ(obj.aggregates.front().function, aggregate_function::count);
+    EXPECT_EQ(obj.field_delimiter, '\t');
+    EXPECT_EQ(obj.record_delimiter, '\n');
+    EXPECT_EQ(obj.memory_budget, aggregator::default_memory_budget);
+    EXPECT_EQ(obj.threads, 0u);
+    EXPECT_TRUE(obj.temporary_directory.empty());
+}
+
+TEST(aggregator, count_whole_records)
+{
+    EXPECT_EQ(group_by(aggregator{}, "b\na\nb\nc\nb\na"),
+              (std::vector<std::string>{"a\t2", "b\t3", "c\t1"}));
+}
+
+TEST(aggregator, key_fields_and_aggregates)
+{
+    const auto spec = aggregator{
+        .key_fields = {3u, 1u},
+        .aggregates = {
+            {aggregate_function::count},
+            {aggregate_function::sum, 2u},
+            {aggregate_function::min, 2u},
+            {aggregate_function::max, 2u},
+        },
+        .field_delimiter = ',',
+        .threads = 2u,
+    };
+    EXPECT_EQ(group_by(spec, "x,1,p\ny,5,p\nx,-2.5,p\nx,4,q\n"),
+              (std::vector<std::string>{
+                  "p,x,2,-1.5,-2.5,1",
+                  "p,y,1,5,5,5",
+                  "q,x,1,4,4,4",
+              }));
+}
+
+TEST(aggregator, spills_and_merges)
+{
+    const auto spec = aggregator{
+        .key_fields = {1u},
+        .aggregates = {
+            {aggregate_function::count},
+            {aggregate_function::sum, 2u},
+        },
+        .memory_budget = 1024u,
+        .threads = 2u,
+    };
+    static constexpr auto groups = 20000u;
+    static constexpr auto repeats = 3u;
+    std::string input;
+    for (auto r = 0u; r < repeats; ++r) {
+        for (auto i = 0u; i < groups; ++i) {
+            input += "key" + std::to_string(i) + "\t" + std::to_string(i) + "\n";
+        }
+    }
+    auto expected = std::vector<std::string>{};
+    for (auto i = 0u; i < groups; ++i) {
+        expected.push_back("key" + std::to_string(i) + "\t" +
+                           std::to_string(repeats) + "\t" +
+                           std::to_string(i * repeats));
+    }
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(group_by(spec, input), expected);
+}
@@ -0,0 +1,138 @@
+#include <future>
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "flow/batch_channel.hpp"
+#include "flow/instantiate.hpp"
+#include "flow/invalid_link.hpp"
+
+using namespace flow;
+
+TEST(record_batch, append)
+{
+    auto batch = make_record_batch({
+        {"name", field_type::text},
+        {"id", field_type::integer},
+        {"score", field_type::real},
+    });
+    ASSERT_EQ(size(batch.columns), 3u);
+    EXPECT_EQ(get_size(batch), 0u);
+    auto& names = batch.columns[0];
+    auto& ids = batch.columns[1];
+    auto& scores = batch.columns[2];
+    append(names, "alpha");
+    append(ids, "42");
+    append(scores, "2.5");
+    append(names, "");
+    append(ids, "4x");
+    append_null(scores);
+    EXPECT_EQ(get_size(batch), 2u);
+    EXPECT_TRUE(is_valid(names, 0u));
+    EXPECT_FALSE(is_valid(names, 1u));
+    EXPECT_EQ(get_text(names, 0u), "alpha");
+    EXPECT_EQ(get_text(names, 1u), "");
+    EXPECT_TRUE(is_valid(ids, 0u));
+    EXPECT_FALSE(is_valid(ids, 1u));
+    EXPECT_EQ(ids.integers, (std::vector<std::int64_t>{42, 0}));
+    EXPECT_TRUE(is_valid(scores, 0u));
+    EXPECT_FALSE(is_valid(scores, 1u));
+    EXPECT_EQ(scores.reals.front(), 2.5);
+    EXPECT_FALSE(is_valid(scores, 2u));
+}
+
+TEST(batch_channel, send_receive_close)
+{
+    auto chan = batch_channel{1u};
+    const auto writer = chan.get(batch_channel::io::write);
+    const auto reader = chan.get(batch_channel::io::read);
+    EXPECT_FALSE(reader.send(record_batch{}));
+    EXPECT_FALSE(writer.receive());
+    auto sending = std::async(std::launch::async, [&](){
+        for (auto i = 0; i < 3; ++i) {
+            auto batch = make_record_batch({{"", field_type::integer}});
+            append(batch.columns[0], std::to_string(i));
+            EXPECT_TRUE(writer.send(std::move(batch)));
+        }
+        writer.close();
+    });
+    auto received = std::vector<std::int64_t>{};
+    while (const auto batch = reader.receive()) {
+        received.push_back(batch->columns.at(0).integers.at(0));
+    }
+    sending.get();
+    EXPECT_EQ(received, (std::vector<std::int64_t>{0, 1, 2}));
+    EXPECT_EQ(chan.get_sent(), 3u);
+}
+
+TEST(batch_channel, destruction_closes)
+{
+    auto reader = batch_channel::handle{};
+    {
+        const auto chan = batch_channel{};
+        reader = chan.get(batch_channel::io::read);
+    }
+    EXPECT_FALSE(reader.receive());
+}
+
+TEST(batch_channel, adapters_in_system)
+{
+    using flow::link; // disambiguate link
+    const auto fields = std::vector<record_field>{
+        {"name", field_type::text},
+        {"count", field_type::integer},
+    };
+    const auto to_batches = batch_adapter{.fields = fields};
+    const auto to_text = batch_adapter{
+        .fields = fields,
+        .conversion = batch_conversion::to_text,
+    };
+    const auto sys = flow::system{
+        .nodes = {
+            {"parse", flow::node{to_batches, make_port_map(to_batches)}},
+            {"format", flow::node{to_text, make_port_map(to_text)}},
+        },
+        .links = {
+            link{user_endpoint{}, node_endpoint{"parse", descriptors::stdin_id}},
+            link{node_endpoint{"parse", descriptors::stdout_id},
+                 node_endpoint{"format", descriptors::stdin_id}},
+            link{node_endpoint{"format", descriptors::stdout_id}, user_endpoint{}},
+        },
+    };
+    std::ostringstream diags;
+    auto object = instantiate(sys, diags);
+    auto info = std::get_if<instance::system>(&object.info);
+    ASSERT_NE(info, nullptr);
+    ASSERT_EQ(size(info->channels), 3u);
+    EXPECT_TRUE(std::holds_alternative<batch_channel>(info->channels[1]));
+    auto in = std::get_if<pipe_channel>(&info->channels[0]);
+    auto out = std::get_if<pipe_channel>(&info->channels[2]);
+    ASSERT_NE(in, nullptr);
+    ASSERT_NE(out, nullptr);
+    write(*in, std::string{"a\t007\nb\tx\n\t3\n"});
+    std::ostringstream os;
+    read(*out, std::ostream_iterator<char>(os));
+    EXPECT_EQ(os.str(), "a\t7\nb\t\n\t3\n");
+    const auto results = wait(object);
+    EXPECT_EQ(size(results), 2u);
+}
+
+TEST(batch_channel, columnar_to_executable)
+{
+    using flow::link; // disambiguate link
+    const auto adapter = batch_adapter{.fields = {{"", field_type::real}}};
+    const auto sys = flow::system{
+        .nodes = {
+            {"parse", flow::node{adapter, make_port_map(adapter)}},
+            {"cat", flow::node{executable{.file = "/bin/cat"}}},
+        },
+        .links = {
+            link{node_endpoint{"parse", descriptors::stdout_id},
+                 node_endpoint{"cat", descriptors::stdin_id}},
+        },
+    };
+    std::ostringstream diags;
+    EXPECT_THROW(instantiate(sys, diags), invalid_link);
+}
@@ -148,3 +148,48 @@ TEST(make_channel, signal_channel)
     ASSERT_EQ(size(sc.signals), 1u);
     EXPECT_EQ(*sc.signals.begin(), sig);
 }
+
+TEST(make_channel, for_record_schemas)
+{
+    using flow::link; // disambiguate link
+    const auto pairs = record_schema{
+        .fields = {{"key", field_type::text, 8u}, {"value", field_type::real}},
+        .encoding = record_encoding::binary,
+    };
+    const auto counts = record_schema{
+        .fields = {{"key", field_type::text, 8u}, {"count", field_type::integer}},
+        .encoding = record_encoding::binary,
+    };
+    const auto make_node = [](const record_schema& in,
+                              const record_schema& out){
+        return flow::node{executable{}, port_map{
+            {reference_descriptor{0}, {"stdin", io_type::in, in}},
+            {reference_descriptor{1}, {"stdout", io_type::out, out}},
+        }};
+    };
+    const auto sys = flow::system{
+        .nodes = {
+            {"a", make_node(pairs, pairs)},
+            {"b", make_node(pairs, counts)},
+            {"c", make_node(counts, counts)},
+            {"untyped", flow::node{executable{}}},
+        }
+    };
+    const auto pconns = std::vector<link>{};
+    auto pchans = std::vector<channel>{};
+    auto chan = channel{};
+    EXPECT_NO_THROW(chan = make_channel(link{
+        node_endpoint{"a", {reference_descriptor{1}}},
+        node_endpoint{"b", {reference_descriptor{0}}},
+    }, node_name{}, port_map{}, sys, {}, pconns, pchans));
+    EXPECT_TRUE(std::holds_alternative<pipe_channel>(chan));
+    EXPECT_NO_THROW(chan = make_channel(link{
+        node_endpoint{"b", {reference_descriptor{1}}},
+        node_endpoint{"untyped", {reference_descriptor{0}}},
+    }, node_name{}, port_map{}, sys, {}, pconns, pchans));
+    EXPECT_TRUE(std::holds_alternative<pipe_channel>(chan));
+    EXPECT_THROW(make_channel(link{
+        node_endpoint{"a", {reference_descriptor{1}}},
+        node_endpoint{"c", {reference_descriptor{0}}},
+    }, node_name{}, port_map{}, sys, {}, pconns, pchans), invalid_link);
+}
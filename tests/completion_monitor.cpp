@@ -0,0 +1,150 @@
+#include <chrono>
+#include <future>
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream
+#include <stdexcept> // for std::invalid_argument
+#include <string>
+#include <vector>
+
+#include <poll.h>
+
+#include <gtest/gtest.h>
+
+#include "flow/completion_monitor.hpp"
+#include "flow/instantiate.hpp"
+#include "flow/pipe_channel.hpp"
+#include "flow/sorter.hpp"
+#include "flow/utility.hpp"
+
+using namespace flow;
+
+namespace {
+
+/// @brief Polls the given monitor whenever its descriptor's readable, until
+///   it's tracking nothing or it's been the given time.
+auto drain(completion_monitor& monitor,
+           std::chrono::milliseconds timeout = std::chrono::seconds{10})
+    -> std::size_t
+{
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + timeout;
+    auto completed = std::size_t{};
+    while ((monitor.size() > 0u) && (clock::now() < deadline)) {
+        auto fds = pollfd{int(monitor.descriptor()), POLLIN, 0};
+        if (::poll(&fds, 1u, 100) > 0) {
+            completed += monitor.poll();
+        }
+    }
+    return completed;
+}
+
+auto make_sleep(const std::string& seconds) -> flow::node
+{
+    return flow::system{
+        .nodes = {
+            {node_name{"sleep"}, {executable{
+                .file = "/bin/sleep", .arguments = {"sleep", seconds}
+            }, {}}},
+        },
+    };
+}
+
+}
+
+TEST(completion_monitor, default_construction)
+{
+    auto monitor = completion_monitor{};
+    EXPECT_EQ(monitor.size(), 0u);
+    EXPECT_NE(monitor.descriptor(), descriptors::invalid_id);
+    EXPECT_EQ(monitor.poll(), 0u);
+}
+
+TEST(completion_monitor, completes_processes_in_order)
+{
+    std::ostringstream diags;
+    auto slow = instantiate(make_sleep("0.3"), diags);
+    auto fast = instantiate(make_sleep("0"), diags);
+    auto monitor = completion_monitor{};
+    auto order = std::vector<const instance*>{};
+    const auto record = [&order](instance& object,
+                                 const std::vector<wait_result>& results){
+        order.push_back(&object);
+        EXPECT_EQ(size(results), 1u);
+    };
+    auto slow_results = monitor.track(slow, record);
+    auto fast_results = monitor.track(fast, record);
+    EXPECT_THROW(monitor.track(fast), std::invalid_argument);
+    EXPECT_EQ(monitor.size(), 2u);
+    EXPECT_EQ(drain(monitor), 2u);
+    EXPECT_EQ(monitor.size(), 0u);
+    ASSERT_EQ(size(order), 2u);
+    EXPECT_EQ(order[0], &fast);
+    EXPECT_EQ(order[1], &slow);
+    for (auto* future: {&slow_results, &fast_results}) {
+        const auto results = future->get();
+        ASSERT_EQ(size(results), 1u);
+        const auto p = std::get_if<info_wait_result>(&results[0]);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p->status, wait_status(wait_exit_status{EXIT_SUCCESS}));
+    }
+    // Completed instances have been waited on.
+    EXPECT_TRUE(empty(wait(slow)));
+    EXPECT_TRUE(empty(wait(fast)));
+}
+
+TEST(completion_monitor, completes_builtins)
+{
+    using flow::link; // disambiguate link
+    const auto sort_name = node_name{"sort"};
+    const auto sys = flow::system{
+        .nodes = {
+            {sort_name, flow::node{sorter{}, {
+                stdin_ports_entry, stdout_ports_entry
+            }}},
+        },
+        .links = {
+            link{user_endpoint{}, node_endpoint{sort_name, descriptors::stdin_id}},
+            link{node_endpoint{sort_name, descriptors::stdout_id}, user_endpoint{}},
+        },
+    };
+    std::ostringstream diags;
+    auto object = instantiate(sys, diags);
+    auto monitor = completion_monitor{};
+    auto results = monitor.track(object);
+    // The sorter's still waiting on its input.
+    EXPECT_EQ(monitor.poll(), 0u);
+    EXPECT_EQ(monitor.size(), 1u);
+    auto& info = std::get<instance::system>(object.info);
+    auto in = std::get_if<pipe_channel>(&info.channels[0]);
+    auto out = std::get_if<pipe_channel>(&info.channels[1]);
+    ASSERT_NE(in, nullptr);
+    ASSERT_NE(out, nullptr);
+    write(*in, std::string{"b\na\n"});
+    std::ostringstream os;
+    read(*out, std::ostream_iterator<char>(os));
+    EXPECT_EQ(os.str(), "a\nb\n");
+    EXPECT_EQ(drain(monitor), 1u);
+    const auto waits = results.get();
+    ASSERT_EQ(size(waits), 1u);
+    EXPECT_EQ(waits[0], wait_result(info_wait_result{
+        current_process_id(), wait_exit_status{EXIT_SUCCESS}
+    }));
+}
+
+TEST(completion_monitor, untrack)
+{
+    std::ostringstream diags;
+    auto object = instantiate(make_sleep("10"), diags);
+    auto monitor = completion_monitor{};
+    auto results = monitor.track(object);
+    EXPECT_EQ(monitor.poll(), 0u);
+    EXPECT_TRUE(monitor.untrack(object));
+    EXPECT_FALSE(monitor.untrack(object));
+    EXPECT_EQ(monitor.size(), 0u);
+    EXPECT_THROW(results.get(), std::future_error);
+    send_signal(signals::kill(), object, diags);
+    const auto waits = wait(object);
+    ASSERT_EQ(size(waits), 1u);
+    // Changes of untracked instances aren't polled for.
+    EXPECT_EQ(monitor.poll(), 0u);
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <sstream> // for std::ostringstream
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "flow/completion_order.hpp"
+#include "flow/instantiate.hpp"
+
+using namespace flow;
+
+namespace {
+
+auto make_shell(const std::string& command) -> flow::node
+{
+    return {executable{
+        .file = "/bin/sh", .arguments = {"sh", "-c", command}
+    }, {}};
+}
+
+auto exit_status_of(const descendant_wait_result& value) -> wait_status
+{
+    const auto p = std::get_if<info_wait_result>(&value.result);
+    return p? p->status: wait_status{wait_unknown_status{}};
+}
+
+}
+
+TEST(completion_order, wait_any_of_nothing)
+{
+    std::ostringstream diags;
+    auto object = instantiate(flow::system{}, diags);
+    EXPECT_FALSE(wait_any(object));
+    auto default_object = instance{};
+    EXPECT_FALSE(wait_any(default_object));
+}
+
+TEST(completion_order, wait_any_returns_first_finished)
+{
+    using namespace std::chrono_literals;
+    using clock = std::chrono::steady_clock;
+    const auto slow_name = node_name{"a_slow"};
+    const auto fail_name = node_name{"z_fail"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {slow_name, make_shell("sleep 1")},
+            {fail_name, make_shell("exit 3")},
+        },
+    }};
+    std::ostringstream diags;
+    auto object = instantiate(sys, diags);
+    const auto start = clock::now();
+    const auto first = wait_any(object);
+    ASSERT_TRUE(first);
+    EXPECT_LT(clock::now() - start, 900ms);
+    EXPECT_EQ(first->names, std::vector<node_name>{fail_name});
+    EXPECT_EQ(exit_status_of(*first), wait_status(wait_exit_status{3}));
+    const auto second = wait_any(object);
+    ASSERT_TRUE(second);
+    EXPECT_EQ(second->names, std::vector<node_name>{slow_name});
+    EXPECT_EQ(exit_status_of(*second),
+              wait_status(wait_exit_status{EXIT_SUCCESS}));
+    EXPECT_FALSE(wait_any(object));
+    EXPECT_TRUE(empty(wait(object)));
+}
+
+TEST(completion_order, iterates_nested_in_finishing_order)
+{
+    const auto outer_name = node_name{"outer"};
+    const auto inner_name = node_name{"inner"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {node_name{"a"}, make_shell("sleep 0.4")},
+            {outer_name, flow::node{flow::system{
+                .nodes = {
+                    {inner_name, make_shell("exit 2")},
+                },
+            }, {}}},
+            {node_name{"c"}, make_shell("sleep 0.2; exit 1")},
+        },
+    }};
+    std::ostringstream diags;
+    auto object = instantiate(sys, diags);
+    auto names = std::vector<std::vector<node_name>>{};
+    auto statuses = std::vector<wait_status>{};
+    for (auto&& result: completion_order{object}) {
+        names.push_back(result.names);
+        statuses.push_back(exit_status_of(result));
+    }
+    ASSERT_EQ(size(names), 3u);
+    EXPECT_EQ(names[0], (std::vector<node_name>{outer_name, inner_name}));
+    EXPECT_EQ(names[1], std::vector<node_name>{node_name{"c"}});
+    EXPECT_EQ(names[2], std::vector<node_name>{node_name{"a"}});
+    EXPECT_EQ(statuses[0], wait_status(wait_exit_status{2}));
+    EXPECT_EQ(statuses[1], wait_status(wait_exit_status{1}));
+    EXPECT_EQ(statuses[2], wait_status(wait_exit_status{EXIT_SUCCESS}));
+    std::ostringstream os;
+    os << descendant_wait_result{{outer_name, inner_name}, {}};
+    EXPECT_EQ(os.str().rfind("outer.inner: ", 0), 0u);
+}
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <sstream> // for std::ostringstream
+#include <thread> // for std::this_thread
+
+#include <gtest/gtest.h>
+
+#include "flow/instance_pool.hpp"
+#include "flow/utility.hpp"
+
+using namespace flow;
+using namespace flow::descriptors;
+
+namespace {
+
+const auto cat_name = node_name{"cat"};
+
+const auto cat_system = flow::node{flow::system{
+    .nodes = {
+        {cat_name, {executable{.file = "/bin/cat"},
+                    {stdin_ports_entry, stdout_ports_entry}}},
+    },
+    .links = {
+        {user_endpoint{}, node_endpoint{cat_name, stdin_id}},
+        {node_endpoint{cat_name, stdout_id}, user_endpoint{}},
+    },
+}};
+
+/// @brief Waits up to a few seconds for the given pool to fill.
+auto wait_until_ready(const instance_pool& pool) -> bool
+{
+    for (auto i = 0; i < 500; ++i) {
+        if (pool.ready() == pool.capacity()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    return false;
+}
+
+auto run_cat(instance& object, const std::string& input) -> std::string
+{
+    auto& info = std::get<instance::system>(object.info);
+    auto& in = std::get<pipe_channel>(info.channels[0]);
+    std::ostringstream diags;
+    write(in, input);
+    in.close(pipe_channel::io::write, diags);
+    std::ostringstream os;
+    read(std::get<pipe_channel>(info.channels[1]),
+         std::ostream_iterator<char>(os));
+    return os.str();
+}
+
+}
+
+TEST(instance_pool, checkouts)
+{
+    auto pool = instance_pool{cat_system, 2u};
+    EXPECT_EQ(pool.capacity(), 2u);
+    ASSERT_TRUE(wait_until_ready(pool));
+    for (auto i = 0; i < 3; ++i) {
+        auto object = pool.checkout();
+        EXPECT_EQ(run_cat(object, "hello\n"), "hello\n");
+        pool.recycle(std::move(object));
+        ASSERT_TRUE(wait_until_ready(pool));
+    }
+    const auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.hits, 3u);
+    EXPECT_EQ(metrics.misses, 0u);
+    EXPECT_EQ(metrics.expired, 0u);
+    EXPECT_EQ(metrics.spawns, 5u);
+    EXPECT_EQ(metrics.failures, 0u);
+    EXPECT_GT(metrics.total_spawn_time.count(), 0);
+    EXPECT_GE(metrics.total_spawn_time, metrics.max_spawn_time);
+}
+
+TEST(instance_pool, misses)
+{
+    auto pool = instance_pool{cat_system, 0u};
+    auto object = pool.checkout();
+    EXPECT_EQ(run_cat(object, "world\n"), "world\n");
+    wait(object);
+    const auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.hits, 0u);
+    EXPECT_EQ(metrics.misses, 1u);
+    EXPECT_EQ(metrics.spawns, 1u);
+}
+
+TEST(instance_pool, expired)
+{
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {node_name{"true"}, {executable{.file = "/bin/true"}, {}}},
+        },
+    }};
+    auto pool = instance_pool{sys, 1u};
+    ASSERT_TRUE(wait_until_ready(pool));
+    // Give the pooled process time to exit & be waited on.
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    auto object = pool.checkout();
+    const auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.expired, 1u);
+    EXPECT_EQ(metrics.hits + metrics.misses, 1u);
+}
+
+TEST(instance_pool, invalid_node)
+{
+    const auto sys = flow::node{flow::system{
+        .links = {{node_endpoint{node_name{}}, node_endpoint{node_name{"b"}}}},
+    }};
+    EXPECT_THROW(instance_pool(sys, 1u), std::invalid_argument);
+}
+
+TEST(instance_pool, deadline_starts_at_checkout)
+{
+    const auto opts = instantiate_options{
+        .deadline = std::chrono::milliseconds{200},
+    };
+    auto pool = instance_pool{cat_system, 1u, opts};
+    ASSERT_TRUE(wait_until_ready(pool));
+    // Pooled for longer than the deadline, which isn't counting yet.
+    std::this_thread::sleep_for(std::chrono::milliseconds{500});
+    auto object = pool.checkout();
+    const auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.hits, 1u);
+    EXPECT_EQ(metrics.expired, 0u);
+    // The cat's input is left open, so it runs until its deadline.
+    const auto waits = wait(object);
+    ASSERT_EQ(size(waits), 1u);
+    const auto status = std::get<info_wait_result>(waits[0]).status;
+    EXPECT_TRUE(std::holds_alternative<wait_signaled_status>(status))
+        << status;
+}
@@ -1,7 +1,15 @@
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdlib> // for std::exit, std::getenv, ::setenv
+#include <filesystem>
+#include <fstream> // for std::ofstream
 #include <sstream> // for std::ostringstream
 #include <thread> // for std::this_thread
 
+#include <sys/resource.h> // for getrlimit, setrlimit
+#include <unistd.h> // for ::alarm
+
 #include <gtest/gtest.h>
 
 #include "flow/reference_descriptor.hpp"
@@ -683,3 +691,883 @@ TEST(instantiate, bin_dd)
         EXPECT_EQ(es.signal, int(signals::kill()));
     }
 }
+
+TEST(instantiate, process_creations)
+{
+    const auto path = std::filesystem::temp_directory_path() /
+                      "flow_instantiate_process_creations";
+    {
+        std::ofstream{path} << "hello world\n";
+    }
+    const auto cat_name = node_name{"cat"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {{cat_name, {
+            executable{
+                .file = "/bin/cat",
+                .arguments = {"cat"},
+                .working_directory = "/",
+            },
+            {stdin_ports_entry, stdout_ports_entry}
+        }}},
+        .links = {
+            {file_endpoint{path}, node_endpoint{cat_name, stdin_id}},
+            {node_endpoint{cat_name, stdout_id}, user_endpoint{}},
+        },
+    }};
+    for (auto&& creation: {process_creation::spawn, process_creation::fork,
+                           process_creation::zygote}) {
+        std::ostringstream diags;
+        auto object = instance{};
+        const auto opts = instantiate_options{.creation = creation};
+        ASSERT_NO_THROW(object = instantiate(sys, diags, opts));
+        auto& info = std::get<instance::system>(object.info);
+        ASSERT_EQ(size(info.channels), 2u);
+        ASSERT_TRUE(std::holds_alternative<pipe_channel>(info.channels[1]));
+        if (creation == process_creation::zygote) {
+            const auto& child = info.children.at(cat_name);
+            const auto& state = std::get<instance::forked>(child.info).state;
+            const auto p = std::get_if<owning_process_id>(&state);
+            ASSERT_NE(p, nullptr);
+            EXPECT_NE(p->pidfd(), descriptors::invalid_id);
+        }
+        std::ostringstream os;
+        EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[1]),
+                             std::ostream_iterator<char>(os)));
+        EXPECT_EQ(os.str(), "hello world\n");
+        const auto waits = wait(object);
+        ASSERT_EQ(size(waits), 1u);
+        ASSERT_TRUE(std::holds_alternative<info_wait_result>(waits.front()));
+        const auto& status = std::get<info_wait_result>(waits.front()).status;
+        ASSERT_TRUE(std::holds_alternative<wait_exit_status>(status));
+        EXPECT_EQ(std::get<wait_exit_status>(status).value, 0);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(instantiate, reports_missing_zygote)
+{
+    if (std::getenv("FLOW_NO_PIDFDS") != nullptr) { // NOLINT(concurrency-mt-unsafe)
+        GTEST_SKIP() << "can't run death tests while waiting on any child";
+    }
+    const auto exe = flow::node{executable{
+        .file = "/bin/true",
+        .arguments = {"true"},
+    }, {}};
+    const auto opts = instantiate_options{
+        .creation = process_creation::zygote,
+    };
+    // In its own process, since the zygote's looked for just once. Before
+    // this process uses the zygote, as the death test reruns what's before.
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT({
+        if (::setenv("FLOW_ZYGOTE", no_such_path, 1) == -1) {
+            std::exit(EXIT_FAILURE);
+        }
+        auto reports = 0;
+        for (auto i = 0; i < 2; ++i) {
+            std::ostringstream diags;
+            auto object = instantiate(exe, diags, opts);
+            if (diags.str().find("can't start zygote") != std::string::npos) {
+                ++reports;
+            }
+            const auto waits = wait(object);
+            if ((size(waits) != 1u) ||
+                (std::get<info_wait_result>(waits[0]).status !=
+                 wait_status{wait_exit_status{EXIT_SUCCESS}})) {
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        std::exit(reports);
+    }, ::testing::ExitedWithCode(1), "");
+    std::ostringstream diags;
+    auto object = instantiate(exe, diags, opts);
+    EXPECT_EQ(diags.str().find("zygote"), std::string::npos) << diags.str();
+}
+
+TEST(instantiate, restarts_until_limit)
+{
+    using namespace std::chrono_literals;
+    const auto fail_name = node_name{"fail"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {fail_name, {executable{
+                .file = "/bin/sh",
+                .arguments = {"sh", "-c", "exit 3"},
+                .restart = restart_policy::on_failure,
+                .limits = {
+                    .initial_backoff = 10ms,
+                    .max_backoff = 40ms,
+                    .max_restarts = 3u,
+                },
+            }, {}}},
+        },
+    }};
+    std::ostringstream diags;
+    auto object = instance{};
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_NO_THROW(object = instantiate(sys, diags));
+    const auto waits = wait(object);
+    // Backoffs of 10, 20, & 40 milliseconds.
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 70ms);
+    ASSERT_EQ(size(waits), 1u);
+    EXPECT_EQ(std::get<info_wait_result>(waits[0]).status,
+              wait_status(wait_exit_status{3}));
+    const auto& info = std::get<instance::system>(object.info);
+    const auto& child = std::get<instance::forked>(info.children.at(fail_name).info);
+    EXPECT_EQ(child.restarts, 3u);
+}
+
+TEST(instantiate, restarts_onto_same_channels)
+{
+    using namespace std::chrono_literals;
+    const auto path = std::filesystem::temp_directory_path() /
+                      "flow_instantiate_restarts_onto_same_channels";
+    const auto flaky_name = node_name{"flaky"};
+    const auto cat_name = node_name{"cat"};
+    // Fails the first two times, then succeeds.
+    const auto script = "n=$(cat '" + path.string() + "' 2>/dev/null || echo 0);"
+                        " echo $((n+1)) > '" + path.string() + "';"
+                        " echo run$n; [ $n -ge 2 ]";
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {flaky_name, {executable{
+                .file = "/bin/sh",
+                .arguments = {"sh", "-c", script},
+                .restart = restart_policy::on_failure,
+                .limits = {.initial_backoff = 1ms},
+            }, {stdout_ports_entry}}},
+            {cat_name, {executable{
+                .file = "/bin/cat",
+                .arguments = {"cat"},
+            }, {stdin_ports_entry, stdout_ports_entry}}},
+        },
+        .links = {
+            {node_endpoint{flaky_name, stdout_id},
+             node_endpoint{cat_name, stdin_id}},
+            {node_endpoint{cat_name, stdout_id}, user_endpoint{}},
+        },
+    }};
+    for (auto&& creation: {process_creation::spawn, process_creation::fork,
+                           process_creation::zygote}) {
+        for (auto&& use_plan: {false, true}) {
+            std::filesystem::remove(path);
+            std::ostringstream diags;
+            auto object = instance{};
+            const auto opts = instantiate_options{.creation = creation};
+            ASSERT_NO_THROW(object = use_plan
+                            ? instantiate(compile(sys, opts), diags)
+                            : instantiate(sys, diags, opts));
+            auto& info = std::get<instance::system>(object.info);
+            ASSERT_EQ(size(info.channels), 2u);
+            std::ostringstream os;
+            // The cat only sees end-of-file once no more restarts are due.
+            EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[1]),
+                                 std::ostream_iterator<char>(os)));
+            EXPECT_EQ(os.str(), "run0\nrun1\nrun2\n");
+            const auto waits = wait(object);
+            ASSERT_EQ(size(waits), 2u);
+            for (auto&& result: waits) {
+                EXPECT_EQ(std::get<info_wait_result>(result).status,
+                          wait_status(wait_exit_status{EXIT_SUCCESS}));
+            }
+            const auto& flaky = info.children.at(flaky_name);
+            EXPECT_EQ(std::get<instance::forked>(flaky.info).restarts, 2u);
+            const auto& cat = info.children.at(cat_name);
+            EXPECT_EQ(std::get<instance::forked>(cat.info).restarts, 0u);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(instantiate, restarts_stop_at_deadline)
+{
+    using namespace std::chrono_literals;
+    const auto sleep_name = node_name{"sleep"};
+    const auto true_name = node_name{"true"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {sleep_name, {executable{
+                .file = "/bin/sleep",
+                .arguments = {"sleep", "10"},
+                .restart = restart_policy::always,
+            }, {}}},
+            {true_name, {executable{
+                .file = "/bin/true",
+                .restart = restart_policy::always,
+                .limits = {.initial_backoff = 5ms, .max_restarts = 0u},
+            }, {}}},
+        },
+    }};
+    const auto opts = instantiate_options{
+        .deadline = 200ms,
+        .kill_grace = 1s,
+    };
+    std::ostringstream diags;
+    auto object = instance{};
+    ASSERT_NO_THROW(object = instantiate(sys, diags, opts));
+    const auto waits = wait_for(object, 5s);
+    ASSERT_EQ(size(waits), 2u);
+    const auto& info = std::get<instance::system>(object.info);
+    // Terminated by the deadline instead of being restarted.
+    EXPECT_EQ(get_wait_status(info.children.at(sleep_name)),
+              wait_status(wait_signaled_status{SIGTERM}));
+    EXPECT_EQ(std::get<instance::forked>(info.children.at(sleep_name).info).restarts,
+              0u);
+    EXPECT_GT(std::get<instance::forked>(info.children.at(true_name).info).restarts,
+              0u);
+}
+
+TEST(instantiate, restarting_instance_destruction)
+{
+    using namespace std::chrono_literals;
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {node_name{"true"}, {executable{
+                .file = "/bin/true",
+                .restart = restart_policy::always,
+                .limits = {.initial_backoff = 50ms, .max_restarts = 0u},
+            }, {}}},
+        },
+    }};
+    std::ostringstream diags;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        auto object = instance{};
+        ASSERT_NO_THROW(object = instantiate(sys, diags));
+        std::this_thread::sleep_for(20ms);
+        // Destroying it stops the restarting, rather than waiting forever.
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(instantiate, child_setup_failure)
+{
+    const auto exe = flow::node{
+        executable{
+            .file = "/bin/true",
+            .arguments = {"true"},
+            .working_directory = no_such_path,
+        },
+        port_map{}
+    };
+    for (auto&& creation: {process_creation::spawn, process_creation::fork,
+                           process_creation::zygote}) {
+        std::ostringstream diags;
+        auto object = instance{};
+        const auto opts = instantiate_options{.creation = creation};
+        ASSERT_NO_THROW(object = instantiate(exe, diags, opts));
+        const auto waits = wait(object);
+        ASSERT_EQ(size(waits), 1u);
+        ASSERT_TRUE(std::holds_alternative<info_wait_result>(waits.front()));
+        const auto& status = std::get<info_wait_result>(waits.front()).status;
+        ASSERT_TRUE(std::holds_alternative<wait_exit_status>(status));
+        EXPECT_EQ(std::get<wait_exit_status>(status).value, 1);
+        std::ostringstream os;
+        write_diags(object, os);
+        EXPECT_NE(os.str().find(std::string{"chdir \""} + no_such_path +
+                                "\" failed: "), std::string::npos)
+            << os.str();
+    }
+}
+
+TEST(instantiate, path_resolution_cache)
+{
+    const auto dir = std::filesystem::temp_directory_path() /
+                     "flow_instantiate_path_resolution_cache";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const auto file = dir / "say";
+    std::filesystem::copy_file("/bin/echo", file);
+    const auto say_name = node_name{"say"};
+    const auto sys = flow::node{flow::system{
+        .environment = {{env_name{"PATH"}, env_value{dir.string()}}},
+        .nodes = {{say_name, {
+            executable{.file = "say", .arguments = {"say", "hello"}},
+            {stdout_ports_entry}
+        }}},
+        .links = {
+            {node_endpoint{say_name, stdout_id}, user_endpoint{}},
+        },
+    }};
+    const auto run = [&sys](process_creation creation) {
+        std::ostringstream diags;
+        auto object = instance{};
+        const auto opts = instantiate_options{.creation = creation};
+        EXPECT_NO_THROW(object = instantiate(sys, diags, opts));
+        std::ostringstream os;
+        if (const auto p = std::get_if<instance::system>(&object.info)) {
+            if (size(p->channels) == 1u) {
+                if (const auto q = std::get_if<pipe_channel>(&p->channels[0])) {
+                    EXPECT_NO_THROW(read(*q, std::ostream_iterator<char>(os)));
+                }
+            }
+        }
+        wait(object);
+        return os.str();
+    };
+    const auto creations = {
+        process_creation::spawn, process_creation::fork,
+        process_creation::zygote
+    };
+    for (auto&& creation: creations) {
+        EXPECT_EQ(run(creation), "hello\n");
+    }
+    // Replacing the file must be noticed. Scripts also can't be executed
+    // from close-on-exec descriptors, so this also exercises falling back
+    // to executing them by path.
+    const auto replacement = dir / "say.new";
+    std::ofstream{replacement} << "#!/bin/sh\necho replaced\n";
+    std::filesystem::permissions(replacement,
+                                 std::filesystem::perms::owner_all);
+    std::filesystem::rename(replacement, file);
+    for (auto&& creation: creations) {
+        EXPECT_EQ(run(creation), "replaced\n");
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TEST(instantiate, argument_and_environment_blocks)
+{
+    const auto env_name_ = node_name{"env"};
+    const auto echo_name = node_name{"echo"};
+    const auto sys = flow::node{flow::system{
+        .environment = {
+            {env_name{"FLOW_A"}, env_value{"1"}},
+            {env_name{"FLOW_B"}, env_value{"two"}},
+        },
+        .nodes = {
+            {env_name_, {executable{.file = "/usr/bin/env"},
+                         {stdout_ports_entry}}},
+            {echo_name, {executable{.file = "/bin/echo",
+                                    .arguments = {"echo", "$$"}},
+                         {stdout_ports_entry}}},
+        },
+        .links = {
+            {node_endpoint{env_name_, stdout_id}, user_endpoint{}},
+            {node_endpoint{echo_name, stdout_id}, user_endpoint{}},
+        },
+    }};
+    // Instantiating repeatedly reuses the cached blocks.
+    for (auto i = 0; i < 3; ++i) {
+        std::ostringstream diags;
+        auto object = instance{};
+        ASSERT_NO_THROW(object = instantiate(sys, diags));
+        auto& info = std::get<instance::system>(object.info);
+        ASSERT_EQ(size(info.channels), 2u);
+        std::ostringstream env_os;
+        EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[0]),
+                             std::ostream_iterator<char>(env_os)));
+        EXPECT_EQ(env_os.str(), "FLOW_A=1\nFLOW_B=two\n");
+        std::ostringstream echo_os;
+        EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[1]),
+                             std::ostream_iterator<char>(echo_os)));
+        const auto& echo = std::get<instance::forked>(
+            info.children.at(echo_name).info);
+        const auto pid = reference_process_id(
+            std::get<owning_process_id>(echo.state));
+        std::ostringstream expected;
+        expected << int(pid) << "\n";
+        EXPECT_EQ(echo_os.str(), expected.str());
+        wait(object);
+    }
+}
+
+TEST(instantiate, concurrently)
+{
+    constexpr auto thread_count = 8;
+    constexpr auto iterations = 25;
+    const auto echo_name = node_name{"echo"};
+    const auto cat_name = node_name{"cat"};
+    const auto make_system = [&](const std::string& message) {
+        return flow::node{flow::system{
+            .nodes = {
+                {echo_name, {executable{.file = "/bin/echo",
+                                        .arguments = {"echo", message}},
+                             {stdout_ports_entry}}},
+                {cat_name, {executable{.file = "/bin/cat"},
+                            {stdin_ports_entry, stdout_ports_entry}}},
+            },
+            .links = {
+                {node_endpoint{echo_name, stdout_id},
+                 node_endpoint{cat_name, stdin_id}},
+                {node_endpoint{cat_name, stdout_id}, user_endpoint{}},
+            },
+        }};
+    };
+    const auto creations = std::array{
+        process_creation::spawn, process_creation::fork,
+        process_creation::zygote
+    };
+    auto failures = std::atomic<int>{};
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]{
+            for (auto i = 0; i < iterations; ++i) {
+                const auto message = std::to_string(t) + "." +
+                                     std::to_string(i);
+                const auto opts = instantiate_options{
+                    .creation = creations[std::size_t(i) % size(creations)]
+                };
+                std::ostringstream diags;
+                auto object = instantiate(make_system(message), diags, opts);
+                auto& info = std::get<instance::system>(object.info);
+                std::ostringstream os;
+                read(std::get<pipe_channel>(info.channels[1]),
+                     std::ostream_iterator<char>(os));
+                if (os.str() != message + "\n") {
+                    ++failures;
+                }
+                for (auto&& result: wait(object)) {
+                    const auto p = std::get_if<info_wait_result>(&result);
+                    const auto q = p? std::get_if<wait_exit_status>(&p->status)
+                                    : nullptr;
+                    if (!q || (q->value != 0)) {
+                        ++failures;
+                    }
+                }
+            }
+        });
+    }
+    for (auto&& thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 0);
+}
+
+TEST(instantiate, compiled_plan)
+{
+    const auto echo_name = node_name{"echo"};
+    const auto inner_name = node_name{"inner"};
+    const auto cat_name = node_name{"cat"};
+    const auto path = environment_map{
+        {env_name{"PATH"}, env_value{"/usr/bin:/bin"}}
+    };
+    const auto inner = flow::system{
+        .environment = path,
+        .nodes = {
+            {cat_name, {executable{.file = "cat"},
+                        {stdin_ports_entry, stdout_ports_entry}}},
+        },
+        .links = {
+            {node_endpoint{node_name{}, stdin_id},
+             node_endpoint{cat_name, stdin_id}},
+            {node_endpoint{cat_name, stdout_id},
+             node_endpoint{node_name{}, stdout_id}},
+        },
+    };
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {echo_name, {executable{.file = "/bin/echo",
+                                    .arguments = {"echo", "hello"},
+                                    .working_directory = "/"},
+                         {stdout_ports_entry}}},
+            {inner_name, {inner, {stdin_ports_entry, stdout_ports_entry}}},
+        },
+        .links = {
+            {node_endpoint{echo_name, stdout_id},
+             node_endpoint{inner_name, stdin_id}},
+            {node_endpoint{inner_name, stdout_id}, user_endpoint{}},
+        },
+    }};
+    for (auto&& creation: {process_creation::spawn, process_creation::fork,
+                           process_creation::zygote}) {
+        auto compiled = plan{};
+        const auto opts = instantiate_options{.creation = creation};
+        ASSERT_NO_THROW(compiled = compile(sys, opts));
+        // The same plan instantiates any number of times.
+        for (auto i = 0; i < 2; ++i) {
+            std::ostringstream diags;
+            auto object = instance{};
+            ASSERT_NO_THROW(object = instantiate(compiled, diags));
+            auto& info = std::get<instance::system>(object.info);
+            ASSERT_EQ(size(info.channels), 2u);
+            ASSERT_EQ(size(info.children), 2u);
+            const auto& inner_info = std::get<instance::system>(
+                info.children.at(inner_name).info);
+            ASSERT_EQ(size(inner_info.channels), 2u);
+            EXPECT_TRUE(std::holds_alternative<reference_channel>(
+                inner_info.channels[0]));
+            EXPECT_TRUE(std::holds_alternative<reference_channel>(
+                inner_info.channels[1]));
+            std::ostringstream os;
+            EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[1]),
+                                 std::ostream_iterator<char>(os)));
+            EXPECT_EQ(os.str(), "hello\n");
+            const auto waits = wait(object);
+            EXPECT_EQ(size(waits), 2u);
+            for (auto&& result: waits) {
+                const auto p = std::get_if<info_wait_result>(&result);
+                ASSERT_NE(p, nullptr);
+                EXPECT_EQ(p->status,
+                          wait_status(wait_exit_status{EXIT_SUCCESS}));
+            }
+        }
+    }
+    std::ostringstream diags;
+    EXPECT_THROW(instantiate(plan{}, diags), std::invalid_argument);
+    const auto bad_link = flow::link{
+        node_endpoint{node_name{}},
+        node_endpoint{node_name{"b"}}
+    };
+    EXPECT_THROW(compile(flow::system{.links = {bad_link}}), invalid_link);
+}
+
+TEST(instantiate, lazy_start)
+{
+    const auto cat_name = node_name{"cat"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {cat_name, {executable{.file = "/bin/cat",
+                                   .start = start_policy::on_data},
+                        {stdin_ports_entry, stdout_ports_entry}}},
+        },
+        .links = {
+            {user_endpoint{}, node_endpoint{cat_name, stdin_id}},
+            {node_endpoint{cat_name, stdout_id}, user_endpoint{}},
+        },
+    }};
+    auto compiled = plan{};
+    ASSERT_NO_THROW(compiled = compile(sys));
+    for (auto&& use_plan: {false, true}) {
+        for (auto&& input: {std::string{"hello\n"}, std::string{}}) {
+            std::ostringstream diags;
+            auto object = instance{};
+            ASSERT_NO_THROW(object = use_plan
+                            ? instantiate(compiled, diags)
+                            : instantiate(sys, diags));
+            auto& info = std::get<instance::system>(object.info);
+            ASSERT_EQ(size(info.channels), 2u);
+            const auto& child = std::get<instance::forked>(
+                info.children.at(cat_name).info);
+            const auto p = std::get_if<owning_process_id>(&child.state);
+            ASSERT_NE(p, nullptr);
+            // Not started until there's data for it.
+            EXPECT_EQ(reference_process_id(*p), no_process_id);
+            auto& in = std::get<pipe_channel>(info.channels[0]);
+            if (!empty(input)) {
+                write(in, input);
+            }
+            in.close(pipe_channel::io::write, diags);
+            std::ostringstream os;
+            EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[1]),
+                                 std::ostream_iterator<char>(os)));
+            EXPECT_EQ(os.str(), input);
+            const auto waits = wait(object);
+            // Never started if its input closed without data.
+            EXPECT_EQ(size(waits), empty(input)? 0u: 1u);
+            for (auto&& result: waits) {
+                const auto r = std::get_if<info_wait_result>(&result);
+                ASSERT_NE(r, nullptr);
+                EXPECT_EQ(r->status,
+                          wait_status(wait_exit_status{EXIT_SUCCESS}));
+            }
+            const auto& state = std::get<instance::forked>(
+                info.children.at(cat_name).info).state;
+            EXPECT_EQ(state, decltype(state)(wait_exit_status{EXIT_SUCCESS}));
+        }
+    }
+}
+
+TEST(instantiate, process_descriptors)
+{
+    const auto sleep_name = node_name{"sleep"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {sleep_name, {executable{.file = "/bin/sleep",
+                                     .arguments = {"sleep", "10"}}, {}}},
+        },
+    }};
+    for (auto&& creation: {process_creation::spawn, process_creation::fork,
+                           process_creation::zygote}) {
+        std::ostringstream diags;
+        auto object = instance{};
+        const auto opts = instantiate_options{.creation = creation};
+        ASSERT_NO_THROW(object = instantiate(sys, diags, opts));
+        auto& info = std::get<instance::system>(object.info);
+        const auto& child = info.children.at(sleep_name);
+        const auto p = std::get_if<owning_process_id>(
+            &std::get<instance::forked>(child.info).state);
+        ASSERT_NE(p, nullptr);
+        // Every process is waited on via a process descriptor for it.
+        EXPECT_NE(p->pidfd(), descriptors::invalid_id);
+        send_signal(signals::kill(), child, diags, sleep_name.get());
+        const auto waits = wait(object);
+        ASSERT_EQ(size(waits), 1u);
+        const auto r = std::get_if<info_wait_result>(&waits[0]);
+        ASSERT_NE(r, nullptr);
+        EXPECT_EQ(r->status, wait_status(wait_signaled_status{SIGKILL}));
+    }
+}
+
+TEST(instantiate, timed_waits)
+{
+    using namespace std::chrono_literals;
+    const auto sleep_name = node_name{"sleep"};
+    const auto true_name = node_name{"true"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {sleep_name, {executable{.file = "/bin/sleep",
+                                     .arguments = {"sleep", "10"}}, {}}},
+            {true_name, {executable{.file = "/bin/true"}, {}}},
+        },
+    }};
+    std::ostringstream diags;
+    auto object = instance{};
+    ASSERT_NO_THROW(object = instantiate(sys, diags));
+    const auto start = std::chrono::steady_clock::now();
+    auto results = wait_for(object, 200ms);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 200ms);
+    // Only the one that finished by then.
+    ASSERT_EQ(size(results), 1u);
+    EXPECT_EQ(std::get<info_wait_result>(results[0]).status,
+              wait_status(wait_exit_status{EXIT_SUCCESS}));
+    auto& info = std::get<instance::system>(object.info);
+    send_signal(signals::kill(), info.children.at(sleep_name), diags);
+    results = wait_until(object, std::chrono::steady_clock::now() + 10s);
+    ASSERT_EQ(size(results), 1u);
+    EXPECT_EQ(std::get<info_wait_result>(results[0]).status,
+              wait_status(wait_signaled_status{SIGKILL}));
+    EXPECT_TRUE(empty(wait(object)));
+}
+
+TEST(instantiate, unbounded_timeouts)
+{
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {node_name{"sleep"}, {executable{
+                .file = "/bin/sleep",
+                .arguments = {"sleep", "0.2"},
+            }, {}}},
+        },
+    }};
+    // Too long to add to the current time, so as good as no deadline.
+    const auto opts = instantiate_options{
+        .deadline = std::chrono::nanoseconds::max(),
+        .kill_grace = std::chrono::nanoseconds::max(),
+    };
+    std::ostringstream diags;
+    auto object = instance{};
+    ASSERT_NO_THROW(object = instantiate(sys, diags, opts));
+    const auto results = wait_for(object, std::chrono::nanoseconds::max());
+    ASSERT_EQ(size(results), 1u);
+    EXPECT_EQ(std::get<info_wait_result>(results[0]).status,
+              wait_status(wait_exit_status{EXIT_SUCCESS}));
+}
+
+TEST(instantiate, deadline)
+{
+    using namespace std::chrono_literals;
+    const auto sleep_name = node_name{"sleep"};
+    const auto stubborn_name = node_name{"stubborn"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {sleep_name, {executable{.file = "/bin/sleep",
+                                     .arguments = {"sleep", "10"}}, {}}},
+            {stubborn_name, {executable{
+                .file = "/bin/sh",
+                .arguments = {"sh", "-c", "trap '' TERM; while :; do :; done"}
+            }, {}}},
+        },
+    }};
+    const auto opts = instantiate_options{
+        .deadline = 200ms,
+        .kill_grace = 200ms,
+    };
+    auto compiled = plan{};
+    ASSERT_NO_THROW(compiled = compile(sys, opts));
+    for (auto&& use_plan: {false, true}) {
+        std::ostringstream diags;
+        auto object = instance{};
+        const auto start = std::chrono::steady_clock::now();
+        ASSERT_NO_THROW(object = use_plan
+                        ? instantiate(compiled, diags)
+                        : instantiate(sys, diags, opts));
+        const auto results = wait_for(object, 5s);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+        ASSERT_EQ(size(results), 2u);
+        const auto& info = std::get<instance::system>(object.info);
+        EXPECT_EQ(get_wait_status(info.children.at(sleep_name)),
+                  wait_status(wait_signaled_status{SIGTERM}));
+        // Ignores SIGTERM so gets killed after the grace period.
+        EXPECT_EQ(get_wait_status(info.children.at(stubborn_name)),
+                  wait_status(wait_signaled_status{SIGKILL}));
+    }
+}
+
+namespace {
+
+/// @brief Instantiates children whose ports include descriptors that
+///   instantiating them likely uses for their pipes, their diagnostics, or
+///   the files they execute.
+/// @return Number of instantiations where any of those got mixed up.
+auto count_mixed_up_descriptors() -> int
+{
+    constexpr auto first_port = 3;
+    constexpr auto pipe_ports = 4;
+    constexpr auto last_port = 40;
+    const auto reader_name = node_name{"reader"};
+    const auto failer_name = node_name{"failer"};
+    auto reader_ports = port_map{stdout_ports_entry};
+    auto failer_ports = port_map{};
+    auto script = std::string{};
+    auto sys = flow::system{.environment = {{"PATH", "/bin"}}};
+    for (auto fd = first_port; fd <= last_port; ++fd) {
+        const auto id = reference_descriptor{fd};
+        reader_ports.emplace(id, port_info{"input", io_type::in});
+        failer_ports.emplace(id, port_info{"input", io_type::in});
+        if (fd < first_port + pipe_ports) {
+            sys.links.emplace_back(user_endpoint{},
+                                   node_endpoint{reader_name, id});
+            script += "read -r line <&" + std::to_string(fd);
+            script += "; echo \"" + std::to_string(fd) + ":$line\"; ";
+        }
+        else {
+            sys.links.emplace_back(file_endpoint{"/dev/null"},
+                                   node_endpoint{reader_name, id});
+        }
+        sys.links.emplace_back(file_endpoint{"/dev/null"},
+                               node_endpoint{failer_name, id});
+    }
+    sys.links.emplace_back(node_endpoint{reader_name, stdout_id},
+                           user_endpoint{});
+    sys.nodes.emplace(reader_name, flow::node{executable{
+        .file = "sh",
+        .arguments = {"sh", "-c", script},
+    }, reader_ports});
+    // Not executable, so fails to exec & reports that to its diags.
+    sys.nodes.emplace(failer_name, flow::node{executable{
+        .file = "/dev/null",
+    }, failer_ports});
+    auto expected = std::string{};
+    for (auto fd = first_port; fd < first_port + pipe_ports; ++fd) {
+        expected += std::to_string(fd) + ":" + std::to_string(fd) + "\n";
+    }
+    const auto root = flow::node{sys};
+    auto problems = 0;
+    for (auto&& creation: {process_creation::spawn,
+                           process_creation::fork,
+                           process_creation::zygote}) {
+        for (auto&& use_plan: {false, true}) {
+            const auto opts = instantiate_options{.creation = creation};
+            std::ostringstream diags;
+            auto object = use_plan
+                ? instantiate(compile(root, opts), diags)
+                : instantiate(root, diags, opts);
+            auto& info = std::get<instance::system>(object.info);
+            for (auto i = 0u; i < size(sys.links); ++i) {
+                const auto ends = make_endpoints<node_endpoint>(
+                    sys.links[i]);
+                if (!ends[1] || (ends[1]->address != reader_name) ||
+                    !std::holds_alternative<pipe_channel>(
+                        info.channels[i])) {
+                    continue;
+                }
+                const auto fd = int(std::get<reference_descriptor>(
+                    *begin(ends[1]->ports)));
+                auto& in = std::get<pipe_channel>(info.channels[i]);
+                write(in, std::to_string(fd) + "\n");
+                in.close(pipe_channel::io::write, diags);
+            }
+            std::ostringstream os;
+            read(std::get<pipe_channel>(info.channels.back()),
+                 std::ostream_iterator<char>(os));
+            (void) wait(object);
+            std::ostringstream failure;
+            write_diags(info.children.at(failer_name), failure);
+            if ((os.str() != expected) ||
+                (failure.str().find("/dev/null") == std::string::npos)) {
+                std::cerr << int(creation) << " " << use_plan << ": ";
+                std::cerr << os.str() << failure.str() << "\n";
+                ++problems;
+            }
+        }
+    }
+    return problems;
+}
+
+}
+
+TEST(instantiate, ports_clear_of_kept_descriptors)
+{
+    if (std::getenv("FLOW_NO_PIDFDS") != nullptr) { // NOLINT(concurrency-mt-unsafe)
+        GTEST_SKIP() << "can't run death tests while waiting on any child";
+    }
+    // In its own process, where descriptors are low enough to be the same
+    // as the children's ports.
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT({
+        (void) ::alarm(60u);
+        std::exit(count_mixed_up_descriptors());
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+TEST(instantiate, many_links)
+{
+    // 50 children with 100 linked input ports each, plus their outputs,
+    // for a total of 5,050 links.
+    constexpr auto child_count = 50;
+    constexpr auto inputs_per_child = 100;
+    constexpr auto first_input = 3;
+    constexpr auto last_input = first_input + inputs_per_child - 1;
+    constexpr auto link_count = child_count * (inputs_per_child + 1);
+    auto limit = rlimit{};
+    ASSERT_EQ(::getrlimit(RLIMIT_NOFILE, &limit), 0);
+    const auto fds_needed = rlim_t{2u * link_count + 256u};
+    if (limit.rlim_cur < fds_needed) {
+        if (limit.rlim_max < fds_needed) {
+            GTEST_SKIP() << "descriptor limit too low for test";
+        }
+        limit.rlim_cur = fds_needed;
+        ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &limit), 0);
+    }
+    auto sys = flow::system{};
+    for (auto i = 0; i < child_count; ++i) {
+        const auto name = node_name{"ls" + std::to_string(i)};
+        auto ports = port_map{stdout_ports_entry};
+        for (auto fd = first_input; fd <= last_input; ++fd) {
+            ports.emplace(reference_descriptor{fd},
+                          port_info{"input", io_type::in});
+            sys.links.emplace_back(user_endpoint{},
+                                   node_endpoint{name, reference_descriptor{fd}});
+        }
+        sys.links.emplace_back(node_endpoint{name, stdout_id},
+                               user_endpoint{});
+        sys.nodes.emplace(name, flow::node{executable{
+            .file = "/bin/ls",
+            .arguments = {"ls", "/proc/self/fd"},
+        }, ports});
+    }
+    ASSERT_EQ(size(sys.links), std::size_t(link_count));
+    std::ostringstream diags;
+    auto object = instance{};
+    ASSERT_NO_THROW(object = instantiate(sys, diags));
+    auto& info = std::get<instance::system>(object.info);
+    ASSERT_EQ(size(info.channels), std::size_t(link_count));
+    for (auto i = 0u; i < size(sys.links); ++i) {
+        const auto ends = make_endpoints<node_endpoint>(sys.links[i]);
+        if (!ends[0]) {
+            continue;
+        }
+        ASSERT_TRUE(std::holds_alternative<pipe_channel>(info.channels[i]));
+        std::ostringstream os;
+        EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[i]),
+                             std::ostream_iterator<char>(os)));
+        // Every input must be open, & nothing past them must be.
+        auto fds = std::set<int>{};
+        std::istringstream is{os.str()};
+        for (auto fd = 0; is >> fd;) {
+            fds.insert(fd);
+        }
+        EXPECT_EQ(fds.count(1), 1u) << ends[0]->address;
+        for (auto fd = first_input; fd <= last_input; ++fd) {
+            EXPECT_EQ(fds.count(fd), 1u) << ends[0]->address << " " << fd;
+        }
+        EXPECT_LE(*fds.rbegin(), last_input) << ends[0]->address;
+    }
+    for (auto&& result: wait(object)) {
+        ASSERT_TRUE(std::holds_alternative<info_wait_result>(result));
+        const auto& status = std::get<info_wait_result>(result).status;
+        ASSERT_TRUE(std::holds_alternative<wait_exit_status>(status));
+        EXPECT_EQ(std::get<wait_exit_status>(status).value, 0);
+    }
+}
@@ -0,0 +1,160 @@
+#include <chrono>
+#include <csignal> // for ::kill
+#include <cstdlib> // for std::exit, std::getenv, ::setenv
+#include <filesystem>
+#include <iostream> // for std::cerr
+#include <string>
+#include <thread> // for std::thread, std::this_thread::sleep_for
+#include <vector>
+
+#include <sys/resource.h> // for ::getrlimit, ::setrlimit
+
+#include <gtest/gtest.h>
+
+#include "flow/owning_process_id.hpp"
+
+using namespace flow;
+
+namespace {
+
+/// @brief Whether this process waits on any child process.
+/// @note Which reaps the children of death tests out from under them.
+auto is_waiting_on_any() -> bool
+{
+    return std::getenv("FLOW_NO_PIDFDS") != nullptr; // NOLINT(concurrency-mt-unsafe)
+}
+
+/// @brief Gets the highest descriptor that's open.
+auto highest_descriptor() -> int
+{
+    auto result = -1;
+    for (auto&& entry: std::filesystem::directory_iterator{"/proc/self/fd"}) {
+        result = std::max(result, std::stoi(entry.path().filename().string()));
+    }
+    return result;
+}
+
+/// @brief Spawns a shell that runs the given command.
+auto spawn_shell(std::string command) -> reference_process_id
+{
+    auto arg0 = std::string{"sh"};
+    auto arg1 = std::string{"-c"};
+    char *args[] = {arg0.data(), arg1.data(), command.data(), nullptr};
+    char *envp[] = {nullptr};
+    return owning_process_id::spawn("/bin/sh", nullptr, nullptr, args, envp);
+}
+
+/// @brief Spawns a shell that exits with the given code.
+auto spawn_exit(int code) -> reference_process_id
+{
+    return spawn_shell("exit " + std::to_string(code));
+}
+
+/// @brief Waits on the given processes, expecting each one's index as its
+///   exit code.
+/// @return Number of processes whose status wasn't as expected, which are
+///   also written to <code>std::cerr</code>.
+auto count_unexpected(std::vector<owning_process_id>& processes) -> int
+{
+    auto result = 0;
+    for (auto i = 0; i < int(size(processes)); ++i) {
+        const auto status = processes[std::size_t(i)].wait();
+        if (status != wait_status{wait_exit_status{i}}) {
+            std::cerr << "process " << i << " status: " << status << "\n";
+            ++result;
+        }
+    }
+    return result;
+}
+
+}
+
+TEST(owning_process_id, waits_for_unbounded_timeout)
+{
+    auto process = owning_process_id{spawn_exit(3)};
+    EXPECT_EQ(process.wait_for(std::chrono::nanoseconds::max()),
+              wait_status{wait_exit_status{3}});
+}
+
+TEST(owning_process_id, reports_stops_when_untraced)
+{
+    using namespace std::chrono_literals;
+    auto process = owning_process_id{spawn_shell("while :; do sleep 1; done")};
+    const auto pid = pid_t(reference_process_id(process));
+    const auto untraced = wait_options::untraced();
+    const auto stopped = wait_status{wait_stopped_status{SIGSTOP}};
+
+    // Stopped before waiting.
+    ASSERT_EQ(::kill(pid, SIGSTOP), 0);
+    EXPECT_EQ(process.wait_for(10s, untraced), stopped);
+    EXPECT_EQ(process.wait_for(10ms, untraced), std::nullopt);
+
+    // Stopped while waiting.
+    ASSERT_EQ(::kill(pid, SIGCONT), 0);
+    auto stopper = std::thread{[pid]{
+        std::this_thread::sleep_for(50ms);
+        (void) ::kill(pid, SIGSTOP);
+    }};
+    EXPECT_EQ(process.wait_for(10s, untraced), stopped);
+    stopper.join();
+
+    ASSERT_EQ(::kill(pid, SIGKILL), 0);
+    EXPECT_EQ(process.wait_for(10s, untraced),
+              wait_status{wait_signaled_status{SIGKILL}});
+}
+
+TEST(owning_process_id, reaps_past_descriptor_limit)
+{
+    if (is_waiting_on_any()) {
+        GTEST_SKIP() << "can't run death tests while waiting on any child";
+    }
+    // In its own process, so the lowered limit & any fallback it needs
+    // don't affect other tests.
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT({
+        static constexpr auto children = 64;
+        static constexpr auto spare_descriptors = 8;
+        auto limit = rlimit{};
+        (void) ::getrlimit(RLIMIT_NOFILE, &limit);
+        const auto saved = limit;
+        limit.rlim_cur = rlim_t(highest_descriptor() + 1 + spare_descriptors);
+        if (::setrlimit(RLIMIT_NOFILE, &limit) == -1) {
+            std::exit(EXIT_FAILURE);
+        }
+        auto processes = std::vector<owning_process_id>{};
+        for (auto i = 0; i < children; ++i) {
+            processes.emplace_back(spawn_exit(i));
+        }
+        (void) ::setrlimit(RLIMIT_NOFILE, &saved);
+        std::exit(count_unexpected(processes));
+    }, ::testing::ExitedWithCode(0), "");
+}
+
+TEST(owning_process_id, waits_on_any_child)
+{
+    if (is_waiting_on_any()) {
+        GTEST_SKIP() << "can't run death tests while waiting on any child";
+    }
+    // Forced in its own process, since the manager's made just once.
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_EXIT({
+        if (::setenv("FLOW_NO_PIDFDS", "1", 1) == -1) {
+            std::exit(EXIT_FAILURE);
+        }
+        static constexpr auto children = 16;
+        auto processes = std::vector<owning_process_id>{};
+        for (auto i = 0; i < children; ++i) {
+            processes.emplace_back(spawn_exit(i));
+        }
+        // Reaped before it's owned, so its status is held as an orphan's.
+        const auto orphan = spawn_exit(children);
+        const auto give_up = std::chrono::steady_clock::now() +
+            std::chrono::seconds{10};
+        while ((::kill(pid_t(orphan), 0) == 0) &&
+               (std::chrono::steady_clock::now() < give_up)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        processes.emplace_back(orphan);
+        std::exit(count_unexpected(processes));
+    }, ::testing::ExitedWithCode(0), "");
+}
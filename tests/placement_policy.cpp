@@ -0,0 +1,147 @@
+#include <sstream> // for std::ostringstream
+#include <string>
+
+#include <sched.h> // for ::sched_getaffinity
+
+#include <gtest/gtest.h>
+
+#include "flow/instantiate.hpp"
+#include "flow/placement_policy.hpp"
+#include "flow/system.hpp"
+
+#include "test_utility.hpp"
+
+using namespace flow;
+
+namespace {
+
+/// @brief Gets the CPUs this process may run on.
+auto get_allowed_cpus() -> std::set<unsigned>
+{
+    auto cpus = cpu_set_t{};
+    auto result = std::set<unsigned>{};
+    if (::sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+        for (auto cpu = 0u; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpus)) {
+                result.insert(cpu);
+            }
+        }
+    }
+    return result;
+}
+
+/// @brief Runs a shell command with the given placement.
+/// @return What the command wrote to its standard output.
+auto run(const std::string& command, const placement_policy& placement,
+         process_creation creation, bool use_plan) -> std::string
+{
+    return test::run(executable{
+        .file = "/bin/sh",
+        .arguments = {"sh", "-c", command},
+        .placement = placement,
+    }, creation, use_plan);
+}
+
+}
+
+TEST(placement_policy, default_construction)
+{
+    const auto placement = placement_policy{};
+    EXPECT_TRUE(empty(placement.cpus));
+    EXPECT_EQ(placement.cpu, cpu_policy::any);
+    EXPECT_EQ(placement.memory, memory_policy::inherit);
+    EXPECT_TRUE(empty(placement.numa_nodes));
+    EXPECT_EQ(executable{}.placement, placement);
+}
+
+TEST(placement_policy, comparison_and_output)
+{
+    const auto placement = placement_policy{
+        .cpus = {0u, 2u},
+        .cpu = cpu_policy::spread,
+    };
+    EXPECT_NE(placement, placement_policy{});
+    EXPECT_NE(executable{.placement = placement}, executable{});
+    std::ostringstream os;
+    os << placement;
+    EXPECT_NE(os.str().find(".cpus={0,2}"), std::string::npos) << os.str();
+    EXPECT_NE(os.str().find(".cpu=spread"), std::string::npos) << os.str();
+    os.str({});
+    os << memory_policy::interleave;
+    EXPECT_EQ(os.str(), "interleave");
+    os.str({});
+    os << executable{};
+    EXPECT_EQ(os.str().find(".placement="), std::string::npos);
+    os.str({});
+    os << executable{.placement = placement};
+    EXPECT_NE(os.str().find(".placement="), std::string::npos);
+}
+
+TEST(placement_policy, rejects_unplaceable)
+{
+    for (auto&& placement: {
+        placement_policy{.cpus = {CPU_SETSIZE}},
+        placement_policy{.numa_nodes = {placement_policy::max_numa_nodes}},
+        placement_policy{.memory = memory_policy::bind},
+        placement_policy{.memory = memory_policy::interleave},
+    }) {
+        const auto exe = flow::node{executable{
+            .file = "/bin/true",
+            .arguments = {"true"},
+            .placement = placement,
+        }, {}};
+        std::ostringstream diags;
+        EXPECT_THROW(instantiate(exe, diags), invalid_executable);
+        EXPECT_THROW(compile(exe), invalid_executable);
+        const auto sys = flow::node{flow::system{
+            .nodes = {{node_name{"a"}, exe}},
+        }};
+        EXPECT_THROW(instantiate(sys, diags), invalid_executable);
+        EXPECT_THROW(compile(sys), invalid_executable);
+    }
+}
+
+TEST(placement_policy, applies_affinity)
+{
+    const auto allowed = get_allowed_cpus();
+    ASSERT_FALSE(empty(allowed));
+    const auto cpu = *allowed.rbegin();
+    const auto expected = "Cpus_allowed_list:\t" + std::to_string(cpu) + "\n";
+    for (auto&& creation: test::all_creations) {
+        for (auto&& use_plan: {false, true}) {
+            EXPECT_EQ(run("grep Cpus_allowed_list /proc/self/status",
+                          placement_policy{.cpus = {cpu}},
+                          creation, use_plan), expected);
+        }
+    }
+}
+
+TEST(placement_policy, spreads_across_cpus)
+{
+    const auto allowed = get_allowed_cpus();
+    ASSERT_FALSE(empty(allowed));
+    const auto placement = placement_policy{.cpu = cpu_policy::spread};
+    auto used = std::set<std::string>{};
+    for (auto i = 0u; i < size(allowed); ++i) {
+        const auto output = run("grep Cpus_allowed_list /proc/self/status",
+                                placement, process_creation::fork, false);
+        ASSERT_TRUE(output.starts_with("Cpus_allowed_list:\t")) << output;
+        const auto cpu = output.substr(19u, size(output) - 20u);
+        EXPECT_TRUE(allowed.contains(unsigned(std::stoul(cpu)))) << cpu;
+        EXPECT_EQ(cpu.find_first_of(",-"), std::string::npos) << cpu;
+        used.insert(cpu);
+    }
+    EXPECT_EQ(size(used), size(allowed));
+}
+
+TEST(placement_policy, applies_memory_policy)
+{
+    // The policy of the process shows for its mappings that don't have one.
+    const auto output = run("grep -c ' local ' /proc/self/numa_maps",
+                            placement_policy{.memory = memory_policy::local},
+                            process_creation::fork, true);
+    if (output.empty()) {
+        GTEST_SKIP() << "no NUMA support";
+    }
+    EXPECT_NE(output, "0\n");
+}
@@ -0,0 +1,96 @@
+#include <sstream> // for std::ostringstream
+
+#include <gtest/gtest.h>
+
+#include "flow/instance.hpp"
+#include "flow/instantiate.hpp"
+#include "flow/process_usage.hpp"
+#include "flow/utility.hpp"
+
+using namespace flow;
+
+TEST(process_usage, default_construction)
+{
+    const auto usage = process_usage{};
+    EXPECT_EQ(usage.user_time.count(), 0);
+    EXPECT_EQ(usage.system_time.count(), 0);
+    EXPECT_EQ(usage.max_resident_kib, 0);
+    EXPECT_EQ(usage.minor_faults, 0);
+    EXPECT_EQ(usage.major_faults, 0);
+    EXPECT_EQ(usage.voluntary_switches, 0);
+    EXPECT_EQ(usage.involuntary_switches, 0);
+}
+
+TEST(process_usage, accumulation)
+{
+    using std::chrono::microseconds;
+    const auto a = process_usage{
+        .user_time = microseconds{10},
+        .system_time = microseconds{20},
+        .max_resident_kib = 300,
+        .minor_faults = 4,
+        .major_faults = 5,
+        .voluntary_switches = 6,
+        .involuntary_switches = 7,
+    };
+    const auto b = process_usage{
+        .user_time = microseconds{1},
+        .system_time = microseconds{2},
+        .max_resident_kib = 500,
+        .minor_faults = 1,
+        .major_faults = 1,
+        .voluntary_switches = 1,
+        .involuntary_switches = 1,
+    };
+    const auto sum = a + b;
+    EXPECT_EQ(sum.user_time, microseconds{11});
+    EXPECT_EQ(sum.system_time, microseconds{22});
+    EXPECT_EQ(sum.max_resident_kib, 500);
+    EXPECT_EQ(sum.minor_faults, 5);
+    EXPECT_EQ(sum.major_faults, 6);
+    EXPECT_EQ(sum.voluntary_switches, 7);
+    EXPECT_EQ(sum.involuntary_switches, 8);
+    auto total = process_usage{};
+    total += a;
+    EXPECT_EQ(total, a);
+}
+
+TEST(process_usage, of_waited_instance)
+{
+    const auto spin_name = node_name{"spin"};
+    const auto true_name = node_name{"true"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {spin_name, {executable{
+                .file = "/bin/sh",
+                .arguments = {"sh", "-c",
+                              "i=0; while [ $i -lt 20000 ]; do i=$((i+1)); done"}
+            }, {}}},
+            {true_name, {executable{.file = "/bin/true"}, {}}},
+        },
+    }};
+    for (auto&& creation: {process_creation::spawn, process_creation::fork,
+                           process_creation::zygote}) {
+        std::ostringstream diags;
+        auto object = instance{};
+        const auto opts = instantiate_options{.creation = creation};
+        ASSERT_NO_THROW(object = instantiate(sys, diags, opts));
+        EXPECT_EQ(total_usage(object), process_usage{});
+        const auto results = wait(object);
+        ASSERT_EQ(size(results), 2u);
+        auto sum = process_usage{};
+        for (auto&& result: results) {
+            const auto p = std::get_if<info_wait_result>(&result);
+            ASSERT_NE(p, nullptr);
+            EXPECT_EQ(p->status, wait_status(wait_exit_status{EXIT_SUCCESS}));
+            EXPECT_GT(p->usage.max_resident_kib, 0);
+            sum += p->usage;
+        }
+        const auto total = total_usage(object);
+        EXPECT_EQ(total, sum);
+        EXPECT_GT((total.user_time + total.system_time).count(), 0);
+        const auto& info = std::get<instance::system>(object.info);
+        EXPECT_GT(total_usage(info.children.at(spin_name)).user_time,
+                  total_usage(info.children.at(true_name)).user_time);
+    }
+}
@@ -0,0 +1,83 @@
+#include <future>
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "flow/pipe_channel.hpp"
+#include "flow/projector.hpp"
+
+using namespace flow;
+
+namespace {
+
+auto project(const projector& spec, const std::string& input) -> std::string
+{
+    pipe_channel in;
+    pipe_channel out;
+    auto projecting = std::async(std::launch::async, [&](){
+        project(spec, in.get(pipe_channel::io::read),
+                out.get(pipe_channel::io::write));
+        out.close(pipe_channel::io::write, std::cerr);
+    });
+    // Output can start before all input's written, so write concurrently.
+    auto writing = std::async(std::launch::async, [&](){
+        write(in, input);
+    });
+    std::ostringstream os;
+    read(out, std::ostream_iterator<char>(os));
+    writing.get();
+    projecting.get();
+    return os.str();
+}
+
+}
+
+TEST(projector, default_construction)
+{
+    const auto obj = projector{};
+    EXPECT_TRUE(empty(obj.fields));
+    EXPECT_EQ(obj.field_delimiter, '\t');
+    EXPECT_EQ(obj.output_delimiter, '\t');
+    EXPECT_EQ(obj.record_delimiter, '\n');
+    EXPECT_EQ(obj.quote, '\0');
+}
+
+TEST(projector, all_fields)
+{
+    const auto spec = projector{.output_delimiter = ','};
+    EXPECT_EQ(project(spec, "a\tb\tc\n\nd"), "a,b,c\n\nd\n");
+}
+
+TEST(projector, reorders_fields)
+{
+    const auto spec = projector{.fields = {3u, 1u, 3u, 5u}};
+    EXPECT_EQ(project(spec, "a\tb\tc\td\nw\tx\ty\n"),
+              "c\ta\tc\t\ny\tw\ty\t\n");
+}
+
+TEST(projector, quoted_fields)
+{
+    const auto spec = projector{
+        .fields = {2u, 3u},
+        .field_delimiter = ',',
+        .output_delimiter = '\t',
+        .quote = '"',
+    };
+    EXPECT_EQ(project(spec, "1,\"a,\"\"b\"\"\nc\",x\n2,plain,y\n"),
+              "\"a,\"\"b\"\"\nc\"\tx\nplain\ty\n");
+}
+
+TEST(projector, long_records)
+{
+    const auto spec = projector{.fields = {2u}};
+    const auto field = std::string(200000u, 'x');
+    std::string input;
+    std::string expected;
+    for (auto i = 0u; i < 3u; ++i) {
+        input += std::to_string(i) + "\t" + field + std::to_string(i) + "\n";
+        expected += field + std::to_string(i) + "\n";
+    }
+    EXPECT_EQ(project(spec, input), expected);
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include "flow/record_schema.hpp"
+
+using namespace flow;
+
+TEST(record_schema, default_construction)
+{
+    const auto obj = record_schema{};
+    EXPECT_TRUE(empty(obj.fields));
+    EXPECT_EQ(obj.encoding, record_encoding::delimited);
+    EXPECT_EQ(obj.field_delimiter, '\t');
+    EXPECT_EQ(obj.record_delimiter, '\n');
+}
+
+TEST(record_schema, get_record_size)
+{
+    auto schema = record_schema{
+        .fields = {
+            {"name", field_type::text, 12u},
+            {"id", field_type::integer},
+            {"score", field_type::real},
+        },
+    };
+    EXPECT_EQ(get_record_size(schema), 0u);
+    schema.encoding = record_encoding::binary;
+    EXPECT_EQ(get_record_size(schema), 28u);
+}
+
+TEST(record_schema, is_compatible)
+{
+    const auto named = record_schema{
+        .fields = {{"id", field_type::integer}, {"name", field_type::text}},
+    };
+    const auto unnamed = record_schema{
+        .fields = {{"", field_type::integer}, {"", field_type::text}},
+    };
+    auto renamed = named;
+    renamed.fields[1].name = "label";
+    auto retyped = named;
+    retyped.fields[0].type = field_type::real;
+    auto csv = named;
+    csv.field_delimiter = ',';
+    auto binary = named;
+    binary.encoding = record_encoding::binary;
+    EXPECT_TRUE(is_compatible(named, named));
+    EXPECT_TRUE(is_compatible(named, unnamed));
+    EXPECT_TRUE(is_compatible(unnamed, named));
+    EXPECT_FALSE(is_compatible(named, renamed));
+    EXPECT_FALSE(is_compatible(named, retyped));
+    EXPECT_FALSE(is_compatible(named, csv));
+    EXPECT_FALSE(is_compatible(named, binary));
+    EXPECT_FALSE(is_compatible(named, record_schema{}));
+}
@@ -0,0 +1,128 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream
+
+#include <gtest/gtest.h>
+
+#include "flow/instantiate.hpp"
+#include "flow/pipe_channel.hpp"
+#include "flow/resource_limits.hpp"
+#include "flow/system.hpp"
+#include "flow/utility.hpp"
+
+#include "test_utility.hpp"
+
+using namespace flow;
+
+TEST(resource_limits, default_construction)
+{
+    const auto limits = resource_limits{};
+    EXPECT_EQ(limits.cpu_quota.count(), 0);
+    EXPECT_EQ(limits.cpu_period.count(), 100'000);
+    EXPECT_EQ(limits.cpu_weight, 0u);
+    EXPECT_EQ(limits.memory_max, 0u);
+    EXPECT_EQ(limits.io_weight, 0u);
+    EXPECT_EQ(executable{}.resources, limits);
+    EXPECT_EQ(flow::system{}.resources, limits);
+}
+
+TEST(resource_limits, comparison_and_output)
+{
+    const auto limits = resource_limits{.cpu_weight = 50u};
+    EXPECT_NE(limits, resource_limits{});
+    EXPECT_NE(executable{.resources = limits}, executable{});
+    EXPECT_NE(flow::system{.resources = limits}, flow::system{});
+    std::ostringstream os;
+    os << limits;
+    EXPECT_NE(os.str().find(".cpu_weight=50"), std::string::npos);
+    os.str({});
+    os << executable{};
+    EXPECT_EQ(os.str().find(".resources="), std::string::npos);
+    os.str({});
+    os << executable{.resources = limits};
+    EXPECT_NE(os.str().find(".resources="), std::string::npos);
+}
+
+TEST(resource_limits, instantiates_into_cgroups)
+{
+    const auto name = node_name{"a"};
+    const auto sys = flow::node{flow::system{
+        .nodes = {
+            {name, {executable{
+                .file = "/bin/sh",
+                .arguments = {"sh", "-c", "grep '^0::' /proc/self/cgroup"},
+            }, {stdout_ports_entry}}},
+        },
+        .links = {
+            {node_endpoint{name, descriptors::stdout_id}, user_endpoint{}},
+        },
+        .resources = {.cpu_weight = 200u},
+    }};
+    auto unenforced = std::string{};
+    for (auto&& creation: test::all_creations) {
+        for (auto&& use_plan: {false, true}) {
+            std::ostringstream diags;
+            auto object = instance{};
+            ASSERT_NO_THROW(object = test::instantiate(sys, diags, creation,
+                                                       use_plan));
+            const auto sys_path = get_cgroup_path(object);
+            if (sys_path.empty()) {
+                GTEST_SKIP() << "can't make control groups: " << diags.str();
+            }
+            // The file's only there if the cpu controller's enabled for it.
+            if (std::ifstream in{sys_path / "cpu.weight"}; in) {
+                auto weight = 0u;
+                EXPECT_TRUE(in >> weight);
+                EXPECT_EQ(weight, 200u);
+            }
+            else {
+                unenforced = diags.str();
+            }
+            auto& info = std::get<instance::system>(object.info);
+            const auto path = get_cgroup_path(info.children.at(name));
+            EXPECT_EQ(path, sys_path / name.get());
+            EXPECT_TRUE(std::filesystem::is_directory(path));
+            std::ostringstream os;
+            EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[0]),
+                                 std::ostream_iterator<char>(os)));
+            const auto expected = (sys_path.filename() / name.get()).string();
+            EXPECT_TRUE(os.str().ends_with(expected + "\n")) << os.str();
+            const auto waits = wait(object);
+            ASSERT_EQ(size(waits), 1u);
+            EXPECT_EQ(std::get<info_wait_result>(waits[0]).status,
+                      wait_status(wait_exit_status{EXIT_SUCCESS}));
+            EXPECT_TRUE(get_cgroup_usage(object));
+            EXPECT_TRUE(get_cgroup_usage(info.children.at(name)));
+            object = instance{};
+            EXPECT_FALSE(std::filesystem::exists(path));
+            EXPECT_FALSE(std::filesystem::exists(sys_path));
+        }
+    }
+    if (!unenforced.empty()) {
+        GTEST_SKIP() << "can't enforce limits: " << unenforced;
+    }
+}
+
+TEST(resource_limits, degrades_without_cgroups)
+{
+    const auto exe = flow::node{executable{
+        .file = "/bin/true",
+        .arguments = {"true"},
+        .resources = {.memory_max = 1u << 30u},
+    }, {}};
+    const auto opts = instantiate_options{
+        .cgroup = "/nonexistent/flow/cgroup",
+    };
+    std::ostringstream diags;
+    auto object = instance{};
+    ASSERT_NO_THROW(object = instantiate(exe, diags, opts));
+    EXPECT_NE(diags.str().find("can't make control group"),
+              std::string::npos) << diags.str();
+    EXPECT_TRUE(get_cgroup_path(object).empty());
+    EXPECT_FALSE(get_cgroup_usage(object));
+    const auto waits = wait(object);
+    ASSERT_EQ(size(waits), 1u);
+    EXPECT_EQ(std::get<info_wait_result>(waits[0]).status,
+              wait_status(wait_exit_status{EXIT_SUCCESS}));
+}
@@ -0,0 +1,120 @@
+#include <sstream> // for std::ostringstream
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "flow/instantiate.hpp"
+#include "flow/scheduling_policy.hpp"
+#include "flow/system.hpp"
+
+#include "test_utility.hpp"
+
+using namespace flow;
+
+namespace {
+
+constexpr auto show_scheduling = "nice; chrt -p $$; ionice -p $$";
+
+/// @brief Runs a shell command with the given scheduling attributes.
+/// @return What the command wrote to its standard output.
+auto run(const std::string& command, const scheduling_policy& scheduling,
+         process_creation creation, bool use_plan) -> std::string
+{
+    return test::run(executable{
+        .file = "/bin/sh",
+        .arguments = {"sh", "-c", command},
+        .scheduling = scheduling,
+    }, creation, use_plan);
+}
+
+}
+
+TEST(scheduling_policy, default_construction)
+{
+    const auto scheduling = scheduling_policy{};
+    EXPECT_FALSE(scheduling.nice);
+    EXPECT_EQ(scheduling.scheduler, scheduling_class::inherit);
+    EXPECT_EQ(scheduling.io, io_class::inherit);
+    EXPECT_EQ(scheduling.io_level, 4u);
+    EXPECT_EQ(executable{}.scheduling, scheduling);
+}
+
+TEST(scheduling_policy, comparison_and_output)
+{
+    const auto scheduling = scheduling_policy{
+        .nice = 10,
+        .scheduler = scheduling_class::batch,
+    };
+    EXPECT_NE(scheduling, scheduling_policy{});
+    EXPECT_NE(executable{.scheduling = scheduling}, executable{});
+    std::ostringstream os;
+    os << scheduling;
+    EXPECT_NE(os.str().find(".nice=10"), std::string::npos) << os.str();
+    EXPECT_NE(os.str().find(".scheduler=batch"), std::string::npos);
+    os.str({});
+    os << io_class::best_effort;
+    EXPECT_EQ(os.str(), "best_effort");
+    os.str({});
+    os << executable{};
+    EXPECT_EQ(os.str().find(".scheduling="), std::string::npos);
+    os.str({});
+    os << executable{.scheduling = scheduling};
+    EXPECT_NE(os.str().find(".scheduling="), std::string::npos);
+}
+
+TEST(scheduling_policy, rejects_out_of_range)
+{
+    for (auto&& scheduling: {
+        scheduling_policy{.nice = scheduling_policy::min_nice - 1},
+        scheduling_policy{.nice = scheduling_policy::max_nice + 1},
+        scheduling_policy{.io = io_class::best_effort, .io_level = 8u},
+    }) {
+        const auto exe = flow::node{executable{
+            .file = "/bin/true",
+            .arguments = {"true"},
+            .scheduling = scheduling,
+        }, {}};
+        std::ostringstream diags;
+        EXPECT_THROW(instantiate(exe, diags), invalid_executable);
+        EXPECT_THROW(compile(exe), invalid_executable);
+        const auto sys = flow::node{flow::system{
+            .nodes = {{node_name{"a"}, exe}},
+        }};
+        EXPECT_THROW(instantiate(sys, diags), invalid_executable);
+        EXPECT_THROW(compile(sys), invalid_executable);
+    }
+}
+
+TEST(scheduling_policy, applies_batch)
+{
+    const auto scheduling = scheduling_policy{
+        .nice = 5,
+        .scheduler = scheduling_class::batch,
+        .io = io_class::best_effort,
+        .io_level = 6u,
+    };
+    for (auto&& creation: test::all_creations) {
+        for (auto&& use_plan: {false, true}) {
+            const auto output = run(show_scheduling, scheduling, creation,
+                                    use_plan);
+            EXPECT_TRUE(output.starts_with("5\n")) << output;
+            EXPECT_NE(output.find("SCHED_BATCH"), std::string::npos)
+                << output;
+            EXPECT_NE(output.find("best-effort: prio 6"), std::string::npos)
+                << output;
+        }
+    }
+}
+
+TEST(scheduling_policy, applies_idle)
+{
+    const auto scheduling = scheduling_policy{
+        .scheduler = scheduling_class::idle,
+        .io = io_class::idle,
+    };
+    const auto output = run(show_scheduling, scheduling,
+                            process_creation::fork, false);
+    EXPECT_TRUE(output.starts_with("0\n")) << output;
+    EXPECT_NE(output.find("SCHED_IDLE"), std::string::npos) << output;
+    EXPECT_NE(output.find("idle"), std::string::npos) << output;
+}
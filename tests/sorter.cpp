@@ -0,0 +1,120 @@
+#include <future>
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "flow/instantiate.hpp"
+#include "flow/pipe_channel.hpp"
+#include "flow/sorter.hpp"
+
+using namespace flow;
+
+namespace {
+
+auto sort(const sorter& spec, const std::string& input) -> std::string
+{
+    pipe_channel in;
+    pipe_channel out;
+    auto sorting = std::async(std::launch::async, [&](){
+        sort(spec, in.get(pipe_channel::io::read),
+             out.get(pipe_channel::io::write));
+        out.close(pipe_channel::io::write, std::cerr);
+    });
+    write(in, input);
+    std::ostringstream os;
+    read(out, std::ostream_iterator<char>(os));
+    sorting.get();
+    return os.str();
+}
+
+}
+
+TEST(sorter, default_construction)
+{
+    const auto obj = sorter{};
+    EXPECT_EQ(obj.key_field, 0u);
+    EXPECT_EQ(obj.field_delimiter, '\t');
+    EXPECT_EQ(obj.record_delimiter, '\n');
+    EXPECT_EQ(obj.order, sort_order::lexicographic);
+    EXPECT_EQ(obj.memory_budget, sorter::default_memory_budget);
+    EXPECT_EQ(obj.threads, 0u);
+    EXPECT_TRUE(obj.temporary_directory.empty());
+}
+
+TEST(sorter, empty_input)
+{
+    EXPECT_EQ(sort(sorter{}, ""), "");
+}
+
+TEST(sorter, lexicographic)
+{
+    EXPECT_EQ(sort(sorter{}, "pear\napple\nfig"), "apple\nfig\npear\n");
+}
+
+TEST(sorter, numeric_key_field)
+{
+    const auto spec = sorter{
+        .key_field = 2u,
+        .field_delimiter = ',',
+        .order = sort_order::numeric,
+    };
+    EXPECT_EQ(sort(spec, "a,10\nb,9\nc,-1.5\nd,x\n"),
+              "c,-1.5\nd,x\nb,9\na,10\n");
+}
+
+TEST(sorter, spills_and_merges)
+{
+    const auto spec = sorter{
+        .order = sort_order::numeric,
+        .memory_budget = 4096u,
+        .threads = 2u,
+    };
+    static constexpr auto count = 20000u;
+    static constexpr auto stride = 7919u; // prime so all values get visited
+    std::string input;
+    std::string expected;
+    for (auto i = 0u; i < count; ++i) {
+        input += std::to_string((i * stride) % count) + "\n";
+        expected += std::to_string(i) + "\n";
+    }
+    EXPECT_EQ(sort(spec, input), expected);
+}
+
+TEST(sorter, instantiated_in_system)
+{
+    using flow::link; // disambiguate link
+    const auto sort_name = node_name{"sort"};
+    const auto sys = flow::system{
+        .nodes = {
+            {sort_name, flow::node{sorter{}, {
+                stdin_ports_entry, stdout_ports_entry
+            }}},
+        },
+        .links = {
+            link{user_endpoint{}, node_endpoint{sort_name, descriptors::stdin_id}},
+            link{node_endpoint{sort_name, descriptors::stdout_id}, user_endpoint{}},
+        },
+    };
+    std::ostringstream diags;
+    auto object = instantiate(sys, diags);
+    auto info = std::get_if<instance::system>(&object.info);
+    ASSERT_NE(info, nullptr);
+    ASSERT_EQ(size(info->channels), 2u);
+    ASSERT_EQ(size(info->children), 1u);
+    EXPECT_TRUE(std::holds_alternative<instance::builtin>(info->children.begin()->second.info));
+    auto in = std::get_if<pipe_channel>(&info->channels[0]);
+    auto out = std::get_if<pipe_channel>(&info->channels[1]);
+    ASSERT_NE(in, nullptr);
+    ASSERT_NE(out, nullptr);
+    write(*in, std::string{"b\nc\na\n"});
+    std::ostringstream os;
+    read(*out, std::ostream_iterator<char>(os));
+    EXPECT_EQ(os.str(), "a\nb\nc\n");
+    const auto results = wait(object);
+    ASSERT_EQ(size(results), 1u);
+    EXPECT_EQ(results.front(), wait_result(info_wait_result{
+        current_process_id(), wait_exit_status{EXIT_SUCCESS}
+    }));
+}
@@ -0,0 +1,44 @@
+#include <iterator> // for std::ostream_iterator
+#include <sstream> // for std::ostringstream
+
+#include <gtest/gtest.h>
+
+#include "flow/pipe_channel.hpp"
+#include "flow/system.hpp"
+#include "flow/utility.hpp"
+
+#include "test_utility.hpp"
+
+namespace flow::test {
+
+auto instantiate(const node& root, std::ostream& diags,
+                 process_creation creation, bool use_plan) -> instance
+{
+    const auto opts = instantiate_options{.creation = creation};
+    return use_plan
+        ? flow::instantiate(compile(root, opts), diags)
+        : flow::instantiate(root, diags, opts);
+}
+
+auto run(const executable& exe, process_creation creation, bool use_plan)
+    -> std::string
+{
+    const auto name = node_name{"a"};
+    const auto sys = node{system{
+        .nodes = {{name, node{exe, {stdout_ports_entry}}}},
+        .links = {
+            {node_endpoint{name, descriptors::stdout_id}, user_endpoint{}},
+        },
+    }};
+    std::ostringstream diags;
+    auto object = instantiate(sys, diags, creation, use_plan);
+    auto& info = std::get<instance::system>(object.info);
+    std::ostringstream os;
+    EXPECT_NO_THROW(read(std::get<pipe_channel>(info.channels[0]),
+                         std::ostream_iterator<char>(os)));
+    const auto waits = wait(object);
+    EXPECT_EQ(size(waits), 1u);
+    return os.str();
+}
+
+}
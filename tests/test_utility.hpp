@@ -0,0 +1,35 @@
+#ifndef test_utility_hpp
+#define test_utility_hpp
+
+#include <array>
+#include <ostream>
+#include <string>
+
+#include "flow/instance.hpp"
+#include "flow/instantiate.hpp"
+#include "flow/node.hpp"
+
+namespace flow::test {
+
+/// @brief Every way of creating processes, for tests to try each one.
+inline constexpr auto all_creations = std::array{
+    process_creation::spawn,
+    process_creation::fork,
+    process_creation::zygote,
+};
+
+/// @brief Instantiates the given node with the given creation, either
+///   directly or from its compiled plan.
+auto instantiate(const node& root, std::ostream& diags,
+                 process_creation creation, bool use_plan) -> instance;
+
+/// @brief Runs the given executable, with its standard output linked to
+///   the user, until it exits.
+/// @return What the executable wrote to its standard output.
+auto run(const executable& exe,
+         process_creation creation = process_creation::fork,
+         bool use_plan = false) -> std::string;
+
+}
+
+#endif /* test_utility_hpp */